@@ -34,11 +34,15 @@
 
 #include "gen_alloc.h"
 #include "data/func_map.h"
+#include "gen_calltree.h"
 #include "gen_common.h"
+#include "gen_symbols.h"
+#include "cpu_arch/instrs.h"
 
 #define DEBUG_ALLOCATOR
 
 #define MAX_STACK_FRAMES 8
+#define TEMP_POOL_SIZE 4                // zeropage temps for 16-bit expressions
 
 //-------------------------------
 // Module variables
@@ -48,6 +52,9 @@ static int globalAddr;
 static int stackSizes[MAX_STACK_FRAMES];       // Track the sizes of 8 stack frames
 static int stackLocs[MAX_STACK_FRAMES];        // Location of each stack frame
 static int callStackDepth;
+static int tempPoolAddr;
+static int tempPoolSize;
+static bool hasPackedBools;
 
 
 void initStackFrames() {
@@ -155,7 +162,7 @@ int allocateVarStorage(const SymbolTable *symbolTable) {
         bool hasHint = ((curSymbol->flags & MF_HINT) != 0) && (curSymbol->location >= 0);
 
         // only vars need allocation storage (and only when they don't already have a location assigned via hint)
-        if (isVariable(curSymbol) && (curSymbol->location != 0xffff) && (!hasHint)) {
+        if (isVariable(curSymbol) && (curSymbol->location != 0xffff) && (!hasHint) && !IS_PACKED_BOOL(curSymbol)) {
             int varSize = calcVarSize(curSymbol);
 
             // allocate memory
@@ -179,6 +186,286 @@ int allocateVarStorage(const SymbolTable *symbolTable) {
     return totalSize;
 }
 
+//-------------------------------------------------------------------
+//  Packed bools
+//
+//  Bools marked 'packed' share a byte, eight to a byte.  Bits 7 and 6 can be
+//  tested with BIT (into the N and V flags) without loading A, so the most
+//  used bools get those bits.  The shared bytes are added to the symbol table
+//  as normal byte vars, so they get allocated (and promoted) like any other.
+
+#define MAX_PACKED_BOOLS 256
+
+int cmp_packedUsage(const void *arg1, const void *arg2) {
+    const SymbolRecord *sym1 = *(SymbolRecord * const *) arg1;
+    const SymbolRecord *sym2 = *(SymbolRecord * const *) arg2;
+    if (sym1->accessWeight != sym2->accessWeight) return (sym1->accessWeight > sym2->accessWeight) ? -1 : 1;     // DESCENDING
+    return 0;
+}
+
+void packBools(SymbolTable *symbolTable) {
+    SymbolRecord *packedBools[MAX_PACKED_BOOLS];
+    int count = 0;
+
+    for (SymbolRecord *curSymbol = symbolTable->firstSymbol; curSymbol != NULL; curSymbol = curSymbol->next) {
+        if (isVariable(curSymbol) && IS_PACKED_BOOL(curSymbol) && (count < MAX_PACKED_BOOLS)) {
+            packedBools[count++] = curSymbol;
+        }
+    }
+    qsort(packedBools, count, sizeof(SymbolRecord *), cmp_packedUsage);
+    hasPackedBools = (count > 0);
+
+    SymbolRecord *packedByte = NULL;
+    for_range(index, 0, count) {
+        int bitNum = 7 - (index & 7);
+        if (bitNum == 7) {
+            char *byteName = allocMem(24);
+            sprintf(byteName, "PACKED_BOOLS_%d", index >> 3);
+            packedByte = addSymbol(symbolTable, byteName, SK_VAR, ST_CHAR, 0);
+        }
+
+        SymbolRecord *boolSym = packedBools[index];
+        boolSym->packedByte = packedByte;
+        boolSym->bitMask = 1 << bitNum;
+
+        packedByte->cntAccesses += boolSym->cntAccesses;
+        packedByte->accessWeight += boolSym->accessWeight;
+    }
+}
+
+/**
+ * Packed bools use the location of the byte they're stored in
+ */
+void placePackedBools(const SymbolTable *symbolTable) {
+    for (SymbolRecord *curSymbol = symbolTable->firstSymbol; curSymbol != NULL; curSymbol = curSymbol->next) {
+        if (!isVariable(curSymbol) || !IS_PACKED_BOOL(curSymbol) || (curSymbol->packedByte == NULL)) continue;
+
+        const SymbolRecord *packedByte = curSymbol->packedByte;
+        setSymbolLocation(curSymbol, packedByte->location, packedByte->flags & SS_STORAGE_MASK);
+
+        if (compilerOptions.showVarAllocations) {
+            printf("\t%-32s allocated at %4X  (mask %02X)\n", curSymbol->name, curSymbol->location, curSymbol->bitMask);
+        }
+    }
+}
+
+//-------------------------------------------------------------------
+//  Zeropage promotion
+//
+//  On machines with RAM outside of the zeropage, global vars go there
+//   by default.  Instead, give the zeropage to the vars that are used the
+//   most (based on the access counts collected while building the call tree).
+
+#define MAX_PROMOTION_CANDIDATES 256
+
+typedef struct {
+    int numVars;
+    int size;
+    int bytesSaved;
+    int cyclesSaved;
+} PromotionResult;
+
+bool needsGlobalAllocation(const SymbolRecord *symbol) {
+    bool hasHint = ((symbol->flags & MF_HINT) != 0) && (symbol->location >= 0);
+    return isVariable(symbol) && (symbol->location != 0xffff) && !hasHint && !IS_PACKED_BOOL(symbol);
+}
+
+/**
+ * Each access to a zeropage var saves a byte and a cycle (two for 16-bit vars)
+ */
+int calcSavingsPerAccess(const SymbolRecord *symbol) {
+    return (getBaseVarSize(symbol) > 1) ? 2 : 1;
+}
+
+void addPromotionSavings(PromotionResult *result, const SymbolRecord *symbol) {
+    int savingsPerAccess = calcSavingsPerAccess(symbol);
+    result->numVars++;
+    result->size += calcVarSize(symbol);
+    result->bytesSaved += symbol->cntAccesses * savingsPerAccess;
+    result->cyclesSaved += symbol->accessWeight * savingsPerAccess;
+}
+
+int cmp_usage(const void *arg1, const void *arg2) {
+    const SymbolRecord *sym1 = *(SymbolRecord * const *) arg1;
+    const SymbolRecord *sym2 = *(SymbolRecord * const *) arg2;
+
+    // compare weight per byte of zeropage used:  w1/s1 vs w2/s2
+    long score1 = (long)sym1->accessWeight * calcVarSize(sym2);
+    long score2 = (long)sym2->accessWeight * calcVarSize(sym1);
+    if (score1 != score2) return (score1 > score2) ? -1 : 1;     // DESCENDING
+    return 0;
+}
+
+/**
+ * Figure out how much zeropage is left for global vars
+ *   (after the vars the user put there, and the local var stack frames)
+ */
+int calcZeropageBudget(const SymbolTable *symbolTable) {
+    int budget = SMA_getFreeSpace(SMA_getZeropageArea()) - 1;
+
+    for_range(frmNum, 0, MAX_STACK_FRAMES-1) { budget -= stackSizes[frmNum]; }
+
+    SymbolRecord *curSymbol = symbolTable->firstSymbol;
+    while (curSymbol != NULL) {
+        if (needsGlobalAllocation(curSymbol) && ((curSymbol->flags & SS_STORAGE_MASK) == SS_ZEROPAGE)) {
+            budget -= calcVarSize(curSymbol);
+        }
+        curSymbol = curSymbol->next;
+    }
+    return budget;
+}
+
+void showPromotionReport(const PromotionResult *promoted, const PromotionResult *declOrder, int budget) {
+    printf("Zeropage promotion: %d vars (%d of %d bytes available)\n", promoted->numVars, promoted->size, budget);
+    printf("\testimated savings:  %5d bytes  %6d cycles\n", promoted->bytesSaved, promoted->cyclesSaved);
+    printf("\tdeclaration order: %5d bytes  %6d cycles  (%d vars)\n",
+           declOrder->bytesSaved, declOrder->cyclesSaved, declOrder->numVars);
+}
+
+/**
+ * Mark the most used global variables to be allocated in the zeropage
+ *
+ * @param symbolTable
+ */
+void promoteGlobalsToZeropage(const SymbolTable *symbolTable) {
+    SymbolRecord *candidates[MAX_PROMOTION_CANDIDATES];
+    int cntCandidates = 0;
+
+    int budget = calcZeropageBudget(symbolTable);
+    if (budget <= 0) return;
+
+    PromotionResult declOrder = {0, 0, 0, 0};
+    SymbolRecord *curSymbol = symbolTable->firstSymbol;
+    while (curSymbol != NULL) {
+        bool isDefaultStorage = ((curSymbol->flags & SS_STORAGE_MASK) == SS_NONE);
+        if (needsGlobalAllocation(curSymbol) && isDefaultStorage && (curSymbol->accessWeight > 0)) {
+
+            // what we'd get by filling the zeropage in declaration order
+            if (declOrder.size + calcVarSize(curSymbol) <= budget) addPromotionSavings(&declOrder, curSymbol);
+
+            if (cntCandidates < MAX_PROMOTION_CANDIDATES) candidates[cntCandidates++] = curSymbol;
+        }
+        curSymbol = curSymbol->next;
+    }
+
+    qsort(candidates, cntCandidates, sizeof(SymbolRecord *), cmp_usage);
+
+    PromotionResult promoted = {0, 0, 0, 0};
+    for_range(index, 0, cntCandidates) {
+        SymbolRecord *varSym = candidates[index];
+        if (promoted.size + calcVarSize(varSym) > budget) continue;
+
+        varSym->flags = (varSym->flags & ~SS_STORAGE_MASK) | SS_ZEROPAGE;
+        addPromotionSavings(&promoted, varSym);
+
+        if (compilerOptions.showVarAllocations) {
+            printf("\t%-32s promoted to zeropage (%d uses, weight %d)\n",
+                   varSym->name, varSym->cntAccesses, varSym->accessWeight);
+        }
+    }
+
+    if (compilerOptions.showGeneralInfo) showPromotionReport(&promoted, &declOrder, budget);
+}
+
+//-------------------------------------------------------------------
+//  Parameter passing convention
+//
+//   By default, params are pushed on the hardware stack by the caller and
+//   read back with TSX / LDA param,X by the function.  Instead, byte-sized
+//   params are stored by the caller directly into the function's local
+//   (statically allocated) frame.  One param can be passed in a register,
+//   which the function saves into its frame when it starts:
+//      Y - if the param is used as an array index (so it's already loaded)
+//      A - otherwise
+//
+//   Params stay on the stack for recursive functions (which need a copy per
+//   call), and when a call's arguments contain another function call (which
+//   could reuse the frame before the call is made).
+
+bool canPassInFrame(const SymbolRecord *paramSym) {
+    return (getBaseVarSize(paramSym) == 1) && !isPointer(paramSym) && !isArray(paramSym)
+           && !isStructDefined(paramSym) && (paramSym->hint == VH_NONE);
+}
+
+void assignFuncParamPassing(SymbolRecord *funcSym) {
+    SymbolList *funcParamList = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
+    if ((funcParamList == NULL) || (funcParamList->count == 0)) return;
+    if (FM_isRecursive(funcSym) || FM_hasCallsInArgs(funcSym)) return;
+
+    // leave the register assignments to the programmer, if there are any register hints
+    bool useRegister = true;
+    for_range(paramIdx, 0, funcParamList->count) {
+        if (funcParamList->list[paramIdx]->hint != VH_NONE) useRegister = false;
+    }
+
+    SymbolRecord *regParam = NULL;
+    bool changed = false;
+    for_range(paramIdx, 0, funcParamList->count) {
+        SymbolRecord *paramSym = funcParamList->list[paramIdx];
+        if (!canPassInFrame(paramSym)) continue;
+
+        // move the param out of the stack and into the local frame
+        paramSym->flags = (paramSym->flags & ~(MF_PARAM | SS_STORAGE_MASK)) | MF_FRAME_PARAM;
+        paramSym->location = -1;
+        changed = true;
+
+        bool isBetterRegParam = (regParam == NULL) || ((regParam->cntIndexUses == 0) && (paramSym->cntIndexUses > 0));
+        if (useRegister && isBetterRegParam) regParam = paramSym;
+    }
+    if (!changed) return;
+
+    if (regParam != NULL) {
+        regParam->hint = (regParam->cntIndexUses > 0) ? VH_Y_REG : VH_A_REG;
+    }
+
+    // any params left on the stack need their stack offsets redone
+    GS_FuncParamAlloc(funcSym);
+
+    if (compilerOptions.showVarAllocations) {
+        printf("\t%-32s params passed in its frame", funcSym->name);
+        if (regParam != NULL) printf(" (%s in %c)", regParam->name, getDestRegFromHint(regParam->hint));
+        printf("\n");
+    }
+}
+
+void assignParamPassing() {
+    for_range (idx, 0, cntDepthSymbols) {
+        SymbolRecord *funcSym = depthSymbolList[idx].symbol;
+        if (!isMainFunction(funcSym) && !isSystemFunction(funcSym)) {
+            assignFuncParamPassing(funcSym);
+        }
+    }
+}
+
+//-------------------------------------------------------------------
+//  Return convention
+//
+//   Functions returning a bool can return it in the carry flag (SEC/CLC + RTS)
+//   instead of in A, so a call used as a condition is just JSR + BCC/BCS.
+//   Leaf functions always do (with the optimizer on), and '-oc' turns it on
+//   for every bool function.  Functions with inline assembly keep returning
+//   in A, since the asm code could be loading the result itself, and so do
+//   functions in a function table (the caller doesn't know which one it got).
+
+void assignReturnConventions(const SymbolTable *symbolTable) {
+    // (not just the functions in depthSymbolList, since functions without locals count too)
+    for (SymbolRecord *funcSym = symbolTable->firstSymbol; funcSym != NULL; funcSym = funcSym->next) {
+        if (!isFunction(funcSym) || isMainFunction(funcSym) || isSystemFunction(funcSym)) continue;
+        if ((getType(funcSym) != ST_BOOL) || FM_hasAsmCode(funcSym) || FM_isTableTarget(funcSym)) continue;
+
+        FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+        bool isLeaf = (funcMapEntry == NULL) || (funcMapEntry->cntFuncsCalled == 0);
+        if (!isLeaf && !compilerOptions.returnBoolInCarry) continue;
+
+        funcSym->flags |= MF_CARRY_RETURN;
+        if (compilerOptions.showVarAllocations) {
+            printf("\t%-32s returns bool in carry\n", funcSym->name);
+        }
+    }
+}
+
+//-------------------------------------------------------------------
+
 /**
  * Allocate storage needed for each stack frame
  *
@@ -213,6 +500,34 @@ void allocateStackFrameStorage() {
     }
 }
 
+//-------------------------------------------------------------------
+
+bool hasWordVars(const SymbolTable *symbolTable) {
+    for (SymbolRecord *curSymbol = symbolTable->firstSymbol; curSymbol != NULL; curSymbol = curSymbol->next) {
+        if (isVariable(curSymbol) && (curSymbol->userTypeDef == NULL) && (getBaseVarSize(curSymbol) == 2)) {
+            return true;
+        }
+        if (isFunction(curSymbol) && (GET_LOCAL_SYMBOL_TABLE(curSymbol) != NULL)
+            && hasWordVars(GET_LOCAL_SYMBOL_TABLE(curSymbol))) return true;
+    }
+    return false;
+}
+
+/**
+ * Allocate the zeropage temps used for 16-bit expressions
+ *   (only needed if the program has 16-bit vars)
+ */
+void allocateTempPool(const SymbolTable *symbolTable) {
+    tempPoolAddr = 0;
+    tempPoolSize = 0;
+    if (hasWordVars(symbolTable) || hasPackedBools) {      // (packed bools are unpacked into a temp for ops)
+        MemoryAllocation tempAlloc = SMA_allocateMemory(SMA_getZeropageArea(), TEMP_POOL_SIZE);
+        tempPoolAddr = tempAlloc.addr;
+        tempPoolSize = TEMP_POOL_SIZE;
+    }
+    ICG_InitTempPool(tempPoolAddr, tempPoolSize);
+}
+
 void showVariableAllocations() {
     printf("\nSummary of Variable Allocation:\n");
     printf("\tGlobal Frame   allocated %2d bytes at %4X\n", globalSize, globalAddr);
@@ -222,6 +537,10 @@ void showVariableAllocations() {
         printf("\t Local Frame %d allocated %2d bytes at %4X\n", frmNum, stackSizes[frmNum], stackLocs[frmNum]);
         stackAddr = stackSizes[frmNum] + stackLocs[frmNum];
     }
+    if (tempPoolSize > 0) {
+        printf("\t   Temp Pool   allocated %2d bytes at %4X\n", tempPoolSize, tempPoolAddr);
+        stackAddr = tempPoolAddr + tempPoolSize;
+    }
 
     int callStackUsage = callStackDepth * 2;
     int callStackAddr = 0x100 - callStackUsage;
@@ -234,6 +553,40 @@ void showVariableAllocations() {
     printf("\n");
 }
 
+/**
+ * Check if the call stack has room for calls 'depth' levels deep
+ */
+bool canUseCallStackDepth(int depth) {
+    return (depth <= callStackDepth) || ((depth * 2) <= SMA_getStackSpace());
+}
+
+/**
+ * Make room on the call stack for calls added after allocation (see code_outline.c)
+ */
+void reserveCallStackDepth(int depth) {
+    if (depth > callStackDepth) callStackDepth = depth;
+}
+
+int getCallStackDepth() {
+    return callStackDepth;
+}
+
+/**
+ * Check the worst case stack use of the final code against the space left for it
+ *   (see stack_depth.c)
+ *
+ * @param stackBytes - most bytes the stack will ever hold
+ * @return false if the stack runs into the variables
+ */
+bool checkStackUsage(int stackBytes) {
+    int stackSpace = SMA_getStackSpace();
+    if (compilerOptions.showVarAllocations) {
+        printf("\tCall Stack   needs %2d bytes at %4X  (%d bytes free for it)\n",
+               stackBytes, SMA_getStackTop() - stackBytes, stackSpace);
+    }
+    return (stackBytes <= stackSpace);
+}
+
 /**
  * Allocate local variable using the provided memory location,
  *  then return the next available memory location
@@ -256,14 +609,18 @@ int allocateLocalVarStorage(const SymbolTable *symbolTable, int curMemloc) {
             int startLoc = curMemloc;
 
             unsigned int curStorage = (curSymbol->flags & SS_STORAGE_MASK);
-            if ((curStorage != SS_STACK) && (curSymbol->hint == VH_NONE)) {
+            // params passed in a register still get saved into the frame
+            if ((curStorage != SS_STACK) && ((curSymbol->hint == VH_NONE) || IS_FRAME_PARAM(curSymbol))) {
                 setSymbolLocation(curSymbol, curMemloc, SS_ZEROPAGE);       // TODO:  Locals are always stored in ZP (?)
                 int varSize = calcVarSize(curSymbol);
                 curMemloc += varSize;
 
             }
             if (compilerOptions.showVarAllocations) {
-                if (curSymbol->hint > VH_NONE) {
+                if (IS_FRAME_PARAM(curSymbol) && (curSymbol->hint > VH_NONE)) {
+                    printf("\t%-20s allocated at %4X (passed in register %c)\n",
+                           curSymbol->name, startLoc, getDestRegFromHint(curSymbol->hint));
+                } else if (curSymbol->hint > VH_NONE) {
                     printf("\t%-20s passed in register %c\n", curSymbol->name, getDestRegFromHint(curSymbol->hint));
                 } else if (curStorage != SS_STACK) {
                     printf("\t%-20s allocated at %4X\n", curSymbol->name, startLoc);
@@ -369,16 +726,30 @@ void calcLocalVarAllocs() {
 
 void generate_var_allocations(SymbolTable *symbolTable) {
     collectFunctionsInOrder(symbolTable);
+    GCT_CalcVarAccessWeights();
+
+    if (compilerOptions.runOptimizer) {
+        assignParamPassing();
+        assignReturnConventions(symbolTable);
+    }
+
+    // figure out the stack frame sizes first (so we know how much zeropage they need)
+    initStackFrames();
+    calcLocalVarAllocs();
 
     // allocate global variables
+    packBools(symbolTable);
+    if (compilerOptions.runOptimizer && !SMA_usesZeropageFirst()) {
+        promoteGlobalsToZeropage(symbolTable);
+    }
     globalAddr = 0x82;
     globalSize = allocateVarStorage(symbolTable);
+    placePackedBools(symbolTable);
 
     // now process all function local variables
-    initStackFrames();
-    calcLocalVarAllocs();
     allocateStackFrameStorage();
     allocateLocalVars();
+    allocateTempPool(symbolTable);
 
     if (compilerOptions.showVarAllocations)
         showVariableAllocations();
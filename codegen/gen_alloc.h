@@ -24,5 +24,9 @@
 #include <machine/mem.h>
 
 extern void generate_var_allocations(SymbolTable *symbolTable);
+extern bool canUseCallStackDepth(int depth);
+extern void reserveCallStackDepth(int depth);
+extern int getCallStackDepth();
+extern bool checkStackUsage(int stackBytes);
 
 #endif //MODULE_GEN_ALLOC_H
@@ -17,6 +17,7 @@
 //
 //  Generate a call tree for:
 //   - figuring out necessary stack space
+//   - counting how often global variables are accessed (for zeropage promotion)
 //
 // Created by admin on 10/17/2020.
 //
@@ -26,25 +27,162 @@
 #include "common/common.h"
 #include "gen_calltree.h"
 #include "data/func_map.h"
+#include "gen_specialize.h"
+#include "gen_hoist.h"
 
 static SymbolTable *mainSymTable;
 
+#define MAX_VAR_USAGES 1024
+#define LOOP_WEIGHT 8           // assume code in a loop runs this many more times
+#define MAX_LOOP_NESTING 3
+
+typedef struct {
+    SymbolRecord *funcSym;
+    SymbolRecord *varSym;
+    int cntAccesses;
+    int weight;                 // accesses weighted by loop nesting
+} VarUsage;
+
+static VarUsage varUsages[MAX_VAR_USAGES];
+static int cntVarUsages = 0;
+
+//-------------------------------------------------------------------------
+//  Track access to global variables
+//
+//  The function depth isn't known until the whole call tree is built,
+//   so usage is tracked per function, and totalled up later.
+
+void GCT_AddVarUsage(SymbolRecord *funcSym, SymbolRecord *varSym, int weight) {
+    for_range(index, 0, cntVarUsages) {
+        VarUsage *varUsage = &varUsages[index];
+        if ((varUsage->funcSym == funcSym) && (varUsage->varSym == varSym)) {
+            varUsage->cntAccesses++;
+            varUsage->weight += weight;
+            return;
+        }
+    }
+    if (cntVarUsages >= MAX_VAR_USAGES) return;
+
+    VarUsage *varUsage = &varUsages[cntVarUsages++];
+    varUsage->funcSym = funcSym;
+    varUsage->varSym = varSym;
+    varUsage->cntAccesses = 1;
+    varUsage->weight = weight;
+}
+
+void GCT_FindVarAccesses(List *stmt, SymbolRecord *srcFunc, int weight) {
+    SymbolTable *localSymTbl = (srcFunc != NULL) ? GET_LOCAL_SYMBOL_TABLE(srcFunc) : NULL;
+
+    for_range(nodeNum, 1, stmt->count) {
+        if (stmt->nodes[nodeNum].type != N_STR) continue;
+        char *name = stmt->nodes[nodeNum].value.str;
+
+        // local vars hide global vars
+        if ((localSymTbl != NULL) && (findSymbol(localSymTbl, name) != NULL)) continue;
+
+        SymbolRecord *varSym = findSymbol(mainSymTable, name);
+        if ((varSym != NULL) && isVariable(varSym) && !IS_LOCAL(varSym)) {
+            GCT_AddVarUsage(srcFunc, varSym, weight);
+        }
+    }
+}
+
+bool GCT_IsLoop(const List *stmt) {
+    ListNode opNode = stmt->nodes[0];
+    return isToken(opNode, PT_WHILE) || isToken(opNode, PT_DOWHILE)
+           || isToken(opNode, PT_FOR) || isToken(opNode, PT_LOOP);
+}
+
+/**
+ * Add up the variable accesses for each global variable
+ *
+ *  Functions deeper in the call tree are assumed to be called more often.
+ */
+void GCT_CalcVarAccessWeights() {
+    for_range(index, 0, cntVarUsages) {
+        VarUsage *varUsage = &varUsages[index];
+        SymbolRecord *funcSym = varUsage->funcSym;
+        if ((funcSym == NULL) || !IS_FUNC_USED(funcSym)) continue;
+
+        varUsage->varSym->cntAccesses += varUsage->cntAccesses;
+        varUsage->varSym->accessWeight += varUsage->weight * (1 + GET_FUNCTION_DEPTH(funcSym));
+    }
+}
+
+
+//-------------------------------------------------------------------------
+//  Track how params are used  (to decide how they get passed)
+
+void GCT_FindParamIndexUses(const List *stmt, SymbolRecord *srcFunc) {
+    // [lookup, arrayName, index]
+    if ((srcFunc == NULL) || !isToken(stmt->nodes[0], PT_LOOKUP) || (stmt->count < 3)) return;
+    if (stmt->nodes[2].type != N_STR) return;
+
+    SymbolTable *localSymTbl = GET_LOCAL_SYMBOL_TABLE(srcFunc);
+    if (localSymTbl == NULL) return;
+
+    SymbolRecord *paramSym = findSymbol(localSymTbl, stmt->nodes[2].value.str);
+    if ((paramSym != NULL) && IS_PARAM_VAR(paramSym)) {
+        paramSym->cntIndexUses++;
+    }
+}
+
+bool GCT_HasFuncCall(const List *expr) {
+    if (isToken(expr->nodes[0], PT_FUNC_CALL)) return true;
+    for_range(nodeNum, 0, expr->count) {
+        if ((expr->nodes[nodeNum].type == N_LIST) && GCT_HasFuncCall(expr->nodes[nodeNum].value.list)) return true;
+    }
+    return false;
+}
+
 
 //-------------------------------------------------------------------------
 //  Build a call tree to figure out function depths
 //
 //   {"SOURCE_FUNC", "DEST_FUNC"}
 
+/**
+ * Add a call thru a function table  (any of the functions in it could be called)
+ *
+ *   [funcCall, [lookup, tableName, index], params]
+ */
+void GCT_FindTableCalls(const List *stmt, SymbolRecord *srcFunc) {
+    const List *lookupExpr = stmt->nodes[1].value.list;
+    if (!isToken(lookupExpr->nodes[0], PT_LOOKUP) || (lookupExpr->nodes[1].type != N_STR)) return;
+
+    SymbolRecord *tableSym = findSymbol(mainSymTable, lookupExpr->nodes[1].value.str);
+    if ((tableSym == NULL) || !IS_FUNC_TABLE(tableSym) || (tableSym->astList == NULL)) return;
+    tableSym->cntAccesses++;
+
+    const List *funcList = tableSym->astList;
+    for_range(index, 1, funcList->count) {
+        if (funcList->nodes[index].type != N_STR) continue;
+        SymbolRecord *destFuncSym = findSymbol(mainSymTable, funcList->nodes[index].value.str);
+        if ((destFuncSym == NULL) || !isFunction(destFuncSym)) continue;
+
+        FM_addCallToMap(srcFunc, destFuncSym);
+        FM_markTableTarget(destFuncSym);
+    }
+}
+
 void GCT_FindFuncCalls(List *stmt, SymbolRecord *srcFunc) {
     // [if, expr, codeblock, codeblock]
     // [funcCall, name, params]
 
     ListNode opNode = stmt->nodes[0];
-    if (isToken(opNode, PT_FUNC_CALL)) {
+    if (isToken(opNode, PT_FUNC_CALL) && (stmt->nodes[1].type == N_LIST)) {
+        GCT_FindTableCalls(stmt, srcFunc);
+    } else if (isToken(opNode, PT_FUNC_CALL)) {
         char *destFuncName = stmt->nodes[1].value.str;
         SymbolRecord *destFuncSym = findSymbol(mainSymTable, destFuncName);
         if (destFuncSym) {
             FM_addCallToMap(srcFunc, destFuncSym);
+            GSP_AddCallSite(stmt, srcFunc, destFuncSym);
+
+            bool hasArgs = (stmt->count > 2) && (stmt->nodes[2].type == N_LIST);
+            if (hasArgs && GCT_HasFuncCall(stmt->nodes[2].value.list)) {
+                FM_markCallsInArgs(destFuncSym);
+            }
         } else {
             // TODO: figure out better error handling here
             //        This warning can be caused by local function pointer variable usage.
@@ -58,15 +196,22 @@ void GCT_FindFuncCalls(List *stmt, SymbolRecord *srcFunc) {
  * @param code
  * @param funcSym
  */
-void GCT_WalkCodeNodes(List *code, SymbolRecord *funcSym) {
+void GCT_WalkCodeNodes(List *code, SymbolRecord *funcSym, int loopNesting) {
+    if (isToken(code->nodes[0], PT_ASM)) FM_markAsmCode(funcSym);
     GCT_FindFuncCalls(code, funcSym);
+    GCT_FindParamIndexUses(code, funcSym);
+
+    int weight = 1;
+    for_range(level, 0, loopNesting) { weight *= LOOP_WEIGHT; }
+    GCT_FindVarAccesses(code, funcSym, weight);
 
     if (code->hasNestedList) {
+        if (GCT_IsLoop(code) && (loopNesting < MAX_LOOP_NESTING)) loopNesting++;
 
         // walk into any other nodes
         for_range(codeNodeNum, 1, code->count) {
             if (code->nodes[codeNodeNum].type == N_LIST)
-                GCT_WalkCodeNodes(code->nodes[codeNodeNum].value.list, funcSym);
+                GCT_WalkCodeNodes(code->nodes[codeNodeNum].value.list, funcSym, loopNesting);
         }
     }
 }
@@ -75,29 +220,36 @@ void GCT_WalkCodeNodes(List *code, SymbolRecord *funcSym) {
 void GCT_CodeBlock(List *code, SymbolRecord *funcSym) {
     if (code->count < 1) return;     // Exit if empty function
 
-    if (!isToken(code->nodes[0], PT_ASM)) {
+    if (isToken(code->nodes[0], PT_ASM)) {
+        FM_markAsmCode(funcSym);
+    } else {
         for_range(stmtNum, 1, code->count) {
             ListNode stmtNode = code->nodes[stmtNum];
             if (stmtNode.type == N_LIST) {
-                GCT_WalkCodeNodes(stmtNode.value.list, funcSym);
+                GCT_WalkCodeNodes(stmtNode.value.list, funcSym, 0);
             }
         }
     }
 }
 
 
-void GCT_Function(List *statement) {
+void GCT_Function(List *statement, bool hasDirective) {
     char *funcName = statement->nodes[1].value.str;
     if (statement->count >= 5) {
         ListNode codeNode = statement->nodes[5];
         if (codeNode.type == N_LIST) {
             SymbolRecord *funcSym = findSymbol(mainSymTable, funcName);
+            if (compilerOptions.runOptimizer && !hasDirective) {
+                GH_HoistLoopInvariants(codeNode.value.list, funcSym, mainSymTable);
+            }
+            GSP_AddFunctionDef(statement, funcSym, hasDirective);
             GCT_CodeBlock(codeNode.value.list, funcSym);
         }
     }
 }
 
 void GCT_Program(List *list) {
+    bool afterDirective = false;        // function could be marked as inline/always included
     for_range(stmtNum, 1, list->count) {
         ListNode stmt = list->nodes[stmtNum];
         if (stmt.type == N_LIST) {
@@ -105,9 +257,10 @@ void GCT_Program(List *list) {
             if (statement->nodes[0].type == N_TOKEN) {
                 enum ParseToken token = statement->nodes[0].value.parseToken;
                 switch (token) {
-                    case PT_FUNCTION:    GCT_Function(statement); break;
+                    case PT_FUNCTION:    GCT_Function(statement, afterDirective); break;
                     default: break;
                 }
+                afterDirective = (token == PT_DIRECTIVE);
             }
         }
     }
@@ -124,6 +277,11 @@ void generate_callTree(ListNode node, SymbolTable *symbolTable, bool isMain) {
 
     GCT_Program(program);
 
+    // clone functions called with constant args  (before figuring out the depths)
+    if (isMain && compilerOptions.runOptimizer) {
+        GSP_SpecializeFunctions(symbolTable);
+    }
+
     int callTreeDepth = FM_calculateCallTree();
     if ((callTreeDepth > compilerOptions.maxFuncCallDepth) && !hasWarnedAboutCallTreeDepth) {
         printf("WARNING: Call tree is very deep: %d (cur limit: %d) \n",
@@ -23,5 +23,7 @@
 #include "data/syntax_tree.h"
 
 extern void generate_callTree(ListNode node, SymbolTable *symbolTable, bool isMain);
+extern void GCT_CalcVarAccessWeights();
+extern void GCT_CodeBlock(List *code, SymbolRecord *funcSym);
 
 #endif //MODULE_GEN_CALLTREE_H
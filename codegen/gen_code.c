@@ -25,8 +25,11 @@
 #include "gen_code.h"
 #include "common/common.h"
 #include "data/symbols.h"
+#include "data/func_map.h"
 #include "cpu_arch/instrs.h"
 #include "cpu_arch/instrs_math.h"
+#include "cpu_arch/instrs_startup.h"
+#include "cpu_arch/instrs_dispatch.h"
 #include "eval_expr.h"
 #include "output/output_block.h"
 #include "common/tree_walker.h"
@@ -38,12 +41,21 @@
 #include "data/bank_layout.h"
 #include "cpu_arch/instrs_opt.h"
 #include "output/output_manager.h"
+#include "output/cycle_timing.h"
 #include "optimizer/optimizer.h"
+#include "gen_specialize.h"
+#include "gen_range.h"
+#include "gen_layout.h"
 
 //-------------------------------------------
 //  Variables used in code generation
 
 static bool reverseData;
+static bool isUnrollPending;    // set by '#unroll' for the next loop
+static bool unrollDisabled;     // set by '#unroll 0' to keep the next loop rolled up
+static int maxLoopsValue = -1;  // set by '#max_loops n' for the next loop  (-1 if not given)
+static int cycleBudgetValue;    // set by '#cycle_budget n' for the next function
+static SymbolRecord *curFuncSym;    // function currently being generated
 enum CompilerDirectiveTokens lastDirective;
 
 //--------------------------------------------------------
@@ -54,6 +66,9 @@ void GC_Statement(List *stmt);
 void GC_CodeBlock(List *code);
 void GC_FuncCall(const List *stmt, enum SymbolType destType);
 void GC_FuncCallExpression(const List *stmt, enum SymbolType destType);
+void GC_CondJump(ListNode condNode, Label *label, bool jumpIfTrue, int lineNum);
+enum SymbolType getSrcType(ListNode argNode, int lineNum);
+void GC_OP(const List *expr, enum MnemonicCode mne, enum SymbolType destType, enum MnemonicCode preOp);
 
 
 
@@ -70,6 +85,12 @@ void GC_LoadPrimitive(ListNode loadNode, enum SymbolType destType, int lineNum)
     int destSize = ((destType == ST_INT) || (destType == ST_PTR)) ? 2 : 1;
     if (loadNode.type == N_STR) {
         GC_LoadVar(loadNode, lineNum);
+
+        // byte values used as 16-bit values need a high byte of 0
+        SymbolRecord *varSym = lookupSymbolNode(loadNode, lineNum);
+        if ((destSize == 2) && (varSym != NULL) && !isArray(varSym) && (getBaseVarSize(varSym) == 1)) {
+            ICG_LoadRegConst('X', 0);
+        }
     } else if (loadNode.type == N_INT) {
         ICG_LoadConst(loadNode.value.num, destSize);
     } else {
@@ -123,6 +144,40 @@ void GC_LoadFromArray(const SymbolRecord *srcSym, enum SymbolType destType) {
     }
 }
 
+/**
+ * Check for an array index in the form (var * const) or (const * var)
+ *
+ * @param varNode - set to the node of the var being scaled
+ * @return scale of index (0 if not in that form)
+ */
+int getScaledIndex(const List *indexExpr, ListNode *varNode) {
+    if ((indexExpr->count != 3) || !isToken(indexExpr->nodes[0], PT_MULTIPLY)) return 0;
+
+    ListNode arg1 = indexExpr->nodes[1];
+    ListNode arg2 = indexExpr->nodes[2];
+    if ((arg1.type == N_INT) && (arg2.type == N_STR)) {
+        arg1 = indexExpr->nodes[2];
+        arg2 = indexExpr->nodes[1];
+    }
+    if ((arg1.type != N_STR) || (arg2.type != N_INT) || (arg2.value.num <= 0)) return 0;
+
+    *varNode = arg1;
+    return arg2.value.num;
+}
+
+/**
+ * Check if an index expression (var * const) is already in the Y register
+ *   (loop counter kept in Y, already scaled)
+ */
+bool isScaledLoopIndex(const List *indexExpr, int lineNum) {
+    ListNode varNode;
+    int scale = getScaledIndex(indexExpr, &varNode);
+    if (scale == 0) return false;
+
+    SymbolRecord *varSym = lookupSymbolNode(varNode, lineNum);
+    return (varSym != NULL) && ICG_IsLoopIndex(varSym, scale);
+}
+
 void GC_ArrayLookupWithExpr(const List *expr, const SymbolRecord *arraySymbol, ListNode indexNode, int destSize) {
     List *indexExpr = indexNode.value.list;
 
@@ -139,6 +194,9 @@ void GC_ArrayLookupWithExpr(const List *expr, const SymbolRecord *arraySymbol, L
             ICG_LoadIndexVar(arrayIndexSymbol, destSize);
             ICG_LoadIndexedWithOffset(arraySymbol, ofs, getBaseVarSize(arraySymbol));
         }
+    } else if (isScaledLoopIndex(indexExpr, expr->lineNum)) {
+        // Y already has the scaled loop counter
+        ICG_LoadIndexed(arraySymbol);
     } else {
         // handle normal (potentially complex) expression
 
@@ -275,6 +333,36 @@ int GC_GetArrayIndex(const SymbolRecord* arraySymbol, const List *expr) {
 //       Need to handle referencing struct pointer case.
 //       Need to produce better ASM source code.
 
+/**
+ * Set Y to index into an array of structs
+ *   (split arrays use the index as is, so no multiply is needed)
+ *
+ * @param preserveAcc - keep the value in the accumulator (when storing/comparing)
+ */
+void GC_LoadStructArrayIndex(const SymbolRecord *arraySym, ListNode indexNode, int lineNum, bool preserveAcc) {
+    char multiplier = (char) (getArrayIndexStride(arraySym) & 0x7f);
+    switch (indexNode.type) {
+        case N_INT:
+            ICG_LoadRegConst('Y', multiplier * (char) (indexNode.value.num));
+            break;
+        case N_STR: {
+            SymbolRecord *indexSym = lookupSymbolNode(indexNode, lineNum);
+            if (indexSym == NULL) return;
+            if (ICG_IsLoopIndex(indexSym, multiplier)) break;
+            if (multiplier > 1) {
+                if (preserveAcc) ICG_PushAcc();
+                ICG_MultiplyVarWithConst(indexSym, multiplier);
+                ICG_MoveAccToIndex('Y');
+                if (preserveAcc) ICG_PullAcc();
+            } else {
+                ICG_LoadRegVar(indexSym, 'Y');
+            }
+        } break;
+        default:
+            ErrorMessageWithNode("Invalid index for array of structs", indexNode, lineNum);
+    }
+}
+
 enum ParseToken GC_LoadAlias(const List *expr, SymbolRecord *structSymbol) {
     List *alias = structSymbol->alias;
 
@@ -292,11 +380,8 @@ enum ParseToken GC_LoadAlias(const List *expr, SymbolRecord *structSymbol) {
     switch (aliasType) {
         case PT_LOOKUP: {
             SymbolRecord *arraySymbol = lookupSymbolNode(alias->nodes[1], alias->lineNum);
-            SymbolRecord *indexSymbol = lookupSymbolNode(alias->nodes[2], alias->lineNum);
-
-            char multiplier = (char) calcVarSize(structSymbol);
-            ICG_MultiplyVarWithConst(indexSymbol, multiplier & 0x7f);
-            ICG_MoveAccToIndex('Y');
+            if (arraySymbol == NULL) break;
+            GC_LoadStructArrayIndex(arraySymbol, alias->nodes[2], alias->lineNum, false);
 
             // Make sure instruction generator knows the use, so we don't have to keep reloading
             ICG_Tag('Y', structSymbol);
@@ -346,19 +431,10 @@ void GC_LoadPropertyRefWithLookup(const List *expr, enum SymbolType destType) {
     }
 
     // Now we can get down to business!
-    int propertyOffset = GET_PROPERTY_OFFSET(propertySymbol);
-    char multiplier = (char) (getBaseVarSize(structSymbol) & 0x7f);
+    int propertyOffset = getArrayPropertyOffset(structSymbol, GET_PROPERTY_OFFSET(propertySymbol));
 
     //--- set Y to be an index into struct array
-    if (indexNode.type == N_STR) {
-        SymbolRecord *indexSymbol = lookupSymbolNode(indexNode, lookupExpr->lineNum);
-
-        ICG_MultiplyVarWithConst(indexSymbol, multiplier);
-        ICG_MoveAccToIndex('Y');
-    } else if (indexNode.type == N_INT) {
-        char value = multiplier * (char)(indexNode.value.num);
-        ICG_LoadRegConst('Y', value);
-    }
+    GC_LoadStructArrayIndex(structSymbol, indexNode, lookupExpr->lineNum, false);
 
     ICG_LoadIndexedWithOffset(structSymbol, propertyOffset, getBaseVarSize(propertySymbol));
 }
@@ -417,7 +493,8 @@ void GC_LoadPropertyRef(const List *expr, enum SymbolType destType) {
         SymbolRecord *baseSymbol = GC_GetAliasBase(expr, structSymbol, aliasType);
         if (baseSymbol != NULL) {
             if (aliasType == PT_LOOKUP) {
-                ICG_LoadIndexedWithOffset(baseSymbol, propertyOffset, getBaseVarSize(propertySymbol));
+                ICG_LoadIndexedWithOffset(baseSymbol, getArrayPropertyOffset(baseSymbol, propertyOffset),
+                                          getBaseVarSize(propertySymbol));
             } else {
                 ICG_LoadPropertyVar(baseSymbol, propertySymbol);
             }
@@ -441,7 +518,9 @@ void GC_SimpleOP(const List *expr, enum MnemonicCode mne, enum SymbolType destTy
     switch (arg.type) {
         case N_STR: {
             SymbolRecord *varSym = lookupSymbolNode(arg, expr->lineNum);
-            if (varSym != NULL) {
+            if ((varSym != NULL) && IS_PACKED_BOOL(varSym)) {
+                ErrorMessage("Cannot increment or decrement packed bool", varSym->name, expr->lineNum);
+            } else if (varSym != NULL) {
                 int destSize = (destType == ST_INT || destType == ST_PTR) ? 2 : 1;
                 ICG_OpWithVar(mne, varSym, destSize);
             }
@@ -532,9 +611,237 @@ bool isSimpleArg(ListNode arg1) {
     return ((arg1.type == N_INT) || (arg1.type == N_STR)) || isSimplePropertyRef(arg1);
 }
 
+//---------------------------------------------------------------------
+//--- 16-bit ops
+//
+//  16-bit values are worked out in A (low byte) and X (high byte), with
+//  the carry chained from the low byte into the high byte.  When both sides
+//  of an op are expressions, one side is worked out first into a temp from
+//  the zeropage temp pool.
+
+/**
+ * Get the size (in bytes) of the value of a node
+ */
+int getNodeSize(ListNode node, int lineNum) {
+    switch (node.type) {
+        case N_INT:
+            return ((node.value.num > 255) || (node.value.num < -128)) ? 2 : 1;
+        case N_STR: {
+            SymbolRecord *varSym = lookupSymbolNode(node, lineNum);
+            return ((varSym != NULL) && !isArray(varSym) && (varSym->userTypeDef == NULL))
+                       ? getBaseVarSize(varSym) : 1;
+        }
+        case N_LIST: {
+            List *expr = node.value.list;
+            EvalResult evalResult = evaluate_expression(expr);
+            if (evalResult.hasResult) return getNodeSize(createIntNode(evalResult.value), lineNum);
+
+            if (expr->nodes[0].type != N_TOKEN) return 1;
+            switch (expr->nodes[0].value.parseToken) {
+                case PT_ADD: case PT_SUB:
+                case PT_BIT_AND: case PT_BIT_OR: case PT_BIT_EOR: {
+                    int size1 = getNodeSize(expr->nodes[1], lineNum);
+                    int size2 = getNodeSize(expr->nodes[2], lineNum);
+                    return (size1 > size2) ? size1 : size2;
+                }
+                case PT_SHIFT_LEFT: case PT_SHIFT_RIGHT:
+                    return getNodeSize(expr->nodes[1], lineNum);
+                case PT_LOOKUP: {
+                    SymbolRecord *arraySym = lookupSymbolNode(expr->nodes[1], lineNum);
+                    return ((arraySym != NULL) && (arraySym->userTypeDef == NULL)) ? getBaseVarSize(arraySym) : 1;
+                }
+                default:
+                    return 1;
+            }
+        }
+        default:
+            return 1;
+    }
+}
+
+bool isWordSized(enum SymbolType destType) {
+    return (destType == ST_INT) || (destType == ST_PTR);
+}
+
+/**
+ * Check if a node can be used directly as an operand of a 16-bit op
+ */
+bool isWordOperandNode(ListNode node, int lineNum) {
+    if (node.type == N_INT) return true;
+    if (node.type == N_LIST) return evaluate_expression(node.value.list).hasResult;
+    if (node.type != N_STR) return false;
+
+    SymbolRecord *varSym = lookupSymbolNode(node, lineNum);
+    return (varSym != NULL) && !isArray(varSym) && (varSym->userTypeDef == NULL)
+           && !IS_PARAM_VAR(varSym) && (varSym->hint == VH_NONE);
+}
+
+WordOperand getWordOperand(ListNode node, int lineNum) {
+    WordOperand operand = {NULL, 0, false};
+    if (node.type == N_STR) {
+        operand.varSym = lookupSymbolNode(node, lineNum);
+    } else if (node.type == N_INT) {
+        operand.value = node.value.num;
+    } else if (node.type == N_LIST) {
+        operand.value = evaluate_expression(node.value.list).value;
+    }
+    return operand;
+}
+
+WordOperand getTempOperand(int tempAddr) {
+    WordOperand operand = {NULL, tempAddr, true};
+    return operand;
+}
+
+int GC_AllocTemp(int size, int lineNum) {
+    int tempAddr = ICG_AllocTemp(size);
+    if (tempAddr < 0) {
+        ErrorMessage("16-bit expression is too complex", "out of zeropage temps", lineNum);
+        return 0;
+    }
+    return tempAddr;
+}
+
+/**
+ * Load a value into A/X  (byte values get a high byte of 0)
+ */
+void GC_LoadWord(ListNode node, enum SymbolType destType, int lineNum) {
+    GC_HandleLoad(node, destType, lineNum);
+    if ((node.type == N_LIST) && isToken(node.value.list->nodes[0], PT_LOOKUP)
+        && (getNodeSize(node, lineNum) == 1)) {
+        ICG_LoadRegConst('X', 0);
+    }
+}
+
+/**
+ * Load a value into a temp  (so it can be used as an operand)
+ *
+ * NOTE: The temp needs to be freed by the caller
+ */
+WordOperand GC_LoadWordIntoTemp(ListNode node, enum SymbolType destType, int lineNum) {
+    int tempAddr = GC_AllocTemp(2, lineNum);
+    GC_LoadWord(node, destType, lineNum);
+    ICG_StoreToAddr(tempAddr, 2);
+    return getTempOperand(tempAddr);
+}
+
+/**
+ * Do a 16-bit op with an operand, freeing up the temp if needed
+ */
+void GC_OpWord(enum MnemonicCode mne, WordOperand operand, enum MnemonicCode preOp, int lineNum) {
+    bool needsTemp = !operand.isTemp && !ICG_IsWordHighByteZero(operand);
+    int tempAddr = needsTemp ? GC_AllocTemp(1, lineNum) : 0;
+
+    ICG_PreOp(preOp);
+    ICG_OpWord(mne, operand, tempAddr);
+
+    if (needsTemp) ICG_FreeTemp(1);
+}
+
+/**
+ * Check if a 16-bit op can be done in 8 bits  (the args and the result always fit in a byte)
+ */
+bool isByteSizedWordOp(const List *expr) {
+    return VR_FitsInByte(VR_GetNodeRange(createListNode((List *)expr), expr->lineNum))
+           && VR_FitsInByte(VR_GetNodeRange(expr->nodes[1], expr->lineNum))
+           && VR_FitsInByte(VR_GetNodeRange(expr->nodes[2], expr->lineNum));
+}
+
+void GC_WordOP(const List *expr, enum MnemonicCode mne, enum SymbolType destType, enum MnemonicCode preOp) {
+    ListNode arg1 = expr->nodes[1];
+    ListNode arg2 = expr->nodes[2];
+
+    if (isByteSizedWordOp(expr)) {
+        GC_OP(expr, mne, ST_CHAR, preOp);
+        ICG_LoadRegConst('X', 0);
+        return;
+    }
+
+    // keep the simple arg as the operand, if the order doesn't matter
+    bool isInterchangeableOp = ((mne == AND) || (mne == ORA) || (mne == EOR) || (mne == ADC));
+    if (isInterchangeableOp && !isWordOperandNode(arg2, expr->lineNum) && isWordOperandNode(arg1, expr->lineNum)) {
+        ListNode temp = arg1;
+        arg1 = arg2;
+        arg2 = temp;
+    }
+
+    if (isWordOperandNode(arg2, expr->lineNum)) {
+        GC_LoadWord(arg1, destType, expr->lineNum);
+        GC_OpWord(mne, getWordOperand(arg2, expr->lineNum), preOp, expr->lineNum);
+    } else {
+        // both args are expressions... work out the second one first
+        WordOperand tempOperand = GC_LoadWordIntoTemp(arg2, destType, expr->lineNum);
+        GC_LoadWord(arg1, destType, expr->lineNum);
+        GC_OpWord(mne, tempOperand, preOp, expr->lineNum);
+        ICG_FreeTemp(2);
+    }
+}
+
+/**
+ * Handle an assignment of a 16-bit op on two simple args  (ex: score = score + points)
+ *   by storing each byte of the result directly, instead of going thru A/X.
+ *
+ * @return true if the assignment was handled
+ */
+bool GC_WordOpToVar(const SymbolRecord *destVar, ListNode loadNode, int lineNum) {
+    if ((loadNode.type != N_LIST) || isArray(destVar) || (destVar->userTypeDef != NULL)) return false;
+    if (IS_PARAM_VAR(destVar) || (destVar->hint != VH_NONE)) return false;
+
+    List *expr = loadNode.value.list;
+    if ((expr->count < 3) || (expr->nodes[0].type != N_TOKEN)) return false;
+    if (evaluate_expression(expr).hasResult) return false;
+
+    enum MnemonicCode mne, preOp = MNE_NONE;
+    switch (expr->nodes[0].value.parseToken) {
+        case PT_ADD:     mne = ADC; preOp = CLC; break;
+        case PT_SUB:     mne = SBC; preOp = SEC; break;
+        case PT_BIT_AND: mne = AND; break;
+        case PT_BIT_OR:  mne = ORA; break;
+        case PT_BIT_EOR: mne = EOR; break;
+        default: return false;
+    }
+
+    if (!isWordOperandNode(expr->nodes[1], lineNum) || !isWordOperandNode(expr->nodes[2], lineNum)) return false;
+    if (isByteSizedWordOp(expr)) return false;
+
+    ICG_PreOp(preOp);
+    ICG_OpWordToVar(mne, getWordOperand(expr->nodes[1], lineNum), getWordOperand(expr->nodes[2], lineNum), destVar);
+    return true;
+}
+
+
+/**
+ * Check if a mask can't clear any bits of a value  (ex: enum with values 0-3, masked with 0x0F)
+ */
+bool isMaskNoOp(ListNode valueNode, ListNode maskNode, int destSize, int lineNum) {
+    ValueRange maskRange = VR_GetNodeRange(maskNode, lineNum);
+    ValueRange valueRange = VR_GetNodeRange(valueNode, lineNum);
+    if ((maskRange.min != maskRange.max) || (valueRange.min < 0)) return false;
+
+    int mask = maskRange.min | ((destSize == 1) ? ~0xff : ~0xffff);
+    return ((VR_GetPossibleBits(valueRange) & ~mask) == 0);
+}
+
 void GC_OP(const List *expr, enum MnemonicCode mne, enum SymbolType destType, enum MnemonicCode preOp) {
     int destSize = (destType == ST_INT || destType == ST_PTR) ? 2 : 1;
 
+    if (mne == AND) {
+        ListNode maskedNode = {N_EMPTY};
+        if (isMaskNoOp(expr->nodes[1], expr->nodes[2], destSize, expr->lineNum)) maskedNode = expr->nodes[1];
+        if (isMaskNoOp(expr->nodes[2], expr->nodes[1], destSize, expr->lineNum)) maskedNode = expr->nodes[2];
+        if (maskedNode.type != N_EMPTY) {
+            IL_SetLineComment("mask not needed");
+            GC_LoadWord(maskedNode, destType, expr->lineNum);
+            return;
+        }
+    }
+
+    bool isWordOp = ((mne == ADC) || (mne == SBC) || (mne == AND) || (mne == ORA) || (mne == EOR));
+    if ((destSize == 2) && isWordOp) {
+        GC_WordOP(expr, mne, destType, preOp);
+        return;
+    }
+
     ListNode arg1 = expr->nodes[1];
     ListNode arg2 = expr->nodes[2];
 
@@ -581,7 +888,8 @@ void GC_OP(const List *expr, enum MnemonicCode mne, enum SymbolType destType, en
             enum ParseToken aliasType = GC_LoadAlias(propertyRef, structSymbol);
             SymbolRecord *baseSymbol = GC_GetAliasBase(expr, structSymbol, aliasType);
             if (aliasType == PT_LOOKUP) {
-                ICG_OpIndexedWithOffset(mne, baseSymbol, GET_PROPERTY_OFFSET(propertySymbol));
+                ICG_OpIndexedWithOffset(mne, baseSymbol,
+                                        getArrayPropertyOffset(baseSymbol, GET_PROPERTY_OFFSET(propertySymbol)));
             } else {
                 ICG_OpPropertyVar(mne, baseSymbol, propertySymbol);
             }
@@ -629,11 +937,40 @@ void GC_Or(const List *expr, enum SymbolType destType)  { GC_OP(expr, ORA, destT
 void GC_Eor(const List *expr, enum SymbolType destType) { GC_OP(expr, EOR, destType, MNE_NONE); }
 void GC_Add(const List *expr, enum SymbolType destType) { GC_OP(expr, ADC, destType, CLC); }
 void GC_Sub(const List *expr, enum SymbolType destType) { GC_OP(expr, SBC, destType, SEC); }
-void GC_BoolAnd(const List *expr, enum SymbolType destType) { GC_OP(expr, AND, destType, MNE_NONE); }
-void GC_BoolOr(const List *expr, enum SymbolType destType) { GC_OP(expr, ORA, destType, MNE_NONE); }
+
+/**
+ * Boolean ops used as a value  (ex: flag = a > b && c)
+ *
+ * Uses the same jump code as conditionals, so that any part of the
+ *   expression that can't change the result is never evaluated.
+ */
+void GC_BoolValue(const List *expr, enum SymbolType destType) {
+    Label *falseLabel = newGenericLabel(LBL_CODE);
+    GC_CondJump(createListNode((List *)expr), falseLabel, false, expr->lineNum);
+    ICG_LoadBoolFromJumps(falseLabel);
+
+    if ((destType == ST_INT) || (destType == ST_PTR)) {
+        ICG_LoadRegConst('X', 0);
+    }
+}
+
+void GC_BoolAnd(const List *expr, enum SymbolType destType) { GC_BoolValue(expr, destType); }
+void GC_BoolOr(const List *expr, enum SymbolType destType) { GC_BoolValue(expr, destType); }
+
+bool isBoolOpNode(ListNode node) {
+    if (node.type != N_LIST) return false;
+    ListNode opNode = node.value.list->nodes[0];
+    return (opNode.type == N_TOKEN)
+           && (isToken(opNode, PT_BOOL_AND) || isToken(opNode, PT_BOOL_OR) || isToken(opNode, PT_NOT)
+               || isComparisonToken(opNode.value.parseToken));
+}
 
 void GC_Not(const List *expr, enum SymbolType destType) {
     ListNode notNode = expr->nodes[1];
+    if (isBoolOpNode(notNode)) {
+        GC_BoolValue(expr, destType);
+        return;
+    }
     if (notNode.type == N_STR) {
         SymbolRecord *varSym = lookupSymbolNode(notNode, expr->lineNum);
         if (varSym != NULL && getType(varSym) == ST_BOOL) {
@@ -667,7 +1004,30 @@ SymbolRecord *getShiftDestSym(ListNode varNode, int lineNum) {
     return result;
 }
 
+/**
+ * Shift a 16-bit value in A/X
+ */
+void GC_ShiftWord(const List *expr, enum MnemonicCode mne, enum SymbolType destType) {
+    ListNode countNode = expr->nodes[2];
+    if (!isGoodShiftCount(countNode)) {
+        ErrorMessageWithList("Unsupported form of 16-bit shift: ", expr);
+        return;
+    }
+
+    bool isSigned = (getSrcType(expr->nodes[1], expr->lineNum) & ST_SIGNED);
+    GC_LoadWord(expr->nodes[1], destType, expr->lineNum);
+
+    int tempAddr = GC_AllocTemp(1, expr->lineNum);
+    ICG_ShiftWord(mne, countNode.value.num, isSigned, tempAddr);
+    ICG_FreeTemp(1);
+}
+
 void GC_ShiftLeft(const List *expr, enum SymbolType destType) {
+    if (isWordSized(destType)) {
+        GC_ShiftWord(expr, ASL, destType);
+        return;
+    }
+
     SymbolRecord *shiftDest = getShiftDestSym(expr->nodes[1], expr->lineNum);
 
     ListNode countNode = expr->nodes[2];
@@ -679,6 +1039,11 @@ void GC_ShiftLeft(const List *expr, enum SymbolType destType) {
 }
 
 void GC_ShiftRight(const List *expr, enum SymbolType destType) {
+    if (isWordSized(destType)) {
+        GC_ShiftWord(expr, LSR, destType);
+        return;
+    }
+
     SymbolRecord *shiftDest = getShiftDestSym(expr->nodes[1], expr->lineNum);
     ListNode countNode = expr->nodes[2];
     if (isGoodShiftCount(countNode)) {
@@ -707,7 +1072,9 @@ bool GC_SimpleModifyOp(enum MnemonicCode mne, const List *stmt, enum SymbolType
         // This is generally an INC/DEC op with a variable
 
         SymbolRecord *varSym = lookupSymbolNode(arg, stmt->lineNum);
-        if (varSym != NULL) {
+        if ((varSym != NULL) && IS_PACKED_BOOL(varSym)) {
+            ErrorMessage("Cannot increment or decrement packed bool", varSym->name, stmt->lineNum);
+        } else if (varSym != NULL) {
             ICG_OpWithVar(mne, varSym, getBaseVarSize(varSym));
         }
     }
@@ -743,6 +1110,10 @@ void GC_HandleBranchOp(ListNode opNode, const Label *skipLabel, bool isCmpToZero
         case PT_EQ: ICG_Branch(BNE, skipLabel); break;
         case PT_NE: ICG_Branch(BEQ, skipLabel); break;
         case PT_LTE: {
+            if (isCmpToZeroR && !isSignedCmp) {
+                ICG_Branch(BNE, skipLabel);     // no CMP done, so carry is not set up
+                break;
+            }
             Label *contLabel = newGenericLabel(LBL_CODE);
             ICG_Branch(BEQ, contLabel);
             if (isSignedCmp) {
@@ -815,7 +1186,9 @@ void GC_AddrOf(const List *expr, enum SymbolType destType) {
         ErrorMessageWithList("Expression not allowed with Address Of operator", expr);
     } else if (addrNode.type == N_STR) {
         SymbolRecord *varSym = lookupSymbolNode(addrNode, expr->lineNum);
-        if (varSym != NULL) {
+        if ((varSym != NULL) && IS_PACKED_BOOL(varSym)) {
+            ErrorMessage("Cannot take the address of packed bool", varSym->name, expr->lineNum);
+        } else if (varSym != NULL) {
             ICG_LoadAddr(varSym);
         }
     }
@@ -826,6 +1199,13 @@ void GC_AddrOf(const List *expr, enum SymbolType destType) {
 
 void GC_CompareOp(const List *expr, enum SymbolType destType) {
     ListNode opNode = expr->nodes[0];
+
+    // 16-bit compares are done as jumps
+    if ((getNodeSize(expr->nodes[1], expr->lineNum) == 2) || (getNodeSize(expr->nodes[2], expr->lineNum) == 2)) {
+        GC_BoolValue(expr, destType);
+        return;
+    }
+
     Label *skipLabel = newGenericLabel(LBL_CODE);
 
     // TODO: maybe need to do something different if 16-bit operation
@@ -1041,28 +1421,9 @@ void GC_StoreToStructProperty(const List *expr) {
     }
 
     /// Handle indexing necessary for array of structs
+    // TODO:  Find a way to compute the index before the assignment expression is processed.
     if (isInArray) {
-        ListNode indexNode = structLookup->nodes[2];
-        char multiplier = (char) (getBaseVarSize(structSym) & 0x7f);
-        switch (indexNode.type) {
-            case N_INT: {
-                char value = multiplier * (char) (indexNode.value.num);
-                ICG_LoadRegConst('Y', value);
-                break;
-            }
-            case N_STR: {
-                SymbolRecord *indexSym = lookupSymbolNode(indexNode, expr->lineNum);
-                // TODO:  Find a way to compute this before the assignment expression is processed.
-                if (multiplier > 1) {
-                    ICG_PushAcc();
-                    ICG_MultiplyVarWithConst(indexSym, multiplier);
-                    ICG_MoveAccToIndex('Y');
-                    ICG_PullAcc();
-                } else {
-                    ICG_LoadRegVar(indexSym, 'Y');
-                }
-            } break;
-        }
+        GC_LoadStructArrayIndex(structSym, structLookup->nodes[2], expr->lineNum, true);
     }
 
     int propertyOffset = GET_PROPERTY_OFFSET(propertySym);
@@ -1072,14 +1433,16 @@ void GC_StoreToStructProperty(const List *expr) {
         enum ParseToken aliasType = GC_LoadAlias(expr, structSym);
         SymbolRecord *baseSymbol = GC_GetAliasBase(expr, structSym, aliasType);
         if (aliasType == PT_LOOKUP) {
-            ICG_StoreIndexedWithOffset(baseSymbol, propertyOffset, getBaseVarSize(propertySym));
+            ICG_StoreIndexedWithOffset(baseSymbol, getArrayPropertyOffset(baseSymbol, propertyOffset),
+                                       getBaseVarSize(propertySym));
         } else if (aliasType == PT_INIT) {
             ICG_StoreVarOffset(baseSymbol, propertyOffset, getBaseVarSize(propertySym));
         }
 
     } else {
         if (isInArray) {
-            ICG_StoreIndexedWithOffset(structSym, propertyOffset, getBaseVarSize(propertySym));
+            ICG_StoreIndexedWithOffset(structSym, getArrayPropertyOffset(structSym, propertyOffset),
+                                       getBaseVarSize(propertySym));
         } else {
             ICG_StoreVarOffset(structSym, propertyOffset, getBaseVarSize(propertySym));
         }
@@ -1143,6 +1506,11 @@ void GC_StoreToArray(const List *expr) {
 
     } else if (expr->nodes[2].type == N_LIST) {
         List *arrayIndexExpr = expr->nodes[2].value.list;
+        if (!isPointerAccessedAsArray && isScaledLoopIndex(arrayIndexExpr, expr->lineNum)) {
+            ICG_StoreVarIndexed(arraySym);
+            return;
+        }
+
         ListNode arg1 = arrayIndexExpr->nodes[1];
         ListNode arg2 = arrayIndexExpr->nodes[2];
 
@@ -1227,6 +1595,7 @@ void GC_ExpressionForStore(const List *expr, enum SymbolType destType) {
             case PT_LOOKUP:        GC_StoreToArray(expr);           break;
             case PT_INC:           GC_Inc(expr, ST_NONE);           break;
             case PT_DEC:           GC_Dec(expr, ST_NONE);           break;
+            default: break;
         }
     } else {
         ErrorMessageWithNode("Invalid token in assignment expr\n", expr->nodes[0], expr->lineNum);
@@ -1289,8 +1658,61 @@ void GC_Strobe(const List *stmt, enum SymbolType destType) {
     }
 }
 
+/**
+ * Is this expression a call to a function that returns its bool in the carry flag?
+ */
+bool isCarryReturnCall(const List *expr) {
+    if (!isToken(expr->nodes[0], PT_FUNC_CALL) || (expr->nodes[1].type != N_STR)) return false;
+    SymbolRecord *funcSym = lookupFunctionSymbolByNameNode(expr->nodes[1], expr->lineNum);
+    return (funcSym != NULL) && IS_CARRY_RETURN(funcSym);
+}
+
+/**
+ * Set the carry flag to the bool being returned
+ */
+void GC_ReturnInCarry(ListNode returnExprNode, int lineNum) {
+    if (returnExprNode.type == N_INT) {
+        IL_AddInstrB((returnExprNode.value.num != 0) ? SEC : CLC);
+        return;
+    }
+
+    // byte var:  CMP #1 sets the carry if it's not zero
+    if (returnExprNode.type == N_STR) {
+        SymbolRecord *varSym = lookupSymbolNode(returnExprNode, lineNum);
+        if (varSym == NULL) return;
+        if (IS_PACKED_BOOL(varSym)) {
+            ICG_PackedBoolToCarry(varSym);
+            return;
+        }
+        if (getBaseVarSize(varSym) == 1) {
+            ICG_LoadVar(varSym);
+            ICG_CompareConst(1);
+            return;
+        }
+    }
+
+    // result of the call is already in the carry
+    if ((returnExprNode.type == N_LIST) && isCarryReturnCall(returnExprNode.value.list)) {
+        GC_FuncCall(returnExprNode.value.list, ST_BOOL);
+        return;
+    }
+
+    Label *falseLabel = newGenericLabel(LBL_CODE);
+    GC_CondJump(returnExprNode, falseLabel, false, lineNum);
+    IL_AddInstrB(SEC);
+    ICG_Return();
+    IL_Label(falseLabel);
+    IL_AddInstrB(CLC);
+}
+
 void GC_Return(const List *stmt, enum SymbolType destType) {
     ListNode returnExprNode = stmt->nodes[1];
+    if ((curFuncSym != NULL) && IS_CARRY_RETURN(curFuncSym)) {
+        GC_ReturnInCarry(returnExprNode, stmt->lineNum);
+        ICG_Return();
+        return;
+    }
+
     switch (returnExprNode.type) {
         case N_LIST: GC_Expression(returnExprNode.value.list, destType); break;
         case N_STR:  ICG_LoadVar(lookupSymbolNode(returnExprNode, stmt->lineNum)); break;
@@ -1316,7 +1738,7 @@ enum SymbolType getSrcType(const ListNode argNode, int lineNum) {
 
         case N_STR:
             varSym = lookupSymbolNode(argNode, lineNum);
-            if (varSym) srcType = getType(varSym);
+            if (varSym) srcType = getType(varSym) | (varSym->flags & ST_SIGNED);
             break;
 
         default:break;
@@ -1374,20 +1796,7 @@ void GC_CompareToStructProperty(const List *expr) {
 
     /// Handle indexing necessary for array of structs
     if (isInArray) {
-        ListNode indexNode = structLookup->nodes[2];
-        char multiplier = (char) (getBaseVarSize(structSym) & 0x7f);
-        switch (indexNode.type) {
-            case N_INT: {
-                char value = multiplier * (char) (indexNode.value.num);
-                ICG_LoadRegConst('Y', value);
-                break;
-            }
-            case N_STR: {
-                // TODO:  Add multiplier logic here
-                SymbolRecord *indexSym = lookupSymbolNode(indexNode, expr->lineNum);
-                ICG_LoadRegVar(indexSym, 'Y');
-            } break;
-        }
+        GC_LoadStructArrayIndex(structSym, structLookup->nodes[2], expr->lineNum, true);
     }
 
     int propertyOffset = GET_PROPERTY_OFFSET(propertySym);
@@ -1397,14 +1806,16 @@ void GC_CompareToStructProperty(const List *expr) {
         enum ParseToken aliasType = GC_LoadAlias(expr, structSym);
         SymbolRecord *baseSymbol = GC_GetAliasBase(expr, structSym, aliasType);
         if (aliasType == PT_LOOKUP) {
-            ICG_CompareIndexedWithOffset(baseSymbol, propertyOffset, getBaseVarSize(propertySym));
+            ICG_CompareIndexedWithOffset(baseSymbol, getArrayPropertyOffset(baseSymbol, propertyOffset),
+                                         getBaseVarSize(propertySym));
         } else if (aliasType == PT_INIT) {
             ICG_CompareVarOffset(baseSymbol, propertyOffset, getBaseVarSize(propertySym));
         }
 
     } else {
         if (isInArray) {
-            ICG_CompareIndexedWithOffset(structSym, propertyOffset, getBaseVarSize(propertySym));
+            ICG_CompareIndexedWithOffset(structSym, getArrayPropertyOffset(structSym, propertyOffset),
+                                         getBaseVarSize(propertySym));
         } else {
             ICG_CompareVarOffset(structSym, propertyOffset, getBaseVarSize(propertySym));
         }
@@ -1441,53 +1852,97 @@ void GC_Compare(ListNode arg, int lineNum) {
 
 
 
-void GC_HandleSubCondExpr(const ListNode ifExprNode, enum SymbolType destType, Label *skipLabel, int lineNum) {
-    if (ifExprNode.type == N_LIST) {
-        List *expr = ifExprNode.value.list;
-        ListNode opNode = expr->nodes[0];
-        ListNode arg1 = expr->nodes[1];
-        ListNode arg2 = expr->nodes[2];
-
-        if (opNode.type == N_TOKEN) {
-
-            // optimizations for booleans
-            if (opNode.value.parseToken == PT_BOOL_AND) {
+/**
+ * Handle a compare where either side is a 16-bit value
+ *   (branches to skipLabel when the compare is false)
+ */
+void GC_HandleWordCompareOp(enum ParseToken opToken, ListNode arg1, ListNode arg2, const Label *skipLabel,
+                            int lineNum) {
+    bool isSignedCmp = (getExprType(arg1, arg2, lineNum) & ST_SIGNED);
+    int maxValue = isSignedCmp ? 0x7fff : 0xffff;
+
+    // only LT and GTE can be done with a single subtract...
+    //   so use (a >= c+1) for (a > c), or swap the sides around.
+    if ((opToken == PT_GT) || (opToken == PT_LTE)) {
+        bool isConstArg2 = isWordOperandNode(arg2, lineNum) && (arg2.type != N_STR);
+        int value = getWordOperand(arg2, lineNum).value;
+        if (isConstArg2 && (value < maxValue)) {
+            arg2 = createIntNode(value + 1);
+            opToken = (opToken == PT_GT) ? PT_GTE : PT_LT;
+        } else {
+            ListNode temp = arg1;
+            arg1 = arg2;
+            arg2 = temp;
+            opToken = (opToken == PT_GT) ? PT_LT : PT_GTE;
+        }
+    }
 
-                GC_HandleLoad(arg1, ST_NONE, expr->lineNum);
-                ICG_Branch(BEQ, skipLabel);    // shortcut boolean logic
+    bool isArg2Simple = isWordOperandNode(arg2, lineNum);
+    WordOperand operand = isArg2Simple ? getWordOperand(arg2, lineNum)
+                                       : GC_LoadWordIntoTemp(arg2, ST_INT, lineNum);
+    GC_LoadWord(arg1, ST_INT, lineNum);
 
-                GC_HandleLoad(arg2, ST_NONE, expr->lineNum);
-                ICG_Branch(BEQ, skipLabel);
+    switch (opToken) {
+        case PT_EQ:
+            ICG_CompareWordEquality(operand, skipLabel);
+            ICG_Branch(BNE, skipLabel);
+            break;
+        case PT_NE: {
+            Label *trueLabel = newGenericLabel(LBL_CODE);
+            ICG_CompareWordEquality(operand, trueLabel);
+            ICG_Branch(BEQ, skipLabel);
+            IL_Label(trueLabel);
+        } break;
+        case PT_LT:
+            ICG_CompareWord(operand, isSignedCmp);
+            ICG_Branch(isSignedCmp ? BPL : BCS, skipLabel);
+            break;
+        case PT_GTE:
+            ICG_CompareWord(operand, isSignedCmp);
+            ICG_Branch(isSignedCmp ? BMI : BCC, skipLabel);
+            break;
+        default:
+            ErrorMessage("Unsupported 16-bit compare", getParseTokenName(opToken), lineNum);
+    }
 
-            } else if (isComparisonToken(opNode.value.parseToken)) {
-                // handle as normal comparison
-                bool isCmpToZeroR = (arg2.type == N_INT && arg2.value.num == 0);
-                bool isSignedCmp = false;
+    if (!isArg2Simple) ICG_FreeTemp(2);
+}
 
-                // load first argument, and compare to second
-                GC_HandleLoad(arg1, ST_NONE, expr->lineNum);
-                if (!isCmpToZeroR) {
-                    GC_Compare(arg2, expr->lineNum);
-                }
-                GC_HandleBranchOp(opNode, skipLabel, isCmpToZeroR, isSignedCmp);
-            } else {
-                //----- if no comparison operators are used, eval expr, skip code if 0
-                GC_Expression(expr, destType);
-                ICG_Branch(BEQ, skipLabel);
-            }
-        } else {
-            ErrorMessageWithList("IfExpr: not implemented", expr);
-        }
-    } else if (ifExprNode.type == N_STR) {
-        // Need to load ARG!
-        GC_HandleLoad(ifExprNode, ST_NONE, lineNum);
-        ICG_Branch(BEQ, skipLabel);
+/**
+ * Check if the ranges of the values being compared decide the result
+ *
+ * @return 1 if always true, 0 if always false, -1 if it needs to be checked
+ */
+int getCompareOutcome(enum ParseToken opToken, ListNode arg1, ListNode arg2, int lineNum) {
+    if (!VR_IsPureNode(arg1) || !VR_IsPureNode(arg2)) return -1;
+
+    ValueRange range1 = VR_GetNodeRange(arg1, lineNum);
+    ValueRange range2 = VR_GetNodeRange(arg2, lineNum);
+    if ((range1.min < 0) || (range2.min < 0)) return -1;
+
+    switch (opToken) {
+        case PT_LT:  if (range1.max < range2.min) return 1;  if (range1.min >= range2.max) return 0; break;
+        case PT_GTE: if (range1.min >= range2.max) return 1; if (range1.max < range2.min) return 0; break;
+        case PT_GT:  if (range1.min > range2.max) return 1;  if (range1.max <= range2.min) return 0; break;
+        case PT_LTE: if (range1.max <= range2.min) return 1; if (range1.min > range2.max) return 0; break;
+        case PT_EQ:  if ((range1.max < range2.min) || (range1.min > range2.max)) return 0; break;
+        case PT_NE:  if ((range1.max < range2.min) || (range1.min > range2.max)) return 1; break;
+        default: break;
     }
+    return -1;
 }
 
-
 void GC_HandleBasicCompareOp(ListNode opNode, ListNode arg1, ListNode arg2, const Label *skipLabel,
                         const List *expr) {
+    int outcome = getCompareOutcome(opNode.value.parseToken, arg1, arg2, expr->lineNum);
+    if (outcome == 0) ICG_Jump(skipLabel, "compare is always false");
+    if (outcome >= 0) return;
+
+    if ((getNodeSize(arg1, expr->lineNum) == 2) || (getNodeSize(arg2, expr->lineNum) == 2)) {
+        GC_HandleWordCompareOp(opNode.value.parseToken, arg1, arg2, skipLabel, expr->lineNum);
+        return;
+    }
+
     bool isCmpToZeroR = (arg2.type == N_INT && arg2.value.num == 0);
     bool isSignedCmp = (getExprType(arg1, arg2, expr->lineNum) & ST_SIGNED);
 
@@ -1499,34 +1954,56 @@ void GC_HandleBasicCompareOp(ListNode opNode, ListNode arg1, ListNode arg2, cons
     GC_HandleBranchOp(opNode, skipLabel, isCmpToZeroR, isSignedCmp);
 }
 
+enum ParseToken invertCompareToken(enum ParseToken compareToken) {
+    switch (compareToken) {
+        case PT_EQ:  return PT_NE;
+        case PT_NE:  return PT_EQ;
+        case PT_LT:  return PT_GTE;
+        case PT_GTE: return PT_LT;
+        case PT_GT:  return PT_LTE;
+        case PT_LTE: return PT_GT;
+        default:     return compareToken;
+    }
+}
+
 /**
- * Handle a conditional expression (typically part of if, while, etc...)
- * @param ifExprNode
- * @param destType
- * @param skipLabel
+ * Generate jump code for a conditional expression
+ *
+ * Nested boolean ops are short-circuited, so sub-expressions are only
+ *   evaluated if they can still change the result.
+ *
+ * @param condNode - expression to check
+ * @param label - where to jump to
+ * @param jumpIfTrue - jump when the expression is true (otherwise, when it's false)
  */
-void GC_HandleCondExpr(const ListNode ifExprNode, enum SymbolType destType, Label *skipLabel, int lineNum) {
+void GC_CondJump(ListNode condNode, Label *label, bool jumpIfTrue, int lineNum) {
 
-    // check basic case of (identifier)
-    if (ifExprNode.type == N_STR) {
-        //printf("GC_HandleCondExpr: using basic case on line %d\n", lineNum);
-        SymbolRecord *symRec = lookupSymbolNode(ifExprNode, lineNum);
-        if (symRec) {
-            ICG_LoadVar(symRec);
-            ICG_Branch(BEQ, skipLabel);
-        }
+    // handle constant
+    if (condNode.type == N_INT) {
+        if ((condNode.value.num != 0) == jumpIfTrue) ICG_Jump(label, "condition is constant");
         return;
     }
 
-    // handle constant
-    if (ifExprNode.type == N_INT) {
-        if (ifExprNode.value.num == 0) ICG_Jump(skipLabel, "skipping code");
+    if (condNode.type == N_STR) {
+        SymbolRecord *varSym = lookupSymbolNode(condNode, lineNum);
+        if ((varSym != NULL) && IS_PACKED_BOOL(varSym)) {
+            ICG_BranchOnPackedBool(varSym, jumpIfTrue, label);
+            return;
+        }
+        if (getNodeSize(condNode, lineNum) == 2) {
+            // compares branch when the condition fails
+            GC_HandleWordCompareOp(jumpIfTrue ? PT_EQ : PT_NE, condNode, createIntNode(0), label, lineNum);
+            return;
+        }
+        GC_HandleLoad(condNode, ST_NONE, lineNum);
+        ICG_Branch(jumpIfTrue ? BNE : BEQ, label);
+        return;
     }
 
     // only other thing supported is list, so leave if not a list
-    if (ifExprNode.type != N_LIST) return;
+    if (condNode.type != N_LIST) return;
 
-    List *expr = ifExprNode.value.list;
+    List *expr = condNode.value.list;
     ListNode opNode = expr->nodes[0];
     ListNode arg1 = expr->nodes[1];
     ListNode arg2 = expr->nodes[2];
@@ -1536,30 +2013,70 @@ void GC_HandleCondExpr(const ListNode ifExprNode, enum SymbolType destType, Labe
         return;
     }
 
-    // optimizations for booleans
-    if (opNode.value.parseToken == PT_BOOL_AND) {
-        GC_HandleSubCondExpr(arg1, ST_NONE, skipLabel, expr->lineNum);
-        GC_HandleSubCondExpr(arg2, ST_NONE, skipLabel, expr->lineNum);
-    } else if (opNode.value.parseToken == PT_BOOL_OR) {
-        Label *checkCond2Label = newGenericLabel(LBL_CODE);
-        Label *execLabel = newGenericLabel(LBL_CODE);
+    EvalResult evalResult = evaluate_expression(expr);
+    if (evalResult.hasResult) {
+        if ((evalResult.value != 0) == jumpIfTrue) ICG_Jump(label, "condition is constant");
+        return;
+    }
+
+    enum ParseToken opToken = opNode.value.parseToken;
+    if ((opToken == PT_BOOL_AND) || (opToken == PT_BOOL_OR)) {
+
+        // first arg can decide the result  (when false for AND, when true for OR)
+        bool isDecidedWhen = (opToken == PT_BOOL_OR);
+        if (isDecidedWhen == jumpIfTrue) {
+            GC_CondJump(arg1, label, jumpIfTrue, expr->lineNum);
+            GC_CondJump(arg2, label, jumpIfTrue, expr->lineNum);
+        } else {
+            Label *decidedLabel = newGenericLabel(LBL_CODE);
+            GC_CondJump(arg1, decidedLabel, isDecidedWhen, expr->lineNum);
+            GC_CondJump(arg2, label, jumpIfTrue, expr->lineNum);
+            IL_Label(decidedLabel);
+        }
+
+    } else if (opToken == PT_NOT) {
+        GC_CondJump(arg1, label, !jumpIfTrue, expr->lineNum);
 
-        GC_HandleSubCondExpr(arg1, ST_NONE, checkCond2Label, expr->lineNum);
-        ICG_Jump(execLabel, "jump because if statement is true (shortcut)");
-        IL_Label(checkCond2Label);
+    } else if (isComparisonToken(opToken)) {
+        // compares branch when the condition fails, so flip it to branch when true
+        if (jumpIfTrue) opNode = createParseToken(invertCompareToken(opToken));
+        GC_HandleBasicCompareOp(opNode, arg1, arg2, label, expr);
 
-        GC_HandleSubCondExpr(arg2, ST_NONE, skipLabel, expr->lineNum);
-        IL_Label(execLabel);
+    } else if (isCarryReturnCall(expr)) {
+        GC_FuncCall(expr, ST_BOOL);
+        ICG_Branch(jumpIfTrue ? BCS : BCC, label);
 
-    } else if (isComparisonToken(opNode.value.parseToken)) {
-        GC_HandleBasicCompareOp(opNode, arg1, arg2, skipLabel, expr);
     } else {
-        //----- if no comparison operators are used, eval expr, skip code if 0
-        GC_Expression(expr, destType);
-        ICG_Branch(BEQ, skipLabel);
+        //----- if no comparison operators are used, eval expr, check if 0
+        GC_Expression(expr, ST_NONE);
+        if (opToken == PT_FUNC_CALL) ICG_CompareConst(0);     // flags are not set by the return
+        ICG_Branch(jumpIfTrue ? BNE : BEQ, label);
     }
 }
 
+/**
+ * Handle a conditional expression (typically part of if, while, etc...)
+ * @param ifExprNode
+ * @param destType
+ * @param skipLabel
+ */
+void GC_HandleCondExpr(const ListNode ifExprNode, enum SymbolType destType, Label *skipLabel, int lineNum) {
+
+    // check basic case of (identifier)
+    if (ifExprNode.type == N_STR) {
+        SymbolRecord *symRec = lookupSymbolNode(ifExprNode, lineNum);
+        if (symRec && IS_PACKED_BOOL(symRec)) {
+            ICG_BranchOnPackedBool(symRec, false, skipLabel);
+        } else if (symRec) {
+            ICG_LoadVar(symRec);
+            ICG_Branch(BEQ, skipLabel);
+        }
+        return;
+    }
+
+    GC_CondJump(ifExprNode, skipLabel, false, lineNum);
+}
+
 
 //-------------------------------------------------------------------------------
 //  Statements
@@ -1570,22 +2087,38 @@ void GC_If(const List *stmt, enum SymbolType destType) {
     Label *skipThenLabel = newGenericLabel(LBL_CODE);
     Label *skipElseLabel = (hasElse ? newGenericLabel(LBL_CODE) : NULL);
 
+    // '#likely' / '#unlikely' tell which way the condition usually goes
+    enum CompilerDirectiveTokens hint = lastDirective;
+    if ((hint == LIKELY) || (hint == UNLIKELY)) lastDirective = 0;
+
     // handle if:
+    Instr *startOfIf = IL_GetCurrentInstr();
     GC_HandleCondExpr(stmt->nodes[1], ST_BOOL, skipThenLabel, stmt->lineNum);
 
     // handle then:
+    Instr *startOfThen = IL_GetCurrentInstr();
     GC_CodeBlock(stmt->nodes[2].value.list);
 
+    // early returns are usually the rare case
+    bool isThenCold = (hint == UNLIKELY)
+            || (!hasElse && (hint != LIKELY) && compilerOptions.runOptimizer && ICG_isLastInstrReturn());
+
     // handle else:
     if (hasElse) {
+        Instr *skipElseJump = NULL;
         if (!ICG_isLastInstrReturn()) {
             ICG_Jump(skipElseLabel, "skip else case");
+            skipElseJump = IL_GetCurrentInstr();
         }
+        if (isThenCold) GL_MarkColdThen(startOfIf, startOfThen, IL_GetCurrentInstr(), skipThenLabel, skipElseLabel);
         IL_Label(skipThenLabel);
 
+        Instr *startOfElse = IL_GetCurrentInstr();
         GC_CodeBlock(stmt->nodes[3].value.list);
+        if (hint == LIKELY) GL_MarkColdElse(startOfIf, skipElseJump, startOfElse, IL_GetCurrentInstr(), skipElseLabel);
         IL_Label(skipElseLabel);
     } else {
+        if (isThenCold) GL_MarkColdThen(startOfIf, startOfThen, IL_GetCurrentInstr(), skipThenLabel, skipThenLabel);
         IL_Label(skipThenLabel);
     }
 }
@@ -1694,9 +2227,493 @@ void GC_Switch(const List *stmt, enum SymbolType destType) {
     IL_Label(endOfSwitch);
 }
 
+//-------------------------------------------------------------------
+//--- Loop unrolling
+//-
+//  Loops with constant bounds can be generated as copies of the loop body,
+//  one per iteration, with the counter variable folded into a constant.
+//  This removes the INC/CMP/branch overhead of each iteration and turns
+//  indexed array accesses (array[i]) into absolute addressing (array+3).
+//
+//  '#unroll' forces the next loop to be unrolled, '#unroll 0' prevents it.
+//  When the optimizer is enabled, small loops are unrolled automatically.
+
+#define UNROLL_MAX_ITERATIONS       64      // limit for '#unroll'
+#define UNROLL_AUTO_MAX_ITERATIONS  8       // limits for automatic unrolling
+#define UNROLL_AUTO_MAX_STATEMENTS  16      //   (iterations * statements in body)
+
+typedef struct {
+    int iterations;
+    int startValue;
+    int step;           // +1 or -1
+    int finalValue;     // counter value once loop is done
+} UnrollInfo;
+
+/**
+ * Check if an expression node can be folded into a single constant
+ */
+bool isFoldableOp(ListNode opNode) {
+    if (opNode.type != N_TOKEN) return false;
+    switch (opNode.value.parseToken) {
+        case PT_ADD: case PT_SUB: case PT_MULTIPLY:
+        case PT_BIT_AND: case PT_BIT_OR: case PT_BIT_EOR:
+        case PT_SHIFT_LEFT: case PT_SHIFT_RIGHT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Make a copy of a statement/expression list with a variable (loop counter
+ *   or function param) replaced by a constant value.  Any math that becomes
+ *   constant is folded.
+ *
+ * @param srcList - list to copy
+ * @param cntVarName - name of variable to replace
+ * @param value - value to use in place of the variable
+ * @return node containing copy
+ */
+ListNode cloneWithConstValue(const List *srcList, const char *cntVarName, int value) {
+    List *newList = createList(srcList->count);
+    newList->lineNum = srcList->lineNum;
+    newList->progLine = srcList->progLine;
+    newList->hasNestedList = srcList->hasNestedList;
+
+    // don't touch names of functions or struct properties
+    ListNode opNode = srcList->nodes[0];
+    bool skipFirstName = isToken(opNode, PT_FUNC_CALL);
+    bool skipSecondName = isToken(opNode, PT_PROPERTY_REF);
+
+    for_range(index, 0, srcList->count) {
+        ListNode node = srcList->nodes[index];
+        bool canReplace = !((skipFirstName && index == 1) || (skipSecondName && index == 2));
+
+        if (node.type == N_LIST) {
+            node = cloneWithConstValue(node.value.list, cntVarName, value);
+        } else if (canReplace && (node.type == N_STR)
+                && (strncmp(node.value.str, cntVarName, SYMBOL_NAME_LIMIT) == 0)) {
+            node = createIntNode(value);
+        }
+        addNode(newList, node);
+    }
+
+    if (isFoldableOp(opNode)) {
+        EvalResult evalResult = evaluate_expression(newList);
+        if (evalResult.hasResult) return createIntNode(evalResult.value);
+    }
+    return createListNode(newList);
+}
+
+/**
+ * Check whether a code block can be replicated for each loop iteration.
+ *
+ *  The counter variable cannot be modified inside the loop (including by a
+ *  nested loop using it as its counter), and anything that can't be
+ *  duplicated (labels, asm blocks, breaks) prevents unrolling.
+ *
+ * @param list - code block or statement to check
+ * @param cntVarName - name of loop counter variable
+ * @param stmtCount - running count of statements (used by heuristic)
+ * @param hasControlFlow - set if any nested control flow statements are found
+ * @param hasFuncCall - set if any function calls are found
+ * @return true if block can be unrolled
+ */
+bool canUnrollBlock(const List *list, const char *cntVarName,
+                    int *stmtCount, bool *hasControlFlow, bool *hasFuncCall) {
+    for_range(index, 0, list->count) {
+        ListNode node = list->nodes[index];
+
+        if (node.type == N_TOKEN) {
+            switch (node.value.parseToken) {
+                case PT_ASM: case PT_LABEL: case PT_BREAK:
+                case PT_DIRECTIVE: case PT_DEFINE:
+                    return false;
+                case PT_SET: case PT_INC: case PT_DEC: case PT_ADDR_OF: {
+                    ListNode targetNode = list->nodes[1];
+                    if ((index == 0) && (targetNode.type == N_STR)
+                        && (strncmp(targetNode.value.str, cntVarName, SYMBOL_NAME_LIMIT) == 0))
+                        return false;
+                } break;
+                case PT_LOOP: {
+                    ListNode loopVarNode = list->nodes[1];
+                    if ((index == 0) && (loopVarNode.type == N_STR)
+                        && (strncmp(loopVarNode.value.str, cntVarName, SYMBOL_NAME_LIMIT) == 0))
+                        return false;
+                    *hasControlFlow = true;
+                } break;
+                case PT_IF: case PT_SWITCH: case PT_FOR:
+                case PT_WHILE: case PT_DOWHILE:
+                    *hasControlFlow = true;
+                    break;
+                case PT_FUNC_CALL:
+                    *hasFuncCall = true;
+                    break;
+                default:
+                    break;
+            }
+        } else if (node.type == N_LIST) {
+            List *subList = node.value.list;
+            if (isToken(list->nodes[0], PT_CODE)) (*stmtCount)++;
+            if (!canUnrollBlock(subList, cntVarName, stmtCount, hasControlFlow, hasFuncCall))
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Decide whether to unroll a loop (using '#unroll' directive or heuristic)
+ *
+ * @param cntVarSym - loop counter variable
+ * @param loopCode - code block of loop
+ * @param iterations - number of times loop will run
+ * @return true if loop should be unrolled
+ */
+bool shouldUnrollLoop(const SymbolRecord *cntVarSym, const List *loopCode, int iterations) {
+    bool forceUnroll = isUnrollPending && !unrollDisabled;
+    bool preventUnroll = isUnrollPending && unrollDisabled;
+    isUnrollPending = false;
+
+    if (preventUnroll) return false;
+    if (!forceUnroll && !compilerOptions.runOptimizer) return false;
+    if (!forceUnroll && compilerOptions.optimizeForSize) return false;     // unrolling makes code bigger
+
+    int stmtCount = 0;
+    bool hasControlFlow = false;
+    bool hasFuncCall = false;
+    bool canUnroll = (iterations > 0) && (getBaseVarSize(cntVarSym) == 1)
+                     && !isToken(loopCode->nodes[0], PT_ASM)
+                     && canUnrollBlock(loopCode, cntVarSym->name, &stmtCount, &hasControlFlow, &hasFuncCall);
+
+    if (forceUnroll) {
+        if (!canUnroll || (iterations > UNROLL_MAX_ITERATIONS)) {
+            WarningMessage("Unable to unroll loop", cntVarSym->name, loopCode->lineNum);
+            return false;
+        }
+        return true;
+    }
+
+    // automatic unrolling: only small, straight-line loops
+    return canUnroll && !hasControlFlow && !hasFuncCall
+           && (iterations <= UNROLL_AUTO_MAX_ITERATIONS)
+           && ((iterations * stmtCount) <= UNROLL_AUTO_MAX_STATEMENTS);
+}
+
+/**
+ * Generate a copy of the loop code for each iteration
+ *
+ *  If the counter variable is global and the loop calls functions, the
+ *  counter is still updated for each iteration since the called functions
+ *  may use it.  In all cases, the counter is left with its final value.
+ */
+void GC_UnrolledLoop(const SymbolRecord *cntVarSym, const List *loopCode, UnrollInfo unrollInfo) {
+    int stmtCount = 0;
+    bool hasControlFlow = false;
+    bool hasFuncCall = false;
+    canUnrollBlock(loopCode, cntVarSym->name, &stmtCount, &hasControlFlow, &hasFuncCall);
+    bool keepCounterUpdated = hasFuncCall && !IS_LOCAL(cntVarSym);
+
+    char *unrollComment = allocMem(40);
+    sprintf(unrollComment, "Unrolled loop: %d iterations", unrollInfo.iterations);
+    IL_AddCommentToCode(unrollComment);
+
+    int counterValue = unrollInfo.startValue;
+    for_range(iteration, 0, unrollInfo.iterations) {
+        if (keepCounterUpdated) {
+            ICG_LoadConst(counterValue, 1);
+            ICG_StoreVarSym(cntVarSym);
+        }
+        ListNode unrolledCode = cloneWithConstValue(loopCode, cntVarSym->name, counterValue & 0xff);
+        GC_CodeBlock(unrolledCode.value.list);
+        counterValue += unrollInfo.step;
+    }
+
+    // leave counter with the same value the rolled-up loop would have
+    ICG_LoadConst(unrollInfo.finalValue & 0xff, 1);
+    ICG_StoreVarSym(cntVarSym);
+}
+
+/**
+ * Figure out the iteration count of a 'for' loop in the simple form:
+ *
+ *    for (i = start; i < end; i++)     -- also: <=, != with ++
+ *    for (i = start; i > end; i--)     -- also: >=, != with --
+ *
+ * @return UnrollInfo with iterations == 0 if loop doesn't match
+ */
+UnrollInfo getForLoopUnrollInfo(const List *stmt, SymbolRecord **cntVarSym) {
+    UnrollInfo unrollInfo = {0, 0, 0, 0};
+
+    ListNode initNode = stmt->nodes[1];
+    ListNode condNode = stmt->nodes[2];
+    ListNode incNode = stmt->nodes[3];
+    if ((initNode.type != N_LIST) || (condNode.type != N_LIST) || (incNode.type != N_LIST)) return unrollInfo;
+
+    List *initStmt = initNode.value.list;
+    List *condExpr = condNode.value.list;
+    List *incStmt = incNode.value.list;
+    if (!isToken(initStmt->nodes[0], PT_SET) || (initStmt->nodes[1].type != N_STR)) return unrollInfo;
+    if ((condExpr->count != 3) || (incStmt->count != 2)) return unrollInfo;
+
+    // all three parts need to use the same variable
+    char *varName = initStmt->nodes[1].value.str;
+    if ((condExpr->nodes[1].type != N_STR) || (incStmt->nodes[1].type != N_STR)) return unrollInfo;
+    if ((strncmp(varName, condExpr->nodes[1].value.str, SYMBOL_NAME_LIMIT) != 0)
+        || (strncmp(varName, incStmt->nodes[1].value.str, SYMBOL_NAME_LIMIT) != 0)) return unrollInfo;
+
+    // need constant start and end values
+    EvalResult startResult = evaluate_node(initStmt->nodes[2]);
+    EvalResult endResult = evaluate_node(condExpr->nodes[2]);
+    if (!startResult.hasResult || !endResult.hasResult) return unrollInfo;
+    int start = startResult.value;
+    int end = endResult.value;
+    if ((start < 0) || (start > 255) || (end < 0) || (end > 255)) return unrollInfo;
+
+    enum ParseToken condOp = condExpr->nodes[0].value.parseToken;
+    int iterations = 0;
+    if (isToken(incStmt->nodes[0], PT_INC)) {
+        unrollInfo.step = 1;
+        switch (condOp) {
+            case PT_LT:  case PT_NE: iterations = end - start; break;
+            case PT_LTE: iterations = end - start + 1; break;
+            default: break;
+        }
+    } else if (isToken(incStmt->nodes[0], PT_DEC)) {
+        unrollInfo.step = -1;
+        switch (condOp) {
+            case PT_GT:  case PT_NE: iterations = start - end; break;
+            case PT_GTE: iterations = (end > 0) ? (start - end + 1) : 0;  break;  // >= 0 never ends
+            default: break;
+        }
+    }
+    if (iterations <= 0) return unrollInfo;
+
+    *cntVarSym = lookupSymbolNode(initStmt->nodes[1], stmt->lineNum);
+    if (*cntVarSym == NULL) return unrollInfo;
+
+    unrollInfo.iterations = iterations;
+    unrollInfo.startValue = start;
+    unrollInfo.finalValue = start + (iterations * unrollInfo.step);
+    return unrollInfo;
+}
+
+//-------------------------------------------------------------------------
+//---  Loops with the counter kept in the Y register
+//
+//  When the loop counter is only used to index arrays, Y can hold the
+//  counter (already multiplied by the element size) for the whole loop:
+//
+//      arr[i]              - Y = i
+//      arr[i*k]            - Y = i*k,  stepped by k each time around
+//      structArr[i].prop   - Y = i*sizeof(struct)
+//
+//  The loop code can't do anything else that might use Y.
+
+SymbolRecord *findVarSymbol(ListNode node) {
+    SymbolRecord *varSym = NULL;
+    if (curFuncSymbolTable != NULL) varSym = findSymbol(curFuncSymbolTable, node.value.str);
+    if (varSym == NULL) varSym = findSymbol(mainSymbolTable, node.value.str);
+    return varSym;
+}
+
+bool isCounterNode(ListNode node, const char *cntVarName) {
+    return (node.type == N_STR) && (strncmp(node.value.str, cntVarName, SYMBOL_NAME_LIMIT) == 0);
+}
+
+/**
+ * All indexes using the counter need to scale it the same way
+ */
+bool useIndexScale(int *scale, int newScale) {
+    if (*scale == 0) *scale = newScale;
+    return (*scale == newScale);
+}
+
+bool isBytePropertyRef(SymbolRecord *structSym, ListNode propNode) {
+    if (!isStructDefined(structSym) || (propNode.type != N_STR)) return false;
+    SymbolRecord *propSym = findSymbol(getStructSymbolSet(structSym), propNode.value.str);
+    return (propSym != NULL) && (getBaseVarSize(propSym) == 1);
+}
+
+/**
+ * Check how the loop counter is used, finding the scale used to index with it
+ *
+ * @return false if something in the code could need the Y register
+ */
+bool checkLoopIndexUse(ListNode node, const char *cntVarName, int *scale) {
+    switch (node.type) {
+        case N_INT:
+            return true;
+        case N_STR: {
+            // counter can only be used as an index
+            if (isCounterNode(node, cntVarName)) return false;
+            SymbolRecord *varSym = findVarSymbol(node);
+            if (varSym == NULL || isConst(varSym)) return true;
+            return !isPointer(varSym) && !isArray(varSym) && !IS_ALIAS(varSym)
+                   && (getBaseVarSize(varSym) == 1);
+        }
+        case N_LIST:
+            break;
+        default:
+            return false;
+    }
+
+    List *list = node.value.list;
+    int firstArg = 1;
+    if (list->nodes[0].type != N_TOKEN) {
+        firstArg = 0;
+    } else {
+        switch (list->nodes[0].value.parseToken) {
+            case PT_CODE: case PT_IF: case PT_SET:
+            case PT_INC: case PT_DEC: case PT_BIT_AND: case PT_BIT_OR: case PT_BIT_EOR:
+            case PT_EQ: case PT_NE: case PT_GT: case PT_GTE: case PT_LT: case PT_LTE:
+            case PT_ADD: case PT_SUB: case PT_SHIFT_LEFT: case PT_SHIFT_RIGHT:
+            case PT_INVERT: case PT_NOT: case PT_POSITIVE: case PT_NEGATIVE:
+            case PT_BOOL_AND: case PT_BOOL_OR:
+                break;
+
+            case PT_LOOKUP: {
+                // simple byte array:  arr[i], arr[i+n], arr[i*k], arr[n]
+                SymbolRecord *arraySym = findVarSymbol(list->nodes[1]);
+                if (arraySym == NULL || !isArray(arraySym) || isPointer(arraySym)
+                    || isStructDefined(arraySym) || (getBaseVarSize(arraySym) != 1)) return false;
+
+                ListNode indexNode = list->nodes[2];
+                if (indexNode.type == N_INT) return true;
+                if (isCounterNode(indexNode, cntVarName)) return useIndexScale(scale, 1);
+                if (indexNode.type != N_LIST) return false;
+
+                List *indexExpr = indexNode.value.list;
+                ListNode varNode;
+                int indexScale = getScaledIndex(indexExpr, &varNode);
+                if (indexScale > 0) {
+                    return isCounterNode(varNode, cntVarName) && useIndexScale(scale, indexScale);
+                }
+                bool isOffset = isToken(indexExpr->nodes[0], PT_ADD) || isToken(indexExpr->nodes[0], PT_SUB);
+                return isOffset && isCounterNode(indexExpr->nodes[1], cntVarName)
+                       && (indexExpr->nodes[2].type == N_INT) && useIndexScale(scale, 1);
+            }
+
+            case PT_PROPERTY_REF: {
+                ListNode structNode = list->nodes[1];
+                if (structNode.type == N_STR) {
+                    // plain struct var or enumeration
+                    SymbolRecord *structSym = findVarSymbol(structNode);
+                    if (structSym == NULL || isEnum(structSym)) return true;
+                    return !IS_ALIAS(structSym) && !IS_PARAM_VAR(structSym) && !isPointer(structSym)
+                           && isBytePropertyRef(structSym, list->nodes[2]);
+                }
+
+                // array of structs:  structArr[i].prop
+                if ((structNode.type != N_LIST) || !isToken(structNode.value.list->nodes[0], PT_LOOKUP)) return false;
+                List *lookupExpr = structNode.value.list;
+                SymbolRecord *arraySym = findVarSymbol(lookupExpr->nodes[1]);
+                if (arraySym == NULL || IS_ALIAS(arraySym) || isPointer(arraySym)
+                    || !isBytePropertyRef(arraySym, list->nodes[2])) return false;
+                return isCounterNode(lookupExpr->nodes[2], cntVarName)
+                       && useIndexScale(scale, getArrayIndexStride(arraySym) & 0x7f);
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    for_range(index, firstArg, list->count) {
+        if (!checkLoopIndexUse(list->nodes[index], cntVarName, scale)) return false;
+    }
+    return true;
+}
+
+/**
+ * Check if the loop counter can be kept in the Y register
+ *
+ * @return scale to keep counter at (0 if it needs to stay in memory)
+ */
+int getLoopIndexScale(const SymbolRecord *cntVarSym, const List *loopCode, UnrollInfo loopInfo) {
+    if (!compilerOptions.runOptimizer || (loopInfo.iterations <= 0)) return 0;
+    if ((getBaseVarSize(cntVarSym) != 1) || isPointer(cntVarSym) || IS_PARAM_VAR(cntVarSym)) return 0;
+
+    int scale = 0;
+    if (!checkLoopIndexUse(createListNode((List *)loopCode), cntVarSym->name, &scale)) return 0;
+
+    // every scaled counter value needs to fit in Y
+    int maxValue = (loopInfo.step > 0) ? loopInfo.finalValue : loopInfo.startValue;
+    int minValue = (loopInfo.step > 0) ? loopInfo.startValue : loopInfo.finalValue;
+    if ((minValue < 0) || ((maxValue * scale) > 255)) return 0;
+    return scale;
+}
+
+/**
+ * Get the loop bound given by '#max_loops n' for the next loop
+ *
+ * @return most times the loop code runs, or -1 if not given
+ */
+int takeMaxLoopsHint() {
+    int maxLoops = maxLoopsValue;
+    maxLoopsValue = -1;
+    return maxLoops;
+}
+
+/**
+ * Generate a loop with the counter (times scale) held in Y
+ *
+ *   LDY #start*scale
+ *   loop:  ...
+ *          INY (xScale)
+ *          CPY #final*scale
+ *          BEQ done
+ *          JMP loop
+ *   done:
+ */
+void GC_IndexRegLoop(const SymbolRecord *cntVarSym, List *loopCode, UnrollInfo loopInfo, int scale) {
+    Label *startOfLoop = newGenericLabel(LBL_LOOP_START);
+    Label *doneWithLoop = newGenericLabel(LBL_CODE);
+    startOfLoop->loopBound = loopInfo.iterations - 1;      // (last time thru exits the loop)
+
+    IL_AddCommentToCode("Loop counter kept in Y");
+    ICG_LoadRegConst('Y', loopInfo.startValue * scale);
+    ICG_SetLoopIndex(cntVarSym, scale);
+
+    IL_Label(startOfLoop);
+    GC_CodeBlock(loopCode);
+
+    ICG_StepLoopIndex(loopInfo.step * scale);
+    if (loopInfo.finalValue != 0) {
+        // (stepping down to zero already sets the Z flag)
+        ICG_CompareLoopIndex(loopInfo.finalValue * scale);
+    }
+    ICG_Branch(BEQ, doneWithLoop);
+    ICG_Jump(startOfLoop, "Loop back");
+    IL_Label(doneWithLoop);
+
+    ICG_StoreLoopIndex(loopInfo.finalValue);
+    ICG_ClearLoopIndex();
+}
+
 void GC_For(const List *stmt, enum SymbolType destType) {
+    int maxLoops = takeMaxLoopsHint();
+    SymbolRecord *cntVarSym = NULL;
+    UnrollInfo unrollInfo = getForLoopUnrollInfo(stmt, &cntVarSym);
+    if (unrollInfo.iterations > 0) {
+        List *loopCode = stmt->nodes[4].value.list;
+        if (shouldUnrollLoop(cntVarSym, loopCode, unrollInfo.iterations)) {
+            GC_UnrolledLoop(cntVarSym, loopCode, unrollInfo);
+            return;
+        }
+        int indexScale = getLoopIndexScale(cntVarSym, loopCode, unrollInfo);
+        if (indexScale > 0) {
+            GC_IndexRegLoop(cntVarSym, loopCode, unrollInfo, indexScale);
+            return;
+        }
+    } else if (isUnrollPending) {
+        if (!unrollDisabled) WarningMessage("Unable to unroll loop", "loop bounds are not constant", stmt->lineNum);
+        isUnrollPending = false;
+    }
+
     Label *startOfLoop = newGenericLabel(LBL_LOOP_START);
     Label *doneWithLoop = newGenericLabel(LBL_CODE);
+    startOfLoop->loopBound = (unrollInfo.iterations > 0) ? unrollInfo.iterations : maxLoops;
 
     ListNode initStmtNode = stmt->nodes[1];
     if (initStmtNode.type != N_LIST) {
@@ -1747,6 +2764,7 @@ void GC_Loop(const List *stmt, enum SymbolType destType) {
     ListNode counterStartValueNode = stmt->nodes[2];
     ListNode counterEndValueNode = stmt->nodes[3];
     ListNode loopCodeNode = stmt->nodes[4];
+    int maxLoops = takeMaxLoopsHint();
 
     //--- Check the loop parameters
     SymbolRecord *cntVarSym = lookupSymbolNode(counterVarNode, stmt->lineNum);
@@ -1765,9 +2783,25 @@ void GC_Loop(const List *stmt, enum SymbolType destType) {
     }
     int counterEndValue = getConstValue(counterEndValueNode, stmt->lineNum);
 
+    //--- Check if loop can be unrolled
+    int iterations = counterEndValue - counterStartValue;
+    UnrollInfo unrollInfo = {iterations, counterStartValue, 1, counterEndValue};
+    if (shouldUnrollLoop(cntVarSym, loopCodeNode.value.list, iterations)) {
+        GC_UnrolledLoop(cntVarSym, loopCodeNode.value.list, unrollInfo);
+        return;
+    }
+
+    int indexScale = getLoopIndexScale(cntVarSym, loopCodeNode.value.list, unrollInfo);
+    if (indexScale > 0) {
+        GC_IndexRegLoop(cntVarSym, loopCodeNode.value.list, unrollInfo, indexScale);
+        return;
+    }
+
     //----------------------------------------------------
     Label *startOfLoop = newGenericLabel(LBL_LOOP_START);
     Label *doneWithLoop = newGenericLabel(LBL_CODE);
+    int loopIterations = (iterations > 0) ? iterations : maxLoops;
+    startOfLoop->loopBound = (loopIterations > 0) ? loopIterations - 1 : -1;     // (last time thru exits the loop)
 
     //---  Initialize the loop counter
     ICG_LoadConst(counterStartValue, getBaseVarSize(cntVarSym));
@@ -1791,11 +2825,12 @@ void GC_Loop(const List *stmt, enum SymbolType destType) {
 void GC_While(const List *stmt, enum SymbolType destType) {
     Label *startOfLoop = newGenericLabel(LBL_LOOP_START);
     Label *doneWithLoop = newGenericLabel(LBL_CODE);
+    startOfLoop->loopBound = takeMaxLoopsHint();
 
     IL_Label(startOfLoop);
 
     ListNode condNode = stmt->nodes[1];
-    if (condNode.type == N_LIST) {
+    if ((condNode.type == N_LIST) || (condNode.type == N_STR)) {
         GC_HandleCondExpr(condNode, ST_BOOL, doneWithLoop, stmt->lineNum);
     } else if (condNode.type == N_INT) {
         if (condNode.value.num == 0) {
@@ -1814,15 +2849,17 @@ void GC_While(const List *stmt, enum SymbolType destType) {
 
 void GC_DoWhile(const List *stmt, enum SymbolType destType) {
     Label *startLoopLabel = newGenericLabel(LBL_LOOP_START);
+    int maxLoops = takeMaxLoopsHint();
+    startLoopLabel->loopBound = (maxLoops > 0) ? maxLoops - 1 : -1;     // (last time thru exits the loop)
     IL_Label(startLoopLabel);
 
     GC_CodeBlock(stmt->nodes[1].value.list);
 
     // now process conditional logic
     ListNode condNode = stmt->nodes[2];
-    if (condNode.type == N_LIST) {
+    if ((condNode.type == N_LIST) || (condNode.type == N_STR)) {
         Label *doneWithLoop = newGenericLabel(LBL_CODE);
-        IL_AddCommentToCode(buildSourceCodeLine(&condNode.value.list->progLine));
+        if (condNode.type == N_LIST) IL_AddCommentToCode(buildSourceCodeLine(&condNode.value.list->progLine));
         GC_HandleCondExpr(condNode, ST_BOOL, doneWithLoop, stmt->lineNum);
         ICG_Jump(startLoopLabel, "beginning of loop");
         IL_Label(doneWithLoop);
@@ -1881,11 +2918,20 @@ void GC_HandleLoadFuncArgExpr(ListNode argNode, enum SymbolType destType, char d
 void GC_LoadFuncArg(const SymbolRecord *curParam, ListNode argNode,
                     int lineNum) {
     SymbolRecord *varSym;
-    if ((curParam->hint == VH_NONE) && (!IS_STACK_VAR(curParam))) {
+    bool isFrameStore = IS_FRAME_PARAM(curParam) && (curParam->hint == VH_NONE);
+    if ((curParam->hint == VH_NONE) && (!IS_STACK_VAR(curParam)) && !isFrameStore) {
         ErrorMessageWithNode("Unable to load parameter: ", argNode, lineNum);
         return;
     }
 
+    // param goes straight into the function's frame
+    if (isFrameStore) {
+        IL_SetLineComment("loading param");
+        GC_HandleLoad(argNode, ST_NONE, lineNum);
+        ICG_StoreFrameParam(curParam);
+        return;
+    }
+
     char destReg = getDestRegFromHint(curParam->hint);
     IL_SetLineComment("loading param");
 
@@ -1924,7 +2970,55 @@ void GC_LoadFuncArg(const SymbolRecord *curParam, ListNode argNode,
     }
 }
 
+/**
+ * Call a function thru a function table
+ *
+ *   [funcCall, [lookup, tableName, index], params]
+ *
+ *  A constant index calls the function directly, otherwise the index
+ *  is loaded into X for the table's dispatch routine.
+ */
+void GC_TableCall(const List *stmt) {
+    const List *lookupExpr = stmt->nodes[1].value.list;
+    SymbolRecord *tableSym = isToken(lookupExpr->nodes[0], PT_LOOKUP)
+                             ? lookupSymbolNode(lookupExpr->nodes[1], stmt->lineNum) : NULL;
+    if ((tableSym == NULL) || !IS_FUNC_TABLE(tableSym)) {
+        ErrorMessageWithList("Only function tables can be called", stmt);
+        return;
+    }
+    if (stmt->nodes[2].type == N_LIST) {
+        ErrorMessageWithList("Functions in a function table can't be passed parameters", stmt);
+        return;
+    }
+
+    ListNode indexNode = lookupExpr->nodes[2];
+    if (isArrayIndexConst(lookupExpr)) {
+        int index = GC_GetArrayIndex(tableSym, lookupExpr);
+        if ((index < 0) || (index >= tableSym->numElements)) {
+            ErrorMessageWithList("Function table index out of range", stmt);
+            return;
+        }
+        ICG_Call(tableSym->astList->nodes[index + 1].value.str);
+        return;
+    }
+
+    if (indexNode.type == N_STR) {
+        SymbolRecord *indexSym = lookupSymbolNode(indexNode, stmt->lineNum);
+        if (indexSym == NULL) return;
+        ICG_LoadRegVar(indexSym, 'X');
+    } else {
+        GC_HandleLoad(indexNode, ST_CHAR, stmt->lineNum);
+        ICG_MoveAccToIndex('X');
+    }
+    ICG_CallFuncTable(tableSym);
+}
+
 void GC_FuncCall(const List *stmt, enum SymbolType destType) {
+    if (stmt->nodes[1].type == N_LIST) {
+        GC_TableCall(stmt);
+        return;
+    }
+
     ListNode funcNameNode = stmt->nodes[1];
     SymbolRecord* funcSym = lookupFunctionSymbolByNameNode(funcNameNode, stmt->lineNum);
     SymbolList* funcParamList = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
@@ -1945,8 +3039,17 @@ void GC_FuncCall(const List *stmt, enum SymbolType destType) {
         if ((requiredParams == args->count) && (funcParamList != NULL)) {
             requiresCleanup = true;
 
+            // params passed in a register (by the calling convention) need to be loaded last,
+            //   so the other args don't disturb the register
             for_range(argIndex, 0, funcParamList->count) {
-                GC_LoadFuncArg(funcParamList->list[argIndex], args->nodes[argIndex], stmt->lineNum);
+                SymbolRecord *curParam = funcParamList->list[argIndex];
+                if (IS_FRAME_PARAM(curParam) && (curParam->hint != VH_NONE)) continue;
+                GC_LoadFuncArg(curParam, args->nodes[argIndex], stmt->lineNum);
+            }
+            for_range(argIndex, 0, funcParamList->count) {
+                SymbolRecord *curParam = funcParamList->list[argIndex];
+                if (!IS_FRAME_PARAM(curParam) || (curParam->hint == VH_NONE)) continue;
+                GC_LoadFuncArg(curParam, args->nodes[argIndex], stmt->lineNum);
             }
         } else {
             ErrorMessageWithList("Incorrect number of parameters in function call", stmt);
@@ -1969,6 +3072,7 @@ void GC_FuncCall(const List *stmt, enum SymbolType destType) {
  */
 void GC_FuncCallExpression(const List *stmt, enum SymbolType destType) {
     GC_FuncCall(stmt, destType);
+    if (isCarryReturnCall(stmt)) ICG_LoadCarry();
 }
 
 
@@ -1979,6 +3083,11 @@ void GC_FuncCallExpression(const List *stmt, enum SymbolType destType) {
  * @param destType
  */
 void GC_FuncCallStatement(const List *stmt, enum SymbolType destType) {
+    if (stmt->nodes[1].type == N_LIST) {
+        GC_TableCall(stmt);
+        return;
+    }
+
     ListNode funcNameNode = stmt->nodes[1];
     SymbolRecord* funcSym = lookupFunctionSymbolByNameNode(funcNameNode, stmt->lineNum);
     if (funcSym == NULL) return;
@@ -2231,8 +3340,15 @@ SymbolRecord* GC_LoadAliasForStructInitializer(const List *expr, SymbolRecord *s
     if (aliasType != PT_LOOKUP) return NULL;
 
     SymbolRecord *arraySymbol = lookupSymbolNode(alias->nodes[1], alias->lineNum);
-    SymbolRecord *indexSymbol = lookupSymbolNode(alias->nodes[2], alias->lineNum);
+    if (arraySymbol == NULL) return NULL;
+
+    // split arrays are stored to directly using Y as the index
+    if (IS_SPLIT_ARRAY(arraySymbol)) {
+        GC_LoadStructArrayIndex(arraySymbol, alias->nodes[2], alias->lineNum, false);
+        return arraySymbol;
+    }
 
+    SymbolRecord *indexSymbol = lookupSymbolNode(alias->nodes[2], alias->lineNum);
     char multiplier = (char) calcVarSize(structSymbol);
     ICG_MultiplyVarWithConst(indexSymbol, multiplier & 0x7f);
     ICG_StoreToAddr(0x80, 1);
@@ -2272,7 +3388,10 @@ void GC_ProcessInitializerExpr(const List *stmt, ListNode *loadNode, ListNode *s
         if (IS_ALIAS(varSymRec)) {
             List *expr = (*loadNode).value.list;
             SymbolRecord *baseSymbol = GC_LoadAliasForStructInitializer(expr, varSymRec);
-            if (baseSymbol != NULL) {
+            if ((baseSymbol != NULL) && IS_SPLIT_ARRAY(baseSymbol)) {
+                ICG_StoreDataIntoSplitArray((*loadNode), baseSymbol);
+                return;
+            } else if (baseSymbol != NULL) {
                 ICG_LoadAddr(baseSymbol);
                 ICG_AddTempVarToInt(0x80);
                 ICG_StoreToAddr(0x80, 2);
@@ -2305,6 +3424,52 @@ int ScanForIndexOps(const List *expr) {
     return 0;
 }
 
+/**
+ * Assign a value to a packed bool by setting/clearing its bit directly
+ *
+ * @return true if handled  (otherwise the value is worked out in A and stored)
+ */
+bool GC_AssignPackedBool(const SymbolRecord *destVar, ListNode loadNode, int lineNum) {
+    EvalResult evalResult = {false, 0};
+    if (loadNode.type == N_INT) {
+        evalResult.hasResult = true;
+        evalResult.value = loadNode.value.num;
+    } else if (loadNode.type == N_STR) {
+        evalResult = evaluate_variable(loadNode);
+    } else if (loadNode.type == N_LIST) {
+        evalResult = evaluate_expression(loadNode.value.list);
+    }
+    if (evalResult.hasResult) {
+        ICG_SetPackedBool(destVar, evalResult.value != 0);
+        return true;
+    }
+
+    // flag = !flag
+    if ((loadNode.type == N_LIST) && isToken(loadNode.value.list->nodes[0], PT_NOT)) {
+        ListNode notNode = loadNode.value.list->nodes[1];
+        if ((notNode.type == N_STR) && (lookupSymbolNode(notNode, lineNum) == destVar)) {
+            ICG_TogglePackedBool(destVar);
+            return true;
+        }
+    }
+
+    // conditions (and other packed bools) can branch straight to setting or clearing the bit
+    SymbolRecord *srcVar = (loadNode.type == N_STR) ? lookupSymbolNode(loadNode, lineNum) : NULL;
+    bool isCarryCall = (loadNode.type == N_LIST) && isCarryReturnCall(loadNode.value.list);
+    if (isBoolOpNode(loadNode) || isCarryCall || ((srcVar != NULL) && IS_PACKED_BOOL(srcVar))) {
+        Label *falseLabel = newGenericLabel(LBL_CODE);
+        Label *doneLabel = newGenericLabel(LBL_CODE);
+        GC_CondJump(loadNode, falseLabel, false, lineNum);
+        ICG_SetPackedBool(destVar, true);
+        ICG_Jump(doneLabel, "skip clearing");
+        IL_Label(falseLabel);
+        ICG_SetPackedBool(destVar, false);
+        IL_Label(doneLabel);
+        return true;
+    }
+    return false;
+}
+
 /**
  * Process assignment statement
  *
@@ -2319,6 +3484,11 @@ void GC_Assignment(const List *stmt, enum SymbolType destType) {
     SymbolRecord *destVar = getAsgnDestVarSym(stmt, storeNode);
     if (destVar == NULL) return;
 
+    if ((storeNode.type == N_STR) && IS_PACKED_BOOL(destVar) && GC_AssignPackedBool(destVar, loadNode, stmt->lineNum)) {
+        IL_ClearCachedIndex();
+        return;
+    }
+
     // Need to check if destination is array element
     //   if so, process without IS_POINTER check
     if (storeNode.type == N_LIST && isToken(storeNode.value.list->nodes[0], PT_LOOKUP)) {
@@ -2365,6 +3535,8 @@ void GC_Assignment(const List *stmt, enum SymbolType destType) {
 
     if (isInitializerExpr) {
         GC_ProcessInitializerExpr(stmt, &loadNode, &storeNode);
+    } else if ((storeNode.type == N_STR) && isWordSized(destType) && GC_WordOpToVar(destVar, loadNode, stmt->lineNum)) {
+        // 16-bit op was stored directly into the var
     } else {
 
         // figure out where data is coming from
@@ -2482,7 +3654,7 @@ void GC_HandleDirective(const List *code, enum SymbolType destType) {
         } break;
 
         case SET_BANKING:
-            addBankToOutputGenerator();
+            addBankToOutputGenerator((code->count > 2) ? code->nodes[2].value.str : NULL, code->lineNum);
             break;
 
         case SET_ADDRESS:
@@ -2492,6 +3664,22 @@ void GC_HandleDirective(const List *code, enum SymbolType destType) {
         case INLINE:
             // handle #inline directive within code block
             break;
+        case UNROLL:
+            // '#unroll 0' can be used to keep a loop from being unrolled
+            isUnrollPending = true;
+            unrollDisabled = (code->count > 2) && (code->nodes[2].value.num == 0);
+            break;
+        case MAX_LOOPS:
+        case CYCLE_BUDGET:
+            if (code->count > 2) {
+                if (directive == MAX_LOOPS) maxLoopsValue = code->nodes[2].value.num;
+                else cycleBudgetValue = code->nodes[2].value.num;
+            } else {
+                WarningMessage("Directive is missing its value", NULL, code->lineNum);
+                if (directive == MAX_LOOPS) maxLoopsValue = -1;
+                lastDirective = 0;
+            }
+            break;
         default:
             break;
     }
@@ -2531,12 +3719,29 @@ void GC_Statement(List *stmt) {
     int funcIndex;
     ListNode opNode = stmt->nodes[0];
     if (opNode.type == N_TOKEN) {
+        enum ParseToken stmtToken = opNode.value.parseToken;
+
+        // loop directives ('#unroll', '#max_loops') only apply to the statement right after them
+        bool isUnrollable = (stmtToken == PT_FOR) || (stmtToken == PT_LOOP);
+        bool isLoop = isUnrollable || (stmtToken == PT_WHILE) || (stmtToken == PT_DOWHILE);
+        if (isUnrollPending && !isUnrollable && (stmtToken != PT_DIRECTIVE)) {
+            WarningMessage("'#unroll' is only used by 'for' and 'loop' statements", NULL, stmt->lineNum);
+            isUnrollPending = false;
+        }
+        if ((maxLoopsValue >= 0) && !isLoop && (stmtToken != PT_DIRECTIVE)) {
+            WarningMessage("'#max_loops' is only used by loops", NULL, stmt->lineNum);
+            maxLoopsValue = -1;
+        }
 
         // using statement token, lookup and call appropriate code generator function
-        funcIndex = findFunc(stmtFunction, stmtFunctionSize, opNode.value.parseToken);
+        funcIndex = findFunc(stmtFunction, stmtFunctionSize, stmtToken);
         if (funcIndex >= 0) {
             stmtFunction[funcIndex].parseFunc(stmt, ST_NONE);
         }
+        if (isLoop) {
+            isUnrollPending = false;
+            maxLoopsValue = -1;
+        }
     } else {
         ErrorMessageWithList("Error in statement: ", stmt);
     }
@@ -2618,6 +3823,44 @@ List *GC_ProcessStringLiteral(const List *varDef, ListNode stringNode) {
     return byteList;
 }
 
+/**
+ * Generate a function table  (and the routine that calls thru it)
+ *
+ *  Tables that are never called are left out, along with any
+ *  functions only they would have used.
+ */
+void GC_FuncTable(const List *varDef, SymbolRecord *tableSym) {
+    if ((tableSym->astList == NULL) || (tableSym->cntAccesses == 0)) return;
+
+    if (OB_UsesBankPlacement()) {
+        ErrorMessage("Function tables can't be used with bank switching", tableSym->name, varDef->lineNum);
+        return;
+    }
+
+    // functions are called thru the table without any setup
+    const List *funcList = tableSym->astList;
+    for_range(index, 1, funcList->count) {
+        ListNode funcNode = funcList->nodes[index];
+        SymbolRecord *funcSym = (funcNode.type == N_STR) ? findSymbol(mainSymbolTable, funcNode.value.str) : NULL;
+        if ((funcSym == NULL) || !isFunction(funcSym)) {
+            ErrorMessageWithNode("Function table entry is not a function", funcNode, varDef->lineNum);
+            return;
+        }
+
+        SymbolList *funcParamList = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
+        if ((funcParamList != NULL) && (funcParamList->count > 0)) {
+            ErrorMessage("Functions in a function table can't have parameters", funcSym->name, varDef->lineNum);
+            return;
+        }
+        if (IS_INLINED_FUNCTION(funcSym)) {
+            ErrorMessage("Functions in a function table can't be inlined", funcSym->name, varDef->lineNum);
+            return;
+        }
+    }
+
+    ICG_AddFuncTable(tableSym);
+}
+
 /**
  * Generate Code for global variables that have initializers.
  * @param varDef
@@ -2634,9 +3877,15 @@ void GC_Variable(const List *varDef) {
         unsigned char multiplier = getBaseVarSize(varSymRec);
 
         // only generate a multiplication lookup table if the multiplier is greater than 2 (not a primitive var)
-        if (multiplier > 2) {
-            SymbolRecord *lookupTable = ICG_Mul_AddLookupTable(multiplier);
-            GC_OB_AddDataBlock(lookupTable);
+        if (IS_SPLIT_ARRAY(varSymRec)) {
+            // each property is its own array, so the index is never multiplied
+            WarningMessage("'#use_quick_index_table' has no effect on a split array", varName, varDef->lineNum);
+        } else if (multiplier > 2) {
+            // structs of the same size can share the same table
+            if ((multiplier >= 64) || !hasValueLookupTable(multiplier)) {
+                SymbolRecord *lookupTable = ICG_Mul_AddLookupTable(multiplier);
+                GC_OB_AddDataBlock(lookupTable);
+            }
 
         } else {
             printf("Warning: Cannot generate quick index table for %s\n", varName);
@@ -2657,6 +3906,11 @@ void GC_Variable(const List *varDef) {
             return;
         }
 
+        if (IS_FUNC_TABLE(varSymRec)) {
+            GC_FuncTable(varDef, varSymRec);
+            return;
+        }
+
         enum NodeType initType = getInitializerType(varDef->nodes[4]);
 
         // Handle strings
@@ -2721,7 +3975,11 @@ void GC_CodeBlock(List *code) {
 void GC_PreloadParams(SymbolList *params) {
     for_range(paramCnt, 0, params->count) {
         SymbolRecord *curParam = params->list[paramCnt];
-        if (curParam->hint != VH_NONE) IL_Preload(curParam);
+        if (curParam->hint == VH_NONE) continue;
+
+        // params passed in a register also have a spot in the frame
+        if (IS_FRAME_PARAM(curParam)) ICG_SaveRegParam(curParam);
+        IL_Preload(curParam);
     }
 }
 
@@ -2733,6 +3991,7 @@ void GC_ProcessFunction(SymbolRecord *funcSym, List *code) {
     ICG_StartOfFunction(funcLabel, funcSym);
 
     // load in local symbol table for function
+    curFuncSym = funcSym;
     curFuncSymbolTable = GET_LOCAL_SYMBOL_TABLE(funcSym);
     setEvalLocalSymbolTable(curFuncSymbolTable);
 
@@ -2746,6 +4005,7 @@ void GC_ProcessFunction(SymbolRecord *funcSym, List *code) {
 
     GC_CodeBlock(code);
     funcSym->instrBlock = ICG_EndOfFunction();
+    GL_PlaceColdBlocks(funcSym->instrBlock);
     funcSym->astList = code;
 
     setEvalLocalSymbolTable(NULL);
@@ -2761,6 +4021,12 @@ void GC_Function(const List *function) {
         return;
     }
 
+    // check if function has a cycle budget  (checked once the code is final)
+    if (lastDirective == CYCLE_BUDGET) {
+        CT_SetCycleBudget(funcName, cycleBudgetValue, function->lineNum);
+        lastDirective = 0;
+    }
+
     // check if function has been flagged to be inlined wherever it's used
     bool isInlineFunction = (lastDirective == INLINE);
     if (isInlineFunction) {
@@ -2795,7 +4061,12 @@ void GC_Function(const List *function) {
                 if ((outputBlock != NULL) && compilerOptions.runOptimizer) {
                     OPT_CodeBlock(outputBlock);
                 }
-                OPT_CheckBranchAlignment(outputBlock);
+
+                // summarize what the final code modifies, for the callers
+                FM_calcClobberSummary(funcSym, mainSymbolTable);
+
+                // with bank placement, final locations are not known yet (checked after placement)
+                if (!OB_UsesBankPlacement()) OPT_CheckBranchAlignment(outputBlock);
             }
         } else {
 
@@ -2817,6 +4088,17 @@ void GC_Function(const List *function) {
     }
 }
 
+/**
+ * Generate the clones of a function that were specialized for constant args
+ */
+void GC_SpecializedFunctions(const List *function) {
+    char *funcName = function->nodes[1].value.str;
+    int cntClones = GSP_GetCloneCount(funcName);
+    for_range(cloneIdx, 0, cntClones) {
+        GC_Function(GSP_GetCloneDef(funcName, cloneIdx));
+    }
+}
+
 //--------------------------------------------------------------
 //  Walk the program
 
@@ -2838,7 +4120,7 @@ void GC_ProcessProgram(ListNode node) {
             if (opNode.type == N_TOKEN) {
                 // Only need to process functions since variables were already processed in the symbol generator module
                 switch (opNode.value.parseToken) {
-                    case PT_FUNCTION:    GC_Function(statement); break;
+                    case PT_FUNCTION:    GC_Function(statement); GC_SpecializedFunctions(statement); break;
                     case PT_DEFINE:   GC_Variable(statement); break;
                     case PT_STRUCT:   break;
                     case PT_UNION:    break;
@@ -2860,6 +4142,8 @@ void GC_ProcessProgram(ListNode node) {
 void initCodeGenerator(SymbolTable *symbolTable, enum Machines machines) {
     mainSymbolTable = symbolTable;
     ICG_Mul_InitLookupTables(symbolTable);
+    ICG_Startup_Init(symbolTable);
+    ICG_Dispatch_Init(symbolTable);
     IL_Init();
 }
 
@@ -25,5 +25,6 @@
 
 extern void initCodeGenerator(SymbolTable *symbolTable, enum Machines machines);
 extern void generate_code(char *name, ListNode node);
+extern ListNode cloneWithConstValue(const List *srcList, const char *cntVarName, int value);
 
 #endif //MODULE_GEN_CODE_H
@@ -0,0 +1,630 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Neolithic Module: GH - Hoisting loop invariant expressions
+//
+//  Runs on the AST of each function before code generation.  Any byte-sized
+//  expression inside a loop that only uses variables the loop never writes
+//  is computed once before the loop, into a new local variable:
+//
+//      while (...) {                   (code
+//          x = arr[j] + k*3              (set, 'inv_1', (add, (lookup, 'arr', 'j'), (mul, 'k', 3)))
+//      }                                 (while ... (set, 'x', 'inv_1')))
+//
+//  The new local is given zeropage space by the variable allocator, like
+//  any other local.
+//
+//  Globals are only treated as unchanging when the loop doesn't call any
+//  functions, and there are no interrupt handlers.  The same goes for locals
+//  that have their address taken anywhere in the function.  Vars at fixed
+//  addresses (hardware registers) are never hoisted, and nothing is hoisted
+//  from a loop that stores thru a pointer or a param.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "gen_hoist.h"
+
+#define MAX_LOOP_WRITES 32
+#define MAX_HOISTED_PER_LOOP 4
+#define MAX_ADDR_TAKEN 16
+
+typedef struct {
+    const char *writtenVars[MAX_LOOP_WRITES];
+    int cntWrittenVars;
+    bool isUnsafe;              // nothing can be hoisted (asm, writes via pointers, aliases...)
+    bool hasFuncCall;           // only locals are safe from being changed
+
+    ListNode hoistedExprs[MAX_HOISTED_PER_LOOP];
+    SymbolRecord *hoistedVars[MAX_HOISTED_PER_LOOP];
+    int cntHoisted;
+} LoopInfo;
+
+static SymbolRecord *curFuncSym;
+static SymbolTable *mainSymTbl;
+static bool hasInterruptHandlers;
+
+static const char *addrTakenVars[MAX_ADDR_TAKEN];    // vars that can be changed thru a pointer
+static int cntAddrTaken;
+static bool hasTooManyAddrTaken;
+
+//-----------------------------------------------------------------------
+
+SymbolRecord *GH_FindSymbol(const char *name) {
+    SymbolRecord *symbol = NULL;
+    SymbolTable *localSymTbl = GET_LOCAL_SYMBOL_TABLE(curFuncSym);
+    if (localSymTbl != NULL) symbol = findSymbol(localSymTbl, name);
+    if (symbol == NULL) symbol = findSymbol(mainSymTbl, name);
+    return symbol;
+}
+
+bool isNodeEqual(ListNode node1, ListNode node2) {
+    if (node1.type != node2.type) return false;
+    switch (node1.type) {
+        case N_INT:   return (node1.value.num == node2.value.num);
+        case N_STR:   return (strncmp(node1.value.str, node2.value.str, SYMBOL_NAME_LIMIT) == 0);
+        case N_TOKEN: return (node1.value.parseToken == node2.value.parseToken);
+        case N_LIST: {
+            List *list1 = node1.value.list;
+            List *list2 = node2.value.list;
+            if (list1->count != list2->count) return false;
+            for_range(index, 0, list1->count) {
+                if (!isNodeEqual(list1->nodes[index], list2->nodes[index])) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Get the var at the bottom of an lvalue  (the array of 'arr[i].x')
+ */
+const char *getBaseVarName(ListNode node) {
+    while (node.type == N_LIST) {
+        List *expr = node.value.list;
+        if (!isToken(expr->nodes[0], PT_LOOKUP) && !isToken(expr->nodes[0], PT_PROPERTY_REF)) return NULL;
+        node = expr->nodes[1];
+    }
+    return (node.type == N_STR) ? node.value.str : NULL;
+}
+
+//-----------------------------------------------------------------------
+//  Find the vars that have their address taken
+
+bool isAddrTaken(const char *varName) {
+    if (hasTooManyAddrTaken) return true;
+    for_range(index, 0, cntAddrTaken) {
+        if (strncmp(addrTakenVars[index], varName, SYMBOL_NAME_LIMIT) == 0) return true;
+    }
+    return false;
+}
+
+void collectAddrTaken(const List *code) {
+    if (code->count < 1) return;
+
+    if (isToken(code->nodes[0], PT_ADDR_OF) && (code->count > 1)) {
+        const char *varName = getBaseVarName(code->nodes[1]);
+        if ((varName == NULL) || (cntAddrTaken >= MAX_ADDR_TAKEN)) {
+            hasTooManyAddrTaken = true;
+        } else if (!isAddrTaken(varName)) {
+            addrTakenVars[cntAddrTaken++] = varName;
+        }
+    }
+
+    for_range(index, 0, code->count) {
+        if (code->nodes[index].type == N_LIST) collectAddrTaken(code->nodes[index].value.list);
+    }
+}
+
+//-----------------------------------------------------------------------
+//  Find the vars written by a loop
+
+void markWritten(LoopInfo *loopInfo, const char *varName) {
+    if (loopInfo->cntWrittenVars >= MAX_LOOP_WRITES) {
+        loopInfo->isUnsafe = true;
+        return;
+    }
+    loopInfo->writtenVars[loopInfo->cntWrittenVars++] = varName;
+}
+
+bool isWritten(const LoopInfo *loopInfo, const char *varName) {
+    for_range(index, 0, loopInfo->cntWrittenVars) {
+        if (strncmp(loopInfo->writtenVars[index], varName, SYMBOL_NAME_LIMIT) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * Mark the variable being stored to  (var, array element or struct property)
+ */
+void markTargetWritten(LoopInfo *loopInfo, ListNode targetNode) {
+    if (targetNode.type == N_STR) {
+        SymbolRecord *varSym = GH_FindSymbol(targetNode.value.str);
+        if ((varSym != NULL) && IS_ALIAS(varSym)) loopInfo->isUnsafe = true;
+        markWritten(loopInfo, targetNode.value.str);
+        return;
+    }
+    if (targetNode.type != N_LIST) {
+        loopInfo->isUnsafe = true;
+        return;
+    }
+
+    List *targetExpr = targetNode.value.list;
+    if (isToken(targetExpr->nodes[0], PT_LOOKUP) || isToken(targetExpr->nodes[0], PT_PROPERTY_REF)) {
+        const char *baseName = getBaseVarName(targetNode);
+        SymbolRecord *baseSym = (baseName != NULL) ? GH_FindSymbol(baseName) : NULL;
+        bool isArrayStore = isToken(targetExpr->nodes[0], PT_LOOKUP);
+        if ((baseSym == NULL) || isPointer(baseSym) || IS_PARAM_VAR(baseSym) || IS_ALIAS(baseSym)
+            || (isArrayStore && ((targetExpr->nodes[1].type != N_STR) || !isArray(baseSym)))) {
+            // writing thru a pointer (or a param) could change anything
+            loopInfo->isUnsafe = true;
+            return;
+        }
+        markWritten(loopInfo, baseName);
+    } else {
+        loopInfo->isUnsafe = true;
+    }
+}
+
+void collectLoopWrites(LoopInfo *loopInfo, const List *code) {
+    if (code->count < 1) return;
+
+    ListNode opNode = code->nodes[0];
+    if (opNode.type == N_TOKEN) {
+        switch (opNode.value.parseToken) {
+            case PT_SET: case PT_INC: case PT_DEC: case PT_ADDR_OF: case PT_LOOP:
+                markTargetWritten(loopInfo, code->nodes[1]);
+                break;
+            case PT_DEFINE:
+                markWritten(loopInfo, code->nodes[1].value.str);
+                break;
+            case PT_FUNC_CALL: {
+                loopInfo->hasFuncCall = true;
+                // calling the same function would overwrite its locals
+                if ((code->nodes[1].type == N_STR)
+                    && (strncmp(code->nodes[1].value.str, curFuncSym->name, SYMBOL_NAME_LIMIT) == 0)) {
+                    loopInfo->isUnsafe = true;
+                }
+            } break;
+            case PT_ASM: case PT_LABEL:
+                loopInfo->isUnsafe = true;
+                return;
+            default:
+                break;
+        }
+    }
+
+    for_range(index, 0, code->count) {
+        if (code->nodes[index].type == N_LIST) collectLoopWrites(loopInfo, code->nodes[index].value.list);
+    }
+}
+
+//-----------------------------------------------------------------------
+//  Check which expressions don't change within a loop
+
+/**
+ * Check if a var/array keeps its value for the whole loop
+ */
+bool isUnchangedVar(const LoopInfo *loopInfo, const SymbolRecord *varSym) {
+    if ((varSym->flags & MF_HINT) || IS_ALIAS(varSym)) return false;
+
+    // anything else could change it, unless it's a local nothing points to
+    bool isShared = !IS_LOCAL(varSym) || isAddrTaken(varSym->name);
+    if (isShared && (loopInfo->hasFuncCall || hasInterruptHandlers)) return false;
+    return !isWritten(loopInfo, varSym->name);
+}
+
+bool isByteProperty(const SymbolRecord *structSym, ListNode propNode) {
+    if ((structSym->userTypeDef == NULL) || (propNode.type != N_STR)) return false;
+    SymbolRecord *propSym = findSymbol(getStructSymbolSet(structSym), propNode.value.str);
+    return (propSym != NULL) && (getBaseVarSize(propSym) == 1);
+}
+
+/**
+ * Check if an expression has the same value for every time thru the loop
+ *
+ * @param usesVar - set if the expression reads any variables
+ * @param isSigned - set if any of the variables are signed
+ */
+bool isInvariantNode(const LoopInfo *loopInfo, ListNode node, bool *usesVar, bool *isSigned) {
+    switch (node.type) {
+        case N_INT:
+            return true;
+        case N_STR: {
+            SymbolRecord *varSym = GH_FindSymbol(node.value.str);
+            if (varSym == NULL) return false;
+            if (isConst(varSym)) return !isArray(varSym);
+            if ((varSym->kind != SK_VAR) || isArray(varSym) || isPointer(varSym)
+                || (getType(varSym) == ST_STRUCT) || (getBaseVarSize(varSym) != 1)) return false;
+            if (!isUnchangedVar(loopInfo, varSym)) return false;
+
+            *usesVar = true;
+            if (varSym->flags & ST_SIGNED) *isSigned = true;
+            return true;
+        }
+        case N_LIST:
+            break;
+        default:
+            return false;
+    }
+
+    List *expr = node.value.list;
+    if (expr->nodes[0].type != N_TOKEN) return false;
+
+    switch (expr->nodes[0].value.parseToken) {
+        case PT_ADD: case PT_SUB: case PT_BIT_AND: case PT_BIT_OR: case PT_BIT_EOR:
+        case PT_SHIFT_LEFT: case PT_SHIFT_RIGHT: case PT_INVERT: case PT_NEGATIVE:
+            break;
+
+        case PT_MULTIPLY:
+            // only multiplies by a constant are supported
+            if ((expr->nodes[1].type != N_INT) && (expr->nodes[2].type != N_INT)) return false;
+            break;
+        case PT_DIVIDE:
+            if ((expr->nodes[2].type != N_INT) || (expr->nodes[2].value.num == 0)) return false;
+            break;
+
+        case PT_LOOKUP: {
+            if (expr->nodes[1].type != N_STR) return false;
+            SymbolRecord *arraySym = GH_FindSymbol(expr->nodes[1].value.str);
+            if ((arraySym == NULL) || !isArray(arraySym) || isPointer(arraySym)
+                || (arraySym->userTypeDef != NULL) || (getBaseVarSize(arraySym) != 1)) return false;
+            if (!isConst(arraySym) && !isUnchangedVar(loopInfo, arraySym)) return false;
+
+            *usesVar = true;
+            if (arraySym->flags & ST_SIGNED) *isSigned = true;
+            return isInvariantNode(loopInfo, expr->nodes[2], usesVar, isSigned);
+        }
+
+        case PT_PROPERTY_REF: {
+            ListNode structNode = expr->nodes[1];
+            ListNode indexNode = createIntNode(0);
+            if ((structNode.type == N_LIST) && isToken(structNode.value.list->nodes[0], PT_LOOKUP)) {
+                indexNode = structNode.value.list->nodes[2];
+                structNode = structNode.value.list->nodes[1];
+            }
+            if (structNode.type != N_STR) return false;
+
+            SymbolRecord *structSym = GH_FindSymbol(structNode.value.str);
+            if (structSym == NULL) return false;
+            if (isEnum(structSym)) return true;
+            if (IS_PARAM_VAR(structSym) || isPointer(structSym) || !isByteProperty(structSym, expr->nodes[2])) return false;
+            if (!isUnchangedVar(loopInfo, structSym)) return false;
+            if ((indexNode.type != N_INT) && (indexNode.type != N_STR)) return false;
+
+            *usesVar = true;
+            return isInvariantNode(loopInfo, indexNode, usesVar, isSigned);
+        }
+
+        default:
+            return false;
+    }
+
+    for_range(index, 1, expr->count) {
+        if (!isInvariantNode(loopInfo, expr->nodes[index], usesVar, isSigned)) return false;
+    }
+    return true;
+}
+
+/**
+ * Check if computing an expression ahead of time saves anything
+ *   (simple loads are as cheap as loading the saved value)
+ */
+bool isWorthHoisting(const List *expr, bool isArrayIndex) {
+    switch (expr->nodes[0].value.parseToken) {
+        case PT_LOOKUP:
+            return (expr->nodes[2].type != N_INT);
+        case PT_PROPERTY_REF: {
+            ListNode structNode = expr->nodes[1];
+            return (structNode.type == N_LIST) && (structNode.value.list->nodes[2].type != N_INT);
+        }
+        case PT_ADD: case PT_SUB:
+            // (var+n) index is just an offset added to the array address
+            return !(isArrayIndex && (expr->nodes[1].type == N_STR) && (expr->nodes[2].type == N_INT));
+        default:
+            return true;
+    }
+}
+
+/**
+ * Check that nothing in an expression is 16-bit  (hoisted values are bytes)
+ */
+bool isByteExpr(ListNode node) {
+    switch (node.type) {
+        case N_STR: {
+            SymbolRecord *varSym = GH_FindSymbol(node.value.str);
+            if (varSym == NULL) return false;
+            if (isEnum(varSym) || isStruct(varSym) || isUnion(varSym)) return true;
+            return !(isPointer(varSym) && !isArray(varSym)) && (getBaseVarSize(varSym) == 1);
+        }
+        case N_LIST: {
+            List *expr = node.value.list;
+            if (isToken(expr->nodes[0], PT_FUNC_CALL) || isToken(expr->nodes[0], PT_ADDR_OF)) return false;
+
+            if (isToken(expr->nodes[0], PT_PROPERTY_REF)) {
+                // check the property, and the index for an array of structs
+                ListNode structNode = expr->nodes[1];
+                ListNode indexNode = createIntNode(0);
+                if ((structNode.type == N_LIST) && isToken(structNode.value.list->nodes[0], PT_LOOKUP)) {
+                    indexNode = structNode.value.list->nodes[2];
+                    structNode = structNode.value.list->nodes[1];
+                }
+                if (structNode.type != N_STR) return false;
+                SymbolRecord *structSym = GH_FindSymbol(structNode.value.str);
+                if ((structSym == NULL) || isEnum(structSym)) return (structSym != NULL);
+                return isByteProperty(structSym, expr->nodes[2]) && isByteExpr(indexNode);
+            }
+
+            for_range(index, 0, expr->count) {
+                if (!isByteExpr(expr->nodes[index])) return false;
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+//-----------------------------------------------------------------------
+//  Move invariant expressions out of a loop
+
+char *makeHoistVarName() {
+    char *varName = allocMem(16);
+    int varNum = 1;
+    do {
+        sprintf(varName, "inv_%d", varNum++);
+    } while (GH_FindSymbol(varName) != NULL);
+    return varName;
+}
+
+/**
+ * Replace an expression with a local var that's set before the loop
+ *   (the same expression used more than once shares the var)
+ */
+void replaceWithHoistVar(LoopInfo *loopInfo, ListNode *node, bool isSigned) {
+    for_range(index, 0, loopInfo->cntHoisted) {
+        if (isNodeEqual(loopInfo->hoistedExprs[index], *node)) {
+            *node = createStrNode(loopInfo->hoistedVars[index]->name);
+            return;
+        }
+    }
+    if (loopInfo->cntHoisted >= MAX_HOISTED_PER_LOOP) return;
+
+    if (GET_LOCAL_SYMBOL_TABLE(curFuncSym) == NULL) {
+        curFuncSym->symbolTbl = initSymbolTable(curFuncSym->name, mainSymTbl);
+    }
+    SymbolRecord *varSym = addSymbol(GET_LOCAL_SYMBOL_TABLE(curFuncSym), makeHoistVarName(), SK_VAR,
+                                     ST_CHAR | (isSigned ? ST_SIGNED : ST_UNSIGNED), SS_ZEROPAGE | MF_LOCAL);
+    setSymbolArraySize(varSym, 1);
+
+    loopInfo->hoistedExprs[loopInfo->cntHoisted] = *node;
+    loopInfo->hoistedVars[loopInfo->cntHoisted] = varSym;
+    loopInfo->cntHoisted++;
+
+    *node = createStrNode(varSym->name);
+}
+
+void hoistFromExpr(LoopInfo *loopInfo, ListNode *node, bool isArrayIndex) {
+    if (node->type != N_LIST) return;
+    List *expr = node->value.list;
+    if (expr->nodes[0].type != N_TOKEN) return;
+
+    bool usesVar = false;
+    bool isSigned = false;
+    if (isInvariantNode(loopInfo, *node, &usesVar, &isSigned) && usesVar && isWorthHoisting(expr, isArrayIndex)) {
+        replaceWithHoistVar(loopInfo, node, isSigned);
+        return;
+    }
+
+    // look for smaller pieces that can be moved
+    switch (expr->nodes[0].value.parseToken) {
+        case PT_ADD: case PT_SUB: case PT_BIT_AND: case PT_BIT_OR: case PT_BIT_EOR:
+        case PT_SHIFT_LEFT: case PT_SHIFT_RIGHT: case PT_INVERT: case PT_NEGATIVE:
+        case PT_MULTIPLY: case PT_DIVIDE:
+        case PT_EQ: case PT_NE: case PT_GT: case PT_GTE: case PT_LT: case PT_LTE:
+        case PT_BOOL_AND: case PT_BOOL_OR: case PT_NOT:
+            for_range(index, 1, expr->count) {
+                hoistFromExpr(loopInfo, &expr->nodes[index], false);
+            }
+            break;
+        case PT_LOOKUP:
+            hoistFromExpr(loopInfo, &expr->nodes[2], true);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Check that all the params of a function are bytes
+ */
+bool hasByteParams(ListNode funcNameNode) {
+    if (funcNameNode.type != N_STR) return false;
+    SymbolRecord *funcSym = findSymbol(mainSymTbl, funcNameNode.value.str);
+    if ((funcSym == NULL) || !isFunction(funcSym)) return false;
+    if (GET_LOCAL_SYMBOL_TABLE(funcSym) == NULL) return true;
+
+    SymbolList *params = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
+    for_range(paramIdx, 0, params->count) {
+        const SymbolRecord *paramSym = params->list[paramIdx];
+        if ((getBaseVarSize(paramSym) != 1) || isPointer(paramSym)) return false;
+    }
+    return true;
+}
+
+void hoistFromBlock(LoopInfo *loopInfo, List *code);
+
+void hoistFromStatement(LoopInfo *loopInfo, List *stmt) {
+    if (stmt->nodes[0].type != N_TOKEN) return;
+
+    switch (stmt->nodes[0].value.parseToken) {
+        case PT_SET: {
+            ListNode targetNode = stmt->nodes[1];
+            if (!isByteExpr(targetNode) || !isByteExpr(stmt->nodes[2])) break;
+            if ((targetNode.type == N_LIST) && isToken(targetNode.value.list->nodes[0], PT_LOOKUP)) {
+                hoistFromExpr(loopInfo, &targetNode.value.list->nodes[2], true);
+            }
+            hoistFromExpr(loopInfo, &stmt->nodes[2], false);
+        } break;
+
+        case PT_IF:
+            if (isByteExpr(stmt->nodes[1])) hoistFromExpr(loopInfo, &stmt->nodes[1], false);
+            hoistFromBlock(loopInfo, stmt->nodes[2].value.list);
+            if ((stmt->count > 3) && (stmt->nodes[3].type == N_LIST)) {
+                hoistFromBlock(loopInfo, stmt->nodes[3].value.list);
+            }
+            break;
+
+        case PT_FUNC_CALL: {
+            // argument setup
+            bool hasArgs = (stmt->count > 2) && (stmt->nodes[2].type == N_LIST);
+            if (!hasArgs || !hasByteParams(stmt->nodes[1])) break;
+            List *args = stmt->nodes[2].value.list;
+            for_range(argIdx, 0, args->count) {
+                if (isByteExpr(args->nodes[argIdx])) hoistFromExpr(loopInfo, &args->nodes[argIdx], false);
+            }
+        } break;
+
+        case PT_CODE:
+            hoistFromBlock(loopInfo, stmt);
+            break;
+
+        default:
+            // nested loops already had their own invariants moved out
+            break;
+    }
+}
+
+void hoistFromBlock(LoopInfo *loopInfo, List *code) {
+    if (isToken(code->nodes[0], PT_ASM)) return;
+    for_range(stmtNum, 1, code->count) {
+        if (code->nodes[stmtNum].type == N_LIST) hoistFromStatement(loopInfo, code->nodes[stmtNum].value.list);
+    }
+}
+
+/**
+ * Move the invariant expressions out of a loop, into a new code block
+ *   that sets the hoisted vars and then does the loop.
+ */
+void hoistFromLoop(List *block, int stmtNum) {
+    List *loopStmt = block->nodes[stmtNum].value.list;
+
+    // keep directives (like #unroll) right before their loop
+    if (isToken(block->nodes[stmtNum-1], PT_DIRECTIVE)) return;
+    if ((block->nodes[stmtNum-1].type == N_LIST) && isToken(block->nodes[stmtNum-1].value.list->nodes[0], PT_DIRECTIVE)) return;
+
+    LoopInfo loopInfo;
+    memset(&loopInfo, 0, sizeof(LoopInfo));
+    collectLoopWrites(&loopInfo, loopStmt);
+    if (loopInfo.isUnsafe) return;
+
+    switch (loopStmt->nodes[0].value.parseToken) {
+        case PT_FOR:
+            if (isByteExpr(loopStmt->nodes[2])) hoistFromExpr(&loopInfo, &loopStmt->nodes[2], false);
+            hoistFromBlock(&loopInfo, loopStmt->nodes[4].value.list);
+            break;
+        case PT_WHILE:
+            if (isByteExpr(loopStmt->nodes[1])) hoistFromExpr(&loopInfo, &loopStmt->nodes[1], false);
+            hoistFromBlock(&loopInfo, loopStmt->nodes[2].value.list);
+            break;
+        case PT_DOWHILE:
+            hoistFromBlock(&loopInfo, loopStmt->nodes[1].value.list);
+            if (isByteExpr(loopStmt->nodes[2])) hoistFromExpr(&loopInfo, &loopStmt->nodes[2], false);
+            break;
+        case PT_LOOP:
+            hoistFromBlock(&loopInfo, loopStmt->nodes[4].value.list);
+            break;
+        default:
+            break;
+    }
+    if (loopInfo.cntHoisted == 0) return;
+
+    //--- build the new block:  (code, (set, hoistVar, expr), ..., loop)
+    List *newBlock = createList(loopInfo.cntHoisted + 2);
+    newBlock->lineNum = loopStmt->lineNum;
+    newBlock->progLine = loopStmt->progLine;
+    addNode(newBlock, createParseToken(PT_CODE));
+
+    for_range(index, 0, loopInfo.cntHoisted) {
+        List *setStmt = createList(3);
+        setStmt->lineNum = loopStmt->lineNum;
+        setStmt->progLine = loopStmt->progLine;
+        addNode(setStmt, createParseToken(PT_SET));
+        addNode(setStmt, createStrNode(loopInfo.hoistedVars[index]->name));
+        addNode(setStmt, loopInfo.hoistedExprs[index]);
+        addNode(newBlock, createListNode(setStmt));
+    }
+    addNode(newBlock, createListNode(loopStmt));
+    block->nodes[stmtNum] = createListNode(newBlock);
+}
+
+bool isLoopStatement(const List *stmt) {
+    ListNode opNode = stmt->nodes[0];
+    return isToken(opNode, PT_WHILE) || isToken(opNode, PT_DOWHILE)
+           || isToken(opNode, PT_FOR) || isToken(opNode, PT_LOOP);
+}
+
+/**
+ * Walk a code block looking for loops  (inner loops are done first)
+ */
+void GH_HoistInBlock(List *block) {
+    if ((block->count < 1) || isToken(block->nodes[0], PT_ASM)) return;
+
+    for_range(stmtNum, 1, block->count) {
+        if (block->nodes[stmtNum].type != N_LIST) continue;
+        List *stmt = block->nodes[stmtNum].value.list;
+
+        // look into any code blocks within the statement
+        for_range(nodeNum, 1, stmt->count) {
+            ListNode node = stmt->nodes[nodeNum];
+            if ((node.type == N_LIST) && isToken(node.value.list->nodes[0], PT_CODE)) {
+                GH_HoistInBlock(node.value.list);
+            }
+        }
+        if (isToken(stmt->nodes[0], PT_CODE)) GH_HoistInBlock(stmt);
+
+        if (isLoopStatement(stmt)) hoistFromLoop(block, stmtNum);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Move loop invariant expressions out of the loops in a function
+ *
+ * @param code - code block of function
+ * @param funcSym - function symbol (hoisted values become its local vars)
+ * @param symbolTable - main symbol table
+ */
+void GH_HoistLoopInvariants(List *code, SymbolRecord *funcSym, SymbolTable *symbolTable) {
+    curFuncSym = funcSym;
+    mainSymTbl = symbolTable;
+
+    SymbolRecord *irqSym = findSymbol(symbolTable, "irq");
+    SymbolRecord *nmiSym = findSymbol(symbolTable, "nmi");
+    hasInterruptHandlers = ((irqSym != NULL) && isFunction(irqSym)) || ((nmiSym != NULL) && isFunction(nmiSym));
+
+    cntAddrTaken = 0;
+    hasTooManyAddrTaken = false;
+    collectAddrTaken(code);
+
+    GH_HoistInBlock(code);
+}
@@ -0,0 +1,27 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef MODULE_GEN_HOIST_H
+#define MODULE_GEN_HOIST_H
+
+#include "data/symbols.h"
+#include "data/syntax_tree.h"
+
+extern void GH_HoistLoopInvariants(List *code, SymbolRecord *funcSym, SymbolTable *symbolTable);
+
+#endif //MODULE_GEN_HOIST_H
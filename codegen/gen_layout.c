@@ -0,0 +1,222 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Neolithic Module: GL - Hot/cold code layout
+//
+//  Code is generated in source order, so the body of an 'if' sits right
+//  after the branch that skips it.  When that body rarely runs (an early
+//  return, or an 'if' marked with '#unlikely'), the common path has to take
+//  the branch every time, and the rare code sits in the middle of loops.
+//
+//  The code generator marks those cold blocks while it works.  Once the
+//  function is done, they are moved after its final RTS/JMP:
+//
+//        BEQ skip             BNE cold
+//        <cold code>          <code after if>
+//   skip:                     ...
+//        <code after if>      RTS
+//        ...             cold:
+//        RTS                  <cold code>
+//                             JMP skip        (unless it ends in RTS/JMP)
+//
+//  Loops already fall thru into their body and jump back, so only 'if'
+//  blocks are moved.  A block stays put when the branch to its new spot
+//  would be out of range, or when it branches to code outside of itself.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "common/common.h"
+#include "gen_layout.h"
+
+#define MAX_COLD_BLOCKS     32
+#define MAX_BRANCH_REACH    127
+
+typedef struct {
+    Instr *condStart;           // first instruction of the 'if' conditional
+    Instr *branchInstr;         // branch that skips the cold code (needs inverting)  -or- NULL
+    Instr *hotJump;             // jump in the hot code over the cold code  -or- NULL
+    Instr *firstInstr;
+    Instr *lastInstr;
+    Label *resumeLabel;         // where the cold code continues
+} ColdBlock;
+
+static ColdBlock coldBlocks[MAX_COLD_BLOCKS];
+static int coldBlockCount = 0;
+
+//-----------------------------------------------------------------------
+
+static bool isExitInstr(const Instr *instr) {
+    return (instr->mne == RTS) || (instr->mne == RTI) || (instr->mne == JMP);
+}
+
+static bool isInRange(const Instr *instr, Instr *firstInstr, const Instr *lastInstr) {
+    for (Instr *curInstr = firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        if (curInstr == instr) return true;
+        if (curInstr == lastInstr) break;
+    }
+    return false;
+}
+
+static bool isLabelInRange(const char *labelName, Instr *firstInstr, const Instr *lastInstr) {
+    for (Instr *curInstr = firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        if ((curInstr->label != NULL) && (strcmp(curInstr->label->name, labelName) == 0)) return true;
+        if (curInstr == lastInstr) break;
+    }
+    return false;
+}
+
+/**
+ * Add a cold block to the list
+ *
+ * Any cold blocks inside of it are dropped, since they get moved along with it.
+ */
+static void addColdBlock(const ColdBlock *coldBlock) {
+    int keepCount = 0;
+    for_range(blockIdx, 0, coldBlockCount) {
+        if (!isInRange(coldBlocks[blockIdx].firstInstr, coldBlock->firstInstr, coldBlock->lastInstr)) {
+            coldBlocks[keepCount++] = coldBlocks[blockIdx];
+        }
+    }
+    coldBlockCount = keepCount;
+
+    if (coldBlockCount < MAX_COLD_BLOCKS) {
+        coldBlocks[coldBlockCount++] = *coldBlock;
+    }
+}
+
+static Instr *getCondStart(Instr *startOfIf) {
+    return (startOfIf != NULL) ? startOfIf->nextInstr : IB_GetCurrentBlock()->firstInstr;
+}
+
+/**
+ * Mark the 'then' part of an if statement as cold
+ *
+ * @param startOfIf - last instruction before the if statement  (NULL if at start of block)
+ * @param branchInstr - last instruction of the conditional
+ * @param lastInstr - last instruction of the 'then' code
+ * @param skipLabel - label the conditional branches to when false
+ * @param resumeLabel - where to continue after the 'then' code
+ */
+void GL_MarkColdThen(Instr *startOfIf, Instr *branchInstr, Instr *lastInstr, const Label *skipLabel, Label *resumeLabel) {
+    if ((branchInstr == NULL) || (branchInstr == lastInstr)) return;
+
+    // need a single branch to the skip label, right before the 'then' code
+    if (!isBranch(branchInstr->mne) || (branchInstr->paramName == NULL)
+        || (strcmp(branchInstr->paramName, skipLabel->name) != 0)) return;
+
+    Instr *condStart = getCondStart(startOfIf);
+    for (Instr *curInstr = condStart; curInstr != branchInstr; curInstr = curInstr->nextInstr) {
+        if (isBranch(curInstr->mne) && (curInstr->paramName != NULL)
+            && (strcmp(curInstr->paramName, skipLabel->name) == 0)) return;
+    }
+
+    ColdBlock coldBlock = {condStart, branchInstr, NULL, branchInstr->nextInstr, lastInstr, resumeLabel};
+    addColdBlock(&coldBlock);
+}
+
+/**
+ * Mark the 'else' part of an if statement as cold
+ *
+ * @param startOfIf - last instruction before the if statement  (NULL if at start of block)
+ * @param skipElseJump - jump at the end of the 'then' code  (NULL if it ends with a return)
+ * @param startOfElse - last instruction before the 'else' code
+ * @param lastInstr - last instruction of the 'else' code
+ * @param resumeLabel - where to continue after the 'else' code
+ */
+void GL_MarkColdElse(Instr *startOfIf, Instr *skipElseJump, Instr *startOfElse, Instr *lastInstr, Label *resumeLabel) {
+    if ((startOfElse == NULL) || (startOfElse == lastInstr)) return;
+
+    ColdBlock coldBlock = {getCondStart(startOfIf), NULL, skipElseJump, startOfElse->nextInstr, lastInstr, resumeLabel};
+    addColdBlock(&coldBlock);
+}
+
+/**
+ * Check if the cold code only branches to labels inside of itself
+ */
+static bool isSelfContained(const ColdBlock *coldBlock) {
+    for (Instr *curInstr = coldBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        if (isBranch(curInstr->mne) && (curInstr->paramName != NULL)
+            && !isLabelInRange(curInstr->paramName, coldBlock->firstInstr, coldBlock->lastInstr)) return false;
+        if (curInstr == coldBlock->lastInstr) break;
+    }
+    return true;
+}
+
+static void moveColdBlock(InstrBlock *instrBlock, ColdBlock *coldBlock) {
+    Instr *firstInstr = coldBlock->firstInstr;
+
+    // the cold code needs a label to branch to
+    Label *coldLabel = firstInstr->label;
+    if (coldLabel == NULL) {
+        coldLabel = newGenericLabel(LBL_CODE);
+        firstInstr->label = coldLabel;
+    }
+
+    if (coldBlock->branchInstr != NULL) {
+        // branch to the cold code instead of skipping it
+        coldBlock->branchInstr->mne = invertBranch(coldBlock->branchInstr->mne);
+        coldBlock->branchInstr->paramName = coldLabel->name;
+        addLabelRef(coldLabel);
+    }
+    if (coldBlock->hotJump != NULL) {
+        // the hot code now falls thru
+        coldBlock->hotJump->mne = MNE_NONE;
+        coldBlock->hotJump->addrMode = ADDR_NONE;
+        coldBlock->hotJump->paramName = NULL;
+    }
+
+    IB_MoveToEnd(instrBlock, firstInstr, coldBlock->lastInstr);
+    if (!isExitInstr(coldBlock->lastInstr)) {
+        Label *resumeLabel = (coldBlock->resumeLabel->link != NULL) ? coldBlock->resumeLabel->link : coldBlock->resumeLabel;
+        addLabelRef(resumeLabel);
+        IB_AddJump(instrBlock, resumeLabel->name);
+    }
+}
+
+/**
+ * Move the cold blocks of a function after the end of its code
+ *
+ * NOTE: Needs to be done after the function is finished (RTS has been added)
+ */
+void GL_PlaceColdBlocks(InstrBlock *instrBlock) {
+
+    // code can only be added after the end, if the end doesn't fall thru
+    if ((coldBlockCount > 0) && (instrBlock->lastInstr != NULL) && isExitInstr(instrBlock->lastInstr)) {
+        int cntMoved = 0;
+        for_range(blockIdx, 0, coldBlockCount) {
+            ColdBlock *coldBlock = &coldBlocks[blockIdx];
+            if (!isSelfContained(coldBlock)) continue;
+
+            // the branches in the conditional need to reach the cold code once it's moved
+            int coldSize = IL_GetCodeSizeOfRange(coldBlock->firstInstr, coldBlock->lastInstr->nextInstr);
+            int reach = IL_GetCodeSizeOfRange(coldBlock->condStart, NULL) - coldSize;
+            if (reach > MAX_BRANCH_REACH) continue;
+
+            moveColdBlock(instrBlock, coldBlock);
+            cntMoved++;
+        }
+
+        if (cntMoved > 0) {
+            instrBlock->codeSize = IL_GetCodeSize(instrBlock);
+            if (compilerOptions.showOptimizerSteps) {
+                printf("\tMoved %d cold block(s) to the end of %s\n", cntMoved, instrBlock->blockName);
+            }
+        }
+    }
+    coldBlockCount = 0;
+}
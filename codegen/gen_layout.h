@@ -0,0 +1,28 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef MODULE_GEN_LAYOUT_H
+#define MODULE_GEN_LAYOUT_H
+
+#include "data/instr_list.h"
+
+extern void GL_MarkColdThen(Instr *startOfIf, Instr *branchInstr, Instr *lastInstr, const Label *skipLabel, Label *resumeLabel);
+extern void GL_MarkColdElse(Instr *startOfIf, Instr *skipElseJump, Instr *startOfElse, Instr *lastInstr, Label *resumeLabel);
+extern void GL_PlaceColdBlocks(InstrBlock *instrBlock);
+
+#endif //MODULE_GEN_LAYOUT_H
@@ -0,0 +1,213 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Neolithic Module: VR - Value ranges of expressions
+//
+//  Works out the smallest and largest value an expression can have, using
+//  what's known from the symbol table:
+//   - consts and enum values are exact
+//   - enum vars can only hold the values of their enumeration
+//   - bools are 0 or 1, and the rest use the range of their type
+//
+//  The code generator uses these to drop masks that can't change anything,
+//  to do 16-bit math in 8 bits when the result always fits, and to skip
+//  compares that always have the same result.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include "common/common.h"
+#include "gen_range.h"
+#include "gen_common.h"
+#include "eval_expr.h"
+#include "data/symbols.h"
+
+static const ValueRange fullRange = {-32768, 65535};
+
+//-----------------------------------------------------------------------
+
+ValueRange makeRange(int min, int max) {
+    ValueRange range = {min, max};
+    return range;
+}
+
+ValueRange getTypeRange(const SymbolRecord *varSym) {
+    bool isSigned = (varSym->flags & ST_SIGNED);
+    if (isPointer(varSym)) return makeRange(0, 65535);
+
+    switch (getType(varSym)) {
+        case ST_BOOL: return makeRange(0, 1);
+        case ST_INT:  return isSigned ? makeRange(-32768, 32767) : makeRange(0, 65535);
+        case ST_CHAR: return isSigned ? makeRange(-128, 127) : makeRange(0, 255);
+        default:      return fullRange;
+    }
+}
+
+/**
+ * Get the range of the values in an enumeration
+ */
+ValueRange getEnumRange(const SymbolRecord *enumSym) {
+    const SymbolTable *enumSymTbl = enumSym->symbolTbl;
+    if ((enumSymTbl == NULL) || (enumSymTbl->firstSymbol == NULL)) return makeRange(0, 255);
+
+    ValueRange range = {enumSymTbl->firstSymbol->constValue, enumSymTbl->firstSymbol->constValue};
+    for (SymbolRecord *valueSym = enumSymTbl->firstSymbol; valueSym != NULL; valueSym = valueSym->next) {
+        if (valueSym->constValue < range.min) range.min = valueSym->constValue;
+        if (valueSym->constValue > range.max) range.max = valueSym->constValue;
+    }
+    return range;
+}
+
+ValueRange getVarRange(const SymbolRecord *varSym) {
+    if (isConst(varSym) && varSym->hasValue && !isArray(varSym)) {
+        return makeRange(varSym->constValue, varSym->constValue);
+    }
+
+    const SymbolRecord *typeSym = varSym->userTypeDef;
+    if ((typeSym != NULL) && (typeSym->kind == SK_ENUM)) return getEnumRange(typeSym);
+    if ((typeSym != NULL) || isArray(varSym)) return fullRange;
+
+    return getTypeRange(varSym);
+}
+
+/**
+ * Get the bits that could be set for a (non-negative) range
+ */
+int VR_GetPossibleBits(ValueRange range) {
+    int bits = 0;
+    while (bits < range.max) bits = (bits << 1) | 1;
+    return bits;
+}
+
+bool VR_FitsInByte(ValueRange range) {
+    return (range.min >= 0) && (range.max <= 255);
+}
+
+bool isRangeUnsigned(ValueRange range) {
+    return (range.min >= 0);
+}
+
+//-----------------------------------------------------------------------
+
+ValueRange getOpRange(const List *expr) {
+    enum ParseToken opToken = expr->nodes[0].value.parseToken;
+    if (isComparisonToken(opToken) || (opToken == PT_BOOL_AND) || (opToken == PT_BOOL_OR) || (opToken == PT_NOT)) {
+        return makeRange(0, 1);
+    }
+
+    switch (opToken) {
+        case PT_LOOKUP: {
+            SymbolRecord *arraySym = lookupSymbolNode(expr->nodes[1], expr->lineNum);
+            return ((arraySym != NULL) && (arraySym->userTypeDef == NULL)) ? getTypeRange(arraySym) : fullRange;
+        }
+        case PT_FUNC_CALL: {
+            if (expr->nodes[1].type != N_STR) return fullRange;        // (call thru a function table)
+            SymbolRecord *funcSym = lookupSymbolNode(expr->nodes[1], expr->lineNum);
+            return (funcSym != NULL) ? getTypeRange(funcSym) : fullRange;
+        }
+        default:
+            break;
+    }
+
+    bool isMathOp = (opToken == PT_ADD) || (opToken == PT_SUB)
+                    || (opToken == PT_BIT_AND) || (opToken == PT_BIT_OR) || (opToken == PT_BIT_EOR)
+                    || (opToken == PT_SHIFT_LEFT) || (opToken == PT_SHIFT_RIGHT);
+    if (!isMathOp || (expr->count < 3)) return fullRange;
+
+    ValueRange range1 = VR_GetNodeRange(expr->nodes[1], expr->lineNum);
+    ValueRange range2 = VR_GetNodeRange(expr->nodes[2], expr->lineNum);
+    bool isUnsigned = isRangeUnsigned(range1) && isRangeUnsigned(range2);
+
+    switch (opToken) {
+        case PT_ADD:
+            return makeRange(range1.min + range2.min, range1.max + range2.max);
+        case PT_SUB:
+            return makeRange(range1.min - range2.max, range1.max - range2.min);
+
+        case PT_BIT_AND:
+            // masking with a positive value limits the result
+            if (isRangeUnsigned(range1) && isRangeUnsigned(range2)) {
+                return makeRange(0, (range1.max < range2.max) ? range1.max : range2.max);
+            }
+            if (isRangeUnsigned(range1)) return makeRange(0, range1.max);
+            if (isRangeUnsigned(range2)) return makeRange(0, range2.max);
+            return fullRange;
+
+        case PT_BIT_OR:
+        case PT_BIT_EOR:
+            if (!isUnsigned) return fullRange;
+            return makeRange(0, VR_GetPossibleBits(range1) | VR_GetPossibleBits(range2));
+
+        case PT_SHIFT_RIGHT:
+            if (!isRangeUnsigned(range1) || (range2.min != range2.max)) return fullRange;
+            return makeRange(range1.min >> range2.min, range1.max >> range2.min);
+
+        case PT_SHIFT_LEFT:
+            if (!isRangeUnsigned(range1) || (range2.min != range2.max)) return fullRange;
+            return makeRange(range1.min << range2.min, range1.max << range2.min);
+
+        default:
+            return fullRange;
+    }
+}
+
+/**
+ * Get the range of values for an expression
+ */
+ValueRange VR_GetNodeRange(ListNode node, int lineNum) {
+    switch (node.type) {
+        case N_INT:
+            return makeRange(node.value.num, node.value.num);
+
+        case N_STR: {
+            SymbolRecord *varSym = lookupSymbolNode(node, lineNum);
+            return (varSym != NULL) ? getVarRange(varSym) : fullRange;
+        }
+
+        case N_LIST: {
+            List *expr = node.value.list;
+            EvalResult evalResult = evaluate_expression(expr);
+            if (evalResult.hasResult) return makeRange(evalResult.value, evalResult.value);
+            if (expr->nodes[0].type != N_TOKEN) return fullRange;
+            return getOpRange(expr);
+        }
+
+        default:
+            return fullRange;
+    }
+}
+
+/**
+ * Check if an expression can be skipped without changing anything
+ *   (no function calls or updates to vars)
+ */
+bool VR_IsPureNode(ListNode node) {
+    if (node.type != N_LIST) return true;
+
+    const List *expr = node.value.list;
+    for_range(nodeIdx, 0, expr->count) {
+        ListNode subNode = expr->nodes[nodeIdx];
+        if ((subNode.type == N_TOKEN) && (nodeIdx == 0)) {
+            switch (subNode.value.parseToken) {
+                case PT_FUNC_CALL: case PT_INC: case PT_DEC: case PT_SET: case PT_ASM:
+                    return false;
+                default:
+                    break;
+            }
+        }
+        if (!VR_IsPureNode(subNode)) return false;
+    }
+    return true;
+}
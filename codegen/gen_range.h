@@ -0,0 +1,34 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef MODULE_GEN_RANGE_H
+#define MODULE_GEN_RANGE_H
+
+#include "data/syntax_tree.h"
+
+typedef struct {
+    int min;
+    int max;
+} ValueRange;
+
+extern ValueRange VR_GetNodeRange(ListNode node, int lineNum);
+extern bool VR_IsPureNode(ListNode node);
+extern bool VR_FitsInByte(ValueRange range);
+extern int VR_GetPossibleBits(ValueRange range);
+
+#endif //MODULE_GEN_RANGE_H
@@ -0,0 +1,437 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Neolithic Module: GSP - Function specialization
+//
+//  Small functions that are called with constant arguments get cloned, with
+//  the constant params folded into the clone's code.  The calls are then
+//  redirected to the clone, which removes the param loading, and lets the
+//  code generator fold any math using those params.
+//
+//  Calls with the same constant arguments share a clone.  A clone is only
+//  made when it replaces every remaining call of the original (so the
+//  original is dropped and no ROM is added), or when it's shared by several
+//  calls and still fits into the ROM growth budget.
+//
+//  Runs after the call tree has been walked (which records the call sites),
+//  but before the function depths are figured out.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/common.h"
+#include "gen_specialize.h"
+#include "gen_calltree.h"
+#include "gen_symbols.h"
+#include "gen_code.h"
+#include "eval_expr.h"
+#include "data/func_map.h"
+
+#define MAX_SPEC_FUNCS              128
+#define MAX_SPEC_CALL_SITES         512
+#define MAX_SPEC_CLONES             64
+#define MAX_CLONES_PER_FUNC         4
+
+#define SPECIALIZE_MAX_STATEMENTS   12      // only clone small functions
+#define SPECIALIZE_ROM_BUDGET       32      // total statements that can be added by clones
+
+typedef struct {
+    List *funcDef;
+    SymbolRecord *funcSym;
+    bool hasDirective;          // inlined/forced functions are left alone
+} SpecFuncDef;
+
+typedef struct {
+    List *callStmt;
+    SymbolRecord *callerSym;
+    SymbolRecord *calleeSym;
+
+    // constant arguments (for params that can be folded)
+    unsigned int constMask;
+    int values[MAX_SYMBOL_LIST_CNT];
+    bool isHandled;
+} CallSite;
+
+typedef struct {
+    SymbolRecord *origSym;
+    SymbolRecord *cloneSym;
+    List *cloneDef;
+} SpecClone;
+
+static SpecFuncDef funcDefs[MAX_SPEC_FUNCS];
+static int cntFuncDefs = 0;
+static CallSite callSites[MAX_SPEC_CALL_SITES];
+static int cntCallSites = 0;
+static SpecClone clones[MAX_SPEC_CLONES];
+static int cntClones = 0;
+
+//-------------------------------------------------------------------------
+//  Collect functions and their call sites  (from the call tree walk)
+
+void GSP_AddFunctionDef(List *funcDef, SymbolRecord *funcSym, bool hasDirective) {
+    if ((funcSym == NULL) || (cntFuncDefs >= MAX_SPEC_FUNCS)) return;
+
+    SpecFuncDef *specFuncDef = &funcDefs[cntFuncDefs++];
+    specFuncDef->funcDef = funcDef;
+    specFuncDef->funcSym = funcSym;
+    specFuncDef->hasDirective = hasDirective;
+}
+
+void GSP_AddCallSite(List *callStmt, SymbolRecord *callerSym, SymbolRecord *calleeSym) {
+    if ((callerSym == NULL) || (cntCallSites >= MAX_SPEC_CALL_SITES)) return;
+
+    CallSite *callSite = &callSites[cntCallSites++];
+    callSite->callStmt = callStmt;
+    callSite->callerSym = callerSym;
+    callSite->calleeSym = calleeSym;
+    callSite->constMask = 0;
+    callSite->isHandled = false;
+}
+
+//-------------------------------------------------------------------------
+//  Check which params can be folded
+
+bool canFoldParamType(const SymbolRecord *paramSym) {
+    return (getBaseVarSize(paramSym) == 1) && !isPointer(paramSym) && !isArray(paramSym)
+           && !isStructDefined(paramSym);
+}
+
+/**
+ * Count the statements in a function  (including nested blocks)
+ */
+int countStatements(const List *list) {
+    int stmtCount = 0;
+    for_range(index, 0, list->count) {
+        ListNode node = list->nodes[index];
+        if (node.type != N_LIST) continue;
+        if (isToken(list->nodes[0], PT_CODE)) stmtCount++;
+        stmtCount += countStatements(node.value.list);
+    }
+    return stmtCount;
+}
+
+/**
+ * Check that a param is never modified in the function (and that the code
+ *   can be copied)
+ */
+bool canFoldParamInCode(const List *list, const char *paramName) {
+    for_range(index, 0, list->count) {
+        ListNode node = list->nodes[index];
+
+        if (node.type == N_TOKEN) {
+            switch (node.value.parseToken) {
+                case PT_ASM: case PT_LABEL: case PT_DIRECTIVE:
+                    return false;
+                case PT_SET: case PT_INC: case PT_DEC: case PT_ADDR_OF: {
+                    ListNode targetNode = list->nodes[1];
+                    if ((index == 0) && (targetNode.type == N_STR)
+                        && (strncmp(targetNode.value.str, paramName, SYMBOL_NAME_LIMIT) == 0))
+                        return false;
+                } break;
+                default:
+                    break;
+            }
+        } else if (node.type == N_LIST) {
+            if (!canFoldParamInCode(node.value.list, paramName)) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Find the constant arguments of a call  (only for params that can be folded)
+ */
+void findConstArgs(CallSite *callSite, const SymbolList *params, unsigned int foldableMask) {
+    ListNode argsNode = callSite->callStmt->nodes[2];
+    if ((argsNode.type != N_LIST) || (argsNode.value.list->count != params->count)) return;
+    List *args = argsNode.value.list;
+
+    // the args are evaluated in the caller's scope
+    setEvalLocalSymbolTable(GET_LOCAL_SYMBOL_TABLE(callSite->callerSym));
+    for_range(paramIdx, 0, params->count) {
+        if (!(foldableMask & (1 << paramIdx))) continue;
+
+        EvalResult evalResult = evaluate_node(args->nodes[paramIdx]);
+        if (evalResult.hasResult) {
+            callSite->constMask |= (1 << paramIdx);
+            callSite->values[paramIdx] = evalResult.value & 0xff;
+        }
+    }
+    setEvalLocalSymbolTable(NULL);
+}
+
+bool hasSameConstArgs(const CallSite *site1, const CallSite *site2, int numParams) {
+    if (site1->constMask != site2->constMask) return false;
+    for_range(paramIdx, 0, numParams) {
+        if ((site1->constMask & (1 << paramIdx)) && (site1->values[paramIdx] != site2->values[paramIdx])) return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+//  Create clones
+
+char *makeCloneName(const char *funcName, SymbolTable *mainSymTbl) {
+    char *cloneName = allocMem(strlen(funcName) + 8);
+    int cloneNum = 1;
+    do {
+        sprintf(cloneName, "%s_%d", funcName, cloneNum++);
+    } while (findSymbol(mainSymTbl, cloneName) != NULL);
+    return cloneName;
+}
+
+/**
+ * Copy a symbol into a table  (keeping the table's links intact)
+ */
+SymbolRecord *copySymbol(SymbolTable *symbolTable, const SymbolRecord *srcSym, char *name) {
+    SymbolRecord *newSym = addSymbol(symbolTable, name, srcSym->kind, ST_NONE, MF_NONE);
+    SymbolRecord *nextSym = newSym->next;
+    *newSym = *srcSym;
+    newSym->next = nextSym;
+    newSym->name = name;
+    return newSym;
+}
+
+/**
+ * Create the symbol for the clone, with a local symbol table without the folded params
+ */
+SymbolRecord *createCloneSymbol(const SymbolRecord *funcSym, char *cloneName, const CallSite *callSite,
+                                SymbolTable *mainSymTbl) {
+    SymbolRecord *cloneSym = copySymbol(mainSymTbl, funcSym, cloneName);
+    cloneSym->cntUses = 0;
+    cloneSym->instrBlock = NULL;
+    cloneSym->astList = NULL;
+    cloneSym->symbolTbl = NULL;
+
+    SymbolTable *localSymTbl = GET_LOCAL_SYMBOL_TABLE(funcSym);
+    if (localSymTbl == NULL) return cloneSym;
+
+    SymbolTable *cloneSymTbl = initSymbolTable(cloneName, mainSymTbl);
+    int paramIdx = 0;
+    bool hasParams = false;
+    for (SymbolRecord *curSym = localSymTbl->firstSymbol; curSym != NULL; curSym = curSym->next) {
+        if (IS_PARAM_VAR(curSym) || IS_FRAME_PARAM(curSym)) {
+            bool isFolded = (callSite->constMask & (1 << paramIdx++)) != 0;
+            if (isFolded) continue;
+
+            SymbolRecord *paramSym = copySymbol(cloneSymTbl, curSym, curSym->name);
+            paramSym->location = -1;
+            paramSym->cntIndexUses = 0;
+            hasParams = true;
+        } else {
+            copySymbol(cloneSymTbl, curSym, curSym->name);
+        }
+    }
+
+    if (cloneSymTbl->firstSymbol != NULL) {
+        cloneSym->symbolTbl = cloneSymTbl;
+        if (hasParams) GS_FuncParamAlloc(cloneSym);
+    } else {
+        killSymbolTable(cloneSymTbl);
+    }
+    return cloneSym;
+}
+
+/**
+ * Make a copy of the function definition, with the constant params folded into the code
+ */
+List *createCloneDef(const List *funcDef, char *cloneName, const CallSite *callSite, const SymbolList *params) {
+    ListNode codeNode = funcDef->nodes[5];
+    for_range(paramIdx, 0, params->count) {
+        if (callSite->constMask & (1 << paramIdx)) {
+            codeNode = cloneWithConstValue(codeNode.value.list, params->list[paramIdx]->name, callSite->values[paramIdx]);
+        }
+    }
+
+    List *cloneDef = createList(funcDef->count);
+    for_range(nodeIdx, 0, funcDef->count) {
+        addNode(cloneDef, funcDef->nodes[nodeIdx]);
+    }
+    cloneDef->lineNum = funcDef->lineNum;
+    cloneDef->progLine = funcDef->progLine;
+    cloneDef->nodes[1] = createStrNode(cloneName);
+    cloneDef->nodes[5] = codeNode;
+    return cloneDef;
+}
+
+/**
+ * Point a call at the clone, dropping the folded arguments
+ */
+void redirectCall(CallSite *callSite, SymbolRecord *cloneSym, int numParams) {
+    List *callStmt = callSite->callStmt;
+    List *args = callStmt->nodes[2].value.list;
+
+    int numArgsLeft = 0;
+    for_range(paramIdx, 0, numParams) {
+        if (!(callSite->constMask & (1 << paramIdx))) numArgsLeft++;
+    }
+
+    if (numArgsLeft > 0) {
+        List *newArgs = createList(numArgsLeft);
+        newArgs->lineNum = args->lineNum;
+        newArgs->progLine = args->progLine;
+        for_range(paramIdx, 0, numParams) {
+            if (!(callSite->constMask & (1 << paramIdx))) addNode(newArgs, args->nodes[paramIdx]);
+        }
+        callStmt->nodes[2] = createListNode(newArgs);
+    } else {
+        callStmt->nodes[2] = createEmptyNode();
+    }
+    callStmt->nodes[1] = createStrNode(cloneSym->name);
+
+    FM_removeCallFromMap(callSite->callerSym, callSite->calleeSym);
+    FM_addCallToMap(callSite->callerSym, cloneSym);
+    callSite->calleeSym = cloneSym;
+    callSite->isHandled = true;
+}
+
+SpecClone *createClone(const SpecFuncDef *specFuncDef, const CallSite *callSite, const SymbolList *params,
+                       SymbolTable *mainSymTbl) {
+    if (cntClones >= MAX_SPEC_CLONES) return NULL;
+
+    SymbolRecord *funcSym = specFuncDef->funcSym;
+    char *cloneName = makeCloneName(funcSym->name, mainSymTbl);
+
+    SpecClone *clone = &clones[cntClones++];
+    clone->origSym = funcSym;
+    clone->cloneSym = createCloneSymbol(funcSym, cloneName, callSite, mainSymTbl);
+    clone->cloneDef = createCloneDef(specFuncDef->funcDef, cloneName, callSite, params);
+
+    // add the clone to the call tree
+    FM_addFunctionDef(clone->cloneSym);
+    GCT_CodeBlock(clone->cloneDef->nodes[5].value.list, clone->cloneSym);
+
+    return clone;
+}
+
+//-------------------------------------------------------------------------
+
+void specializeFunction(const SpecFuncDef *specFuncDef, SymbolTable *mainSymTbl, int *romBudget) {
+    SymbolRecord *funcSym = specFuncDef->funcSym;
+    if (specFuncDef->hasDirective || (specFuncDef->funcDef->count <= 5)) return;
+    if (specFuncDef->funcDef->nodes[5].type != N_LIST) return;
+
+    SymbolList *params = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
+    if ((params == NULL) || (params->count == 0)) return;
+
+    // only small functions are worth copying
+    List *code = specFuncDef->funcDef->nodes[5].value.list;
+    int stmtCount = countStatements(code);
+    if (stmtCount > SPECIALIZE_MAX_STATEMENTS) return;
+
+    // find which params could be folded
+    unsigned int foldableMask = 0;
+    for_range(paramIdx, 0, params->count) {
+        SymbolRecord *paramSym = params->list[paramIdx];
+        if (canFoldParamType(paramSym) && canFoldParamInCode(code, paramSym->name)) {
+            foldableMask |= (1 << paramIdx);
+        }
+    }
+    if (foldableMask == 0) return;
+
+    // look at all the calls to the function
+    int cntUsesLeft = 0;
+    for_range(siteIdx, 0, cntCallSites) {
+        CallSite *callSite = &callSites[siteIdx];
+        if (callSite->calleeSym != funcSym) continue;
+        cntUsesLeft++;
+        findConstArgs(callSite, params, foldableMask);
+        if (callSite->constMask == 0) callSite->isHandled = true;
+    }
+
+    for_range(cloneCnt, 0, MAX_CLONES_PER_FUNC) {
+
+        // find the most common set of constant args
+        CallSite *bestSite = NULL;
+        int bestCount = 0;
+        for_range(siteIdx, 0, cntCallSites) {
+            CallSite *callSite = &callSites[siteIdx];
+            if ((callSite->calleeSym != funcSym) || callSite->isHandled) continue;
+
+            int count = 0;
+            for_range(otherIdx, 0, cntCallSites) {
+                CallSite *otherSite = &callSites[otherIdx];
+                if ((otherSite->calleeSym == funcSym) && !otherSite->isHandled
+                    && hasSameConstArgs(callSite, otherSite, params->count)) count++;
+            }
+            if (count > bestCount) {
+                bestSite = callSite;
+                bestCount = count;
+            }
+        }
+        if (bestSite == NULL) return;
+
+        // clone replaces the original?  otherwise, it adds to the ROM size
+        bool replacesOriginal = (bestCount == cntUsesLeft);
+        int romGrowth = replacesOriginal ? 0 : stmtCount;
+        if (!replacesOriginal && ((bestCount < 2) || (romGrowth > *romBudget))) return;
+
+        CallSite signature = *bestSite;
+        SpecClone *clone = createClone(specFuncDef, &signature, params, mainSymTbl);
+        if (clone == NULL) return;
+        *romBudget -= romGrowth;
+
+        for_range(siteIdx, 0, cntCallSites) {
+            CallSite *callSite = &callSites[siteIdx];
+            if ((callSite->calleeSym == funcSym) && !callSite->isHandled
+                && hasSameConstArgs(&signature, callSite, params->count)) {
+                redirectCall(callSite, clone->cloneSym, params->count);
+                cntUsesLeft--;
+            }
+        }
+
+        if (compilerOptions.reportFunctionProcessing) {
+            printf("Specialized function %s as %s (%d calls)\n", funcSym->name, clone->cloneSym->name, bestCount);
+        }
+    }
+}
+
+/**
+ * Clone small functions called with constant arguments
+ *
+ * @param mainSymTbl - main symbol table (clones are added to it)
+ */
+void GSP_SpecializeFunctions(SymbolTable *mainSymTbl) {
+    int romBudget = SPECIALIZE_ROM_BUDGET;
+
+    // NOTE: clones are not specialized again  (they're added to the list after this count)
+    int cntOrigFuncDefs = cntFuncDefs;
+    for_range(funcIdx, 0, cntOrigFuncDefs) {
+        specializeFunction(&funcDefs[funcIdx], mainSymTbl, &romBudget);
+    }
+}
+
+//-------------------------------------------------------------------------
+//  Let the code generator know about the clones
+
+int GSP_GetCloneCount(const char *funcName) {
+    int count = 0;
+    for_range(cloneIdx, 0, cntClones) {
+        if (strcmp(clones[cloneIdx].origSym->name, funcName) == 0) count++;
+    }
+    return count;
+}
+
+List *GSP_GetCloneDef(const char *funcName, int index) {
+    for_range(cloneIdx, 0, cntClones) {
+        if ((strcmp(clones[cloneIdx].origSym->name, funcName) == 0) && (index-- == 0)) {
+            return clones[cloneIdx].cloneDef;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,32 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef MODULE_GEN_SPECIALIZE_H
+#define MODULE_GEN_SPECIALIZE_H
+
+#include "data/symbols.h"
+#include "data/syntax_tree.h"
+
+extern void GSP_AddFunctionDef(List *funcDef, SymbolRecord *funcSym, bool hasDirective);
+extern void GSP_AddCallSite(List *callStmt, SymbolRecord *callerSym, SymbolRecord *calleeSym);
+extern void GSP_SpecializeFunctions(SymbolTable *mainSymTbl);
+
+extern int GSP_GetCloneCount(const char *funcName);
+extern List *GSP_GetCloneDef(const char *funcName, int index);
+
+#endif //MODULE_GEN_SPECIALIZE_H
@@ -258,6 +258,8 @@ SymbolRecord *GS_Variable(List *varDef, SymbolTable *symbolTable, enum ModifierF
                     case PT_SIGNED:   modFlags |= ST_SIGNED;   break;
                     case PT_REGISTER: modFlags |= SS_REGISTER; break;
                     case PT_INLINE:   modFlags |= MF_INLINE;   break;
+                    case PT_SPLIT:    modFlags |= MF_SPLIT_ARRAY; break;
+                    case PT_PACKED:   modFlags |= MF_PACKED_BOOL; break;
                 }
             } else {
                 printf("Unknown modifier: %s\n", modNode.value.str);
@@ -272,6 +274,28 @@ SymbolRecord *GS_Variable(List *varDef, SymbolTable *symbolTable, enum ModifierF
     }
 #endif
 
+    // only arrays of structs can be split into one array per struct byte
+    bool isStructArray = (userTypeSymbol != NULL) && (modFlags & MF_ARRAY) && !(modFlags & MF_POINTER);
+    if ((modFlags & MF_SPLIT_ARRAY) && !isStructArray) {
+        WarningMessage("split only applies to arrays of structs, ignoring for", varName, varDef->lineNum);
+        modFlags &= ~MF_SPLIT_ARRAY;
+    }
+
+    // only simple global bools can be packed into bits
+    bool isPackable = (symbolTable == mainSymbolTable) && (symbolKind == SK_VAR) && (symbolType == ST_BOOL)
+                      && !(modFlags & (MF_ARRAY | MF_POINTER)) && (hint == 0)
+                      && !((varDef->count > 5) && (varDef->nodes[5].type == N_INT));     // (no memory hint)
+    if ((modFlags & MF_PACKED_BOOL) && !isPackable) {
+        WarningMessage("packed only applies to global bool variables, ignoring for", varName, varDef->lineNum);
+        modFlags &= ~MF_PACKED_BOOL;
+    }
+
+    // functions can only be listed in a const table  (called with table[index]())
+    bool isFuncTable = (symbolKind == SK_CONST) && (modFlags & MF_ARRAY) && !(modFlags & MF_POINTER);
+    if ((symbolType == ST_FUNC) && !isFuncTable) {
+        ErrorMessage("function can only be used for const arrays of functions", varName, varDef->lineNum);
+    }
+
     // create the new variable
     SymbolRecord *varSymRec = addSymbol(symbolTable, varName, symbolKind, symbolType, modFlags);
     varSymRec->userTypeDef = userTypeSymbol;
@@ -302,6 +326,12 @@ SymbolRecord *GS_Variable(List *varDef, SymbolTable *symbolTable, enum ModifierF
         } else {
             GS_processInitializer(varDef, varSymRec);
         }
+
+        // function tables hold on to the list of functions  (for the call tree)
+        ListNode valueNode = varDef->nodes[4].value.list->nodes[1];
+        if ((symbolType == ST_FUNC) && (valueNode.type == N_LIST)) {
+            varSymRec->astList = valueNode.value.list;
+        }
     }
     return varSymRec;
 }
@@ -467,11 +497,11 @@ void GS_Structure(List *structDef, SymbolTable *symbolTable) {
 void GS_FuncParamAlloc(const SymbolRecord *funcSym) {
     SymbolList *funcParamList = getParamSymbols(GET_LOCAL_SYMBOL_TABLE(funcSym));
 
-    // first count stack params
+    // first count stack params  (params passed in the function's frame don't use the stack)
     int numStackParams = 0;
     for_range (paramIdx, 0, funcParamList->count) {
         SymbolRecord *curParam = funcParamList->list[paramIdx];
-        if (curParam->hint == VH_NONE) {
+        if ((curParam->hint == VH_NONE) && !IS_FRAME_PARAM(curParam)) {
             numStackParams++;
         }
     }
@@ -485,7 +515,7 @@ void GS_FuncParamAlloc(const SymbolRecord *funcSym) {
 
     for_range (paramIdx, 0, funcParamList->count) {
         SymbolRecord *curParam = funcParamList->list[paramIdx];
-        if (curParam->hint == VH_NONE) {
+        if ((curParam->hint == VH_NONE) && !IS_FRAME_PARAM(curParam)) {
             setSymbolLocation(curParam, curStackPos, SS_STACK);
             curStackPos--;
         }
@@ -508,7 +538,10 @@ void GS_Function(List *funcDef, SymbolTable *symbolTable) {
         ErrorMessage("Duplicate function name", funcName, funcDef->lineNum);
         return;
     }
-    funcSym = addSymbol(symbolTable, funcName, SK_FUNC, ST_NONE, MF_NONE);
+    // keep the return type  (bool functions can return in the carry flag)
+    List *returnTypeList = funcDef->nodes[2].value.list;
+    enum SymbolType returnType = (returnTypeList->count == 1) ? getSymbolType(returnTypeList->nodes[0].value.str) : ST_NONE;
+    funcSym = addSymbol(symbolTable, funcName, SK_FUNC, returnType, MF_NONE);
 
     FM_addFunctionDef(funcSym);
 
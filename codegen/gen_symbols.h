@@ -24,5 +24,6 @@
 #include "machine/mem.h"
 
 extern void generate_symbols(ListNode node, SymbolTable *symbolTable);
+extern void GS_FuncParamAlloc(const SymbolRecord *funcSym);
 
 #endif //MODULE_GEN_SYMBOLS_H
@@ -50,6 +50,10 @@ typedef struct {
     char maxFuncCallDepth;
     bool runOptimizer;
     bool showOptimizerSteps;
+    bool optimizeForSize;
+    bool returnBoolInCarry;     // all bool functions return in carry  (not just leaf functions)
+    bool useUndocumentedOpcodes;    // let the optimizer use LAX, SAX, DCP, SBX and ISB
+    char *timingFuncName;       // function to show the worst case timing of
 } CompilerOptions;
 
 extern CompilerOptions compilerOptions;
@@ -85,7 +85,10 @@ struct SMnemonic Mnemonics[] = {
 
         // specialty (undocumented) opcodes
         {"DCP", DCP, false},
+        {"ISB", ISB, false},
         {"LAX", LAX, false},
+        {"SAX", SAX, false},
+        {"SBX", SBX, false},
 
         // ex
         {"byte", MNE_DATA, false},
@@ -201,6 +204,7 @@ enum MnemonicCode invertBranch(enum MnemonicCode mne) {
         case BPL: return BMI;
         case BVC: return BVS;
         case BVS: return BVC;
+        default: break;
     }
     return mne;
 }
@@ -303,16 +307,23 @@ struct StOpcodeTable opcodeTable[] = {
         {INX, ADDR_NONE,0xE8, 2},
         {INY, ADDR_NONE,0xC8, 2},
         //
+        {ISB, ADDR_ZP,  0xE7, 5},
+        {ISB, ADDR_ZPX, 0xF7, 6},
+        {ISB, ADDR_ABS, 0xEF, 6},
+        {ISB, ADDR_ABX, 0xFF, 7},
+        {ISB, ADDR_ABY, 0xFB, 7},
+        {ISB, ADDR_IX,  0xE3, 8},
+        {ISB, ADDR_IY,  0xF3, 8},
+        //
         {JMP, ADDR_ABS, 0x4C, 3},
         {JMP, ADDR_IND, 0x6C, 5},
         {JSR, ADDR_ABS, 0x20, 6},
         //
         {LAX, ADDR_IMM, 0xAB, 2},
         {LAX, ADDR_ZP,  0xA7, 3},
-        {LAX, ADDR_ZPX, 0xB7, 4},
+        {LAX, ADDR_ZPY, 0xB7, 4},
         {LAX, ADDR_ABS, 0xAF, 4},
-        {LAX, ADDR_ABX, 0xBF, 4},
-        {LAX, ADDR_ABY, 0xBB, 4},
+        {LAX, ADDR_ABY, 0xBF, 4},
         {LAX, ADDR_IX,  0xA3, 6},
         {LAX, ADDR_IY,  0xB3, 5},
         //
@@ -382,6 +393,11 @@ struct StOpcodeTable opcodeTable[] = {
         {RTI, ADDR_NONE,0x40, 6},
         {RTS, ADDR_NONE,0x60, 6},
         //
+        {SAX, ADDR_ZP,  0x87, 3},
+        {SAX, ADDR_ZPY, 0x97, 4},
+        {SAX, ADDR_ABS, 0x8F, 4},
+        {SAX, ADDR_IX,  0x83, 6},
+        //
         {SBC, ADDR_IMM, 0xE9, 2},
         {SBC, ADDR_ZP,  0xE5, 3},
         {SBC, ADDR_ZPX, 0xF5, 4},
@@ -391,6 +407,8 @@ struct StOpcodeTable opcodeTable[] = {
         {SBC, ADDR_IX,  0xE1, 6},
         {SBC, ADDR_IY,  0xF1, 5},
         //
+        {SBX, ADDR_IMM, 0xCB, 2},
+        //
         {SEC, ADDR_NONE,0x38, 2},
         {SED, ADDR_NONE,0xF8, 2},
         {SEI, ADDR_NONE,0x78, 2},
@@ -433,6 +451,18 @@ OpcodeEntry lookupOpcodeEntry(enum MnemonicCode mneCode, enum AddrModes addrMode
     return opcodeEntry;
 }
 
+/**
+ * Find the opcode table entry for an opcode value (used by the simulator)
+ *
+ * @return entry, or MNE_NONE entry if not a known opcode
+ */
+OpcodeEntry lookupOpcodeByValue(int opcode) {
+    for_range(index, 1, NumOpcodes) {
+        if (opcodeTable[index].opcode == opcode) return opcodeTable[index];
+    }
+    return opcodeTable[0];
+}
+
 int getCycleCount(enum MnemonicCode mne, enum AddrModes addrMode) {
     OpcodeEntry opcodeEntry = lookupOpcodeEntry(mne, addrMode);
     if (opcodeEntry.mneCode != MNE_NONE) {
@@ -28,8 +28,8 @@ enum MnemonicCode {
     JSR, LDA, LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL, ROR, RTI,
     RTS, SBC, SEC, SED, SEI, STA, STX, STY, TAX, TAY, TSX, TXA, TXS, TYA,
 
-    // specialty ones
-    DCP, LAX,
+    // specialty ones  (undocumented opcodes)
+    DCP, ISB, LAX, SAX, SBX,
 
     // data in the middle of code (ASM block only)
     MNE_DATA,
@@ -108,6 +108,7 @@ extern bool isBranch(enum MnemonicCode mne);
 extern enum MnemonicCode invertBranch(enum MnemonicCode mne);
 
 extern OpcodeEntry lookupOpcodeEntry(enum MnemonicCode mneCode, enum AddrModes addrMode);
+extern OpcodeEntry lookupOpcodeByValue(int opcode);
 extern int getCycleCount(enum MnemonicCode mne, enum AddrModes addrMode);
 
 #endif //MODULE_ASM_CODE_H
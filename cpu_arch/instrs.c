@@ -26,6 +26,9 @@
 
 #include "common/common.h"
 #include "instrs.h"
+#include "data/func_map.h"
+#include "codegen/gen_common.h"
+#include "instrs_startup.h"
 
 //#define DEBUG_INSTRS
 
@@ -46,6 +49,12 @@ LastRegisterUse lastStoredAReg;
 const char *tempVarName = "0x80";
 char *curCachedIndexVar;
 
+//--------------------------------------------------
+// Loop counter kept in the Y register (scaled by loopIndexScale)
+
+const SymbolRecord *loopIndexVar;
+int loopIndexScale;
+
 
 //------------------------------------------------------------------------------
 //--- Initialization of Instruction List / Instruction Code Generator
@@ -57,6 +66,7 @@ void IL_Init() {
     lastUseForYReg = REG_USED_FOR_NOTHING;
 
     curCachedIndexVar = "";
+    loopIndexVar = NULL;
 
     IL_SetLineComment(NULL);
 }
@@ -67,12 +77,15 @@ void IL_Init() {
 // Atari 2600:
 //      Need to reset the stack (Atari 2600 specific)
 // TODO: move into machine specific module.
+//
+// Then RAM is cleared, and global variables get their initial values.
 
 void ICG_SystemInitCode() {
     IL_AddInstrB(CLD);
     IL_AddComment(
             IL_AddInstrN(LDX, ADDR_IMM, 0xFF), "Initialize the Stack");
     IL_AddInstrB(TXS);
+    ICG_StartupInitRAM();
 }
 
 
@@ -259,7 +272,8 @@ bool ICG_IsCurrentTag(char regName, SymbolRecord *varSym) {
         case 'Y': registerUse = lastUseForYReg; break;
         default:return false;
     }
-    return (registerUse.varSym == varSym);
+    // the register may have been reloaded (with a const) since it was tagged
+    return (registerUse.loadedWith == LW_VAR) && (registerUse.varSym == varSym);
 }
 
 bool ICG_isLastInstrReturn() {
@@ -282,6 +296,7 @@ bool ICG_isLastInstrReturn() {
 void ICG_LoadFromArray(const SymbolRecord *arraySymbol, int index,
                        enum SymbolType destType) {
     // const index, so add to address to read from
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
     enum AddrModes addrMode = CALC_SYMBOL_ADDR_MODE(arraySymbol);
     if (destType == ST_PTR) {
@@ -294,7 +309,8 @@ void ICG_LoadFromArray(const SymbolRecord *arraySymbol, int index,
 }
 
 void ICG_LoadConst(int constValue, int size) {
-    if ((lastUseForAReg.loadedWith == LW_CONST) && (lastUseForAReg.constValue == constValue)) return;
+    // NOTE: X is not tracked, so 16-bit consts are always loaded
+    if ((size != 2) && (lastUseForAReg.loadedWith == LW_CONST) && (lastUseForAReg.constValue == constValue)) return;
 
     IL_AddInstrN(LDA, ADDR_IMM, constValue & 0xff);
     if (size == 2) {
@@ -302,6 +318,7 @@ void ICG_LoadConst(int constValue, int size) {
     }
 
     // mark that we have a constant loaded
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg.loadedWith = LW_CONST;
     lastUseForAReg.constValue = constValue;
 }
@@ -319,16 +336,27 @@ void ICG_OpWithParamVar(enum MnemonicCode mne, const SymbolRecord *varRec) {
 //-------------------------------------------------------------------
 
 void ICG_LoadByteVar(const SymbolRecord *varRec, int ofs) {
+    if (IS_PACKED_BOOL(varRec)) {
+        ICG_LoadPackedBool(varRec);
+        return;
+    }
     const char *varName = getVarName(varRec);
     enum AddrModes addrMode = (ofs < 0x100 ? ADDR_ZP : ADDR_ABS);
     IL_AddInstrS(LDA, addrMode, varName, numToStr(ofs), PARAM_ADD);
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
 void ICG_LoadVar(const SymbolRecord *varRec) {
-    // Check contents of A reg.
-    if ((lastUseForAReg.loadedWith == LW_VAR) && (lastUseForAReg.varSym == varRec)) return;
-    if ((lastStoredAReg.loadedWith == LW_VAR) && (lastStoredAReg.varSym == varRec)) {
+    if (IS_PACKED_BOOL(varRec)) {
+        ICG_LoadPackedBool(varRec);
+        return;
+    }
+
+    // Check contents of A reg.  (16-bit vars are always loaded, since X is not tracked)
+    bool isWord = (getBaseVarSize(varRec) == 2);
+    if (!isWord && (lastUseForAReg.loadedWith == LW_VAR) && (lastUseForAReg.varSym == varRec)) return;
+    if (!isWord && (lastStoredAReg.loadedWith == LW_VAR) && (lastStoredAReg.varSym == varRec)) {
         lastUseForAReg = lastStoredAReg;
         return;
     }
@@ -364,6 +392,161 @@ void ICG_LoadVar(const SymbolRecord *varRec) {
     lastUseForAReg.varSym = varRec;
 }
 
+//-------------------------------------------------------------------
+//  Packed bools
+//
+//  A packed bool is a single bit (bitMask) of a shared byte (packedByte).
+//  Bits 7 and 6 are tested with BIT, which leaves A alone.  Loading one
+//  gives a normal bool (0 or 1) in A.
+
+static void loadPackedByte(const SymbolRecord *varSym) {
+    const SymbolRecord *packedByte = varSym->packedByte;
+    IL_AddInstrP(LDA, CALC_SYMBOL_ADDR_MODE(packedByte), packedByte->name, PARAM_NORMAL);
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+}
+
+static void storePackedByte(const SymbolRecord *varSym) {
+    const SymbolRecord *packedByte = varSym->packedByte;
+    IL_ClearOnUpdate(packedByte);
+    IL_AddInstrP(STA, CALC_SYMBOL_ADDR_MODE(packedByte), packedByte->name, PARAM_NORMAL);
+}
+
+void ICG_LoadPackedBool(const SymbolRecord *varSym) {
+    loadPackedByte(varSym);
+    switch (varSym->bitMask) {
+        case 0x80:
+        case 0x40:
+            // shift the bit into carry, then rotate it into an empty A
+            IL_AddComment(
+                    IL_AddInstrN(ASL, ADDR_ACC, 0), varSym->name);
+            if (varSym->bitMask == 0x40) IL_AddInstrN(ASL, ADDR_ACC, 0);
+            IL_AddInstrN(LDA, ADDR_IMM, 0);
+            IL_AddInstrN(ROL, ADDR_ACC, 0);
+            break;
+        default:
+            IL_AddComment(
+                    IL_AddInstrN(AND, ADDR_IMM, varSym->bitMask), varSym->name);
+            if (varSym->bitMask != 0x01) {
+                IL_AddInstrN(BEQ, ADDR_REL, +4);
+                IL_AddInstrN(LDA, ADDR_IMM, 1);
+            }
+            break;
+    }
+}
+
+/**
+ * Branch on the value of a packed bool
+ */
+void ICG_BranchOnPackedBool(const SymbolRecord *varSym, bool branchIfTrue, const Label *label) {
+    const SymbolRecord *packedByte = varSym->packedByte;
+    switch (varSym->bitMask) {
+        case 0x80:
+            IL_AddComment(
+                    IL_AddInstrP(BIT, CALC_SYMBOL_ADDR_MODE(packedByte), packedByte->name, PARAM_NORMAL), varSym->name);
+            ICG_Branch(branchIfTrue ? BMI : BPL, label);
+            break;
+        case 0x40:
+            IL_AddComment(
+                    IL_AddInstrP(BIT, CALC_SYMBOL_ADDR_MODE(packedByte), packedByte->name, PARAM_NORMAL), varSym->name);
+            ICG_Branch(branchIfTrue ? BVS : BVC, label);
+            break;
+        default:
+            loadPackedByte(varSym);
+            IL_AddComment(
+                    IL_AddInstrN(AND, ADDR_IMM, varSym->bitMask), varSym->name);
+            ICG_Branch(branchIfTrue ? BNE : BEQ, label);
+            break;
+    }
+}
+
+/**
+ * Set a packed bool to a known value
+ */
+void ICG_SetPackedBool(const SymbolRecord *varSym, bool value) {
+    loadPackedByte(varSym);
+    IL_AddComment(
+            value ? IL_AddInstrN(ORA, ADDR_IMM, varSym->bitMask)
+                  : IL_AddInstrN(AND, ADDR_IMM, ~varSym->bitMask & 0xFF), varSym->name);
+    storePackedByte(varSym);
+}
+
+void ICG_TogglePackedBool(const SymbolRecord *varSym) {
+    loadPackedByte(varSym);
+    IL_AddComment(
+            IL_AddInstrN(EOR, ADDR_IMM, varSym->bitMask), varSym->name);
+    storePackedByte(varSym);
+}
+
+/**
+ * Store A (zero or not) into a packed bool
+ */
+void ICG_StorePackedBool(const SymbolRecord *varSym) {
+    Label *clearLabel = newGenericLabel(LBL_CODE);
+    Label *doneLabel = newGenericLabel(LBL_CODE);
+
+    IL_AddInstrN(CMP, ADDR_IMM, 0);
+    ICG_Branch(BEQ, clearLabel);
+    loadPackedByte(varSym);
+    IL_AddInstrN(ORA, ADDR_IMM, varSym->bitMask);
+    ICG_Branch(BNE, doneLabel);     // always taken
+    IL_Label(clearLabel);
+    loadPackedByte(varSym);
+    IL_AddInstrN(AND, ADDR_IMM, ~varSym->bitMask & 0xFF);
+    IL_Label(doneLabel);
+    IL_AddComment(
+            IL_AddInstrP(STA, CALC_SYMBOL_ADDR_MODE(varSym->packedByte), varSym->packedByte->name, PARAM_NORMAL),
+            varSym->name);
+    IL_ClearOnUpdate(varSym->packedByte);
+}
+
+/**
+ * Move a packed bool into the carry flag  (for functions returning a bool in carry)
+ */
+void ICG_PackedBoolToCarry(const SymbolRecord *varSym) {
+    loadPackedByte(varSym);
+    switch (varSym->bitMask) {
+        case 0x80:
+            IL_AddComment(
+                    IL_AddInstrN(ASL, ADDR_ACC, 0), varSym->name);
+            break;
+        case 0x40:
+            IL_AddComment(
+                    IL_AddInstrN(ASL, ADDR_ACC, 0), varSym->name);
+            IL_AddInstrN(ASL, ADDR_ACC, 0);
+            break;
+        case 0x01:
+            IL_AddComment(
+                    IL_AddInstrN(LSR, ADDR_ACC, 0), varSym->name);
+            break;
+        default:
+            IL_AddComment(
+                    IL_AddInstrN(AND, ADDR_IMM, varSym->bitMask), varSym->name);
+            IL_AddInstrN(CMP, ADDR_IMM, 1);
+            break;
+    }
+}
+
+/**
+ * Do an op between A and a packed bool  (the bool is unpacked into a temp first)
+ */
+static void opWithPackedBool(enum MnemonicCode mne, const SymbolRecord *varSym) {
+    int tempAddr = ICG_AllocTemp(1);
+    if (tempAddr < 0) {
+        ErrorMessage("Out of zeropage temps to unpack bool", varSym->name, 0);
+        return;
+    }
+    ICG_PushAcc();
+    ICG_LoadPackedBool(varSym);
+    ICG_StoreToAddr(tempAddr, 1);
+    ICG_PullAcc();
+    IL_AddInstrN(mne, ADDR_ZP, tempAddr);
+    ICG_FreeTemp(1);
+
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+}
+
 bool isLastYUse(const SymbolRecord *varSym, int size) {
     enum LastRegisterUseType regUseType = size == 2 ? LW_VAR_X2 : LW_VAR;
     return ((lastUseForYReg.loadedWith == regUseType)
@@ -373,6 +556,13 @@ bool isLastYUse(const SymbolRecord *varSym, int size) {
 void ICG_LoadIndexVar(const SymbolRecord *varSym, int size) {
     const char *varName = getVarName(varSym);
 
+    if (ICG_IsLoopIndex(varSym, size)) return;
+    if (IS_PACKED_BOOL(varSym)) {
+        ICG_LoadRegVar(varSym, 'Y');
+        lastUseForYReg = REG_USED_FOR_NOTHING;
+        return;
+    }
+
     if (strncmp(varName, curCachedIndexVar, SYMBOL_NAME_LIMIT)==0) {
         IL_AddComment(
             IL_AddInstrP(LDY, ADDR_ZP, tempVarName, PARAM_NORMAL), "load cached index");
@@ -389,6 +579,7 @@ void ICG_LoadIndexVar(const SymbolRecord *varSym, int size) {
             IL_AddInstrN(ASL, ADDR_ACC, 0);
             IL_AddInstrB(TAY);
             lastUseForYReg.loadedWith = LW_VAR_X2;
+            lastStoredAReg = REG_USED_FOR_NOTHING;
             lastUseForAReg = REG_USED_FOR_NOTHING;
         } else {
             if (IS_PARAM_VAR(varSym)) {
@@ -413,6 +604,9 @@ void ICG_LoadIndexVar(const SymbolRecord *varSym, int size) {
 void ICG_SaveIndexVar(const SymbolRecord *varSym, int size) {
     const char *varName = getVarName(varSym);
 
+    // Y already holds the index for the whole loop, so nothing needs to be saved
+    if (ICG_IsLoopIndex(varSym, size)) return;
+
     IL_AddComment(
             IL_AddInstrP(LDA, ADDR_ZP, varName, PARAM_NORMAL), "load array index");
     if (size == 2) {
@@ -421,14 +615,83 @@ void ICG_SaveIndexVar(const SymbolRecord *varSym, int size) {
     IL_AddInstrP(STA, ADDR_ZP, tempVarName, PARAM_NORMAL);
 
     curCachedIndexVar = varName;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
+//-----------------------------------------------------------------------------
+//  Loop counter kept in the Y register
+//
+//    While set, Y holds (counter * scale), so any index loads of the
+//    counter using the same scale can be skipped.
+
+void ICG_SetLoopIndex(const SymbolRecord *varSym, int scale) {
+    loopIndexVar = varSym;
+    loopIndexScale = scale;
+}
+
+void ICG_ClearLoopIndex() {
+    loopIndexVar = NULL;
+}
+
+bool ICG_IsLoopIndex(const SymbolRecord *varSym, int scale) {
+    return (loopIndexVar != NULL) && (scale == loopIndexScale)
+           && (strncmp(loopIndexVar->name, varSym->name, SYMBOL_NAME_LIMIT) == 0);
+}
+
+/**
+ * Move the loop index to the next iteration
+ * @param delta - amount to add to Y (counter step * scale)
+ */
+void ICG_StepLoopIndex(int delta) {
+    int count = (delta < 0) ? -delta : delta;
+    if (count <= 3) {
+        for_range(step, 0, count) {
+            IL_AddInstrB((delta < 0) ? DEY : INY);
+        }
+    } else {
+        IL_AddInstrB(TYA);
+        if (delta < 0) {
+            IL_AddInstrB(SEC);
+            IL_AddInstrN(SBC, ADDR_IMM, count);
+        } else {
+            IL_AddInstrB(CLC);
+            IL_AddInstrN(ADC, ADDR_IMM, count);
+        }
+        IL_AddInstrB(TAY);
+        lastStoredAReg = REG_USED_FOR_NOTHING;
+        lastUseForAReg = REG_USED_FOR_NOTHING;
+    }
+    lastUseForYReg = REG_USED_FOR_NOTHING;
+}
+
+void ICG_CompareLoopIndex(int value) {
+    IL_AddInstrN(CPY, ADDR_IMM, value);
+}
+
+/**
+ * Leave the loop counter with its final value
+ *   (Y only holds the counter itself when it isn't scaled)
+ */
+void ICG_StoreLoopIndex(int finalValue) {
+    const SymbolRecord *varSym = loopIndexVar;
+    if (loopIndexScale == 1) {
+        IL_ClearOnUpdate(varSym);
+        IL_AddInstrP(STY, CALC_SYMBOL_ADDR_MODE(varSym), getVarName(varSym), PARAM_NORMAL);
+        lastUseForYReg.loadedWith = LW_VAR;
+        lastUseForYReg.varSym = varSym;
+    } else {
+        ICG_LoadConst(finalValue, 1);
+        ICG_StoreVarSym(varSym);
+    }
+}
+
 void ICG_LoadAddr(const SymbolRecord *varSym) {
     const char *varName = getVarName(varSym);
     IL_AddInstrP(LDA, ADDR_IMM, varName, PARAM_LO);
     IL_AddInstrP(LDX, ADDR_IMM, varName, PARAM_HI);
 
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg.loadedWith = LW_VAR;
     lastUseForAReg.varSym = varSym;
 }
@@ -437,6 +700,7 @@ void ICG_LoadAddrPlusIndex(const SymbolRecord *varSym, unsigned char index) {
     const char *varName = getVarName(varSym);
     IL_AddInstrS(LDA, ADDR_IMM, varName, numToStr(index), PARAM_ADD + PARAM_LO);
     IL_AddInstrS(LDX, ADDR_IMM, varName, numToStr(index), PARAM_ADD + PARAM_HI);
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
@@ -455,6 +719,7 @@ void ICG_LoadIndirect(const SymbolRecord *varSym, int destSize) {
     IL_AddComment(
             IL_AddInstrP(LDA, ADDR_IY, varName, PARAM_NORMAL),
             "load from pointer location using index");
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
@@ -466,6 +731,7 @@ void ICG_LoadIndexed(const SymbolRecord *varSym) {
     if (getBaseVarSize(varSym) > 1) {
         IL_AddInstrP(LDX, ADDR_ABY, varName, PARAM_NORMAL + PARAM_PLUS_ONE);
     }
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
@@ -476,8 +742,9 @@ void ICG_LoadIndexedWithOffset(const SymbolRecord *varSym, int ofs, int varSize)
             "load from array using index with offset");
 
     if (varSize == 2) {
-        IL_AddInstrS(LDX, ADDR_ABY, varName, numToStr(ofs+1), PARAM_NORMAL + PARAM_ADD);
+        IL_AddInstrS(LDX, ADDR_ABY, varName, numToStr(ofs + getArrayByteStride(varSym)), PARAM_NORMAL + PARAM_ADD);
     }
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
@@ -493,6 +760,7 @@ void ICG_LoadPropertyVar(const SymbolRecord *structSym, const SymbolRecord *prop
     if (getBaseVarSize(propertySym) == 2) {
         IL_AddInstrS(LDX, addrMode, structName, numToStr(propertyOfs+1), PARAM_NORMAL + PARAM_ADD);
     }
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg = REG_USED_FOR_NOTHING;
 }
 
@@ -506,6 +774,7 @@ void ICG_LoadRegConst(const char destReg, int ofs) {
         case 'A':
             if (!((lastUseForAReg.loadedWith == LW_CONST) && (lastUseForAReg.constValue == ofs))) {
                 IL_AddInstrN(LDA, ADDR_IMM, ofs);
+                lastStoredAReg = REG_USED_FOR_NOTHING;
                 lastUseForAReg.loadedWith = LW_CONST;
                 lastUseForAReg.constValue = ofs;
             }
@@ -522,6 +791,7 @@ void ICG_LoadRegConst(const char destReg, int ofs) {
             break;
         case 'S':
             IL_AddInstrN(LDA, ADDR_IMM, ofs);
+            lastStoredAReg = REG_USED_FOR_NOTHING;
             lastUseForAReg.loadedWith = LW_CONST;
             lastUseForAReg.constValue = ofs;
             ICG_PushAcc();
@@ -531,6 +801,17 @@ void ICG_LoadRegConst(const char destReg, int ofs) {
 
 void ICG_LoadRegVar(const SymbolRecord *varSym, char destReg) {
     const char *varName = getVarName(varSym);
+    if ((destReg == 'Y') && ICG_IsLoopIndex(varSym, 1)) return;
+    if (IS_PACKED_BOOL(varSym)) {
+        // unpacking uses A, so keep what's in it
+        if (destReg != 'A') ICG_PushAcc();
+        ICG_LoadPackedBool(varSym);
+        if (destReg != 'A') {
+            ICG_MoveAccToIndex(destReg);
+            ICG_PullAcc();
+        }
+        return;
+    }
     enum MnemonicCode mne;
     switch (destReg) {
         case 'A': mne = LDA; break;
@@ -541,8 +822,14 @@ void ICG_LoadRegVar(const SymbolRecord *varSym, char destReg) {
     enum AddrModes addrMode = isConst(varSym) ? ADDR_IMM : CALC_SYMBOL_ADDR_MODE(varSym);
     IL_AddInstrP(mne, addrMode, varName, PARAM_NORMAL);
 
-    if (destReg == 'A') {
-        lastUseForAReg = REG_USED_FOR_NOTHING;
+    switch (destReg) {
+        case 'A':
+            lastStoredAReg = REG_USED_FOR_NOTHING;
+            lastUseForAReg = REG_USED_FOR_NOTHING;
+            break;
+        case 'X': lastUseForXReg = REG_USED_FOR_NOTHING; break;
+        case 'Y': lastUseForYReg = REG_USED_FOR_NOTHING; break;
+        default: break;
     }
 }
 
@@ -557,6 +844,7 @@ void ICG_LoadPointerAddr(const SymbolRecord *varSym) {
     ICG_PushAcc();
 
     // mark that we have nothing loaded, since we pushed the DATA
+    lastStoredAReg = REG_USED_FOR_NOTHING;
     lastUseForAReg.loadedWith = LW_NONE;
 }
 
@@ -644,6 +932,11 @@ void ICG_StoreIndirect(const SymbolRecord *varSym, int dstSize) {
 
 
 void ICG_StoreVarSym(const SymbolRecord *varSym) {
+    if (IS_PACKED_BOOL(varSym)) {
+        ICG_StorePackedBool(varSym);
+        return;
+    }
+
     const char *varName = getVarName(varSym);
 
     bool isAregUnknown = (lastUseForAReg.loadedWith == LW_NONE);
@@ -664,6 +957,29 @@ void ICG_StoreVarSym(const SymbolRecord *varSym) {
     lastStoredAReg.varSym = varSym;
 }
 
+/**
+ * Store the A reg into a param in the called function's frame
+ *   (the param is local to the other function, so its address is used directly)
+ */
+void ICG_StoreFrameParam(const SymbolRecord *paramSym) {
+    IL_AddComment(
+            IL_AddInstrN(STA, ADDR_ZP, paramSym->location), paramSym->name);
+}
+
+/**
+ * Save a param passed in a register into its spot in the function's frame
+ */
+void ICG_SaveRegParam(const SymbolRecord *paramSym) {
+    enum MnemonicCode mne;
+    switch (paramSym->hint) {
+        case VH_X_REG: mne = STX; break;
+        case VH_Y_REG: mne = STY; break;
+        default:       mne = STA; break;
+    }
+    IL_AddComment(
+            IL_AddInstrP(mne, ADDR_ZP, getVarName(paramSym), PARAM_NORMAL), "save param passed in register");
+}
+
 void ICG_StoreIndexedWithOffset(const SymbolRecord *varSym, int ofs, int varSize) {
     const char *varName = getVarName(varSym);
     IL_AddComment(
@@ -671,7 +987,7 @@ void ICG_StoreIndexedWithOffset(const SymbolRecord *varSym, int ofs, int varSize
             "store to array using index with offset");
     if (varSize == 2) {
         IL_AddInstrB(TXA);
-        IL_AddInstrS(STA, ADDR_ABY, varName, numToStr(ofs), PARAM_PLUS_ONE + PARAM_ADD);
+        IL_AddInstrS(STA, ADDR_ABY, varName, numToStr(ofs + getArrayByteStride(varSym)), PARAM_NORMAL + PARAM_ADD);
     }
 }
 
@@ -691,6 +1007,22 @@ void ICG_NotBool() {
     IL_AddInstrN(EOR, ADDR_IMM, 0x01);
 }
 
+/**
+ * Load a bool result at the end of jump code
+ *
+ * Code falls thru to here when the condition is true, and branches to falseLabel when false.
+ */
+void ICG_LoadBoolFromJumps(Label *falseLabel) {
+    Label *doneLabel = newGenericLabel(LBL_CODE);
+
+    // NOTE: loads are not skipped here, since the branch needs the flags
+    IL_AddInstrN(LDA, ADDR_IMM, 1);
+    ICG_Branch(BNE, doneLabel);     // always taken
+    IL_Label(falseLabel);
+    IL_AddInstrN(LDA, ADDR_IMM, 0);
+    IL_Label(doneLabel);
+}
+
 void ICG_Negate() {
     IL_AddInstrN(EOR, ADDR_IMM, 0xFF);
     IL_AddInstrB(CLC);
@@ -725,6 +1057,209 @@ void ICG_OpHighByte(enum MnemonicCode mne, const char *varName) {
     }
 }
 
+//-------------------------------------------------------------------
+//  Zeropage temp pool
+//
+//  Holds values while working out 16-bit expressions.  Temps are
+//  handed out (and freed) like a stack, since expressions nest.
+
+static int tempPoolAddr;
+static int tempPoolSize;
+static int tempPoolUsed;
+
+void ICG_InitTempPool(int addr, int size) {
+    tempPoolAddr = addr;
+    tempPoolSize = size;
+    tempPoolUsed = 0;
+}
+
+/**
+ * Get a temp from the pool
+ *
+ * @return address of the temp, or -1 if the pool is out of space
+ */
+int ICG_AllocTemp(int size) {
+    if (tempPoolUsed + size > tempPoolSize) return -1;
+
+    int addr = tempPoolAddr + tempPoolUsed;
+    tempPoolUsed += size;
+    return addr;
+}
+
+void ICG_FreeTemp(int size) {
+    tempPoolUsed = (tempPoolUsed > size) ? (tempPoolUsed - size) : 0;
+}
+
+//-------------------------------------------------------------------
+//  16-bit ops  (16-bit values are held in A (low byte) and X (high byte))
+
+bool ICG_IsWordHighByteZero(WordOperand operand) {
+    if (operand.isTemp) return false;
+    if (operand.varSym == NULL) return ((operand.value & 0xff00) == 0);
+    if (isConst(operand.varSym)) return ((operand.varSym->constValue & 0xff00) == 0);
+    return (getBaseVarSize(operand.varSym) < 2);
+}
+
+/**
+ * Do an op with either the low or high byte of a 16-bit operand
+ */
+void ICG_OpWordByte(enum MnemonicCode mne, WordOperand operand, bool isHighByte) {
+    const SymbolRecord *varSym = operand.varSym;
+
+    if (operand.isTemp) {
+        IL_AddInstrN(mne, ADDR_ZP, operand.value + (isHighByte ? 1 : 0));
+    } else if (varSym == NULL) {
+        IL_AddInstrN(mne, ADDR_IMM, (isHighByte ? (operand.value >> 8) : operand.value) & 0xff);
+    } else if (isConst(varSym)) {
+        IL_AddInstrP(mne, ADDR_IMM, getVarName(varSym), isHighByte ? PARAM_HI : PARAM_LO);
+    } else if (isHighByte && (getBaseVarSize(varSym) < 2)) {
+        IL_AddInstrN(mne, ADDR_IMM, 0);
+    } else {
+        IL_AddInstrP(mne, CALC_SYMBOL_ADDR_MODE(varSym), getVarName(varSym),
+                     isHighByte ? PARAM_PLUS_ONE : PARAM_NORMAL);
+    }
+}
+
+/**
+ * Do a 16-bit op on A/X with an operand  (carry needs to be set up for ADC/SBC)
+ *
+ * @param tempAddr - temp to hold the low byte of the result while doing the high byte
+ */
+void ICG_OpWord(enum MnemonicCode mne, WordOperand operand, int tempAddr) {
+    ICG_OpWordByte(mne, operand, false);
+
+    if (ICG_IsWordHighByteZero(operand)) {
+        switch (mne) {
+            case ADC: ICG_OpHighByte(ADC, NULL); break;
+            case SBC: ICG_OpHighByte(SBC, NULL); break;
+            case AND: IL_AddInstrN(LDX, ADDR_IMM, 0); break;
+            default: break;
+        }
+    } else {
+        // the low byte of a temp operand is done with, so it can hold the result
+        int lowByteAddr = operand.isTemp ? operand.value : tempAddr;
+        IL_AddInstrN(STA, ADDR_ZP, lowByteAddr);
+        IL_AddInstrB(TXA);
+        ICG_OpWordByte(mne, operand, true);
+        IL_AddInstrB(TAX);
+        IL_AddInstrN(LDA, ADDR_ZP, lowByteAddr);
+    }
+
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+    lastUseForXReg = REG_USED_FOR_NOTHING;
+}
+
+/**
+ * Compare A/X with a 16-bit operand for less than / greater or equal
+ *
+ * Carry is set if A/X >= operand  (unsigned)
+ * Negative flag is set if A/X < operand  (signed)
+ */
+void ICG_CompareWord(WordOperand operand, bool isSigned) {
+    ICG_OpWordByte(CMP, operand, false);
+    IL_AddInstrB(TXA);
+    ICG_OpWordByte(SBC, operand, true);
+    if (isSigned) {
+        IL_AddInstrN(BVC, ADDR_REL, +4);
+        IL_AddInstrN(EOR, ADDR_IMM, 0x80);
+    }
+
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+}
+
+/**
+ * Compare A/X with a 16-bit operand for equality
+ *   (branches to notEqualLabel if the low bytes differ, otherwise the high bytes are compared)
+ */
+void ICG_CompareWordEquality(WordOperand operand, const Label *notEqualLabel) {
+    ICG_OpWordByte(CMP, operand, false);
+    ICG_Branch(BNE, notEqualLabel);
+    ICG_OpWordByte(CPX, operand, true);
+}
+
+/**
+ * Shift A/X
+ *
+ * @param mne - ASL or LSR
+ * @param isSigned - keep the sign when shifting right
+ * @param tempAddr - temp to hold one of the bytes while shifting
+ */
+void ICG_ShiftWord(enum MnemonicCode mne, int count, bool isSigned, int tempAddr) {
+    if (mne == ASL) {
+        IL_AddInstrN(STX, ADDR_ZP, tempAddr);
+        for_range(c, 0, count) {
+            IL_AddInstrN(ASL, ADDR_ACC, 0);
+            IL_AddInstrN(ROL, ADDR_ZP, tempAddr);
+        }
+        IL_AddInstrN(LDX, ADDR_ZP, tempAddr);
+    } else {
+        IL_AddInstrN(STA, ADDR_ZP, tempAddr);
+        IL_AddInstrB(TXA);
+        for_range(c, 0, count) {
+            if (isSigned) {
+                IL_AddInstrN(CMP, ADDR_IMM, 0x80);
+                IL_AddInstrN(ROR, ADDR_ACC, 0);
+            } else {
+                IL_AddInstrN(LSR, ADDR_ACC, 0);
+            }
+            IL_AddInstrN(ROR, ADDR_ZP, tempAddr);
+        }
+        IL_AddInstrB(TAX);
+        IL_AddInstrN(LDA, ADDR_ZP, tempAddr);
+    }
+
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+    lastUseForXReg = REG_USED_FOR_NOTHING;
+}
+
+/**
+ * Do a 16-bit op on two operands, storing the result directly in a var
+ *   (carry needs to be set up for ADC/SBC)
+ */
+void ICG_OpWordToVar(enum MnemonicCode mne, WordOperand operand1, WordOperand operand2, const SymbolRecord *destSym) {
+    const char *destName = getVarName(destSym);
+    enum AddrModes addrMode = CALC_SYMBOL_ADDR_MODE(destSym);
+
+    IL_ClearOnUpdate(destSym);
+
+    // when updating a var with a byte value, only the carry needs to go into the high byte
+    bool isUpdatingWithByte = (operand1.varSym == destSym) && !operand1.isTemp && ICG_IsWordHighByteZero(operand2);
+    int byteCount = isUpdatingWithByte ? 1 : 2;
+
+    for_range(byteIdx, 0, byteCount) {
+        bool isHighByte = (byteIdx == 1);
+        ICG_OpWordByte(LDA, operand1, isHighByte);
+        ICG_OpWordByte(mne, operand2, isHighByte);
+        IL_AddInstrP(STA, addrMode, destName, isHighByte ? PARAM_PLUS_ONE : PARAM_NORMAL);
+    }
+
+    if (isUpdatingWithByte) {
+        int incDecSize = (addrMode == ADDR_ZP) ? 2 : 3;
+        switch (mne) {
+            case ADC:
+                IL_AddInstrN(BCC, ADDR_REL, 2 + incDecSize);
+                IL_AddInstrP(INC, addrMode, destName, PARAM_PLUS_ONE);
+                break;
+            case SBC:
+                IL_AddInstrN(BCS, ADDR_REL, 2 + incDecSize);
+                IL_AddInstrP(DEC, addrMode, destName, PARAM_PLUS_ONE);
+                break;
+            case AND:
+                IL_AddInstrN(LDA, ADDR_IMM, 0);
+                IL_AddInstrP(STA, addrMode, destName, PARAM_PLUS_ONE);
+                break;
+            default:    // ORA/EOR with zero leave the high byte alone
+                break;
+        }
+    }
+
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+}
+
 void ICG_OpWithConst(enum MnemonicCode mne, int num, int dataSize) {
     IL_AddInstrN(mne, ADDR_IMM, num);
     if (dataSize > 1) ICG_OpHighByte(mne, NULL);
@@ -734,6 +1269,11 @@ void ICG_OpWithConst(enum MnemonicCode mne, int num, int dataSize) {
 }
 
 void ICG_OpWithVar(enum MnemonicCode mne, const SymbolRecord *varSym, int dataSize) {
+    if (IS_PACKED_BOOL(varSym)) {
+        opWithPackedBool(mne, varSym);
+        return;
+    }
+
     const char *varName = getVarName(varSym);
     if (isConst(varSym)) {
         IL_AddInstrP(mne, ADDR_IMM, varName, PARAM_NORMAL);
@@ -781,7 +1321,7 @@ void ICG_OpPropertyVar(enum MnemonicCode mne, const SymbolRecord *structSym, con
 
 void ICG_OpPropertyVarIndexed(enum MnemonicCode mne, const SymbolRecord *structSym, const SymbolRecord *propertySym) {
     const char *structName = getVarName(structSym);
-    const char *propOfsParam = numToStr(propertySym->location & 0xff);
+    const char *propOfsParam = numToStr(getArrayPropertyOffset(structSym, propertySym->location & 0xff));
 
     // DEC and INC operations are special because they don't have Absolute,Y address mode available,
     //   so things need to be done differently
@@ -809,6 +1349,16 @@ void ICG_OpPropertyVarIndexed(enum MnemonicCode mne, const SymbolRecord *structS
 
 void ICG_OpIndexed(enum MnemonicCode mne, const SymbolRecord *varSym, const SymbolRecord *indexSym) {
     const char *varName = getVarName(varSym);
+
+    // the loop counter is only in Y  (it isn't stored until the loop is done)
+    if (ICG_IsLoopIndex(indexSym, 1)) {
+        IL_AddComment(
+                IL_AddInstrP(mne, ADDR_ABY, varName, PARAM_NORMAL), "op with data from array using loop index");
+        lastUseForAReg = REG_USED_FOR_NOTHING;
+        lastStoredAReg = REG_USED_FOR_NOTHING;
+        return;
+    }
+
     IL_AddComment(
             IL_AddInstrP(LDX, CALC_SYMBOL_ADDR_MODE(indexSym), getVarName(indexSym), PARAM_NORMAL),
             "loading index var for array op");
@@ -973,6 +1523,11 @@ void ICG_CompareConst(int constValue) {
 }
 
 void ICG_CompareVar(const SymbolRecord *varSym) {
+    if (IS_PACKED_BOOL(varSym)) {
+        opWithPackedBool(CMP, varSym);
+        return;
+    }
+
     if (isConst(varSym)) {
         IL_AddInstrN(CMP, ADDR_IMM, varSym->constValue);
     } else {
@@ -1010,7 +1565,7 @@ void ICG_CompareIndexedWithOffset(const SymbolRecord *varSym, int ofs, int varSi
             "store to array using index with offset");
     if (varSize == 2) {
         //IL_AddInstrB(TXA);
-        IL_AddInstrS(CPX, ADDR_ABY, varName, numToStr(ofs), PARAM_PLUS_ONE + PARAM_ADD);
+        IL_AddInstrS(CPX, ADDR_ABY, varName, numToStr(ofs + getArrayByteStride(varSym)), PARAM_NORMAL + PARAM_ADD);
     }
 }
 
@@ -1023,17 +1578,52 @@ void ICG_Jump(const Label *label, const char *comment) {
             (char *)comment);
 }
 
+/**
+ * Clear a register tracker if the call could have changed the register, or the var it holds
+ */
+void clearTrackerOnCall(LastRegisterUse *registerUse, bool isRegClobbered, const ClobberSummary *clobbers) {
+    bool holdsVar = (registerUse->loadedWith == LW_VAR) || (registerUse->loadedWith == LW_VAR_X2);
+    if (isRegClobbered || (holdsVar && FM_isVarClobbered(clobbers, registerUse->varSym))) {
+        *registerUse = REG_USED_FOR_NOTHING;
+    }
+}
+
 void ICG_Call(const char *funcName) {
     IL_AddInstrP(JSR, ADDR_ABS, funcName, PARAM_NORMAL);
-    lastUseForAReg = REG_USED_FOR_NOTHING;
-    lastStoredAReg = REG_USED_FOR_NOTHING;
-    lastUseForYReg = REG_USED_FOR_NOTHING;
+
+    // only keep what's in the registers if the function is known to leave it alone
+    const ClobberSummary *clobbers = FM_getClobberSummary(funcName);
+    if (clobbers == NULL) {
+        lastUseForAReg = REG_USED_FOR_NOTHING;
+        lastStoredAReg = REG_USED_FOR_NOTHING;
+        lastUseForXReg = REG_USED_FOR_NOTHING;
+        lastUseForYReg = REG_USED_FOR_NOTHING;
+        IL_ClearCachedIndex();
+        return;
+    }
+
+    clearTrackerOnCall(&lastUseForAReg, clobbers->regs & CLOBBER_A, clobbers);
+    clearTrackerOnCall(&lastStoredAReg, clobbers->regs & CLOBBER_A, clobbers);
+    clearTrackerOnCall(&lastUseForXReg, clobbers->regs & CLOBBER_X, clobbers);
+    clearTrackerOnCall(&lastUseForYReg, clobbers->regs & CLOBBER_Y, clobbers);
+    if (clobbers->zeropage[0x80 >> 3] & 0x01) IL_ClearCachedIndex();
 }
 
 void ICG_Return() {
     IL_AddInstrB(RTS);
 }
 
+/**
+ * Load A with the bool returned in the carry flag  (0 or 1)
+ */
+void ICG_LoadCarry() {
+    IL_AddComment(
+            IL_AddInstrN(LDA, ADDR_IMM, 0), "bool returned in carry");
+    IL_AddInstrN(ROL, ADDR_ACC, 0);
+    lastUseForAReg = REG_USED_FOR_NOTHING;
+    lastStoredAReg = REG_USED_FOR_NOTHING;
+}
+
 
 //----------------------------------------
 //  Handle inline assembly
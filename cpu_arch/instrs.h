@@ -38,6 +38,15 @@ typedef struct {
     const SymbolRecord *varSym;
 } LastRegisterUse;
 
+//----------------------------------------------
+//  16-bit operands  (var, const or temp)
+
+typedef struct {
+    const SymbolRecord *varSym;     // NULL for a const or temp
+    int value;                      // const value or temp address
+    bool isTemp;
+} WordOperand;
+
 extern void ICG_Tag(char regName, SymbolRecord *varSym);
 extern bool ICG_IsCurrentTag(char regName, SymbolRecord *varSym);
 extern bool ICG_isLastInstrReturn();
@@ -51,8 +60,20 @@ extern void ICG_LoadConst(int constValue, int size);
 
 extern void ICG_LoadByteVar(const SymbolRecord *varRec, int ofs);
 extern void ICG_LoadVar(const SymbolRecord *varRec);
+extern void ICG_LoadPackedBool(const SymbolRecord *varSym);
+extern void ICG_BranchOnPackedBool(const SymbolRecord *varSym, bool branchIfTrue, const Label *label);
+extern void ICG_SetPackedBool(const SymbolRecord *varSym, bool value);
+extern void ICG_TogglePackedBool(const SymbolRecord *varSym);
+extern void ICG_StorePackedBool(const SymbolRecord *varSym);
+extern void ICG_PackedBoolToCarry(const SymbolRecord *varSym);
 extern void ICG_LoadIndexVar(const SymbolRecord *varSym, int size);
 extern void ICG_SaveIndexVar(const SymbolRecord *varSym, int size);
+extern void ICG_SetLoopIndex(const SymbolRecord *varSym, int scale);
+extern void ICG_ClearLoopIndex();
+extern bool ICG_IsLoopIndex(const SymbolRecord *varSym, int scale);
+extern void ICG_StepLoopIndex(int delta);
+extern void ICG_CompareLoopIndex(int value);
+extern void ICG_StoreLoopIndex(int finalValue);
 extern void ICG_LoadAddr(const SymbolRecord *varSym);
 extern void ICG_LoadAddrPlusIndex(const SymbolRecord *varSym, unsigned char index);
 extern void ICG_LoadIndirect(const SymbolRecord *varSym, int destSize);
@@ -70,12 +91,15 @@ extern void ICG_StoreVarOffset(const SymbolRecord *varSym, int ofs, int destSize
 extern void ICG_StoreVarIndexed(const SymbolRecord *varSym);
 extern void ICG_StoreIndirect(const SymbolRecord *varSym, int dstSize);
 extern void ICG_StoreVarSym(const SymbolRecord *varSym);
+extern void ICG_StoreFrameParam(const SymbolRecord *paramSym);
+extern void ICG_SaveRegParam(const SymbolRecord *paramSym);
 extern void ICG_StoreIndexedWithOffset(const SymbolRecord *varSym, int ofs, int varSize);
 
 extern void ICG_Branch(enum MnemonicCode mne, const Label *label);
 
 extern void ICG_Not();
 extern void ICG_NotBool();
+extern void ICG_LoadBoolFromJumps(Label *falseLabel);
 extern void ICG_Negate();
 extern void ICG_PreOp(enum MnemonicCode preOp);
 
@@ -87,6 +111,17 @@ extern void ICG_OpIndexed(enum MnemonicCode mne, const SymbolRecord *varSym, con
 extern void ICG_OpIndexedWithOffset(enum MnemonicCode mne, const SymbolRecord *varSym, int ofs);
 extern void ICG_OpWithStack(enum MnemonicCode mne);
 
+extern void ICG_InitTempPool(int addr, int size);
+extern int ICG_AllocTemp(int size);
+extern void ICG_FreeTemp(int size);
+
+extern bool ICG_IsWordHighByteZero(WordOperand operand);
+extern void ICG_OpWord(enum MnemonicCode mne, WordOperand operand, int tempAddr);
+extern void ICG_OpWordToVar(enum MnemonicCode mne, WordOperand operand1, WordOperand operand2, const SymbolRecord *destSym);
+extern void ICG_CompareWord(WordOperand operand, bool isSigned);
+extern void ICG_CompareWordEquality(WordOperand operand, const Label *notEqualLabel);
+extern void ICG_ShiftWord(enum MnemonicCode mne, int count, bool isSigned, int tempAddr);
+
 extern void ICG_MoveAccToIndex(const char destReg);
 extern void ICG_PushAcc();
 extern void ICG_PullAcc();
@@ -109,6 +144,7 @@ extern void ICG_CompareIndexedWithOffset(const SymbolRecord *varSym, int ofs, in
 extern void ICG_Jump(const Label *label, const char* comment);
 extern void ICG_Call(const char *funcName);
 extern void ICG_Return();
+extern void ICG_LoadCarry();
 
 //-----------------------------------------------------------------------
 //---- Handle other things:  inline assembly, functions, static data
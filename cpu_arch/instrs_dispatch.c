@@ -0,0 +1,157 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Function table dispatch
+//
+//  A function table is stored as the low bytes of each function's
+//  address (less one), followed by the high bytes:
+//
+//      handlers:   .byte <(funcA-1), <(funcB-1), <(funcC-1)
+//                  .byte >(funcA-1), >(funcB-1), >(funcC-1)
+//
+//  Each table gets a small dispatch routine, which is called with the
+//  index in X.  It pushes the address and "returns" to it, so the function
+//  runs as if it had been called directly, and its RTS goes straight back
+//  to the caller:
+//
+//      handlers_dispatch:
+//          LDA handlers+3,X
+//          PHA
+//          LDA handlers,X
+//          PHA
+//          RTS
+//
+//  A call thru the table is then LDX index / JSR handlers_dispatch
+//  (or a JMP, when it's the last thing a function does).
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "instrs_dispatch.h"
+#include "instrs.h"
+#include "common/common.h"
+#include "codegen/gen_common.h"
+#include "output/output_block.h"
+
+enum {
+    MAX_FUNC_TABLES = 32
+};
+
+typedef struct {
+    const SymbolRecord *tableSym;
+    SymbolRecord *dispatchSym;
+    const List *funcList;           // [list, funcName, ...]
+} FuncTable;
+
+//-- symbol table to add the dispatch routines to
+static SymbolTable *dispatch_globalSymbolTable;
+
+static FuncTable funcTables[MAX_FUNC_TABLES];
+static int funcTableCount;
+
+//-----------------------------------------------------------------------------
+
+void ICG_Dispatch_Init(SymbolTable *globalSymbolTable) {
+    dispatch_globalSymbolTable = globalSymbolTable;
+    funcTableCount = 0;
+}
+
+static const FuncTable *findFuncTable(const SymbolRecord *tableSym) {
+    for_range(index, 0, funcTableCount) {
+        if (funcTables[index].tableSym == tableSym) return &funcTables[index];
+    }
+    return NULL;
+}
+
+/**
+ * Build the dispatch routine for a table
+ */
+static SymbolRecord *buildDispatch(const SymbolRecord *tableSym, int funcCount) {
+    char *dispatchName = allocMem(strlen(tableSym->name) + 10);
+    sprintf(dispatchName, "%s_dispatch", tableSym->name);
+
+    SymbolRecord *dispatchSym = addSymbol(dispatch_globalSymbolTable, dispatchName, SK_FUNC, ST_NONE, MF_NONE);
+    markFunctionUsed(dispatchSym);
+
+    ICG_StartOfFunction(newLabel(dispatchName, LBL_CODE), dispatchSym);
+    IL_AddComment(
+            IL_AddInstrS(LDA, ADDR_ABX, tableSym->name, intToStr(funcCount), PARAM_ADD), "push address-1 of function");
+    IL_AddInstrB(PHA);
+    IL_AddInstrP(LDA, ADDR_ABX, tableSym->name, PARAM_NORMAL);
+    IL_AddInstrB(PHA);
+    IL_AddComment(
+            IL_AddInstrB(RTS), "...and return into it");
+    dispatchSym->instrBlock = ICG_EndOfFunction();
+
+    GC_OB_AddCodeBlock(dispatchSym);
+    return dispatchSym;
+}
+
+/**
+ * Add a function table (and its dispatch routine) to the output
+ *
+ *  The table's symbol comes in with the list of function names, and
+ *  leaves with the table data  (the low bytes, then the high bytes).
+ */
+void ICG_AddFuncTable(SymbolRecord *tableSym) {
+    if (funcTableCount >= MAX_FUNC_TABLES) {
+        ErrorMessage("Too many function tables", tableSym->name, 0);
+        return;
+    }
+
+    const List *funcList = tableSym->astList;
+    int funcCount = funcList->count - 1;
+
+    List *dataList = createList(funcCount * 2 + 1);
+    addNode(dataList, createParseToken(PT_LIST));
+    for_range(half, 0, 2) {
+        for_range(index, 1, funcList->count) {
+            addNode(dataList, funcList->nodes[index]);
+        }
+    }
+    tableSym->numElements = funcCount;
+    tableSym->astList = dataList;
+    GC_OB_AddDataBlock(tableSym);
+
+    FuncTable *funcTable = &funcTables[funcTableCount++];
+    funcTable->tableSym = tableSym;
+    funcTable->funcList = funcList;
+    funcTable->dispatchSym = buildDispatch(tableSym, funcCount);
+}
+
+/**
+ * Call the function picked by X from a table
+ */
+void ICG_CallFuncTable(const SymbolRecord *tableSym) {
+    const FuncTable *funcTable = findFuncTable(tableSym);
+    if (funcTable == NULL) return;
+
+    ICG_Call(funcTable->dispatchSym->name);
+}
+
+/**
+ * Get the functions a dispatch routine can go to
+ *
+ * @return list of function names ([list, funcName, ...]), or NULL if it's not a dispatch routine
+ */
+const List *ICG_GetDispatchTargets(const char *dispatchName) {
+    for_range(index, 0, funcTableCount) {
+        if (strcmp(funcTables[index].dispatchSym->name, dispatchName) == 0) return funcTables[index].funcList;
+    }
+    return NULL;
+}
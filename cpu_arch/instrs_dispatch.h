@@ -0,0 +1,29 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef MODULE_INSTRS_DISPATCH_H
+#define MODULE_INSTRS_DISPATCH_H
+
+#include "data/symbols.h"
+
+extern void ICG_Dispatch_Init(SymbolTable *globalSymbolTable);
+extern void ICG_AddFuncTable(SymbolRecord *tableSym);
+extern void ICG_CallFuncTable(const SymbolRecord *tableSym);
+extern const List *ICG_GetDispatchTargets(const char *dispatchName);
+
+#endif //MODULE_INSTRS_DISPATCH_H
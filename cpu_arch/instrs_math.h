@@ -23,6 +23,7 @@
 
 extern void ICG_Mul_InitLookupTables(SymbolTable *globalSymbolTable);
 extern SymbolRecord* ICG_Mul_AddLookupTable(char lookupValue);
+extern bool hasValueLookupTable(char lookupValue);
 
 extern void ICG_LoadVarForMultiply(const SymbolRecord *varRec);
 extern void ICG_MultiplyVarWithVar(const SymbolRecord *varRec, const SymbolRecord *varRec2);
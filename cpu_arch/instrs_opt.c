@@ -90,4 +90,38 @@ initCopyLoop:
     }
     IL_AddInstrB(DEY);
     ICG_Branch(BPL, startOfLoop);
-}
\ No newline at end of file
+}
+/**
+ * Store a set of initial data into an element of a split array of structs
+ *   (Y holds the index of the element)
+ *
+ * Each byte of the struct lives in its own array, so there is no
+ *  contiguous block to copy... each byte is stored separately.
+ *
+ * @param listNode
+ * @param arraySym - split array being stored into
+ */
+void ICG_StoreDataIntoSplitArray(ListNode listNode, SymbolRecord *arraySym) {
+    const char *arrayName = getVarName(arraySym);
+    int byteStride = getArrayByteStride(arraySym);
+
+    SymbolTable *structSymTbl = GET_STRUCT_SYMBOL_TABLE(arraySym->userTypeDef);
+    SymbolRecord *curStructVar = structSymTbl->firstSymbol;
+    List *initList = listNode.value.list;
+    int index = 1;
+    while ((index < initList->count) && (curStructVar != NULL)) {
+        int value = initList->nodes[index].value.num;
+        int ofs = getArrayPropertyOffset(arraySym, GET_PROPERTY_OFFSET(curStructVar));
+
+        IL_AddInstrN(LDA, ADDR_IMM, value & 0xff);
+        IL_AddInstrS(STA, ADDR_ABY, arrayName, numToStr(ofs), PARAM_NORMAL + PARAM_ADD);
+        if (getBaseVarSize(curStructVar) > 1) {
+            IL_AddInstrN(LDA, ADDR_IMM, (value >> 8) & 0xff);
+            IL_AddInstrS(STA, ADDR_ABY, arrayName, numToStr(ofs + byteStride), PARAM_NORMAL + PARAM_ADD);
+        }
+
+        // go to next element
+        curStructVar = curStructVar->next;
+        index++;
+    }
+}
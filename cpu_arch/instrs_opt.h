@@ -24,5 +24,6 @@
 #include "data/symbols.h"
 
 extern void ICG_CopyDataIntoStruct(ListNode listNode, SymbolRecord *destVar, bool useIndirect);
+extern void ICG_StoreDataIntoSplitArray(ListNode listNode, SymbolRecord *arraySym);
 
 #endif //NEOLITHIC_INSTRS_OPT_H
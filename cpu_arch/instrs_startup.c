@@ -0,0 +1,335 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Startup RAM initialization
+//
+//  Generates the part of main's init code that sets up RAM:
+//
+//   - all of the zeropage RAM (and the used part of any other RAM) is
+//       cleared with a tight loop
+//   - global variables with a non-zero initial value are then copied in
+//       from a table in ROM
+//
+//  The table is made of records, one per run of variables allocated next
+//  to each other (small gaps are filled in with zeros):
+//
+//      .byte runLength, <(addr-1) [, >(addr-1)]     ; high byte left out if all runs are in zeropage
+//      .byte data...                                ; last byte first
+//      ...
+//      .byte 0                                      ; end of table
+//
+//  The copy loop uses the two zeropage bytes reserved for the 16-bit
+//  accumulator as its pointer.  The table is indexed with X, so a table
+//  can't go past 255 bytes.  Bigger programs get more than one table.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "instrs_startup.h"
+#include "instrs.h"
+#include "common/common.h"
+#include "machine/mem.h"
+#include "codegen/gen_common.h"
+#include "output/output_block.h"
+
+enum {
+    MAX_INIT_VARS = 256,
+    MAX_TABLE_SIZE = 255,       // tables are indexed with X
+    MAX_RUN_LENGTH = 255
+};
+
+typedef struct {
+    int addr;
+    int size;
+    int value;
+} InitVar;
+
+typedef struct {
+    List *dataList;
+    int size;
+    int recordCount;
+    int maxRunLength;
+} InitTable;
+
+//-- symbol table to look for initialized globals in (and to add the tables to)
+static SymbolTable *startup_globalSymbolTable;
+static int initTableCount;
+
+//-----------------------------------------------------------------------------
+
+void ICG_Startup_Init(SymbolTable *globalSymbolTable) {
+    startup_globalSymbolTable = globalSymbolTable;
+    initTableCount = 0;
+}
+
+static int compareInitVars(const void *a, const void *b) {
+    return ((const InitVar *)a)->addr - ((const InitVar *)b)->addr;
+}
+
+/**
+ * Collect the global variables that start with a non-zero value
+ * @return number of variables found (sorted by address)
+ */
+static int collectInitVars(InitVar *initVars) {
+    int count = 0;
+
+    for (SymbolRecord *curSymbol = startup_globalSymbolTable->firstSymbol; curSymbol != NULL; curSymbol = curSymbol->next) {
+        if (!isVariable(curSymbol) || isArray(curSymbol) || !curSymbol->hasValue) continue;
+        if (!HAS_SYMBOL_LOCATION(curSymbol) || (curSymbol->location == 0xffff)) continue;
+
+        int size = getBaseVarSize(curSymbol);
+        if (size > 2) continue;
+
+        int value = curSymbol->constValue & ((size > 1) ? 0xFFFF : 0xFF);
+        if (value == 0) continue;       // RAM is already cleared
+
+        // packed bools set their bit in the byte they share
+        if (IS_PACKED_BOOL(curSymbol)) {
+            value = curSymbol->bitMask;
+            InitVar *sharedByte = NULL;
+            for_range(index, 0, count) {
+                if (initVars[index].addr == curSymbol->location) sharedByte = &initVars[index];
+            }
+            if (sharedByte != NULL) {
+                sharedByte->value |= value;
+                continue;
+            }
+        }
+
+        if (count >= MAX_INIT_VARS) {
+            WarningMessage("Too many initialized variables, skipping", curSymbol->name, 0);
+            continue;
+        }
+        initVars[count].addr = curSymbol->location;
+        initVars[count].size = size;
+        initVars[count].value = value;
+        count++;
+    }
+
+    qsort(initVars, count, sizeof(InitVar), compareInitVars);
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+//  Table building
+
+static void startTable(InitTable *table) {
+    table->dataList = createList(MAX_TABLE_SIZE + 1);
+    addNode(table->dataList, createParseToken(PT_INIT));
+    table->size = 0;
+    table->recordCount = 0;
+    table->maxRunLength = 0;
+}
+
+static void addTableByte(InitTable *table, int value) {
+    addNode(table->dataList, createIntNode(value & 0xFF));
+    table->size++;
+}
+
+/**
+ * Add a record for a run of variables  (initVars[first] up to, but not including, initVars[last])
+ *
+ *  Any bytes between the variables are left as 0.
+ */
+static void addRecord(InitTable *table, const InitVar *initVars, int first, int last, int headerSize) {
+    int startAddr = initVars[first].addr;
+    int runLength = initVars[last-1].addr + initVars[last-1].size - startAddr;
+
+    unsigned char runData[MAX_RUN_LENGTH] = {0};
+    for_range(index, first, last) {
+        const InitVar *initVar = &initVars[index];
+        int ofs = initVar->addr - startAddr;
+        runData[ofs] = initVar->value & 0xFF;
+        if (initVar->size > 1) runData[ofs+1] = initVar->value >> 8;
+    }
+
+    // pointer is one byte before the run, since Y counts down from runLength to 1
+    addTableByte(table, runLength);
+    addTableByte(table, startAddr - 1);
+    if (headerSize > 2) addTableByte(table, (startAddr - 1) >> 8);
+
+    for (int ofs = runLength-1; ofs >= 0; ofs--) {
+        addTableByte(table, runData[ofs]);
+    }
+
+    table->recordCount++;
+    if (runLength > table->maxRunLength) table->maxRunLength = runLength;
+}
+
+static const MemoryArea *findMemoryArea(int addr) {
+    const MemoryArea *memArea;
+    for (int areaIndex = 0; (memArea = SMA_getMemoryArea(areaIndex)) != NULL; areaIndex++) {
+        if ((addr >= memArea->startAddr) && (addr <= memArea->endAddr)) return memArea;
+    }
+    return NULL;
+}
+
+/**
+ * Can the next variable be added to the run?
+ *
+ *  Small gaps (of variables starting at 0) are filled in with zeros, when
+ *  that takes fewer bytes than starting a new record.  The gap has to be
+ *  variable RAM, so both sides need to be in the same memory area.
+ */
+static bool canJoinRun(const InitVar *prevVar, const InitVar *nextVar, int headerSize) {
+    int gap = nextVar->addr - (prevVar->addr + prevVar->size);
+    if (gap == 0) return true;
+    if ((gap < 0) || (gap >= headerSize)) return false;
+
+    const MemoryArea *memArea = findMemoryArea(prevVar->addr);
+    return (memArea != NULL) && (memArea == findMemoryArea(nextVar->addr));
+}
+
+//-----------------------------------------------------------------------------
+//  Code generation
+
+/**
+ * Clear RAM
+ *
+ *  Zeropage is cleared all the way, the other areas are cleared a page at
+ *  a time up to the last page holding variables.
+ *
+ *  Leaves X = 0
+ */
+static void emitClearRAM() {
+    const MemoryArea *zeropage = SMA_getZeropageArea();
+    int zeropageSize = zeropage->endAddr - zeropage->startAddr + 1;
+
+    IL_AddComment(
+            IL_AddInstrN(LDA, ADDR_IMM, 0), "Clear RAM");
+    IL_AddInstrN(LDX, ADDR_IMM, zeropageSize & 0xFF);
+
+    Label *clearZeropage = newGenericLabel(LBL_LOOP_START);
+    clearZeropage->loopBound = zeropageSize - 1;
+    IL_Label(clearZeropage);
+    IL_AddInstrN(STA, ADDR_ZPX, zeropage->startAddr - 1);
+    IL_AddInstrB(DEX);
+    ICG_Branch(BNE, clearZeropage);
+
+    // X is 0 here, so it can run a full page for everything else
+    Label *clearPages = NULL;
+    const MemoryArea *memArea;
+    for (int areaIndex = 1; (memArea = SMA_getMemoryArea(areaIndex)) != NULL; areaIndex++) {
+        for (int pageAddr = memArea->startAddr; pageAddr < memArea->curOffset; pageAddr += 0x100) {
+            if ((pageAddr + 0xFF) > memArea->endAddr) break;      // (areas are expected to be whole pages)
+
+            if (clearPages == NULL) {
+                clearPages = newGenericLabel(LBL_LOOP_START);
+                clearPages->loopBound = 0xFF;
+                IL_Label(clearPages);
+            }
+            IL_AddInstrN(STA, ADDR_ABX, pageAddr);
+        }
+    }
+    if (clearPages != NULL) {
+        IL_AddInstrB(INX);
+        ICG_Branch(BNE, clearPages);
+    }
+}
+
+/**
+ * Add the table to the output, and the loop that copies it into RAM
+ */
+static void emitCopyTable(const InitTable *table, int headerSize) {
+    addNode(table->dataList, createIntNode(0));        // end of table
+
+    char *tableName = allocMem(16);
+    sprintf(tableName, "RAM_INIT_%d", initTableCount++);
+
+    SymbolRecord *tableRec = addSymbol(startup_globalSymbolTable, tableName, SK_CONST, ST_CHAR, MF_ARRAY);
+    tableRec->astList = table->dataList;
+    GC_OB_AddDataBlock(tableRec);
+
+    int ptrAddr = SMA_getZeropageArea()->startAddr;
+
+    Label *nextRecord = newGenericLabel(LBL_LOOP_START);
+    Label *copyByte = newGenericLabel(LBL_LOOP_START);
+    Label *doneLabel = newGenericLabel(LBL_CODE);
+    nextRecord->loopBound = table->recordCount;          // (goes around once more to reach the end of the table)
+    copyByte->loopBound = table->maxRunLength - 1;
+
+    IL_AddComment(
+            IL_AddInstrN(LDX, ADDR_IMM, 0), "Copy initial values");
+    IL_Label(nextRecord);
+    IL_AddInstrP(LDY, ADDR_ABX, tableName, PARAM_NORMAL);
+    ICG_Branch(BEQ, doneLabel);
+    IL_AddInstrS(LDA, ADDR_ABX, tableName, intToStr(1), PARAM_ADD);
+    IL_AddInstrN(STA, ADDR_ZP, ptrAddr);
+    if (headerSize > 2) {
+        IL_AddInstrS(LDA, ADDR_ABX, tableName, intToStr(2), PARAM_ADD);
+        IL_AddInstrN(STA, ADDR_ZP, ptrAddr + 1);
+    }
+
+    IL_Label(copyByte);
+    IL_AddInstrS(LDA, ADDR_ABX, tableName, intToStr(headerSize), PARAM_ADD);
+    IL_AddInstrN(STA, ADDR_IY, ptrAddr);
+    IL_AddInstrB(INX);
+    IL_AddInstrB(DEY);
+    ICG_Branch(BNE, copyByte);
+
+    for_range(index, 0, headerSize) {
+        IL_AddInstrB(INX);
+    }
+    ICG_Branch(BNE, nextRecord);        // always taken  (table is less than a page)
+    IL_Label(doneLabel);
+}
+
+/**
+ * Generate the code that clears RAM and sets the initial values of global variables
+ *
+ *  Must be called after variables have been allocated.
+ */
+void ICG_StartupInitRAM() {
+    emitClearRAM();
+
+    InitVar *initVars = allocMem(MAX_INIT_VARS * sizeof(InitVar));
+    int initVarCount = collectInitVars(initVars);
+    if (initVarCount == 0) return;
+
+    // the high byte of the address is only needed if a variable is outside of zeropage
+    //   (the pointer's high byte was just cleared)
+    int headerSize = (initVars[initVarCount-1].addr + initVars[initVarCount-1].size > 0x100) ? 3 : 2;
+
+    InitTable table;
+    startTable(&table);
+
+    int first = 0;
+    while (first < initVarCount) {
+        // grow the run while the variables are next to each other
+        int last = first + 1;
+        int runLength = initVars[first].size;
+        while (last < initVarCount) {
+            int newRunLength = initVars[last].addr + initVars[last].size - initVars[first].addr;
+            if (!canJoinRun(&initVars[last-1], &initVars[last], headerSize)) break;
+            if ((newRunLength > MAX_RUN_LENGTH) || (headerSize + newRunLength >= MAX_TABLE_SIZE)) break;
+
+            runLength = newRunLength;
+            last++;
+        }
+
+        // start another table if this one is full  (leaving room for the end marker)
+        if (table.size + headerSize + runLength >= MAX_TABLE_SIZE) {
+            emitCopyTable(&table, headerSize);
+            startTable(&table);
+        }
+
+        addRecord(&table, initVars, first, last, headerSize);
+        first = last;
+    }
+    emitCopyTable(&table, headerSize);
+}
@@ -22,22 +22,42 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "common/common.h"
 #include "bank_layout.h"
 
 struct BankLayout *mainBankLayout;
 
+//--------------------------------------------------------------------
+//  Supported bank-switching schemes
+//
+//    F8/F6/F4 - whole 4k bank is switched by reading a hotspot ($1FF8+)
+//    E0       - 1k slices; slices 0-6 are switched into $1000, slice 7 is fixed at $1C00
+//    3F       - 2k banks; write bank number to $3F, last bank is fixed at $1800
+
+static const BankingSchemeDef BankingSchemes[] = {
+        {BANKING_F8, "F8", 2, 0x1000, 0x1FF8, 8,  false},
+        {BANKING_F6, "F6", 4, 0x1000, 0x1FF6, 10, false},
+        {BANKING_F4, "F4", 8, 0x1000, 0x1FF4, 12, false},
+        {BANKING_E0, "E0", 8, 0x0400, 0x1FE0, 32, true},
+        {BANKING_3F, "3F", 4, 0x0800, 0x003F, 4,  true},
+};
+static const int NumBankingSchemes = sizeof(BankingSchemes) / sizeof(BankingSchemeDef);
+
 void BL_init() {
     mainBankLayout = malloc(sizeof(struct BankLayout));
     mainBankLayout->banksUsed = 0;
     mainBankLayout->usesMultipleBankSizes = false;
+    mainBankLayout->bankingScheme = NULL;
 }
 
-void BL_addBank(int size, int memLoc, int fileLoc) {
+void BL_addBank(int size, int memLoc, int fileLoc, int reserved) {
     struct BankDef newBank;
     newBank.size = size;
     newBank.memLoc = memLoc;
     newBank.fileLoc = fileLoc;
+    newBank.reserved = reserved;
+    newBank.isFixed = false;
 
     mainBankLayout->banks[mainBankLayout->banksUsed] = newBank;
     mainBankLayout->banksUsed++;
@@ -47,18 +67,67 @@ int BL_getMachineAddr(int bankNum) {
     return mainBankLayout->banks[bankNum].memLoc;
 }
 
+/**
+ * Get the number of bytes in a bank available for code and data
+ */
+int BL_getUsableSize(int bankNum) {
+    return mainBankLayout->banks[bankNum].size - mainBankLayout->banks[bankNum].reserved;
+}
+
+const BankingSchemeDef *BL_lookupBankingScheme(const char *schemeName) {
+    for_range(index, 0, NumBankingSchemes) {
+        if (strcmp(schemeName, BankingSchemes[index].name) == 0) {
+            return &BankingSchemes[index];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Replace the current bank layout with the banks of a bank-switching scheme
+ *
+ *   Banks are given unique (mirrored) addresses by placing each one
+ *   in its own 8k block of the address space:  bank N => startAddr + N*$2000
+ *
+ * @param bankingScheme - scheme to use
+ * @param startAddr - start of cartridge address space ($1000)
+ */
+void BL_setBankingScheme(const BankingSchemeDef *bankingScheme, int startAddr) {
+    mainBankLayout->banksUsed = 0;
+    mainBankLayout->bankingScheme = bankingScheme;
+
+    int fixedBank = bankingScheme->hasFixedBank ? (bankingScheme->numBanks - 1) : -1;
+    for_range(bankNum, 0, bankingScheme->numBanks) {
+        bool isFixed = (bankNum == fixedBank);
+        int windowAddr = isFixed ? (startAddr + 0x1000 - bankingScheme->bankSize) : startAddr;
+        int reserved = (isFixed || (fixedBank < 0)) ? bankingScheme->reserved : 0;
+
+        BL_addBank(bankingScheme->bankSize, windowAddr + (bankNum * 0x2000),
+                   bankNum * bankingScheme->bankSize, reserved);
+        mainBankLayout->banks[bankNum].isFixed = isFixed;
+    }
+}
+
+const BankingSchemeDef *BL_getBankingScheme() {
+    return mainBankLayout->bankingScheme;
+}
+
 void BL_done() {
     if (mainBankLayout) free(mainBankLayout);
 }
 
 void BL_printBanks() {
-    printf("\nBank layout:\n");
+    if (mainBankLayout->bankingScheme != NULL) {
+        printf("\nBank layout (%s):\n", mainBankLayout->bankingScheme->name);
+    } else {
+        printf("\nBank layout:\n");
+    }
     printf("------------------\n");
     for_range(curBank, 0, mainBankLayout->banksUsed) {
         struct BankDef curBankDef = mainBankLayout->banks[curBank];
         int bankEnd = (curBankDef.memLoc + curBankDef.size - 1);
 
-        printf("  %d: %4X - %4X\n", curBank, curBankDef.memLoc, bankEnd);
+        printf("  %d: %4X - %4X%s\n", curBank, curBankDef.memLoc, bankEnd, curBankDef.isFixed ? "  (fixed)" : "");
     }
     printf("\n");
 }
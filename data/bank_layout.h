@@ -31,20 +31,41 @@ struct BankDef {
     int memLoc;     // memory location of the start of the bank
     int fileLoc;    // where in the binary file the bank is located
     int size;       // size of the bank
+    int reserved;   // bytes at the end of the bank not available for code/data (hotspots, vectors)
+    bool isFixed;   // bank is always mapped in (can be reached from any other bank)
 };
 typedef struct BankDef BankDef;
 
+//--- Bank-switching schemes (Atari 2600)
+
+enum BankingScheme { BANKING_NONE, BANKING_F8, BANKING_F6, BANKING_F4, BANKING_E0, BANKING_3F };
+
+typedef struct {
+    enum BankingScheme scheme;
+    char *name;
+    int numBanks;
+    int bankSize;
+    int hotspotAddr;    // address used to select the first bank (others follow)
+    int reserved;       // bytes reserved at end of each bank (or fixed bank only, if there is one)
+    bool hasFixedBank;  // last bank is always mapped in at the top of the address space
+} BankingSchemeDef;
+
 struct BankLayout {
     bool usesMultipleBankSizes;
     int banksUsed;
+    const BankingSchemeDef *bankingScheme;
     struct BankDef banks[MAX_BANKS];
 };
 typedef struct BankLayout BankLayout;
 
 
 extern void BL_init();
-extern void BL_addBank(int size, int memLoc, int fileLoc);
+extern void BL_addBank(int size, int memLoc, int fileLoc, int reserved);
 extern int BL_getMachineAddr(int bankNum);
+extern int BL_getUsableSize(int bankNum);
+extern const BankingSchemeDef *BL_lookupBankingScheme(const char *schemeName);
+extern void BL_setBankingScheme(const BankingSchemeDef *bankingScheme, int startAddr);
+extern const BankingSchemeDef *BL_getBankingScheme();
 extern void BL_done();
 extern void BL_printBanks();
 extern BankLayout *BL_getBankLayout();
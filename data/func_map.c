@@ -20,6 +20,8 @@
 #include <string.h>
 
 #include "func_map.h"
+#include "instr_list.h"
+#include "common/common.h"
 
 static FuncCallMapEntry *firstFuncCallEntry;
 static FuncCallMapEntry *curFuncCallEntry;
@@ -36,7 +38,14 @@ FuncCallMapEntry* FM_findFunction(char *funcName) {
 FuncCallMapEntry * FM_addNewFunc(char *srcName) {
     FuncCallMapEntry *newFuncCallEntry = allocMem(sizeof(FuncCallMapEntry));
     newFuncCallEntry->srcFuncName = srcName;
+    newFuncCallEntry->funcSym = NULL;
     newFuncCallEntry->deepestSpotCalled = -1;
+    newFuncCallEntry->clobbers.isKnown = false;
+    newFuncCallEntry->isRecursive = false;
+    newFuncCallEntry->isOnCallChain = false;
+    newFuncCallEntry->hasCallsInArgs = false;
+    newFuncCallEntry->hasAsmCode = false;
+    newFuncCallEntry->isTableTarget = false;
     newFuncCallEntry->cntFuncsCalled = 0;
     newFuncCallEntry->next = NULL;
 
@@ -81,19 +90,124 @@ void FM_addCallToMap(SymbolRecord *srcFuncSym, SymbolRecord *dstFuncSym) {
     }
 }
 
+/**
+ * Remove one call from the map  (when a call gets redirected to another function)
+ */
+void FM_removeCallFromMap(SymbolRecord *srcFuncSym, SymbolRecord *dstFuncSym) {
+    FuncCallMapEntry *funcCallMapEntry = FM_findFunction(srcFuncSym->name);
+    if (funcCallMapEntry == NULL) return;
+
+    for_range(idx, 0, funcCallMapEntry->cntFuncsCalled) {
+        if (strcmp(funcCallMapEntry->dstFuncName[idx], dstFuncSym->name) != 0) continue;
+
+        if (dstFuncSym->cntUses > 0) dstFuncSym->cntUses--;
+        if (--funcCallMapEntry->dstFuncCallCnt[idx] == 0) {
+
+            // no more calls to this function, so remove it from the list
+            int lastIdx = --funcCallMapEntry->cntFuncsCalled;
+            funcCallMapEntry->dstFuncName[idx] = funcCallMapEntry->dstFuncName[lastIdx];
+            funcCallMapEntry->dstFuncCallCnt[idx] = funcCallMapEntry->dstFuncCallCnt[lastIdx];
+        }
+        return;
+    }
+}
+
 void FM_addFunctionDef(SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcCallMapEntry = FM_findFunction(funcSym->name);
+    if (funcCallMapEntry == NULL) {
+        funcCallMapEntry = FM_addNewFunc(funcSym->name);
+    }
+
+    // the entry may have already been created when processing calls made by this function
+    funcCallMapEntry->funcSym = funcSym;
+}
+
+/**
+ * Mark that a call to this function has another function call in its arguments
+ *
+ *  (the argument's call could overwrite the callee's local frame while the arguments are being set up)
+ */
+void FM_markCallsInArgs(SymbolRecord *dstFuncSym) {
+    FuncCallMapEntry *funcCallMapEntry = FM_findFunction(dstFuncSym->name);
+    if (funcCallMapEntry == NULL) {
+        funcCallMapEntry = FM_addNewFunc(dstFuncSym->name);
+        funcCallMapEntry->funcSym = dstFuncSym;
+    }
+    funcCallMapEntry->hasCallsInArgs = true;
+}
+
+/**
+ * Mark that a function has inline assembly
+ */
+void FM_markAsmCode(SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcCallMapEntry = FM_findFunction(funcSym->name);
+    if (funcCallMapEntry == NULL) {
+        funcCallMapEntry = FM_addNewFunc(funcSym->name);
+        funcCallMapEntry->funcSym = funcSym;
+    }
+    funcCallMapEntry->hasAsmCode = true;
+}
+
+/**
+ * Mark that a function is called thru a function table
+ */
+void FM_markTableTarget(SymbolRecord *funcSym) {
     FuncCallMapEntry *funcCallMapEntry = FM_findFunction(funcSym->name);
     if (funcCallMapEntry == NULL) {
         funcCallMapEntry = FM_addNewFunc(funcSym->name);
         funcCallMapEntry->funcSym = funcSym;
     }
+    funcCallMapEntry->isTableTarget = true;
+}
+
+bool FM_isRecursive(const SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+    return (funcMapEntry != NULL) && funcMapEntry->isRecursive;
+}
+
+bool FM_hasCallsInArgs(const SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+    return (funcMapEntry != NULL) && funcMapEntry->hasCallsInArgs;
+}
+
+bool FM_hasAsmCode(const SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+    return (funcMapEntry != NULL) && funcMapEntry->hasAsmCode;
+}
+
+bool FM_isTableTarget(const SymbolRecord *funcSym) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+    return (funcMapEntry != NULL) && funcMapEntry->isTableTarget;
 }
 
 //=====================================================================
 
+#define MAX_CALL_CHAIN 64
+
 int deepestDepth = 0;
+static FuncCallMapEntry *callChain[MAX_CALL_CHAIN];
+static int callChainLen = 0;
+
+/**
+ * Mark all the functions in a call cycle as recursive
+ *  (the cycle runs from the re-entered function to the end of the current chain)
+ */
+void FM_markRecursiveChain(FuncCallMapEntry *reenteredEntry) {
+    for (int chainIdx = callChainLen-1; chainIdx >= 0; chainIdx--) {
+        callChain[chainIdx]->isRecursive = true;
+        if (callChain[chainIdx] == reenteredEntry) break;
+    }
+}
+
 void FM_followChainsToCalculateDepth(FuncCallMapEntry *funcMapEntry, int depth) {
 
+    // stop at recursive calls, otherwise we'd never get out of here
+    if (funcMapEntry->isOnCallChain) {
+        FM_markRecursiveChain(funcMapEntry);
+        return;
+    }
+    if (callChainLen >= MAX_CALL_CHAIN) return;
+
     // mark the depth of the current function (only if it's deeper than before
     int newDepth = depth-1;
 
@@ -105,6 +219,9 @@ void FM_followChainsToCalculateDepth(FuncCallMapEntry *funcMapEntry, int depth)
         }
     }
 
+    funcMapEntry->isOnCallChain = true;
+    callChain[callChainLen++] = funcMapEntry;
+
     int cntDestFunc = 0;
     while (cntDestFunc<funcMapEntry->cntFuncsCalled) {
         if (depth > deepestDepth) deepestDepth = depth;
@@ -116,6 +233,9 @@ void FM_followChainsToCalculateDepth(FuncCallMapEntry *funcMapEntry, int depth)
         }
         cntDestFunc++;
     }
+
+    callChainLen--;
+    funcMapEntry->isOnCallChain = false;
 }
 
 int FM_calculateCallTree() {
@@ -127,6 +247,234 @@ int FM_calculateCallTree() {
     return deepestDepth;
 }
 
+//--------------------------------------------------------------------------
+//  Clobber summaries
+//
+//    After a function's code has been generated (and optimized), its
+//    instructions are scanned to find which registers and memory it may
+//    modify.  Calls to functions that have already been summarized just
+//    merge in the callee's summary, which builds the summaries bottom-up
+//    over the call graph, since callees are typically defined before
+//    their callers.  Anything that can't be resolved is assumed to clobber
+//    everything.
+
+static void markClobberAll(ClobberSummary *clobbers) {
+    clobbers->regs = CLOBBER_ALL;
+    clobbers->writesOtherMem = true;
+    memset(clobbers->zeropage, 0xFF, sizeof(clobbers->zeropage));
+}
+
+static void markClobberAddr(ClobberSummary *clobbers, int addr) {
+    if ((addr >= 0) && (addr < 0x100)) {
+        clobbers->zeropage[addr >> 3] |= (1 << (addr & 7));
+    } else {
+        clobbers->writesOtherMem = true;
+    }
+}
+
+static void mergeClobbers(ClobberSummary *clobbers, const ClobberSummary *calleeClobbers) {
+    clobbers->regs |= calleeClobbers->regs;
+    clobbers->writesOtherMem |= calleeClobbers->writesOtherMem;
+    for_range(index, 0, (int)sizeof(clobbers->zeropage)) {
+        clobbers->zeropage[index] |= calleeClobbers->zeropage[index];
+    }
+}
+
+/**
+ * Resolve an instruction parameter into an address  (like the binary writer does)
+ *
+ * @return address, or -1 if it can't be resolved yet
+ */
+static int resolveParamAddr(const char *param, SymbolTable *localSymTbl, SymbolTable *mainSymTbl) {
+    SymbolRecord *paramSym = NULL;
+    if (localSymTbl != NULL) {
+        paramSym = findSymbol(localSymTbl, param);
+        if ((paramSym == NULL) && (param[0] == '.')) paramSym = findSymbol(localSymTbl, param + 1);
+    }
+    if (paramSym == NULL) paramSym = findSymbol(mainSymTbl, param);
+
+    if (paramSym != NULL) {
+        if (HAS_SYMBOL_LOCATION(paramSym)) return paramSym->location;
+        if (paramSym->hasValue) return paramSym->constValue;
+        return -1;
+    }
+
+    // only plain numbers are left
+    const char *numStr = (param[0] == '-') ? param + 1 : param;
+    bool isNumber = (numStr[0] == '$') || (numStr[0] == '%') || ((numStr[0] >= '0') && (numStr[0] <= '9'));
+    return isNumber ? strToInt(param) : -1;
+}
+
+static int resolveInstrAddr(const Instr *instr, SymbolTable *localSymTbl, SymbolTable *mainSymTbl) {
+    if (NOT_INSTR_USES_VAR(instr)) return instr->offset;
+
+    // lo/hi bytes of an address are not addresses themselves
+    if ((instr->paramExt & (PARAM_LO | PARAM_HI)) != 0) return -1;
+
+    int addr = resolveParamAddr(instr->paramName, localSymTbl, mainSymTbl);
+    if ((addr >= 0) && (instr->paramExt & PARAM_ADD)) {
+        int secondValue = resolveParamAddr(instr->param2, localSymTbl, mainSymTbl);
+        addr = (secondValue >= 0) ? addr + secondValue : -1;
+    }
+    if ((addr >= 0) && (instr->paramExt & PARAM_PLUS_ONE)) addr++;
+    return addr;
+}
+
+static void markClobberMemWrite(ClobberSummary *clobbers, const Instr *instr,
+                                SymbolTable *localSymTbl, SymbolTable *mainSymTbl) {
+    int addr = resolveInstrAddr(instr, localSymTbl, mainSymTbl);
+    if (addr < 0) {
+        markClobberAll(clobbers);
+        return;
+    }
+
+    switch (instr->addrMode) {
+        case ADDR_ZP:
+        case ADDR_ABS:
+        case ADDR_UNK_M:
+            markClobberAddr(clobbers, addr);
+            break;
+        case ADDR_ABX:
+        case ADDR_ABY:
+        case ADDR_UNK_MX:
+        case ADDR_UNK_MY:
+            // indexing from an address above the zeropage can't reach back into it
+            clobbers->writesOtherMem = true;
+            if (addr < 0x100) memset(clobbers->zeropage, 0xFF, sizeof(clobbers->zeropage));
+            break;
+        case ADDR_ZPX:
+        case ADDR_ZPY:
+            memset(clobbers->zeropage, 0xFF, sizeof(clobbers->zeropage));
+            break;
+        default:
+            markClobberAll(clobbers);
+            break;
+    }
+}
+
+static bool isLabelInBlock(const InstrBlock *instrBlock, const char *labelName) {
+    Label *label = findLabel(labelName);
+    if (label == NULL) return false;
+
+    // labels at the same spot get linked to the one attached to the instruction
+    while (label->link != NULL) label = label->link;
+
+    for (Instr *instr = instrBlock->firstInstr; instr != NULL; instr = instr->nextInstr) {
+        if (instr->label == label) return true;
+    }
+    return false;
+}
+
+/**
+ * Add in what's clobbered by a JSR/JMP to another function (or a label in this one)
+ */
+static void markClobberCall(ClobberSummary *clobbers, const Instr *instr, const SymbolRecord *funcSym) {
+    if ((instr->addrMode != ADDR_ABS) || NOT_INSTR_USES_VAR(instr)) {
+        markClobberAll(clobbers);
+        return;
+    }
+
+    // recursion or jumps within the function are already covered by this scan
+    if ((strcmp(instr->paramName, funcSym->name) == 0) || isLabelInBlock(funcSym->instrBlock, instr->paramName)) return;
+
+    const ClobberSummary *calleeClobbers = FM_getClobberSummary(instr->paramName);
+    if (calleeClobbers != NULL) {
+        mergeClobbers(clobbers, calleeClobbers);
+    } else {
+        markClobberAll(clobbers);
+    }
+}
+
+/**
+ * Calculate the clobber summary for a function whose code has been generated
+ *
+ * @param funcSym - function symbol (with its instruction block)
+ * @param mainSymTbl - main symbol table (to look up global vars)
+ */
+void FM_calcClobberSummary(SymbolRecord *funcSym, SymbolTable *mainSymTbl) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction(funcSym->name);
+    if ((funcMapEntry == NULL) || (funcSym->instrBlock == NULL)) return;
+
+    ClobberSummary clobbers;
+    memset(&clobbers, 0, sizeof(clobbers));
+    SymbolTable *localSymTbl = GET_LOCAL_SYMBOL_TABLE(funcSym);
+
+    for (Instr *instr = funcSym->instrBlock->firstInstr; instr != NULL; instr = instr->nextInstr) {
+        switch (instr->mne) {
+            case LDA: case TXA: case TYA: case PLA:
+            case ADC: case SBC: case AND: case ORA: case EOR:
+                clobbers.regs |= CLOBBER_A;
+                break;
+            case LDX: case TAX: case TSX: case INX: case DEX: case SBX:
+                clobbers.regs |= CLOBBER_X;
+                break;
+            case LDY: case TAY: case INY: case DEY:
+                clobbers.regs |= CLOBBER_Y;
+                break;
+            case LAX:
+                clobbers.regs |= CLOBBER_A | CLOBBER_X;
+                break;
+
+            case ASL: case LSR: case ROL: case ROR:
+                if ((instr->addrMode == ADDR_ACC) || (instr->addrMode == ADDR_NONE)) {
+                    clobbers.regs |= CLOBBER_A;
+                } else {
+                    markClobberMemWrite(&clobbers, instr, localSymTbl, mainSymTbl);
+                }
+                break;
+            case STA: case STX: case STY: case SAX:
+            case INC: case DEC: case DCP:
+                markClobberMemWrite(&clobbers, instr, localSymTbl, mainSymTbl);
+                break;
+            case ISB:
+                clobbers.regs |= CLOBBER_A;
+                markClobberMemWrite(&clobbers, instr, localSymTbl, mainSymTbl);
+                break;
+
+            case JSR:
+            case JMP:
+                markClobberCall(&clobbers, instr, funcSym);
+                break;
+            case BRK: case RTI:
+                markClobberAll(&clobbers);
+                break;
+            default:
+                break;
+        }
+    }
+
+    clobbers.isKnown = true;
+    funcMapEntry->clobbers = clobbers;
+}
+
+/**
+ * Get the clobber summary of a function
+ *
+ * @return summary, or NULL if the function hasn't been summarized (yet)
+ */
+const ClobberSummary *FM_getClobberSummary(const char *funcName) {
+    FuncCallMapEntry *funcMapEntry = FM_findFunction((char *)funcName);
+    if ((funcMapEntry == NULL) || !funcMapEntry->clobbers.isKnown) return NULL;
+    return &funcMapEntry->clobbers;
+}
+
+/**
+ * Could a variable be modified by a call with this clobber summary?
+ */
+bool FM_isVarClobbered(const ClobberSummary *clobbers, const SymbolRecord *varSym) {
+    if (!HAS_SYMBOL_LOCATION(varSym) || IS_STACK_VAR(varSym)) return true;
+
+    // check both bytes, in case it's an int
+    for_range(addr, varSym->location, varSym->location + 2) {
+        if (addr >= 0x100) {
+            if (clobbers->writesOtherMem) return true;
+        } else if (clobbers->zeropage[addr >> 3] & (1 << (addr & 7))) {
+            return true;
+        }
+    }
+    return false;
+}
+
 //--------------------------------------------------------------------------
 //  Functions for displaying information about the Function Map / Call Tree
 
@@ -28,6 +28,26 @@
 
 enum { MAX_DIFFERENT_FUNCS_CALLED = 32 };
 
+//--- Registers a function (or anything it calls) may modify
+enum ClobberRegs {
+    CLOBBER_NONE = 0x00,
+    CLOBBER_A    = 0x01,
+    CLOBBER_X    = 0x02,
+    CLOBBER_Y    = 0x04,
+    CLOBBER_ALL  = 0x07
+};
+
+/**
+ * Summary of what a function may modify, so callers can keep
+ *   track of registers across calls.
+ */
+typedef struct {
+    bool isKnown;                       // only set once the function's code has been generated
+    unsigned char regs;                 // ClobberRegs
+    bool writesOtherMem;                // writes outside the zeropage (or to an unknown address)
+    unsigned char zeropage[32];         // bitmap of zeropage cells that may be written
+} ClobberSummary;
+
 struct FuncCallMapEntryStruct;
 
 typedef struct FuncCallMapEntryStruct {
@@ -39,6 +59,14 @@ typedef struct FuncCallMapEntryStruct {
     int deepestSpotCalled;                              // how deep in the stack will this function ever be called?
     char *dstFuncName[MAX_DIFFERENT_FUNCS_CALLED];      // list of destinations (functions this function calls)
     int dstFuncCallCnt[MAX_DIFFERENT_FUNCS_CALLED];     // for each destination, provide the number of time it's called
+
+    ClobberSummary clobbers;                            // what this function (and its callees) may modify
+
+    bool isRecursive;                                   // function is part of a call cycle
+    bool isOnCallChain;                                 // (used while walking the call tree)
+    bool hasCallsInArgs;                                // some call to this function has a function call in its arguments
+    bool hasAsmCode;                                    // function has inline assembly  (so its return value stays in A)
+    bool isTableTarget;                                 // function is called thru a function table  (so it uses the normal convention)
 } FuncCallMapEntry;
 
 
@@ -47,5 +75,17 @@ extern void FM_addCallToMap(SymbolRecord *srcFuncSym, SymbolRecord *dstFuncSym);
 extern void FM_displayCallTree();
 extern void FM_addFunctionDef(SymbolRecord *funcSym);
 extern int FM_calculateCallTree();
+extern void FM_removeCallFromMap(SymbolRecord *srcFuncSym, SymbolRecord *dstFuncSym);
+extern void FM_markCallsInArgs(SymbolRecord *dstFuncSym);
+extern bool FM_isRecursive(const SymbolRecord *funcSym);
+extern bool FM_hasCallsInArgs(const SymbolRecord *funcSym);
+extern void FM_markAsmCode(SymbolRecord *funcSym);
+extern bool FM_hasAsmCode(const SymbolRecord *funcSym);
+extern void FM_markTableTarget(SymbolRecord *funcSym);
+extern bool FM_isTableTarget(const SymbolRecord *funcSym);
+
+extern void FM_calcClobberSummary(SymbolRecord *funcSym, SymbolTable *mainSymTbl);
+extern const ClobberSummary *FM_getClobberSummary(const char *funcName);
+extern bool FM_isVarClobbered(const ClobberSummary *clobbers, const SymbolRecord *varSym);
 
 #endif //MODULE_FUNC_MAP_H
@@ -17,6 +17,7 @@
 //
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "instr_list.h"
 
@@ -57,6 +58,7 @@ static char* curLineComment;
 InstrBlock* IB_StartInstructionBlock(char *name) {
     InstrBlock *newBlock = allocMem(sizeof(struct InstrBlockStruct));
     newBlock->codeSize = 0;
+    newBlock->tailMergeSavings = 0;
     newBlock->blockName = name;
     newBlock->firstInstr = NULL;
     newBlock->curInstr = NULL;
@@ -89,6 +91,36 @@ void IB_AddInstr(InstrBlock *curBlock, Instr *newInstr) {
 }
 
 
+/**
+ * Move a range of instructions to the end of a block
+ *
+ *   NOTE:  firstInstr and lastInstr need to be from the same code block!
+ *
+ * @param instrBlock
+ * @param firstInstr - first instruction to move
+ * @param lastInstr - last instruction to move
+ */
+void IB_MoveToEnd(InstrBlock *instrBlock, Instr *firstInstr, Instr *lastInstr) {
+    if (instrBlock->lastInstr == lastInstr) return;
+
+    // unlink the range
+    Instr *prevInstr = firstInstr->prevInstr;
+    Instr *nextInstr = lastInstr->nextInstr;
+    if (prevInstr != NULL) {
+        prevInstr->nextInstr = nextInstr;
+    } else {
+        instrBlock->firstInstr = nextInstr;
+    }
+    nextInstr->prevInstr = prevInstr;
+
+    // ...and add it after the last instruction
+    instrBlock->lastInstr->nextInstr = firstInstr;
+    firstInstr->prevInstr = instrBlock->lastInstr;
+    lastInstr->nextInstr = NULL;
+    instrBlock->lastInstr = lastInstr;
+    instrBlock->curInstr = lastInstr;
+}
+
 void IB_Walk(InstrBlock *instrBlock) {
     if (instrBlock == NULL) return;
     Instr *curOutInstr = instrBlock->firstInstr;
@@ -116,6 +148,7 @@ void IB_CloseBlock() {
 
 Instr* startNewInstruction(enum MnemonicCode mne, enum AddrModes addrMode) {
     Instr *newInstr = INSTR_allocMem(sizeof(struct InstrStruct));
+    memset(newInstr, 0, sizeof(struct InstrStruct));     // single byte ops don't set a param
     newInstr->mne = mne;
     newInstr->addrMode = addrMode;
     newInstr->showCycles = showCycles;
@@ -270,6 +303,21 @@ int IL_GetCodeSizeOfRange(Instr *startInstr, Instr *endInstr) {
     return size;
 }
 
+/**
+ * Add a JMP to the end of a block  (the block doesn't need to be the current one)
+ * @param instrBlock
+ * @param labelName - where to jump to
+ * @return pointer to new instruction node
+ */
+Instr* IB_AddJump(InstrBlock *instrBlock, const char *labelName) {
+    Instr *newInstr = startNewInstruction(JMP, ADDR_ABS);
+    newInstr->paramName = labelName;
+    newInstr->paramExt = PARAM_NORMAL;
+    newInstr->param2 = NULL;
+    IB_AddInstr(instrBlock, newInstr);
+    return newInstr;
+}
+
 void IL_ShowCycles() {
     showCycles = true;
 }
@@ -308,6 +356,7 @@ void IL_FixLongBranch(Instr *startInstr, Instr *endInstr) {
                 case BNE: curInstr->mne = BEQ; break;
                 case BPL: curInstr->mne = BMI; break;
                 case BMI: curInstr->mne = BPL; break;
+                default: break;
             }
             curInstr->paramName = NULL;
             curInstr->param2 = NULL;
@@ -51,6 +51,7 @@ typedef struct InstrStruct {
 
 typedef struct InstrBlockStruct {
     int codeSize;                       // size of code
+    int tailMergeSavings;               // bytes saved by merging identical code
     char *blockName;
     struct SymbolRecordStruct *funcSym;              // if part of a function (for outputting local/param vars)
     struct InstrStruct *firstInstr;
@@ -68,6 +69,8 @@ extern InstrBlock* IB_StartInstructionBlock(char *name);
 extern void IB_AddInstr(InstrBlock *curBlock, Instr *newInstr);
 extern InstrBlock* IB_GetCurrentBlock();
 extern void IB_CloseBlock();
+extern void IB_MoveToEnd(InstrBlock *instrBlock, Instr *firstInstr, Instr *lastInstr);
+extern Instr* IB_AddJump(InstrBlock *instrBlock, const char *labelName);
 
 //----------------------------------------------
 //  Interface for Instruction List metadata
@@ -53,6 +53,7 @@ Label * newGenericLabel(enum LabelType type) {
     label->hasBeenReferenced = false;
     label->hasLocation = false;
     label->location = 0;
+    label->loopBound = -1;
     addToLabelList(label);
     return label;
 }
@@ -65,6 +66,7 @@ Label * newLabel(char* name, enum LabelType type) {
     label->hasBeenReferenced = false;
     label->hasLocation = false;
     label->location = 0;
+    label->loopBound = -1;
     addToLabelList(label);
     return label;
 }
@@ -76,6 +78,27 @@ Label * newLabel(char* name, enum LabelType type) {
  */
 void linkToLabel(Label *srcLabel, Label *linkedLabel) {
     srcLabel->link = linkedLabel;
+    mergeLoopBound(linkedLabel, srcLabel);
+}
+
+/**
+ * Carry the loop info of a label over to the label replacing it
+ *   (when both start a loop, the loops are nested)
+ *
+ * @param label - label that will be kept
+ * @param mergedLabel - label going away
+ */
+void mergeLoopBound(Label *label, const Label *mergedLabel) {
+    if (mergedLabel->type != LBL_LOOP_START) return;
+
+    if (label->type != LBL_LOOP_START) {
+        label->type = LBL_LOOP_START;
+        label->loopBound = mergedLabel->loopBound;
+    } else if ((label->loopBound >= 0) && (mergedLabel->loopBound >= 0)) {
+        label->loopBound = (label->loopBound + 1) * (mergedLabel->loopBound + 1) - 1;
+    } else {
+        label->loopBound = -1;
+    }
 }
 
 /**
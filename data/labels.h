@@ -31,6 +31,7 @@ typedef struct LabelStruct {
     bool hasBeenReferenced;
     bool hasLocation;
     int location;
+    int loopBound;          // most times a loop jumps back to this label (-1 if not known)
     struct LabelStruct *link;
     struct LabelStruct *next;
 } Label;
@@ -38,6 +39,7 @@ typedef struct LabelStruct {
 extern Label * newGenericLabel(enum LabelType type);
 extern Label * newLabel(char* name, enum LabelType type);
 extern void linkToLabel(Label *srcLabel, Label *linkedLabel);
+extern void mergeLoopBound(Label *label, const Label *mergedLabel);
 extern void addLabelRef(Label *label);
 extern Label * findLabel(const char *name);
 extern void printLabelList();
@@ -76,6 +76,7 @@ struct SymbolTypeList {
         {"word",    ST_INT,     ST_UNSIGNED},
         {"bool",    ST_BOOL,    0},
         {"boolean", ST_BOOL,    0},
+        {"function",ST_FUNC,    0},
 };
 
 const int NUM_DATA_TYPES = sizeof(SymbolTypes) / sizeof(struct SymbolTypeList);
@@ -217,6 +218,33 @@ int getBaseVarSize(const SymbolRecord *varSymRec) {
     return (isPointer || isInt) ? 2 : 1;
 }
 
+//--- Layout of arrays of structs
+//
+//   Normally each struct is stored one after another.  Split arrays store
+//   each byte of the struct in its own array instead, so byte k of element i
+//   is found at (k * numElements) + i, and the index never needs multiplying.
+
+/**
+ * Get the amount to multiply an index by to get to an element in an array of structs
+ */
+int getArrayIndexStride(const SymbolRecord *arraySym) {
+    return IS_SPLIT_ARRAY(arraySym) ? 1 : getBaseVarSize(arraySym);
+}
+
+/**
+ * Get the offset of a struct property for the first element in an array of structs
+ */
+int getArrayPropertyOffset(const SymbolRecord *arraySym, int propertyOfs) {
+    return IS_SPLIT_ARRAY(arraySym) ? (propertyOfs * arraySym->numElements) : propertyOfs;
+}
+
+/**
+ * Get the distance between the low and high bytes of a word within an array element
+ */
+int getArrayByteStride(const SymbolRecord *arraySym) {
+    return IS_SPLIT_ARRAY(arraySym) ? arraySym->numElements : 1;
+}
+
 int getCodeSize(const SymbolRecord *funcSymRec) {
     bool isFunc = isFunction(funcSymRec);
     bool isCodeUsed = IS_FUNC_USED(funcSymRec);
@@ -267,7 +295,7 @@ SymbolList *getParamSymbols(SymbolTable *symTblWithParams) {
 
     SymbolRecord *firstSymbol = symTblWithParams->firstSymbol;
     while (firstSymbol != NULL) {
-        if (IS_PARAM_VAR(firstSymbol)) {
+        if (IS_PARAM_VAR(firstSymbol) || IS_FRAME_PARAM(firstSymbol)) {
             paramList->list[paramList->count] = firstSymbol;
             paramList->count++;
 
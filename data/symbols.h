@@ -34,14 +34,19 @@
 
 #define IS_STACK_VAR(sym) (((sym)->flags & SS_STORAGE_MASK) == SS_STACK)
 #define IS_PARAM_VAR(sym) ((sym)->flags & MF_PARAM)
+#define IS_FRAME_PARAM(sym) (((sym)->flags & MF_FRAME_PARAM) != 0)
 
 #define HAS_SYMBOL_LOCATION(sym)  ((sym)->location >= 0)
+#define IS_SPLIT_ARRAY(sym)       (((sym)->flags & MF_SPLIT_ARRAY) != 0)
+#define IS_PACKED_BOOL(sym)       (((sym)->flags & MF_PACKED_BOOL) != 0)
+#define IS_FUNC_TABLE(sym)        (((sym)->flags & ST_MASK) == ST_FUNC)
 
 //--- macros for function symbols
 #define GET_LOCAL_SYMBOL_TABLE(funcSym) ((funcSym)->symbolTbl)
 #define GET_FUNCTION_DEPTH(funcSym)     ((funcSym)->funcDepth)
 #define IS_FUNC_USED(funcSym)           ((funcSym)->cntUses > 0)
 #define IS_INLINED_FUNCTION(funcSym)    ((funcSym)->flags & MF_INLINE)
+#define IS_CARRY_RETURN(funcSym)        (((funcSym)->flags & MF_CARRY_RETURN) != 0)
 
 #define GET_STRUCT_SYMBOL_TABLE(structSym)  ((structSym)->symbolTbl)
 #define getStructSymbolSet(sym)             GET_STRUCT_SYMBOL_TABLE((sym)->userTypeDef)
@@ -60,6 +65,8 @@ enum SymbolType {           //-- base type of variable
 
     ST_PTR = 0x05,        //-- pointer (used in code generator)
 
+    ST_FUNC = 0x06,       //-- function address  (only used for const function tables)
+
     ST_MASK = 0x07,
 
     ST_UNSIGNED = 0x00,     //-- default
@@ -99,13 +106,18 @@ enum ModifierFlags {
     MF_LOCAL        = 0x0200,
 
     MF_HINT         = 0x0400,
+    MF_SPLIT_ARRAY  = 0x0800,     // array of structs stored as one array per struct byte
 
     MF_ENUM_VALUE   = 0x1000,     // only used in enumeration definitions (TODO: is this necessary?)
     MF_INLINE       = 0x2000,       // only applies to functions
 
     // these are the two important flags, so I put them at the very top of the bitspace
     MF_ARRAY        = 0x4000,
-    MF_POINTER      = 0x8000
+    MF_POINTER      = 0x8000,
+
+    MF_FRAME_PARAM  = 0x10000,    // param passed in the function's local frame (instead of the stack)
+    MF_PACKED_BOOL  = 0x20000,    // bool stored as a single bit  (sharing a byte with other packed bools)
+    MF_CARRY_RETURN = 0x40000     // (function) bool result is returned in the carry flag
 };
 
 enum VarHint {
@@ -142,6 +154,13 @@ typedef struct SymbolRecordStruct {     // 112 bytes!
 
     // used by SK_VAR - function params
     enum VarHint hint;                  // Hint for Function Param Symbol
+    int cntIndexUses;                   // number of times the param is used as an array index
+
+    // used by SK_VAR - global vars
+    int cntAccesses;                    // number of places in the code the variable is used
+    int accessWeight;                   // accesses weighted by loop nesting and call depth
+    struct SymbolRecordStruct *packedByte;  // byte holding a packed bool
+    int bitMask;                            // bit of the byte used by a packed bool
 
     // used by SK_FUNC
     int cntUses;                            // number of times function is used
@@ -183,6 +202,7 @@ extern enum SymbolType getSymbolType(const char *baseType);
 extern SymbolRecord * addConst(SymbolTable *symbolTable, char *name, int value, enum SymbolType type, enum ModifierFlags flags);
 
 extern SymbolTable *initSymbolTable(char *name, SymbolTable *parentTable);
+extern SymbolRecord * newSymbol(char *tname, enum SymbolKind kind, enum SymbolType type, unsigned int flags);
 extern SymbolRecord * addSymbol(SymbolTable *, char *name, enum SymbolKind kind, enum SymbolType type, unsigned int flags);
 
 extern void setSymbolLocation(SymbolRecord *symbolRecord, int location, enum ModifierFlags storageType);
@@ -193,6 +213,9 @@ extern void markFunctionUsed(SymbolRecord *funcSymbol);
 extern int calcVarSize(const SymbolRecord *varSymRec);
 extern int calcCodeSize(const SymbolRecord *varSymRec);
 extern int getBaseVarSize(const SymbolRecord *varSymRec);
+extern int getArrayIndexStride(const SymbolRecord *arraySym);
+extern int getArrayPropertyOffset(const SymbolRecord *arraySym, int propertyOfs);
+extern int getArrayByteStride(const SymbolRecord *arraySym);
 extern SymbolRecord * findSymbol(SymbolTable *symbolTable, const char *name);
 extern char getDestRegFromHint(enum VarHint hint);
 extern SymbolList *getParamSymbols(SymbolTable *symTblWithParams);
@@ -48,6 +48,7 @@ void prepForMachine(enum Machines machine) {
         case Atari2600:
             SMA_init(0);        // only has zeropage memory
             zeropageMem = SMA_addMemoryRange(0x80, 0xFF);
+            SMA_setStackArea(0x180, true);  // stack is a mirror of zeropage
             break;
 
         case Atari5200:
@@ -58,6 +59,7 @@ void prepForMachine(enum Machines machine) {
             SMA_init(1);
             zeropageMem = SMA_addMemoryRange(0x20, 0xFF);       // 0x20 to start after system usage
             SMA_addMemoryRange(0x0300, 0x3fff);                 // 0x300 to start after system usage
+            SMA_setStackArea(0x100, false);
             break;
 
         case Atari7800:
@@ -71,6 +73,7 @@ void prepForMachine(enum Machines machine) {
             zeropageMem = SMA_addMemoryRange(0x40, 0xFF);
             SMA_addMemoryRange(0x1800, 0x1FFF);
             SMA_addMemoryRange(0x2200, 0x27FF);
+            SMA_setStackArea(0x140, false);
             break;
         default:
             printf("Unknown machine!\n");
@@ -30,6 +30,8 @@
 static MemoryArea memoryAreas[16];
 static int cntMemoryAreas;
 static int firstMemAllocArea;       // memory allocation area to use first
+static int stackLowAddr;            // lowest address the stack can grow down to
+static bool isStackInZeropage;      // stack shares memory with zeropage variables
 
 //--------------------------------------------------------------------------------------
 
@@ -42,6 +44,14 @@ MemoryArea *SMA_getZeropageArea() {
     return &memoryAreas[0];
 }
 
+/**
+ * Get a memory area by index  (in the order they were added)
+ * @return NULL when there isn't one
+ */
+MemoryArea *SMA_getMemoryArea(int index) {
+    return (index < cntMemoryAreas) ? &memoryAreas[index] : NULL;
+}
+
 MemoryArea *SMA_addMemoryRange(int start, int end) {
     // TODO: Maybe do this a different way?
     //       Might not matter since this compiler is currently 6502 specific.
@@ -99,4 +109,43 @@ MemoryAllocation SMA_allocateMemory(MemoryArea *specificMemArea, int size) {
     resultMemAlloc.memoryArea = NULL;
     resultMemAlloc.addr = -1;
     return resultMemAlloc;
-}
\ No newline at end of file
+}
+
+int SMA_getFreeSpace(const MemoryArea *memArea) {
+    return memArea->endAddr - memArea->curOffset + 1;
+}
+
+/**
+ * Are variables placed in zeropage by default?
+ *   (when the machine has no other RAM, or zeropage is the first choice)
+ */
+bool SMA_usesZeropageFirst() {
+    return (firstMemAllocArea == 0) || (cntMemoryAreas < 2);
+}
+
+/**
+ * Set where the stack can go  (it always grows down from $1FF)
+ *
+ * @param lowAddr - lowest address the stack can use
+ * @param sharesZeropage - page 1 is a mirror of zeropage  (Atari 2600)
+ */
+void SMA_setStackArea(int lowAddr, bool sharesZeropage) {
+    stackLowAddr = lowAddr;
+    isStackInZeropage = sharesZeropage;
+}
+
+/**
+ * Get the number of bytes the stack can use
+ *   (when it shares zeropage, it gets whatever the variables didn't use)
+ */
+int SMA_getStackSpace() {
+    if (isStackInZeropage) return SMA_getFreeSpace(SMA_getZeropageArea());
+    return 0x200 - stackLowAddr;
+}
+
+/**
+ * Get the address just above the top of the stack  (as the program sees it)
+ */
+int SMA_getStackTop() {
+    return isStackInZeropage ? 0x100 : 0x200;
+}
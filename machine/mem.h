@@ -19,6 +19,8 @@
 #ifndef MODULE_MEM_H
 #define MODULE_MEM_H
 
+#include <stdbool.h>
+
 typedef struct MemoryAreaSt {
     int startAddr;
     int endAddr;
@@ -36,7 +38,13 @@ typedef struct {
 
 extern void SMA_init(int startArea);
 extern MemoryArea *SMA_getZeropageArea();
+extern MemoryArea *SMA_getMemoryArea(int index);
 extern MemoryArea *SMA_addMemoryRange (int start, int end);
 extern MemoryAllocation SMA_allocateMemory(MemoryArea *specificMemArea, int size);
+extern int SMA_getFreeSpace(const MemoryArea *memArea);
+extern bool SMA_usesZeropageFirst();
+extern void SMA_setStackArea(int lowAddr, bool sharesZeropage);
+extern int SMA_getStackSpace();
+extern int SMA_getStackTop();
 
 #endif //MODULE_MEM_H
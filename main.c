@@ -45,6 +45,11 @@
 #include "codegen/gen_code.h"
 #include "cpu_arch/instrs.h"
 #include "output/output_manager.h"
+#include "output/bank_placement.h"
+#include "output/code_outline.h"
+#include "output/cycle_timing.h"
+#include "output/data_merge.h"
+#include "output/stack_depth.h"
 #include "output/write_output.h"
 #include "optimizer/optimizer.h"
 
@@ -306,11 +311,38 @@ int mainCompiler() {
 
     check_for_entry_point();
 
-    //----- IF Compiled successfully, THEN do post-processing and output.
+    //----- Move repeated code into subroutines (when optimizing for size)
+    if ((GC_ErrorCount == 0) && compilerOptions.optimizeForSize && !OB_UsesBankPlacement()) {
+        CO_OutlineCode(mainSymbolTable);
+    }
+
+    //----- Share space between constant tables
+    if ((GC_ErrorCount == 0) && compilerOptions.runOptimizer) {
+        DM_MergeData();
+    }
+
+    //----- Size mode waits until everything has shrunk before checking that it fits
+    if ((GC_ErrorCount == 0) && compilerOptions.optimizeForSize) {
+        OB_CheckBlocksFit();
+    }
+
+    //----- Place code/data into banks (if using bank-switching)
+    if ((GC_ErrorCount == 0) && OB_UsesBankPlacement()) {
+        BP_PlaceBlocks(mainSymbolTable);
+    }
+
+    //----- Make sure the stack won't run into the variables
     if (GC_ErrorCount == 0) {
-        //OB_BuildInitialLayout();
-        //OB_ArrangeBlocks();
+        SD_CheckStackDepth();
+    }
 
+    //----- Check worst case timing of functions with a cycle budget
+    if (GC_ErrorCount == 0) {
+        CT_CheckCycleBudgets();
+    }
+
+    //----- IF Compiled successfully, THEN do post-processing and output.
+    if (GC_ErrorCount == 0) {
         if (compilerOptions.showOutputBlockList) {
             printf("\nOutput layout:\n");
             OB_PrintBlockList();
@@ -381,6 +413,10 @@ void setDefaultCompilerParameters() {
 
     compilerOptions.runOptimizer = false;
     compilerOptions.showOptimizerSteps = false;
+    compilerOptions.optimizeForSize = false;
+    compilerOptions.returnBoolInCarry = false;
+    compilerOptions.useUndocumentedOpcodes = false;
+    compilerOptions.timingFuncName = NULL;
 }
 
 /**
@@ -424,10 +460,14 @@ const char *help[] = {
         "  -o  Run Optimizer on generated machine code",
         "        -o   Run optimizer without logging",
         "        -ov  Show log of optimizations",
+        "        -os  Optimize for size (moves repeated code into subroutines)",
+        "        -oc  Return bools in carry from all functions (not just leaf functions)",
+        "        -ou  Use undocumented opcodes (LAX, SAX, DCP, SBX, ISB)",
         "  -v  View details about:",
         "        -va  Show variable allocations",
         "        -vc  Show call tree",
-        "        -vl  Show output block layout"
+        "        -vl  Show output block layout  (and bank placement)",
+        "        -vt<func>  Show worst case cycle timing of a function"
 };
 
 void showCmdParamHelp() {
@@ -484,6 +524,12 @@ void parseCommandLineParameters(int argc, char *argv[]) {
             case 'o':
                 if (cmdParam[2] == 'v') {
                     compilerOptions.showOptimizerSteps = true;
+                } else if (cmdParam[2] == 's') {
+                    compilerOptions.optimizeForSize = true;
+                } else if (cmdParam[2] == 'c') {
+                    compilerOptions.returnBoolInCarry = true;
+                } else if (cmdParam[2] == 'u') {
+                    compilerOptions.useUndocumentedOpcodes = true;
                 }
                 compilerOptions.runOptimizer = true;
                 break;
@@ -502,6 +548,7 @@ void parseCommandLineParameters(int argc, char *argv[]) {
                     case 'c': compilerOptions.showCallTree = true; break;
                     case 'r': compilerOptions.reportFunctionProcessing = true; break;
                     case 'l': compilerOptions.showOutputBlockList = true; break;
+                    case 't': compilerOptions.timingFuncName = newSubstring(cmdParam, 3, 3); break;
                     default:
                         printf("Unknown view option\n");
                         break;
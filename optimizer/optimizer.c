@@ -18,11 +18,13 @@
 // Created by admin on 6/22/2020.
 //
 
+#include <stdlib.h>
 #include <string.h>
 #include "data/labels.h"
 #include "optimizer.h"
 #include "data/instr_list.h"
 #include "output/output_block.h"
+#include "cpu_arch/instrs_dispatch.h"
 
 typedef void (*ProcessInstrFunc)(Instr *);          // pointer to instruction processing function
 
@@ -161,6 +163,8 @@ void RecalcAllLabelLocations(Instr *curInstr) {
  */
 
 void RemapLabel(InstrBlock *instrBlock, Label *oldLabel, Label *newLabel) {
+    mergeLoopBound(newLabel, oldLabel);
+
     Instr *curInstr = instrBlock->firstInstr;
     while (curInstr != NULL) {
         bool isJump = (curInstr->mne == JMP) || (curInstr->mne == JSR);
@@ -435,6 +439,957 @@ void OPT_Compares(OutputBlock *curBlock) {
     WalkInstructions(&OptimizePosNegCmp, instrBlock);
 }
 
+//===============================================================================
+//---- Known value tracking... follows what's known about the carry and A
+//       thru the code, to remove CLC/SEC, masks and compares that don't
+//       change anything.
+//-------------------------------------------------------------------------------
+
+enum CarryState { CARRY_UNKNOWN, CARRY_CLEAR, CARRY_SET };
+
+typedef struct {
+    enum CarryState carry;
+    int zeroBits;       // bits of A known to be zero
+    int minA, maxA;     // range of values in A
+    int cmpValue;       // value A was just compared with  (-1 if none)
+} KnownState;
+
+typedef struct {
+    int location;
+    bool isJoin;        // can be reached from somewhere other than the previous instruction
+    bool isFixed;       // inside of a branch with a fixed offset, so it can't be removed
+} KnownInstrInfo;
+
+static KnownInstrInfo *knownInfo;
+static int knownInfoCount;
+
+/**
+ * Check if an instruction leaves the carry (and A) alone
+ */
+bool isCarryUnchanged(enum MnemonicCode mne) {
+    switch (mne) {
+        case MNE_NONE:
+        case LDX: case LDY: case STA: case STX: case STY:
+        case TAX: case TAY: case TSX: case TXS:
+        case INC: case DEC: case INX: case INY: case DEX: case DEY:
+        case BIT: case NOP: case PHA: case PHP:
+        case CLD: case CLI: case CLV: case SED: case SEI:
+        case BEQ: case BNE: case BMI: case BPL: case BVC: case BVS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if an instruction sets the N/Z flags from the value in A
+ */
+bool isFlagsFromA(const Instr *instr) {
+    switch (instr->mne) {
+        case LDA: case AND: case ORA: case EOR: case ADC: case SBC:
+        case TXA: case TYA: case PLA:
+            return true;
+        case ASL: case LSR: case ROL: case ROR:
+            return (instr->addrMode == ADDR_ACC);
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if an instruction replaces all of the N/Z flags without reading any flags
+ */
+bool isFlagsReplaced(const Instr *instr) {
+    switch (instr->mne) {
+        case LDA: case LDX: case LDY:
+        case TAX: case TAY: case TXA: case TYA: case PLA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isNumericImmediate(const Instr *instr) {
+    return (instr->addrMode == ADDR_IMM) && (instr->paramName == NULL);
+}
+
+/**
+ * Get the bits that could be set for values up to maxValue
+ */
+int getPossibleBits(int maxValue) {
+    int usedBits = 0;
+    while (usedBits < maxValue) usedBits = (usedBits << 1) | 1;
+    return usedBits;
+}
+
+void forgetA(KnownState *state) {
+    state->zeroBits = 0;
+    state->minA = 0;
+    state->maxA = 255;
+}
+
+void setRangeOfA(KnownState *state, int minA, int maxA) {
+    if ((minA < 0) || (maxA > 255)) {
+        forgetA(state);
+        return;
+    }
+    state->minA = minA;
+    state->maxA = maxA;
+    state->zeroBits |= (~getPossibleBits(maxA) & 0xff);
+}
+
+void removeInstr(InstrBlock *instrBlock, Instr *prevInstr, Instr *instr) {
+    Instr *nextInstr = instr->nextInstr;
+
+    if (prevInstr != NULL) prevInstr->nextInstr = nextInstr; else instrBlock->firstInstr = nextInstr;
+    if (nextInstr != NULL) nextInstr->prevInstr = prevInstr; else instrBlock->lastInstr = prevInstr;
+
+    // keep the line comment around
+    if ((nextInstr != NULL) && (nextInstr->lineComment == NULL)) nextInstr->lineComment = instr->lineComment;
+}
+
+/**
+ * Fold the carry into the next ADC #n/SBC #n  (ADC #n-1 with the carry set is the same as ADC #n)
+ *
+ * @return true if the carry op can be removed
+ */
+bool foldCarryIntoImmediate(Instr *carryInstr, int instrIndex, enum MnemonicCode opMne) {
+    Instr *curInstr = carryInstr->nextInstr;
+    for (int index = instrIndex + 1; (curInstr != NULL) && (index < knownInfoCount); index++) {
+        if (knownInfo[index].isJoin || knownInfo[index].isFixed) return false;
+
+        if (curInstr->mne == opMne) {
+            if (!isNumericImmediate(curInstr) || (curInstr->offset < 1) || (curInstr->offset > 255)) return false;
+            curInstr->offset--;
+            return true;
+        }
+
+        // A can be loaded in between, but nothing else can touch the carry
+        if ((curInstr->mne != LDA) && !isCarryUnchanged(curInstr->mne)) return false;
+        if (isBranch(curInstr->mne)) return false;
+        curInstr = curInstr->nextInstr;
+    }
+    return false;
+}
+
+/**
+ * Check if a compare with A always (or never) takes the following branch
+ *
+ * @return 1 if always taken, 0 if never taken, -1 if it depends
+ */
+int getBranchOutcome(enum MnemonicCode branchMne, int cmpValue, const KnownState *state) {
+    bool isAlwaysGTE = (state->minA >= cmpValue);
+    bool isAlwaysLT = (state->maxA < cmpValue);
+    bool isNeverEQ = (cmpValue < state->minA) || (cmpValue > state->maxA);
+    bool isAlwaysEQ = (state->minA == cmpValue) && (state->maxA == cmpValue);
+
+    switch (branchMne) {
+        case BCS: return isAlwaysGTE ? 1 : (isAlwaysLT ? 0 : -1);
+        case BCC: return isAlwaysLT ? 1 : (isAlwaysGTE ? 0 : -1);
+        case BEQ: return isAlwaysEQ ? 1 : (isNeverEQ ? 0 : -1);
+        case BNE: return isNeverEQ ? 1 : (isAlwaysEQ ? 0 : -1);
+        default:  return -1;
+    }
+}
+
+/**
+ * Find where code can be reached by branches with fixed offsets (ex: BCC *+3)
+ *
+ * @return false if the block can't be handled  (has data inside of the code)
+ */
+bool findJoinPoints(InstrBlock *instrBlock) {
+    int location = 0;
+    int index = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr, index++) {
+        if ((curInstr->mne == MNE_DATA) || (curInstr->mne == MNE_DATA_WORD)) return false;
+
+        knownInfo[index].location = location;
+        knownInfo[index].isJoin = (curInstr->label != NULL);
+        location += getInstrSize(curInstr->mne, curInstr->addrMode);
+    }
+
+    index = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr, index++) {
+        bool isFixedBranch = isBranch(curInstr->mne) && (curInstr->addrMode == ADDR_REL) && (curInstr->paramName == NULL);
+        if (!isFixedBranch) continue;
+
+        int branchLoc = knownInfo[index].location;
+        int destLoc = branchLoc + curInstr->offset;
+        int spanStart = (destLoc < branchLoc) ? destLoc : (branchLoc + 2);
+        int spanEnd = (destLoc < branchLoc) ? (branchLoc + 2) : destLoc;
+
+        for_range(spanIdx, 0, knownInfoCount) {
+            int spanLoc = knownInfo[spanIdx].location;
+            if (spanLoc == destLoc) knownInfo[spanIdx].isJoin = true;
+            if ((spanLoc >= spanStart) && (spanLoc < spanEnd)) knownInfo[spanIdx].isFixed = true;
+        }
+    }
+    return true;
+}
+
+/**
+ * Handle a compare of A with a value, followed by a branch
+ *
+ * @return 1 if the compare was removed, 0 if the branch was removed too, -1 if nothing was removed
+ */
+int removeKnownCompare(InstrBlock *instrBlock, Instr *prevInstr, Instr *cmpInstr, int index, const KnownState *state) {
+    Instr *branchInstr = cmpInstr->nextInstr;
+    if ((branchInstr == NULL) || !isBranch(branchInstr->mne) || (branchInstr->paramName == NULL)) return -1;
+    if (knownInfo[index].isFixed || knownInfo[index + 1].isJoin || knownInfo[index + 1].isFixed) return -1;
+
+    int outcome = getBranchOutcome(branchInstr->mne, cmpInstr->offset, state);
+    if (outcome < 0) return -1;
+
+    if (outcome == 1) {
+        if (compilerOptions.showOptimizerSteps) printf("\tBranch is always taken, replacing compare with JMP\n");
+        removeInstr(instrBlock, prevInstr, cmpInstr);
+        branchInstr->mne = JMP;
+        branchInstr->addrMode = ADDR_ABS;
+        return 1;
+    }
+
+    // the flags from the compare can't be needed after the branch
+    Instr *afterInstr = branchInstr->nextInstr;
+    while ((afterInstr != NULL) && (afterInstr->mne == MNE_NONE)) afterInstr = afterInstr->nextInstr;
+    if ((afterInstr == NULL) || !isFlagsReplaced(afterInstr)) return -1;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tBranch is never taken, removing compare\n");
+    removeInstr(instrBlock, prevInstr, cmpInstr);
+    removeInstr(instrBlock, prevInstr, branchInstr);
+    return 0;
+}
+
+/**
+ * Update what's known after a branch isn't taken
+ */
+void updateStateAfterBranch(KnownState *state, enum MnemonicCode branchMne) {
+    switch (branchMne) {
+        case BCC:
+            state->carry = CARRY_SET;
+            if (state->cmpValue >= 0) setRangeOfA(state, (state->minA > state->cmpValue) ? state->minA : state->cmpValue, state->maxA);
+            break;
+        case BCS:
+            state->carry = CARRY_CLEAR;
+            if (state->cmpValue > 0) setRangeOfA(state, state->minA, (state->maxA < state->cmpValue) ? state->maxA : (state->cmpValue - 1));
+            break;
+        case BNE:
+            if (state->cmpValue >= 0) setRangeOfA(state, state->cmpValue, state->cmpValue);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Walk thru the code, keeping track of the carry and the value in A,
+ *   removing any CLC/SEC, mask or compare that doesn't change anything.
+ */
+void OPT_KnownValues(InstrBlock *instrBlock) {
+    knownInfoCount = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) knownInfoCount++;
+    if (knownInfoCount == 0) return;
+
+    knownInfo = calloc(knownInfoCount + 1, sizeof(KnownInstrInfo));
+    if (!findJoinPoints(instrBlock)) {
+        free(knownInfo);
+        return;
+    }
+
+    KnownState state = {CARRY_UNKNOWN};
+    forgetA(&state);
+
+    Instr *prevInstr = NULL;
+    Instr *curInstr = instrBlock->firstInstr;
+    for (int index = 0; curInstr != NULL; index++) {
+        Instr *nextInstr = curInstr->nextInstr;
+        bool isNumImm = isNumericImmediate(curInstr);
+        bool isAcc = (curInstr->addrMode == ADDR_ACC);
+        bool isRemoved = false;
+
+        if (knownInfo[index].isJoin) {
+            state.carry = CARRY_UNKNOWN;
+            state.cmpValue = -1;
+            forgetA(&state);
+        }
+        if (!isBranch(curInstr->mne)) state.cmpValue = -1;
+
+        switch (curInstr->mne) {
+            case CLC:
+            case SEC: {
+                enum CarryState newCarry = (curInstr->mne == CLC) ? CARRY_CLEAR : CARRY_SET;
+                enum MnemonicCode opMne = (curInstr->mne == CLC) ? ADC : SBC;
+                isRemoved = !knownInfo[index].isFixed
+                        && ((state.carry == newCarry)
+                            || ((state.carry != CARRY_UNKNOWN) && foldCarryIntoImmediate(curInstr, index, opMne)));
+                if (isRemoved) {
+                    if (compilerOptions.showOptimizerSteps) {
+                        printf("\tRemoving %s (carry is already known)\n", (curInstr->mne == CLC) ? "CLC" : "SEC");
+                    }
+                    removeInstr(instrBlock, prevInstr, curInstr);
+                }
+                state.carry = newCarry;
+            } break;
+
+            case BCC: case BCS: case BNE:
+                updateStateAfterBranch(&state, curInstr->mne);
+                break;
+
+            case CMP: {
+                bool isByteImm = isNumImm && (curInstr->offset >= 0) && (curInstr->offset <= 255);
+                int removed = isByteImm ? removeKnownCompare(instrBlock, prevInstr, curInstr, index, &state) : -1;
+                if (removed >= 0) {
+                    isRemoved = true;
+                    if (removed == 0) {     // branch was removed too
+                        nextInstr = nextInstr->nextInstr;
+                        index++;
+                    }
+                    break;
+                }
+                state.carry = (isNumImm && (curInstr->offset == 0)) ? CARRY_SET : CARRY_UNKNOWN;
+                state.cmpValue = isByteImm ? curInstr->offset : -1;
+            } break;
+
+            case CPX: case CPY:
+                state.carry = (isNumImm && (curInstr->offset == 0)) ? CARRY_SET : CARRY_UNKNOWN;
+                break;
+
+            case ADC:
+                if (isNumImm && (state.carry != CARRY_UNKNOWN)) {
+                    int carryIn = (state.carry == CARRY_SET) ? 1 : 0;
+                    int maxValue = state.maxA + curInstr->offset + carryIn;
+                    state.carry = (maxValue <= 255) ? CARRY_CLEAR : CARRY_UNKNOWN;
+                    state.zeroBits = 0;
+                    setRangeOfA(&state, state.minA + curInstr->offset + carryIn, maxValue);
+                } else {
+                    state.carry = CARRY_UNKNOWN;
+                    forgetA(&state);
+                }
+                break;
+
+            case ASL:
+                state.carry = (isAcc && (state.zeroBits & 0x80)) ? CARRY_CLEAR : CARRY_UNKNOWN;
+                if (isAcc) {
+                    state.zeroBits = ((state.zeroBits << 1) | 1) & 0xff;
+                    setRangeOfA(&state, state.minA << 1, state.maxA << 1);
+                }
+                break;
+            case LSR:
+                state.carry = (isAcc && (state.zeroBits & 0x01)) ? CARRY_CLEAR : CARRY_UNKNOWN;
+                if (isAcc) {
+                    state.zeroBits = (state.zeroBits >> 1) | 0x80;
+                    setRangeOfA(&state, state.minA >> 1, state.maxA >> 1);
+                }
+                break;
+
+            case LDA:
+                forgetA(&state);
+                if (isNumImm) {
+                    state.zeroBits = (~curInstr->offset & 0xff);
+                    setRangeOfA(&state, curInstr->offset & 0xff, curInstr->offset & 0xff);
+                }
+                break;
+
+            case AND:
+                if (!isNumImm) {
+                    forgetA(&state);
+                } else {
+                    // the mask doesn't clear anything?
+                    int possibleBits = ~state.zeroBits & getPossibleBits(state.maxA) & 0xff;
+                    bool isNoOp = ((possibleBits & ~curInstr->offset) == 0);
+                    if (isNoOp && !knownInfo[index].isJoin && !knownInfo[index].isFixed
+                        && (prevInstr != NULL) && isFlagsFromA(prevInstr)) {
+                        if (compilerOptions.showOptimizerSteps) printf("\tRemoving AND (mask is not needed)\n");
+                        removeInstr(instrBlock, prevInstr, curInstr);
+                        isRemoved = true;
+                        break;
+                    }
+                    state.zeroBits |= (~curInstr->offset & 0xff);
+                    setRangeOfA(&state, 0, (state.maxA < (curInstr->offset & 0xff)) ? state.maxA : (curInstr->offset & 0xff));
+                }
+                break;
+
+            case ORA:
+            case EOR:
+                if (isNumImm) {
+                    int possibleBits = (~state.zeroBits & getPossibleBits(state.maxA)) | curInstr->offset;
+                    forgetA(&state);
+                    setRangeOfA(&state, 0, possibleBits & 0xff);
+                } else {
+                    forgetA(&state);
+                }
+                break;
+
+            case TXA: case TYA: case PLA:
+                forgetA(&state);
+                break;
+
+            default:
+                if (!isCarryUnchanged(curInstr->mne)) {
+                    state.carry = CARRY_UNKNOWN;
+                    forgetA(&state);
+                }
+        }
+
+        if (!isRemoved) prevInstr = curInstr;
+        curInstr = nextInstr;
+    }
+
+    free(knownInfo);
+}
+
+//===============================================================================
+//---- Tail merging... when two paths end with the same instructions before
+//       going to the same place, one copy is kept and the other jumps to it.
+//
+//             LDA #1                LDA #1
+//             STA x           +---> STA x
+//             JMP done        |     JMP done
+//             ...             |     ...
+//             LDA #2          |     LDA #2
+//             STA x           +---- JMP merged
+//             JMP done
+//
+//  The 6502 doesn't have a branch-always, so the jump to the kept copy is a
+//  JMP.  It takes the place of the old JMP (or the RTS), and the code only
+//  gets smaller, so branches that were in range stay in range.
+//  Code shown with #show_cycles is left alone.
+//-------------------------------------------------------------------------------
+
+typedef struct {
+    int lastIndex;          // last instruction before the exit
+    int exitIndex;          // index of JMP/RTS/RTI at the end  (-1 if it falls thru)
+    const Instr *dest;      // where the JMP goes  (NULL if it leaves the block)
+} TailInfo;
+
+static Instr **tailInstrs;
+
+static bool isTailExit(const Instr *instr) {
+    return ((instr->mne == JMP) && (instr->addrMode == ADDR_ABS) && (instr->paramName != NULL))
+        || (instr->mne == RTS) || (instr->mne == RTI);
+}
+
+/**
+ * Find the first real instruction at a label  (skipping over label/comment lines)
+ */
+static int findLabelIndex(const char *labelName) {
+    for_range(index, 0, knownInfoCount) {
+        Instr *curInstr = tailInstrs[index];
+        if ((curInstr->label == NULL) || (strcmp(curInstr->label->name, labelName) != 0)) continue;
+
+        while ((index < knownInfoCount) && (tailInstrs[index]->mne == MNE_NONE)) index++;
+        return (index < knownInfoCount) ? index : -1;
+    }
+    return -1;
+}
+
+static bool isSameParam(const char *param1, const char *param2) {
+    if ((param1 == NULL) || (param2 == NULL)) return (param1 == param2);
+    return (strcmp(param1, param2) == 0);
+}
+
+static bool isSameOperand(const Instr *instr1, const Instr *instr2) {
+    if (instr1->addrMode != instr2->addrMode) return false;
+    if ((instr1->addrMode == ADDR_NONE) || (instr1->addrMode == ADDR_ACC)) return true;
+
+    if (!isSameParam(instr1->paramName, instr2->paramName) || !isSameParam(instr1->param2, instr2->param2)) return false;
+    if ((instr1->paramName == NULL) && (instr1->offset != instr2->offset)) return false;
+    return (instr1->paramExt == instr2->paramExt);
+}
+
+bool isSameInstr(const Instr *instr1, const Instr *instr2) {
+    return (instr1->mne == instr2->mne) && isSameOperand(instr1, instr2);
+}
+
+/**
+ * Check if an instruction can be part of a merged tail
+ */
+bool canMergeInstr(const Instr *instr) {
+    if (instr->showCycles) return false;
+    if ((instr->mne == MNE_DATA) || (instr->mne == MNE_DATA_WORD)) return false;
+    if (isBranch(instr->mne) && (instr->paramName == NULL)) return false;     // fixed offset
+    return !isTailExit(instr);
+}
+
+/**
+ * Check if two tails go to the same place
+ */
+bool isSameDest(const TailInfo *tail1, const TailInfo *tail2) {
+    const Instr *exit1 = (tail1->exitIndex >= 0) ? tailInstrs[tail1->exitIndex] : NULL;
+    const Instr *exit2 = (tail2->exitIndex >= 0) ? tailInstrs[tail2->exitIndex] : NULL;
+
+    if ((exit1 != NULL) && (exit2 != NULL) && (exit1->mne != JMP)) return (exit1->mne == exit2->mne);
+    if (((exit1 != NULL) && (exit1->mne != JMP)) || ((exit2 != NULL) && (exit2->mne != JMP))) return false;
+
+    // both go to a label... check if it's the same spot
+    if ((tail1->dest != NULL) || (tail2->dest != NULL)) return (tail1->dest == tail2->dest);
+    return (strcmp(exit1->paramName, exit2->paramName) == 0);
+}
+
+/**
+ * Work out how many bytes are saved when 'removeTail' jumps to the end of 'keepTail'
+ *
+ * @param keepStart - (output) index of the first instruction of the kept copy
+ * @param removeStart - (output) index of the first instruction of the removed copy
+ * @return number of bytes saved
+ */
+int getTailSavings(const TailInfo *keepTail, const TailInfo *removeTail, int *keepStart, int *removeStart) {
+    int keepIndex = keepTail->lastIndex;
+    int removeIndex = removeTail->lastIndex;
+    int size = 0;
+
+    // the code being removed is replaced by a JMP, so nothing can jump into the middle of it
+    const Instr *exitInstr = tailInstrs[removeTail->exitIndex];
+    if (exitInstr->showCycles || knownInfo[removeTail->exitIndex].isJoin || knownInfo[removeTail->exitIndex].isFixed) return 0;
+
+    while ((keepIndex >= 0) && (removeIndex >= 0) && (keepIndex != removeIndex)) {
+        Instr *keepInstr = tailInstrs[keepIndex];
+        Instr *removeInstr = tailInstrs[removeIndex];
+
+        // skip over label/comment lines in the kept copy, and comments in the removed one
+        if (keepInstr->mne == MNE_NONE) { keepIndex--; continue; }
+        if ((removeInstr->mne == MNE_NONE) && !knownInfo[removeIndex].isJoin) { removeIndex--; continue; }
+
+        if (!canMergeInstr(keepInstr) || !canMergeInstr(removeInstr) || !isSameInstr(keepInstr, removeInstr)) break;
+        if (knownInfo[removeIndex].isFixed) break;
+        if (knownInfo[removeIndex].isJoin && (removeInstr->label == NULL)) break;
+
+        size += getInstrSize(removeInstr->mne, removeInstr->addrMode);
+        *keepStart = keepIndex;
+        *removeStart = removeIndex;
+
+        // a label can only be on the first instruction (it moves to the new JMP)
+        if (removeInstr->label != NULL) break;
+
+        keepIndex--;
+        removeIndex--;
+    }
+
+    // a JMP replaces the old JMP  (or RTS)
+    return size + getInstrSize(exitInstr->mne, exitInstr->addrMode) - 3;
+}
+
+/**
+ * Find all of the tails in a block
+ * @return number of tails found
+ */
+int findTails(TailInfo *tails) {
+    int tailCount = 0;
+    for_range(index, 1, knownInfoCount) {
+        Instr *curInstr = tailInstrs[index];
+        if (!isTailExit(curInstr)) continue;
+
+        int destIndex = (curInstr->mne == JMP) ? findLabelIndex(curInstr->paramName) : -1;
+        tails[tailCount].lastIndex = index - 1;
+        tails[tailCount].exitIndex = index;
+        tails[tailCount].dest = (destIndex >= 0) ? tailInstrs[destIndex] : NULL;
+        tailCount++;
+
+        // the code falling into the spot the JMP goes to is a tail too
+        int fallIndex = destIndex - 1;
+        while ((fallIndex >= 0) && (tailInstrs[fallIndex]->mne == MNE_NONE)) fallIndex--;
+        if ((fallIndex < 0) || isTailExit(tailInstrs[fallIndex])) continue;
+
+        bool isFound = false;
+        for_range(tailIdx, 0, tailCount) {
+            if ((tails[tailIdx].exitIndex < 0) && (tails[tailIdx].lastIndex == fallIndex)) isFound = true;
+        }
+        if (!isFound) {
+            tails[tailCount].lastIndex = fallIndex;
+            tails[tailCount].exitIndex = -1;
+            tails[tailCount].dest = tailInstrs[destIndex];
+            tailCount++;
+        }
+    }
+    return tailCount;
+}
+
+/**
+ * Find the best pair of tails to merge, and merge them
+ * @return number of bytes saved  (0 if nothing was merged)
+ */
+int mergeBestTails(InstrBlock *instrBlock) {
+    TailInfo *tails = calloc(knownInfoCount * 2, sizeof(TailInfo));
+    int tailCount = findTails(tails);
+
+    int bestSavings = 0, bestKeep = 0, bestRemove = 0;
+    for_range(tailIdx1, 0, tailCount) {
+        for_range(tailIdx2, 0, tailCount) {
+            const TailInfo *keepTail = &tails[tailIdx1];
+            const TailInfo *removeTail = &tails[tailIdx2];
+
+            // code falling thru has to be kept
+            if ((tailIdx1 == tailIdx2) || (removeTail->exitIndex < 0)) continue;
+            if (!isSameDest(keepTail, removeTail)) continue;
+
+            int keepStart, removeStart;
+            int savings = getTailSavings(keepTail, removeTail, &keepStart, &removeStart);
+            if (savings > bestSavings) {
+                bestSavings = savings;
+                bestKeep = keepStart;
+                bestRemove = removeStart;
+            }
+        }
+    }
+
+    if (bestSavings > 0) {
+        Instr *keepInstr = tailInstrs[bestKeep];
+        Instr *jumpInstr = tailInstrs[bestRemove];
+
+        // find the end of the removed copy
+        Instr *exitInstr = jumpInstr;
+        while (!isTailExit(exitInstr)) exitInstr = exitInstr->nextInstr;
+
+        if (keepInstr->label == NULL) keepInstr->label = newGenericLabel(LBL_CODE);
+        addLabelRef(keepInstr->label);
+
+        if (compilerOptions.showOptimizerSteps) {
+            printf("\tMerging tail into %s (%d bytes saved)\n", keepInstr->label->name, bestSavings);
+        }
+
+        // turn the start of the removed copy into the JMP, and drop the rest
+        jumpInstr->mne = JMP;
+        jumpInstr->addrMode = ADDR_ABS;
+        jumpInstr->paramName = keepInstr->label->name;
+        jumpInstr->param2 = NULL;
+        jumpInstr->paramExt = PARAM_NORMAL;
+        jumpInstr->nextInstr = exitInstr->nextInstr;
+        if (exitInstr->nextInstr != NULL) {
+            exitInstr->nextInstr->prevInstr = jumpInstr;
+        } else {
+            instrBlock->lastInstr = jumpInstr;
+        }
+
+        // other JMPs to the new JMP can go straight to the kept copy
+        if (jumpInstr->label != NULL) {
+            for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+                if ((curInstr->mne == JMP) && (curInstr->paramName != NULL)
+                    && (strcmp(curInstr->paramName, jumpInstr->label->name) == 0)) {
+                    curInstr->paramName = jumpInstr->paramName;
+                }
+            }
+        }
+    }
+
+    free(tails);
+    return bestSavings;
+}
+
+void OPT_TailMerge(InstrBlock *instrBlock) {
+    int savings;
+    do {
+        knownInfoCount = 0;
+        for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) knownInfoCount++;
+        if (knownInfoCount == 0) return;
+
+        knownInfo = calloc(knownInfoCount + 1, sizeof(KnownInstrInfo));
+        tailInstrs = calloc(knownInfoCount + 1, sizeof(Instr *));
+
+        int index = 0;
+        for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+            tailInstrs[index++] = curInstr;
+        }
+
+        savings = findJoinPoints(instrBlock) ? mergeBestTails(instrBlock) : 0;
+        instrBlock->tailMergeSavings += savings;
+
+        free(tailInstrs);
+        free(knownInfo);
+    } while (savings > 0);
+}
+
+//===============================================================================
+//---- Undocumented opcodes (-ou)... fuses common sequences into the stable
+//       undocumented opcodes of the NMOS 6502:
+//
+//         LDA m / TAX                           ->  LAX m
+//         LDA m / AND #k / STA d   (X holds k)  ->  LDA m / SAX d
+//         DEC m / LDA m / CMP v / BNE           ->  LDA v / DCP m / BNE
+//         LDA m / SEC / SBC #k / TAX            ->  LAX m / SBX #k
+//         INC m / SEC / SBC m                   ->  SEC / ISB m
+//
+//  The ones that leave something else in A (or in the flags) are only used
+//  when A is loaded again before anything looks at it.  The code generator
+//  always sets up the carry before an ADC/SBC, so a carry that comes out
+//  different after a compare doesn't matter.  Code shown with #show_cycles
+//  is left alone.
+//-------------------------------------------------------------------------------
+
+static Instr **undocInstrs;
+
+/**
+ * Get the next instruction that can be fused with the one at 'index'
+ *
+ * @return index of the instruction, or -1 if a join point or fixed code comes first
+ */
+static int nextFusable(int index) {
+    for (index++; index < knownInfoCount; index++) {
+        const Instr *instr = undocInstrs[index];
+        if (instr == NULL) continue;            // (already fused)
+        if (knownInfo[index].isJoin || knownInfo[index].isFixed || instr->showCycles) return -1;
+        if (instr->mne != MNE_NONE) return index;
+    }
+    return -1;
+}
+
+static void removeFused(InstrBlock *instrBlock, int index) {
+    int prevIndex = index - 1;
+    while ((prevIndex >= 0) && (undocInstrs[prevIndex] == NULL)) prevIndex--;
+
+    removeInstr(instrBlock, (prevIndex >= 0) ? undocInstrs[prevIndex] : NULL, undocInstrs[index]);
+    undocInstrs[index] = NULL;
+}
+
+static void copyOperand(Instr *destInstr, const Instr *srcInstr) {
+    destInstr->addrMode = srcInstr->addrMode;
+    destInstr->offset = srcInstr->offset;
+    destInstr->paramName = srcInstr->paramName;
+    destInstr->param2 = srcInstr->param2;
+    destInstr->paramExt = srcInstr->paramExt;
+}
+
+static void setImmediate(Instr *instr, enum MnemonicCode mne, int value) {
+    instr->mne = mne;
+    instr->addrMode = ADDR_IMM;
+    instr->offset = value & 0xff;
+    instr->paramName = NULL;
+    instr->param2 = NULL;
+    instr->paramExt = PARAM_NORMAL;
+}
+
+static bool hasAddrMode(enum MnemonicCode mne, enum AddrModes addrMode) {
+    return (lookupOpcodeEntry(mne, addrMode).mneCode != MNE_NONE);
+}
+
+static bool isXChanged(enum MnemonicCode mne) {
+    switch (mne) {
+        case LDX: case TAX: case TSX: case INX: case DEX: case LAX: case SBX:
+        case JSR: case BRK: case RTI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check if A and the N/Z flags get loaded again before anything looks at them
+ *    (follows JMPs a short way)
+ */
+static bool isAReloaded(const Instr *instr) {
+    for_range(jumpCount, 0, 4) {
+        while ((instr != NULL) && (instr->mne == MNE_NONE)) instr = instr->nextInstr;
+        if (instr == NULL) return false;
+
+        switch (instr->mne) {
+            case LDA: case TXA: case TYA: case PLA: case LAX:
+                return true;
+            case JSR:
+            case JMP:
+                // a function table's dispatch routine loads A first thing
+                if ((instr->paramName != NULL) && (ICG_GetDispatchTargets(instr->paramName) != NULL)) return true;
+                if ((instr->mne == JSR) || (instr->addrMode != ADDR_ABS) || (instr->paramName == NULL)) return false;
+                instr = findLabelDestination(instr->paramName);
+                break;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+/**
+ *  LDA m / TAX  ->  LAX m          LDA m / LDX m  ->  LAX m
+ *  LDX m / TXA  ->  LAX m          LDX m / LDA m  ->  LAX m
+ *
+ *  (STAs can be in between, they only store the value that's already in m)
+ */
+static bool fuseLAX(InstrBlock *instrBlock, int index) {
+    Instr *loadInstr = undocInstrs[index];
+    if ((loadInstr->mne != LDA) && (loadInstr->mne != LDX)) return false;
+    if ((loadInstr->addrMode == ADDR_IMM) || !hasAddrMode(LAX, loadInstr->addrMode)) return false;     // (LAX #imm isn't stable)
+
+    int nextIndex = nextFusable(index);
+    while ((nextIndex >= 0) && (loadInstr->mne == LDA) && (undocInstrs[nextIndex]->mne == STA)) {
+        nextIndex = nextFusable(nextIndex);
+    }
+    if (nextIndex < 0) return false;
+    const Instr *nextInstr = undocInstrs[nextIndex];
+
+    enum MnemonicCode otherLoad = (loadInstr->mne == LDA) ? LDX : LDA;
+    enum MnemonicCode transfer = (loadInstr->mne == LDA) ? TAX : TXA;
+    bool isFused = (nextInstr->mne == transfer)
+            || ((nextInstr->mne == otherLoad) && isSameOperand(loadInstr, nextInstr));
+    if (!isFused) return false;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tUsing LAX for %s/%s\n", getMnemonicStr(loadInstr->mne), getMnemonicStr(nextInstr->mne));
+    loadInstr->mne = LAX;
+    removeFused(instrBlock, nextIndex);
+    return true;
+}
+
+/**
+ *  LDA m / AND #k / STA d  ->  LDA m / SAX d     (when X is known to hold k)
+ */
+static bool fuseSAX(InstrBlock *instrBlock, int index, int knownX) {
+    if ((knownX < 0) || (undocInstrs[index]->mne != LDA)) return false;
+
+    int andIndex = nextFusable(index);
+    if (andIndex < 0) return false;
+    Instr *andInstr = undocInstrs[andIndex];
+    if ((andInstr->mne != AND) || !isNumericImmediate(andInstr) || ((andInstr->offset & 0xff) != knownX)) return false;
+
+    int storeIndex = nextFusable(andIndex);
+    if (storeIndex < 0) return false;
+    const Instr *storeInstr = undocInstrs[storeIndex];
+    if ((storeInstr->mne != STA) || !hasAddrMode(SAX, storeInstr->addrMode)) return false;
+    if (!isAReloaded(storeInstr->nextInstr)) return false;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tUsing SAX for AND/STA (X = %d)\n", knownX);
+    andInstr->mne = SAX;
+    copyOperand(andInstr, storeInstr);
+    removeFused(instrBlock, storeIndex);
+    return true;
+}
+
+/**
+ *  DEC m / LDA m / CMP v / BNE  ->  LDA v / DCP m / BNE
+ *
+ *  (only the Z flag comes out the same, so it has to be BNE/BEQ)
+ */
+static bool fuseDCP(InstrBlock *instrBlock, int index) {
+    Instr *decInstr = undocInstrs[index];
+    if ((decInstr->mne != DEC) || !hasAddrMode(DCP, decInstr->addrMode)) return false;
+
+    int loadIndex = nextFusable(index);
+    if (loadIndex < 0) return false;
+    Instr *loadInstr = undocInstrs[loadIndex];
+    if ((loadInstr->mne != LDA) || !isSameOperand(decInstr, loadInstr)) return false;
+
+    int cmpIndex = nextFusable(loadIndex);
+    if (cmpIndex < 0) return false;
+    const Instr *cmpInstr = undocInstrs[cmpIndex];
+    if ((cmpInstr->mne != CMP) || isSameOperand(cmpInstr, decInstr)) return false;
+
+    int branchIndex = nextFusable(cmpIndex);
+    if (branchIndex < 0) return false;
+    const Instr *branchInstr = undocInstrs[branchIndex];
+    if (((branchInstr->mne != BNE) && (branchInstr->mne != BEQ)) || (branchInstr->paramName == NULL)) return false;
+
+    // A ends up holding v... both ways out have to load it again
+    if (!isAReloaded(branchInstr->nextInstr) || !isAReloaded(findLabelDestination(branchInstr->paramName))) return false;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tUsing DCP for DEC/LDA/CMP\n");
+    decInstr->mne = LDA;
+    copyOperand(decInstr, cmpInstr);
+    loadInstr->mne = DCP;
+    removeFused(instrBlock, cmpIndex);
+    return true;
+}
+
+/**
+ *  LDA m / SEC / SBC #k / TAX  ->  LAX m / SBX #k
+ *  LDA m / CLC / ADC #k / TAX  ->  LAX m / SBX #-k
+ *
+ *  (SBX subtracts without the carry, and sets the carry the same way)
+ */
+static bool fuseSBX(InstrBlock *instrBlock, int index) {
+    Instr *loadInstr = undocInstrs[index];
+    if ((loadInstr->mne != LDA) || (loadInstr->addrMode == ADDR_IMM) || !hasAddrMode(LAX, loadInstr->addrMode)) return false;
+
+    int carryIndex = nextFusable(index);
+    if (carryIndex < 0) return false;
+    Instr *carryInstr = undocInstrs[carryIndex];
+    if ((carryInstr->mne != SEC) && (carryInstr->mne != CLC)) return false;
+
+    int opIndex = nextFusable(carryIndex);
+    if (opIndex < 0) return false;
+    const Instr *opInstr = undocInstrs[opIndex];
+    if ((opInstr->mne != ((carryInstr->mne == SEC) ? SBC : ADC)) || !isNumericImmediate(opInstr)) return false;
+    if ((opInstr->mne == ADC) && ((opInstr->offset & 0xff) == 0)) return false;      // (ADC #0 leaves the carry clear)
+
+    int transferIndex = nextFusable(opIndex);
+    if (transferIndex < 0) return false;
+    const Instr *transferInstr = undocInstrs[transferIndex];
+    if ((transferInstr->mne != TAX) || !isAReloaded(transferInstr->nextInstr)) return false;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tUsing LAX/SBX for %s/TAX\n", getMnemonicStr(opInstr->mne));
+    loadInstr->mne = LAX;
+    setImmediate(carryInstr, SBX, (opInstr->mne == SBC) ? opInstr->offset : -opInstr->offset);
+    removeFused(instrBlock, transferIndex);
+    removeFused(instrBlock, opIndex);
+    return true;
+}
+
+/**
+ *  INC m / SEC / SBC m  ->  SEC / ISB m
+ */
+static bool fuseISB(InstrBlock *instrBlock, int index) {
+    Instr *incInstr = undocInstrs[index];
+    if ((incInstr->mne != INC) || !hasAddrMode(ISB, incInstr->addrMode)) return false;
+
+    int nextIndex = nextFusable(index);
+    if (nextIndex < 0) return false;
+    Instr *carryInstr = undocInstrs[nextIndex];
+    bool hasCarryOp = (carryInstr->mne == SEC) || (carryInstr->mne == CLC);
+
+    int opIndex = hasCarryOp ? nextFusable(nextIndex) : nextIndex;
+    if (opIndex < 0) return false;
+    const Instr *opInstr = undocInstrs[opIndex];
+    if ((opInstr->mne != SBC) || !isSameOperand(incInstr, opInstr)) return false;
+
+    if (compilerOptions.showOptimizerSteps) printf("\tUsing ISB for INC/SBC\n");
+    if (hasCarryOp) {
+        // swap the INC and the carry op
+        enum MnemonicCode carryMne = carryInstr->mne;
+        carryInstr->mne = ISB;
+        copyOperand(carryInstr, incInstr);
+        incInstr->mne = carryMne;
+        incInstr->addrMode = ADDR_NONE;
+        incInstr->paramName = NULL;
+        incInstr->param2 = NULL;
+    } else {
+        incInstr->mne = ISB;
+    }
+    removeFused(instrBlock, opIndex);
+    return true;
+}
+
+void OPT_UndocumentedOpcodes(InstrBlock *instrBlock) {
+    knownInfoCount = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) knownInfoCount++;
+    if (knownInfoCount == 0) return;
+
+    knownInfo = calloc(knownInfoCount + 1, sizeof(KnownInstrInfo));
+    undocInstrs = calloc(knownInfoCount + 1, sizeof(Instr *));
+
+    int index = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        undocInstrs[index++] = curInstr;
+    }
+
+    if (findJoinPoints(instrBlock)) {
+        int knownX = -1;        // value in X  (-1 if not known)
+        for_range(instrIndex, 0, knownInfoCount) {
+            const Instr *curInstr = undocInstrs[instrIndex];
+            if (curInstr == NULL) continue;
+            if (knownInfo[instrIndex].isJoin) knownX = -1;
+
+            if (!knownInfo[instrIndex].isFixed && !curInstr->showCycles) {
+                if (!fuseLAX(instrBlock, instrIndex) && !fuseSBX(instrBlock, instrIndex)
+                    && !fuseDCP(instrBlock, instrIndex) && !fuseISB(instrBlock, instrIndex)) {
+                    fuseSAX(instrBlock, instrIndex, knownX);
+                }
+            }
+
+            // (looks at the instruction after any fusing)
+            if (isXChanged(curInstr->mne)) knownX = -1;
+            if ((curInstr->mne == LDX) && isNumericImmediate(curInstr)) knownX = curInstr->offset & 0xff;
+        }
+    }
+
+    free(undocInstrs);
+    free(knownInfo);
+}
+
 //===============================================================================
 //---- Branch Checking code... checks for page-crossing branches.
 //-------------------------------------------------------------------------------
@@ -475,12 +1430,10 @@ void OPT_CheckBranchAlignment(OutputBlock *curBlock) {
     checkingFuncName = curBlock->codeBlock->funcSym->name;
 
     // IMPORTANT:
-    //  If optimizer has not been run, we need to build the label list
-    //   here... otherwise the compiler will crash
-    if (!compilerOptions.runOptimizer) {
-        OPT_FindAllLabels(instrBlock);
-        OPT_RecalcAllLabelLocations(instrBlock);
-    }
+    //  Always rebuild the label list here... the optimizer may have changed
+    //   the code, and the block may have been moved (bank placement) since then
+    OPT_FindAllLabels(instrBlock);
+    OPT_RecalcAllLabelLocations(instrBlock);
     instrLocation = curBlock->codeBlock->funcSym->location;
     WalkInstructions(&CheckBranchJumps, instrBlock);
 }
@@ -503,9 +1456,12 @@ void OPT_CodeBlock(OutputBlock *curBlock) {
 
     OPT_Loops(curBlock);
     OPT_Compares(curBlock);
+    if (compilerOptions.useUndocumentedOpcodes) OPT_UndocumentedOpcodes(instrBlock);
+    OPT_KnownValues(instrBlock);
 
     OPT_Jumps(instrBlock);
     OPT_RemapLabelsInBlock(instrBlock);
+    OPT_TailMerge(instrBlock);
 
     //--- TODO: remove the following as they don't really do anything of value
     //          now that OPT_RemapLabelsInBlock has been fixed
@@ -23,5 +23,6 @@
 
 extern void OPT_CodeBlock(OutputBlock *curBlock);
 extern void OPT_CheckBranchAlignment(OutputBlock *curBlock);
+extern bool isSameInstr(const Instr *instr1, const Instr *instr2);
 
 #endif //MODULE_OPTIMIZER_H
@@ -0,0 +1,723 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Bank Placement - assign code and data blocks to banks
+//
+//  When a bank-switching scheme is selected (#set_banking), the output blocks
+//  are placed into banks after all the code has been generated:
+//
+//   - Functions that call each other are clustered together using the call
+//     graph (func_map.c).  The most frequent calls (dstFuncCallCnt) are
+//     considered first, so they are the most likely to stay within a bank.
+//   - Data blocks are kept in the same bank as the code that uses them.
+//   - Calls that still cross banks are redirected through generated
+//     trampolines which select the destination bank, call the function,
+//     and then switch back to the caller's bank.
+//
+//  F8/F6/F4:  the whole 4k bank is switched out from under the running code,
+//             so trampolines are copied to the same spot in every bank.
+//  E0/3F:     trampolines live in the fixed bank (which is always visible).
+//             Only functions that don't call out of their cluster can be
+//             placed in the fixed bank.
+//
+//  Blocks placed with '#set_bank' stay in the bank they were given.
+//
+//  Functions taking parameters on the stack read them at a fixed distance
+//  from their return address, and a trampoline pushes a second one.  So
+//  they're kept in the same bank as their callers, the same way data is.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bank_placement.h"
+#include "output_block.h"
+#include "common/common.h"
+#include "codegen/gen_common.h"
+#include "cpu_arch/instrs.h"
+#include "data/bank_layout.h"
+#include "data/func_map.h"
+#include "data/instr_list.h"
+#include "optimizer/optimizer.h"
+
+enum {
+    MAX_PLACED_BLOCKS = 256,
+    MAX_TRAMPOLINES = 128,
+    MAX_PLACEMENT_PASSES = 4,
+
+    CALL_WEIGHT = 1,            // per call site (dstFuncCallCnt)
+    DATA_WEIGHT = 10000,        // data (and stack param functions) really need to be with the code using them
+};
+
+typedef struct {
+    OutputBlock *block;
+    int parent;         // cluster this block belongs to (union-find)
+    int clusterSize;    // total size of cluster (only valid for cluster root)
+    int pinnedBank;     // bank cluster must go in (-1 if free to move)
+    bool callsOut;      // cluster calls functions outside of itself (root only)
+    int bank;
+} PlacementNode;
+
+typedef struct {
+    int callerBank;
+    int funcNode;
+    Label *label;
+} Trampoline;
+
+typedef struct {
+    int nodeA, nodeB;
+    int weight;
+} AffinityEdge;
+
+static PlacementNode nodes[MAX_PLACED_BLOCKS];
+static int nodeCount;
+static int *affinity;           // nodeCount x nodeCount matrix of call/data weights
+
+static Trampoline trampolines[MAX_TRAMPOLINES];
+static int trampolineCount;
+
+static int bankUsed[MAX_BANKS];
+
+static BankLayout *bp_bankLayout;
+static const BankingSchemeDef *bp_scheme;
+
+#define AFFINITY(a, b)  affinity[((a) * nodeCount) + (b)]
+#define IS_CODE_NODE(n) (nodes[n].block->blockType == BT_CODE)
+
+//-----------------------------------------------------------------------
+//--- Trampoline / bank switching code sizes
+
+int bankSwitchSize() {
+    // 3F: PHA / LDA #bank / STA $3F / PLA    others: BIT hotspot
+    return (bp_scheme->scheme == BANKING_3F) ? 6 : 3;
+}
+
+int trampolineSize() { return bankSwitchSize() + 3 + bankSwitchSize() + 1; }
+int bootCodeSize() { return bankSwitchSize() + 3; }
+
+int calcStubAreaSize(int numTrampolines) {
+    return bootCodeSize() + (numTrampolines * trampolineSize());
+}
+
+/**
+ * Does this bank hold a copy of the trampolines?
+ */
+bool bankHasStubs(int bankNum) {
+    return !bp_scheme->hasFixedBank || bp_bankLayout->banks[bankNum].isFixed;
+}
+
+int bankCapacity(int bankNum, int stubArea) {
+    return BL_getUsableSize(bankNum) - (bankHasStubs(bankNum) ? stubArea : 0);
+}
+
+//-----------------------------------------------------------------------
+//--- Collect blocks and figure out how they're related
+
+int findNodeByName(const char *name) {
+    for_range(index, 0, nodeCount) {
+        if (strncmp(nodes[index].block->blockName, name, SYMBOL_NAME_LIMIT) == 0) return index;
+
+        // data merged into this block belongs to the same node
+        const OutputBlock *mergedBlock = nodes[index].block->mergedBlocks;
+        while (mergedBlock != NULL) {
+            if (strncmp(mergedBlock->blockName, name, SYMBOL_NAME_LIMIT) == 0) return index;
+            mergedBlock = mergedBlock->nextBlock;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Find the code block a call/jump instruction goes to
+ * @return node index of function, or -1 if not a function call
+ */
+int findCallDestination(const Instr *instr) {
+    bool isCall = (instr->mne == JSR) || (instr->mne == JMP);
+    if (!isCall || (instr->addrMode != ADDR_ABS) || (instr->paramName == NULL)) return -1;
+
+    int destNode = findNodeByName(instr->paramName);
+    if ((destNode < 0) || !IS_CODE_NODE(destNode)) return -1;
+    return destNode;
+}
+
+bool collectBlocks() {
+    nodeCount = 0;
+    OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
+    while (block != NULL) {
+        if (nodeCount >= MAX_PLACED_BLOCKS) {
+            ErrorMessage("Too many blocks for bank placement", NULL, 0);
+            return false;
+        }
+        PlacementNode *node = &nodes[nodeCount++];
+        node->block = block;
+        node->bank = -1;
+        block = block->nextBlock;
+    }
+    return true;
+}
+
+/**
+ * Does a function read any of its parameters off of the stack?
+ */
+bool hasStackParams(int nodeIndex) {
+    const SymbolRecord *funcSym = nodes[nodeIndex].block->symbol;
+    if ((funcSym == NULL) || (GET_LOCAL_SYMBOL_TABLE(funcSym) == NULL)) return false;
+
+    for (const SymbolRecord *curSym = GET_LOCAL_SYMBOL_TABLE(funcSym)->firstSymbol; curSym != NULL; curSym = curSym->next) {
+        if (IS_PARAM_VAR(curSym)) return true;
+    }
+    return false;
+}
+
+void addAffinity(int nodeA, int nodeB, int weight) {
+    if (nodeA == nodeB) return;
+    AFFINITY(nodeA, nodeB) += weight;
+    AFFINITY(nodeB, nodeA) += weight;
+}
+
+/**
+ * Build the affinity matrix:
+ *   - function calls (from the call graph) weighted by number of call sites
+ *   - references to data blocks (found by scanning the generated code)
+ */
+void buildAffinity() {
+    affinity = allocMem(nodeCount * nodeCount * sizeof(int));
+    memset(affinity, 0, nodeCount * nodeCount * sizeof(int));
+
+    for_range(nodeIndex, 0, nodeCount) {
+        if (!IS_CODE_NODE(nodeIndex)) continue;
+        OutputBlock *block = nodes[nodeIndex].block;
+
+        FuncCallMapEntry *funcMapEntry = FM_findFunction(block->blockName);
+        if (funcMapEntry != NULL) {
+            for_range(callIndex, 0, funcMapEntry->cntFuncsCalled) {
+                int destNode = findNodeByName(funcMapEntry->dstFuncName[callIndex]);
+                if (destNode >= 0) {
+                    int weight = hasStackParams(destNode) ? DATA_WEIGHT : (funcMapEntry->dstFuncCallCnt[callIndex] * CALL_WEIGHT);
+                    addAffinity(nodeIndex, destNode, weight);
+                }
+            }
+        }
+
+        Instr *instr = block->codeBlock->firstInstr;
+        while (instr != NULL) {
+            if (instr->paramName != NULL) {
+                int dataNode = findNodeByName(instr->paramName);
+                if ((dataNode >= 0) && !IS_CODE_NODE(dataNode)) {
+                    addAffinity(nodeIndex, dataNode, DATA_WEIGHT);
+                }
+            }
+            instr = instr->nextInstr;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+//--- Clustering
+
+int findCluster(int nodeIndex) {
+    while (nodes[nodeIndex].parent != nodeIndex) nodeIndex = nodes[nodeIndex].parent;
+    return nodeIndex;
+}
+
+int compareEdges(const void *a, const void *b) {
+    return ((const AffinityEdge *)b)->weight - ((const AffinityEdge *)a)->weight;
+}
+
+/**
+ * Merge strongly connected blocks into clusters, as long as they still fit in a bank
+ */
+void clusterBlocks(int maxClusterSize) {
+    for_range(nodeIndex, 0, nodeCount) {
+        OutputBlock *block = nodes[nodeIndex].block;
+        nodes[nodeIndex].parent = nodeIndex;
+        nodes[nodeIndex].clusterSize = block->blockSize;
+        nodes[nodeIndex].pinnedBank = block->isBankPinned ? block->bankNum : -1;
+        nodes[nodeIndex].callsOut = false;
+    }
+
+    // build list of edges, heaviest first
+    AffinityEdge *edges = allocMem(((nodeCount * nodeCount) / 2 + 1) * sizeof(AffinityEdge));
+    int edgeCount = 0;
+    for_range(nodeA, 0, nodeCount) {
+        for_range(nodeB, nodeA + 1, nodeCount) {
+            if (AFFINITY(nodeA, nodeB) > 0) {
+                edges[edgeCount].nodeA = nodeA;
+                edges[edgeCount].nodeB = nodeB;
+                edges[edgeCount].weight = AFFINITY(nodeA, nodeB);
+                edgeCount++;
+            }
+        }
+    }
+    qsort(edges, edgeCount, sizeof(AffinityEdge), compareEdges);
+
+    for_range(edgeIndex, 0, edgeCount) {
+        int clusterA = findCluster(edges[edgeIndex].nodeA);
+        int clusterB = findCluster(edges[edgeIndex].nodeB);
+        if (clusterA == clusterB) continue;
+
+        int pinnedA = nodes[clusterA].pinnedBank;
+        int pinnedB = nodes[clusterB].pinnedBank;
+        if ((pinnedA >= 0) && (pinnedB >= 0) && (pinnedA != pinnedB)) continue;
+
+        int mergedSize = nodes[clusterA].clusterSize + nodes[clusterB].clusterSize;
+        if (mergedSize > maxClusterSize) continue;
+
+        nodes[clusterB].parent = clusterA;
+        nodes[clusterA].clusterSize = mergedSize;
+        if (pinnedA < 0) nodes[clusterA].pinnedBank = pinnedB;
+    }
+    free(edges);
+
+    // figure out which clusters call out to other clusters
+    for_range(nodeIndex, 0, nodeCount) {
+        if (!IS_CODE_NODE(nodeIndex)) continue;
+        Instr *instr = nodes[nodeIndex].block->codeBlock->firstInstr;
+        while (instr != NULL) {
+            int destNode = findCallDestination(instr);
+            if ((destNode >= 0) && (findCluster(destNode) != findCluster(nodeIndex))) {
+                nodes[findCluster(nodeIndex)].callsOut = true;
+            }
+            instr = instr->nextInstr;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+//--- Assign clusters to banks
+
+int compareClusterSize(const void *a, const void *b) {
+    const PlacementNode *nodeA = &nodes[*(const int *)a];
+    const PlacementNode *nodeB = &nodes[*(const int *)b];
+
+    // pinned clusters go first, then biggest to smallest
+    bool pinnedA = (nodeA->pinnedBank >= 0);
+    bool pinnedB = (nodeB->pinnedBank >= 0);
+    if (pinnedA != pinnedB) return pinnedA ? -1 : 1;
+    return nodeB->clusterSize - nodeA->clusterSize;
+}
+
+/**
+ * Calculate how strongly a cluster is tied to the blocks already in a bank
+ */
+int calcBankAffinity(int cluster, int bankNum) {
+    int bankAffinity = 0;
+    for_range(nodeIndex, 0, nodeCount) {
+        if (findCluster(nodeIndex) != cluster) continue;
+        for_range(otherNode, 0, nodeCount) {
+            if (nodes[otherNode].bank == bankNum) bankAffinity += AFFINITY(nodeIndex, otherNode);
+        }
+    }
+    return bankAffinity;
+}
+
+/**
+ * Put each cluster into the bank it has the most calls/data in common with.
+ *
+ * @return false if a cluster does not fit anywhere
+ */
+bool assignBanks(int stubArea) {
+    int banksUsed = bp_bankLayout->banksUsed;
+    for_range(bankNum, 0, banksUsed) { bankUsed[bankNum] = 0; }
+    for_range(nodeIndex, 0, nodeCount) { nodes[nodeIndex].bank = -1; }
+
+    int clusters[MAX_PLACED_BLOCKS];
+    int clusterCount = 0;
+    for_range(nodeIndex, 0, nodeCount) {
+        if (findCluster(nodeIndex) == nodeIndex) clusters[clusterCount++] = nodeIndex;
+    }
+    qsort(clusters, clusterCount, sizeof(int), compareClusterSize);
+
+    for_range(clusterIndex, 0, clusterCount) {
+        int cluster = clusters[clusterIndex];
+        int clusterSize = nodes[cluster].clusterSize;
+        int bestBank = -1;
+        int bestAffinity = -1;
+
+        for_range(bankNum, 0, banksUsed) {
+            if ((nodes[cluster].pinnedBank >= 0) && (nodes[cluster].pinnedBank != bankNum)) continue;
+            if (bp_bankLayout->banks[bankNum].isFixed && nodes[cluster].callsOut) continue;
+
+            int freeSpace = bankCapacity(bankNum, stubArea) - bankUsed[bankNum];
+            if (clusterSize > freeSpace) continue;
+
+            int bankAffinity = calcBankAffinity(cluster, bankNum);
+            bool isBetter = (bankAffinity > bestAffinity)
+                    || ((bankAffinity == bestAffinity)
+                        && (freeSpace > bankCapacity(bestBank, stubArea) - bankUsed[bestBank]));
+            if (isBetter) {
+                bestBank = bankNum;
+                bestAffinity = bankAffinity;
+            }
+        }
+
+        if (bestBank < 0) {
+            ErrorMessage("Unable to fit block into any bank", nodes[cluster].block->blockName, 0);
+            return false;
+        }
+
+        for_range(nodeIndex, 0, nodeCount) {
+            if (findCluster(nodeIndex) == cluster) nodes[nodeIndex].bank = bestBank;
+        }
+        bankUsed[bestBank] += clusterSize;
+    }
+    return true;
+}
+
+/**
+ * Check that data is in the same bank as all the code using it.
+ *
+ *  Data used from several banks is moved to the fixed bank (if there is one).
+ */
+void checkDataPlacement(int stubArea) {
+    for_range(dataNode, 0, nodeCount) {
+        if (IS_CODE_NODE(dataNode)) continue;
+        int dataBank = nodes[dataNode].bank;
+        if (bp_bankLayout->banks[dataBank].isFixed) continue;
+
+        for_range(codeNode, 0, nodeCount) {
+            if (!IS_CODE_NODE(codeNode) || (AFFINITY(codeNode, dataNode) < DATA_WEIGHT)) continue;
+            if (nodes[codeNode].bank == dataBank) continue;
+
+            // try moving data into the fixed bank
+            int fixedBank = bp_bankLayout->banksUsed - 1;
+            int dataSize = nodes[dataNode].block->blockSize;
+            if (bp_scheme->hasFixedBank
+                && (bankUsed[fixedBank] + dataSize <= bankCapacity(fixedBank, stubArea))) {
+                bankUsed[dataBank] -= dataSize;
+                bankUsed[fixedBank] += dataSize;
+                nodes[dataNode].bank = fixedBank;
+            } else {
+                char errStr[128];
+                snprintf(errStr, 128, "%s (used by %s)", nodes[dataNode].block->blockName,
+                         nodes[codeNode].block->blockName);
+                ErrorMessage("Data is used from more than one bank", errStr, 0);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Check that functions taking stack parameters aren't called thru a trampoline
+ */
+void checkStackParamCalls() {
+    for_range(index, 0, trampolineCount) {
+        int funcNode = trampolines[index].funcNode;
+        if (!hasStackParams(funcNode)) continue;
+
+        char errStr[128];
+        snprintf(errStr, 128, "%s (called from bank %d)", nodes[funcNode].block->blockName, trampolines[index].callerBank);
+        ErrorMessage("Function with stack parameters can't be called from another bank", errStr, 0);
+    }
+}
+
+//-----------------------------------------------------------------------
+//--- Trampolines
+
+int findTrampoline(int callerBank, int funcNode) {
+    for_range(index, 0, trampolineCount) {
+        if ((trampolines[index].callerBank == callerBank) && (trampolines[index].funcNode == funcNode)) return index;
+    }
+    return -1;
+}
+
+/**
+ * Find all calls that cross banks and determine the trampolines needed
+ *
+ * @return number of trampolines needed, or -1 if there are too many
+ */
+int collectTrampolines() {
+    trampolineCount = 0;
+    for_range(nodeIndex, 0, nodeCount) {
+        if (!IS_CODE_NODE(nodeIndex)) continue;
+        int callerBank = nodes[nodeIndex].bank;
+
+        Instr *instr = nodes[nodeIndex].block->codeBlock->firstInstr;
+        while (instr != NULL) {
+            int destNode = findCallDestination(instr);
+            if ((destNode >= 0) && (nodes[destNode].bank != callerBank)
+                && !bp_bankLayout->banks[nodes[destNode].bank].isFixed
+                && (findTrampoline(callerBank, destNode) < 0)) {
+
+                if (trampolineCount >= MAX_TRAMPOLINES) return -1;
+                trampolines[trampolineCount].callerBank = callerBank;
+                trampolines[trampolineCount].funcNode = destNode;
+                trampolines[trampolineCount].label = NULL;
+                trampolineCount++;
+            }
+            instr = instr->nextInstr;
+        }
+    }
+    return trampolineCount;
+}
+
+void emitBankSelect(int bankNum) {
+    if (bp_scheme->scheme == BANKING_3F) {
+        IL_AddInstrB(PHA);
+        IL_AddInstrN(LDA, ADDR_IMM, bankNum);
+        IL_AddInstrN(STA, ADDR_ZP, bp_scheme->hotspotAddr);
+        IL_AddInstrB(PLA);
+    } else {
+        IL_AddInstrN(BIT, ADDR_ABS, bp_scheme->hotspotAddr + bankNum);
+    }
+}
+
+/**
+ * Generate the boot code and trampolines for a bank
+ *
+ *   BankBoot:   <select main bank>       -- reset vector points here
+ *               JMP main
+ *   BSn_func:   <select func bank>       -- call to func from bank n
+ *               JSR func
+ *               <select bank n>
+ *               RTS
+ *
+ * @param blockName - name of the block
+ * @param addLabels - only one copy of the trampolines gets the labels
+ */
+InstrBlock *buildTrampolineCode(char *blockName, bool addLabels, int mainBank) {
+    InstrBlock *instrBlock = IB_StartInstructionBlock(blockName);
+    instrBlock->funcSym = newSymbol(blockName, SK_FUNC, ST_NONE, MF_NONE);
+    IL_SetLabel(NULL);      // don't pick up any label left over from the last function
+
+    if (addLabels) IL_Label(newLabel(BANK_BOOT_LABEL, LBL_CODE));
+    emitBankSelect(mainBank);
+    IL_AddInstrP(JMP, ADDR_ABS, compilerOptions.entryPointFuncName, PARAM_NORMAL);
+
+    for_range(index, 0, trampolineCount) {
+        Trampoline *trampoline = &trampolines[index];
+        PlacementNode *funcNode = &nodes[trampoline->funcNode];
+        if (addLabels) {
+            IL_Label(trampoline->label);
+            IL_SetLineComment("bank trampoline");
+        }
+        emitBankSelect(funcNode->bank);
+        IL_AddInstrP(JSR, ADDR_ABS, funcNode->block->blockName, PARAM_NORMAL);
+        emitBankSelect(trampoline->callerBank);
+        IL_AddInstrB(RTS);
+    }
+
+    instrBlock->codeSize = IL_GetCodeSize(instrBlock);
+    IB_CloseBlock();
+    return instrBlock;
+}
+
+OutputBlock *newTrampolineBlock(int bankNum, int stubArea, bool addLabels, int mainBank) {
+    char *blockName = allocMem(20);
+    sprintf(blockName, "BankTrampolines%d", bankNum);
+
+    OutputBlock *block = allocMem(sizeof(struct SOutputBlock));
+    memset(block, 0, sizeof(struct SOutputBlock));
+    block->blockType = BT_CODE;
+    block->blockName = blockName;
+    block->bankNum = bankNum;
+    block->blockAddr = BL_getUsableSize(bankNum) - stubArea;
+    block->blockSize = stubArea;
+    block->alignOffset = -1;
+    block->codeBlock = buildTrampolineCode(blockName, addLabels, mainBank);
+    block->symbol = block->codeBlock->funcSym;
+    setSymbolLocation(block->symbol, BL_getMachineAddr(bankNum) + block->blockAddr, SS_ROM);
+    return block;
+}
+
+//-----------------------------------------------------------------------
+//--- Final layout
+
+/**
+ * Lay out the blocks within each bank (keeping their original order)
+ *   and set the symbol locations.
+ *
+ * @return false if a bank overflowed (due to page alignment)
+ */
+bool layoutBanks(int stubArea) {
+    bool fits = true;
+    for_range(bankNum, 0, bp_bankLayout->banksUsed) {
+        int addr = 0;
+        for_range(nodeIndex, 0, nodeCount) {
+            OutputBlock *block = nodes[nodeIndex].block;
+            if (nodes[nodeIndex].bank != bankNum) continue;
+
+            if (block->alignOffset >= 0) {
+                int alignedAddr = (addr & 0xFF00) + block->alignOffset;
+                if (alignedAddr < addr) alignedAddr += 0x100;
+                addr = alignedAddr;
+            }
+            block->bankNum = bankNum;
+            block->blockAddr = addr;
+            addr += block->blockSize;
+            OB_SetBlockLocation(block);
+        }
+        bankUsed[bankNum] = addr;
+
+        if (addr > bankCapacity(bankNum, stubArea)) {
+            char errStr[64];
+            sprintf(errStr, "bank %d needs %d bytes, has %d", bankNum, addr, bankCapacity(bankNum, stubArea));
+            ErrorMessage("Code/data doesn't fit in bank", errStr, 0);
+            fits = false;
+        }
+    }
+    return fits;
+}
+
+/**
+ * Point cross-bank calls at the trampolines
+ */
+void redirectCrossBankCalls() {
+    for_range(nodeIndex, 0, nodeCount) {
+        if (!IS_CODE_NODE(nodeIndex)) continue;
+        int callerBank = nodes[nodeIndex].bank;
+
+        Instr *instr = nodes[nodeIndex].block->codeBlock->firstInstr;
+        while (instr != NULL) {
+            int destNode = findCallDestination(instr);
+            if (destNode >= 0) {
+                int trampolineIndex = findTrampoline(callerBank, destNode);
+                if (trampolineIndex >= 0) {
+                    instr->paramName = trampolines[trampolineIndex].label->name;
+                    IL_AddComment(instr, "cross-bank call");
+                }
+            }
+            instr = instr->nextInstr;
+        }
+    }
+}
+
+/**
+ * Set up trampoline labels and their locations (all copies are at the same address)
+ */
+void locateTrampolineLabels(int stubBank, int stubArea) {
+    int addr = BL_getMachineAddr(stubBank) + BL_getUsableSize(stubBank) - stubArea;
+
+    Label *bootLabel = findLabel(BANK_BOOT_LABEL);
+    if (bootLabel != NULL) {
+        bootLabel->location = addr;
+        bootLabel->hasLocation = true;
+    }
+    addr += bootCodeSize();
+
+    for_range(index, 0, trampolineCount) {
+        Label *label = trampolines[index].label;
+        label->location = addr;
+        label->hasLocation = true;
+        addr += trampolineSize();
+    }
+}
+
+void showBankPlacement(int stubArea) {
+    int crossBankWeight = 0;
+    for_range(nodeA, 0, nodeCount) {
+        for_range(nodeB, nodeA + 1, nodeCount) {
+            if (IS_CODE_NODE(nodeA) && IS_CODE_NODE(nodeB) && (nodes[nodeA].bank != nodes[nodeB].bank))
+                crossBankWeight += AFFINITY(nodeA, nodeB);
+        }
+    }
+
+    printf("\nBank placement (%s):\n", bp_scheme->name);
+    printf("------------------\n");
+    for_range(bankNum, 0, bp_bankLayout->banksUsed) {
+        printf("  %d: %5d of %5d bytes used\n", bankNum,
+               bankUsed[bankNum] + (bankHasStubs(bankNum) ? stubArea : 0), BL_getUsableSize(bankNum));
+    }
+    printf("  %d trampolines, %d cross-bank call sites\n", trampolineCount, crossBankWeight);
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Bank placement - figure out which bank each code/data block goes in
+ *
+ * @param mainSymTbl
+ */
+void BP_PlaceBlocks(SymbolTable *mainSymTbl) {
+    bp_bankLayout = BL_getBankLayout();
+    bp_scheme = BL_getBankingScheme();
+    if (!OB_UsesBankPlacement() || (bp_scheme == NULL)) return;
+
+    if (!collectBlocks() || (nodeCount == 0)) return;
+    buildAffinity();
+
+    //--- Place blocks... repeat if the trampolines take up more space than expected
+    int stubArea = calcStubAreaSize(0);
+    bool placed = false;
+    for_range(pass, 0, MAX_PLACEMENT_PASSES) {
+        int maxClusterSize = 0;
+        for_range(bankNum, 0, bp_bankLayout->banksUsed) {
+            int capacity = bankCapacity(bankNum, stubArea);
+            if (capacity > maxClusterSize) maxClusterSize = capacity;
+        }
+        clusterBlocks(maxClusterSize);
+        if (!assignBanks(stubArea)) return;
+
+        int numTrampolines = collectTrampolines();
+        if (numTrampolines < 0) {
+            ErrorMessage("Too many cross-bank calls", NULL, 0);
+            return;
+        }
+        int newStubArea = calcStubAreaSize(numTrampolines);
+        if (newStubArea <= stubArea) {
+            placed = true;
+            break;
+        }
+        stubArea = newStubArea;
+    }
+    if (!placed) {
+        ErrorMessage("Unable to place code into banks", bp_scheme->name, 0);
+        return;
+    }
+    checkDataPlacement(stubArea);
+    checkStackParamCalls();
+    if (!layoutBanks(stubArea)) return;
+
+    //--- Build trampolines and redirect calls to them
+    for_range(index, 0, trampolineCount) {
+        Trampoline *trampoline = &trampolines[index];
+        char *labelName = allocMem(SYMBOL_NAME_LIMIT);
+        snprintf(labelName, SYMBOL_NAME_LIMIT, "BS%d_%s",
+                 trampoline->callerBank, nodes[trampoline->funcNode].block->blockName);
+        trampoline->label = newLabel(labelName, LBL_CODE);
+    }
+    redirectCrossBankCalls();
+
+    int mainNode = findNodeByName(compilerOptions.entryPointFuncName);
+    int mainBank = (mainNode >= 0) ? nodes[mainNode].bank : 0;
+
+    OutputBlock *blockList[MAX_PLACED_BLOCKS + MAX_BANKS];
+    int blockCount = 0;
+    int stubBank = -1;
+    for_range(bankNum, 0, bp_bankLayout->banksUsed) {
+        for_range(nodeIndex, 0, nodeCount) {
+            if (nodes[nodeIndex].bank == bankNum) blockList[blockCount++] = nodes[nodeIndex].block;
+        }
+        if (bankHasStubs(bankNum)) {
+            bool addLabels = (stubBank < 0);
+            if (addLabels) stubBank = bankNum;
+            blockList[blockCount++] = newTrampolineBlock(bankNum, stubArea, addLabels, mainBank);
+        }
+    }
+    OB_RebuildList(blockList, blockCount);
+    locateTrampolineLabels(stubBank, stubArea);
+
+    //--- Now that blocks have their final location, check for page crossing branches
+    for_range(nodeIndex, 0, nodeCount) {
+        if (IS_CODE_NODE(nodeIndex)) OPT_CheckBranchAlignment(nodes[nodeIndex].block);
+    }
+
+    if (compilerOptions.showOutputBlockList) showBankPlacement(stubArea);
+    free(affinity);
+}
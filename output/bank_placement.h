@@ -0,0 +1,29 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef NEOLITHIC_BANK_PLACEMENT_H
+#define NEOLITHIC_BANK_PLACEMENT_H
+
+#include "data/symbols.h"
+
+// label used for the reset vector when bank-switching is used
+#define BANK_BOOT_LABEL "BankBoot"
+
+extern void BP_PlaceBlocks(SymbolTable *mainSymTbl);
+
+#endif //NEOLITHIC_BANK_PLACEMENT_H
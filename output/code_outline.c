@@ -0,0 +1,495 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Code Outline - move repeated code into shared subroutines  (-os)
+//
+//  Runs over all of the code blocks after code generation.  Runs of
+//  instructions that show up more than once (in any function) are copied
+//  into a new subroutine, and each copy is replaced by a JSR to it:
+//
+//      LDA enemyX,X          JSR outlined_1       outlined_1:
+//      STA RESP0                 ...                  LDA enemyX,X
+//      LDA enemyY,X          JSR outlined_1           STA RESP0
+//      STA ptr                                        LDA enemyY,X
+//                                                     STA ptr
+//                                                     RTS
+//
+//  A run of S bytes used N times saves  N*S - (N*3 + S + 1)  bytes.
+//  The best run is outlined first, then the search is repeated.
+//
+//  Each call costs 12 extra cycles and 2 bytes of stack, so:
+//   - the call can't go deeper than the stack has room for
+//   - code shown with #show_cycles, page aligned code, irq/nmi handlers
+//     and recursive functions are left alone
+//   - runs can't contain branches, jumps, stack instructions, or
+//     function-local variables, and only the first instruction can
+//     have a label  (it moves to the JSR)
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "code_outline.h"
+#include "output_block.h"
+#include "codegen/gen_alloc.h"
+#include "codegen/gen_common.h"
+#include "data/func_map.h"
+#include "optimizer/optimizer.h"
+
+enum {
+    MAX_OUTLINE_BLOCKS = 256,
+    MAX_SEQUENCE_LEN = 24,          // longest run of instructions to look for
+    MAX_OUTLINED = 64               // most subroutines to create
+};
+
+typedef struct {
+    Instr *instr;
+    int blockIndex;
+    int location;               // offset in code block
+    int size;
+    unsigned int hash;
+    bool canMove;               // can be moved into a subroutine
+    bool isJoin;                // has a label  (can only start a run)
+    int runLen;                 // number of instructions from here that can be moved together
+} CodeUnit;
+
+typedef struct {
+    OutputBlock *block;
+    SymbolTable *localSymTbl;
+    int funcDepth;
+    int oldAddr;
+    bool isChanged;
+} OutlineBlock;
+
+typedef struct {
+    int start;
+    unsigned int hash;
+} Window;
+
+typedef struct {
+    int start;
+    int len;
+    int size;
+    int savings;
+} Candidate;
+
+static OutlineBlock blocks[MAX_OUTLINE_BLOCKS];
+static int blockCount;
+
+static CodeUnit *units;
+static int unitCount;
+
+//-----------------------------------------------------------------------
+//--- Collect the code that can be outlined
+
+static bool isLocalName(const char *name, const SymbolTable *localSymTbl) {
+    if (name == NULL) return false;
+    return (name[0] == '.') || ((localSymTbl != NULL) && (findSymbol((SymbolTable *)localSymTbl, name) != NULL));
+}
+
+/**
+ * Check if an instruction does the same thing when moved into a subroutine
+ */
+static bool canMoveInstr(const Instr *instr, const SymbolTable *localSymTbl) {
+    if (isBranch(instr->mne) || instr->showCycles) return false;
+
+    switch (instr->mne) {
+        case JMP: case JSR: case RTS: case RTI: case BRK:
+        case PHA: case PLA: case PHP: case PLP: case TSX: case TXS:
+        case MNE_DATA: case MNE_DATA_WORD:
+            return false;
+        default:
+            break;
+    }
+    if ((instr->addrMode == ADDR_NONE) || (instr->addrMode == ADDR_ACC)) return true;
+
+    // locals are only known inside their function
+    return !isLocalName(instr->paramName, localSymTbl) && !isLocalName(instr->param2, localSymTbl);
+}
+
+static unsigned int hashString(const char *str, unsigned int hash) {
+    while (*str != '\0') hash = (hash * 31) + (unsigned char)*str++;
+    return hash;
+}
+
+/**
+ * Hash an instruction  (instructions that match with isSameInstr() have the same hash)
+ */
+static unsigned int hashInstr(const Instr *instr) {
+    unsigned int hash = (instr->mne * 64) + instr->addrMode;
+    if ((instr->addrMode == ADDR_NONE) || (instr->addrMode == ADDR_ACC)) return hash;
+
+    hash = (instr->paramName != NULL) ? hashString(instr->paramName, hash) : (hash * 31) + instr->offset;
+    if (instr->param2 != NULL) hash = hashString(instr->param2, hash);
+    return (hash * 31) + instr->paramExt;
+}
+
+/**
+ * Check if the code in a block can be outlined at all
+ */
+static bool isOutlineCandidate(const OutputBlock *block) {
+    if ((block->blockType != BT_CODE) || (block->codeBlock == NULL)) return false;
+    if ((block->alignOffset >= 0) || block->hasFixedAddr) return false;
+
+    const SymbolRecord *funcSym = block->codeBlock->funcSym;
+    if ((funcSym == NULL) || isSystemFunction(funcSym) || FM_isRecursive(funcSym)) return false;
+    if (!canUseCallStackDepth(funcSym->funcDepth + 1)) return false;
+
+    for (const Instr *curInstr = block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        if (curInstr->showCycles || (curInstr->mne == TSX)) return false;
+        if ((curInstr->mne == MNE_DATA) || (curInstr->mne == MNE_DATA_WORD)) return false;
+    }
+    return true;
+}
+
+/**
+ * Code in the range of a fixed offset branch (ex: BCC *+3) has to stay put
+ */
+static void markFixedSpans(int firstUnit) {
+    for_range(index, firstUnit, unitCount) {
+        const Instr *curInstr = units[index].instr;
+        bool isFixedBranch = isBranch(curInstr->mne) && (curInstr->addrMode == ADDR_REL) && (curInstr->paramName == NULL);
+        if (!isFixedBranch) continue;
+
+        int branchLoc = units[index].location;
+        int destLoc = branchLoc + curInstr->offset;
+        int spanStart = (destLoc < branchLoc) ? destLoc : (branchLoc + 2);
+        int spanEnd = (destLoc < branchLoc) ? (branchLoc + 2) : destLoc;
+
+        for_range(spanIdx, firstUnit, unitCount) {
+            int spanLoc = units[spanIdx].location;
+            if ((spanLoc == destLoc) || ((spanLoc >= spanStart) && (spanLoc < spanEnd))) units[spanIdx].canMove = false;
+        }
+    }
+}
+
+static void collectUnits(const OutlineBlock *outlineBlock, int blockIndex) {
+    int firstUnit = unitCount;
+    int location = 0;
+    bool hasLabel = false;
+
+    for (Instr *curInstr = outlineBlock->block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        if (curInstr->label != NULL) hasLabel = true;
+        if (curInstr->mne == MNE_NONE) continue;
+
+        CodeUnit *unit = &units[unitCount++];
+        unit->instr = curInstr;
+        unit->blockIndex = blockIndex;
+        unit->location = location;
+        unit->size = getInstrSize(curInstr->mne, curInstr->addrMode);
+        unit->hash = hashInstr(curInstr);
+        unit->canMove = canMoveInstr(curInstr, outlineBlock->localSymTbl);
+        unit->isJoin = hasLabel;
+        location += unit->size;
+        hasLabel = false;
+    }
+    markFixedSpans(firstUnit);
+
+    // work out how long a run can start at each instruction
+    for (int index = unitCount - 1; index >= firstUnit; index--) {
+        CodeUnit *unit = &units[index];
+        bool canExtend = (index + 1 < unitCount) && !units[index + 1].isJoin;
+        int runLen = !unit->canMove ? 0 : 1 + (canExtend ? units[index + 1].runLen : 0);
+        unit->runLen = (runLen > MAX_SEQUENCE_LEN) ? MAX_SEQUENCE_LEN : runLen;
+    }
+}
+
+/**
+ * Build the list of instructions from all of the code blocks that can be outlined
+ */
+static void collectCode() {
+    int instrCount = 0;
+    blockCount = 0;
+
+    OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
+    for (; (block != NULL) && (blockCount < MAX_OUTLINE_BLOCKS); block = block->nextBlock) {
+        if (!isOutlineCandidate(block)) continue;
+
+        OutlineBlock *outlineBlock = &blocks[blockCount++];
+        outlineBlock->block = block;
+        outlineBlock->localSymTbl = GET_LOCAL_SYMBOL_TABLE(block->codeBlock->funcSym);
+        outlineBlock->funcDepth = block->codeBlock->funcSym->funcDepth;
+        outlineBlock->oldAddr = block->blockAddr;
+        outlineBlock->isChanged = false;
+
+        for (const Instr *curInstr = block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+            instrCount++;
+        }
+    }
+    units = calloc(instrCount + 1, sizeof(CodeUnit));
+}
+
+/**
+ * Rebuild the instruction list  (after code was outlined)
+ */
+static void loadUnits() {
+    unitCount = 0;
+    for_range(blockIndex, 0, blockCount) {
+        collectUnits(&blocks[blockIndex], blockIndex);
+    }
+}
+
+//-----------------------------------------------------------------------
+//--- Find the repeated code that saves the most
+
+static bool isSameSequence(int start1, int start2, int len) {
+    if (blocks[units[start1].blockIndex].block->bankNum != blocks[units[start2].blockIndex].block->bankNum) return false;
+    for_range(index, 0, len) {
+        if (!isSameInstr(units[start1 + index].instr, units[start2 + index].instr)) return false;
+    }
+    return true;
+}
+
+static int getSequenceSize(int start, int len) {
+    int size = 0;
+    for_range(index, 0, len) { size += units[start + index].size; }
+    return size;
+}
+
+/**
+ * Count the copies of a run that don't overlap each other
+ *
+ * @param occurrences - (output) the start of each copy  (can be NULL)
+ */
+static int findCopies(int start, int len, int *occurrences) {
+    int count = 0;
+    int nextFree = 0;
+    for_range(index, 0, unitCount) {
+        if ((index < nextFree) || (units[index].runLen < len)) continue;
+        if ((index != start) && !isSameSequence(start, index, len)) continue;
+
+        if (occurrences != NULL) occurrences[count] = index;
+        count++;
+        nextFree = index + len;
+    }
+    return count;
+}
+
+static int cmpWindows(const void *a, const void *b) {
+    const Window *windowA = a;
+    const Window *windowB = b;
+    if (windowA->hash != windowB->hash) return (windowA->hash < windowB->hash) ? -1 : 1;
+    return windowA->start - windowB->start;
+}
+
+/**
+ * Find the repeated run of code that saves the most space when outlined
+ */
+static Candidate findBestCandidate() {
+    Candidate best = {0, 0, 0, 0};
+    Window *windows = calloc(unitCount + 1, sizeof(Window));
+
+    for_range(len, 2, MAX_SEQUENCE_LEN + 1) {
+        int windowCount = 0;
+        for_range(start, 0, unitCount) {
+            if (units[start].runLen < len) continue;
+
+            unsigned int hash = blocks[units[start].blockIndex].block->bankNum;
+            for_range(index, 0, len) { hash = (hash * 1000003) ^ units[start + index].hash; }
+            windows[windowCount].start = start;
+            windows[windowCount].hash = hash;
+            windowCount++;
+        }
+        qsort(windows, windowCount, sizeof(Window), cmpWindows);
+
+        // each group of windows with the same hash is (most likely) the same code
+        int groupStart = 0;
+        while (groupStart < windowCount) {
+            int groupEnd = groupStart + 1;
+            while ((groupEnd < windowCount) && (windows[groupEnd].hash == windows[groupStart].hash)) groupEnd++;
+
+            if (groupEnd - groupStart > 1) {
+                int start = windows[groupStart].start;
+                int size = getSequenceSize(start, len);
+                int copies = findCopies(start, len, NULL);
+
+                // each copy becomes a JSR, plus the subroutine needs an RTS
+                int savings = (copies * size) - ((copies * 3) + size + 1);
+                if (savings > best.savings) {
+                    Candidate candidate = {start, len, size, savings};
+                    best = candidate;
+                }
+            }
+            groupStart = groupEnd;
+        }
+    }
+
+    free(windows);
+    return best;
+}
+
+//-----------------------------------------------------------------------
+//--- Outline the code
+
+static char *makeOutlineName(const SymbolTable *mainSymTbl) {
+    static int outlineNum = 1;
+    char *name = allocMem(20);
+    do {
+        sprintf(name, "outlined_%d", outlineNum++);
+    } while ((findSymbol((SymbolTable *)mainSymTbl, name) != NULL) || (findLabel(name) != NULL));
+    return name;
+}
+
+/**
+ * Create the subroutine holding a copy of the code
+ */
+static SymbolRecord *buildSubroutine(SymbolTable *mainSymTbl, int start, int len) {
+    char *name = makeOutlineName(mainSymTbl);
+    SymbolRecord *funcSym = addSymbol(mainSymTbl, name, SK_FUNC, ST_NONE, MF_NONE);
+
+    InstrBlock *instrBlock = IB_StartInstructionBlock(name);
+    instrBlock->funcSym = funcSym;
+    funcSym->instrBlock = instrBlock;
+    IL_SetLabel(NULL);      // don't pick up any label left over from the last function
+
+    for_range(index, 0, len) {
+        Instr *newInstr = allocMem(sizeof(Instr));
+        *newInstr = *units[start + index].instr;
+        newInstr->label = (index == 0) ? newLabel(name, LBL_CODE) : NULL;
+        IB_AddInstr(instrBlock, newInstr);
+    }
+    IL_AddInstrB(RTS);
+
+    instrBlock->codeSize = IL_GetCodeSize(instrBlock);
+    IB_CloseBlock();
+    return funcSym;
+}
+
+/**
+ * Replace a copy of the code with a call to the subroutine
+ *   (the first instruction becomes the JSR, so it keeps any label)
+ */
+static void replaceWithCall(int start, int len, const char *funcName) {
+    OutlineBlock *outlineBlock = &blocks[units[start].blockIndex];
+    InstrBlock *instrBlock = outlineBlock->block->codeBlock;
+    Instr *jsrInstr = units[start].instr;
+    Instr *lastInstr = units[start + len - 1].instr;
+
+    jsrInstr->mne = JSR;
+    jsrInstr->addrMode = ADDR_ABS;
+    jsrInstr->paramName = funcName;
+    jsrInstr->param2 = NULL;
+    jsrInstr->paramExt = PARAM_NORMAL;
+    jsrInstr->lineComment = NULL;
+
+    jsrInstr->nextInstr = lastInstr->nextInstr;
+    if (lastInstr->nextInstr != NULL) {
+        lastInstr->nextInstr->prevInstr = jsrInstr;
+    } else {
+        instrBlock->lastInstr = jsrInstr;
+    }
+    instrBlock->curInstr = instrBlock->lastInstr;
+    outlineBlock->isChanged = true;
+}
+
+/**
+ * Outline the best candidate
+ * @return the subroutine created
+ */
+static SymbolRecord *outlineCandidate(SymbolTable *mainSymTbl, const Candidate *candidate) {
+    int *occurrences = calloc(unitCount + 1, sizeof(int));
+    int copies = findCopies(candidate->start, candidate->len, occurrences);
+
+    // the new calls go one level deeper than the code they came from
+    int deepestCall = 0;
+    for_range(index, 0, copies) {
+        int callDepth = blocks[units[occurrences[index]].blockIndex].funcDepth + 1;
+        if (callDepth > deepestCall) deepestCall = callDepth;
+    }
+    reserveCallStackDepth(deepestCall);
+
+    SymbolRecord *funcSym = buildSubroutine(mainSymTbl, candidate->start, candidate->len);
+    for_range(index, 0, copies) {
+        replaceWithCall(occurrences[index], candidate->len, funcSym->name);
+    }
+
+    if (compilerOptions.showOptimizerSteps) {
+        printf("\tOutlined %d bytes (%d copies) into %s, saving %d bytes\n",
+               candidate->size, copies, funcSym->name, candidate->savings);
+    }
+    free(occurrences);
+    return funcSym;
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Move repeated code into subroutines  (whole program, size optimization)
+ *
+ *  Blocks are then relocated and moved code is rechecked for page crossings
+ */
+void CO_OutlineCode(SymbolTable *mainSymbolTable) {
+    collectCode();
+
+    SymbolRecord *newFuncs[MAX_OUTLINED];
+    int newFuncBanks[MAX_OUTLINED];
+    int newFuncCount = 0;
+    int bytesSaved = 0;
+
+    while (newFuncCount < MAX_OUTLINED) {
+        loadUnits();
+        Candidate candidate = findBestCandidate();
+        if (candidate.savings <= 0) break;
+
+        newFuncBanks[newFuncCount] = blocks[units[candidate.start].blockIndex].block->bankNum;
+        newFuncs[newFuncCount++] = outlineCandidate(mainSymbolTable, &candidate);
+        bytesSaved += candidate.savings;
+    }
+    free(units);
+    if (newFuncCount == 0) return;
+
+    for_range(blockIndex, 0, blockCount) {
+        OutputBlock *block = blocks[blockIndex].block;
+        if (!blocks[blockIndex].isChanged) continue;
+        block->codeBlock->codeSize = IL_GetCodeSize(block->codeBlock);
+        block->blockSize = block->codeBlock->codeSize;
+    }
+
+    // the subroutines go at the start of the bank their callers are in
+    //   (code can fall off the end of main into whatever comes next)
+    int oldBlockCount = 0;
+    for (const OutputBlock *block = OB_getFirstBlock(); block != NULL; block = block->nextBlock) oldBlockCount++;
+
+    OutputBlock **blockList = calloc(oldBlockCount + newFuncCount, sizeof(OutputBlock *));
+    int listCount = 0;
+    for_range(funcIndex, 0, newFuncCount) {
+        OutputBlock *newBlock = GC_OB_AddCodeBlock(newFuncs[funcIndex]);
+        newBlock->bankNum = newFuncBanks[funcIndex];
+        blockList[listCount++] = newBlock;
+    }
+    OutputBlock *oldBlock = (OutputBlock *)OB_getFirstBlock();
+    for_range(index, 0, oldBlockCount) {
+        blockList[listCount++] = oldBlock;
+        oldBlock = oldBlock->nextBlock;
+    }
+    OB_RebuildList(blockList, listCount);
+    free(blockList);
+    OB_Relayout();
+
+    for_range(blockIndex, 0, blockCount) {
+        OutputBlock *block = blocks[blockIndex].block;
+        if (blocks[blockIndex].isChanged || (block->blockAddr != blocks[blockIndex].oldAddr)) {
+            OPT_CheckBranchAlignment(block);
+        }
+    }
+
+    if (compilerOptions.showGeneralInfo) {
+        printf("Outlined %d repeated code sequences into subroutines, saving %d bytes (call stack depth: %d)\n",
+               newFuncCount, bytesSaved, getCallStackDepth());
+    }
+}
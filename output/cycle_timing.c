@@ -0,0 +1,615 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Cycle Timing - work out the worst case number of cycles a function takes
+//
+//  Runs over the final code (after all code blocks are done being changed),
+//  so the result matches what actually ends up in the binary:
+//
+//   - each instruction uses its cycle count from the opcode table
+//   - taken branches add a cycle, plus one more if they cross a page
+//   - indexed reads are assumed to cross a page (add a cycle)
+//   - JSR adds the worst case of the called code
+//   - the RTS of a function table's dispatch routine adds the worst case
+//       of the functions in the table
+//
+//  The longest path thru the code is found, with each loop counted as:
+//
+//      (times it jumps back) * (longest trip around the loop)
+//                             + (longest way out of the loop)
+//
+//  The times a loop can jump back comes from the code generator
+//  ('loop' and simple 'for' loops with constant bounds, or '#max_loops n').
+//  Any loop without a known bound makes the timing unbounded.
+//
+//  '#cycle_budget n' in front of a function turns an overrun into an error,
+//  and '-vt<func>' shows the timing of any function.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle_timing.h"
+#include "output_block.h"
+#include "codegen/gen_common.h"
+#include "cpu_arch/instrs_dispatch.h"
+
+enum {
+    MAX_TIMING_BLOCKS = 512,
+    MAX_CYCLE_BUDGETS = 32,
+
+    UNREACHABLE = -1,           // path never gets to where it's going
+    NOT_DONE = -2,              // (not worked out yet)
+    UNBOUNDED = INT_MAX,
+
+    TOP_LEVEL = -1              // path goes until the code returns
+};
+
+/**
+ * Timing info for the code of one block
+ */
+typedef struct {
+    OutputBlock *block;
+    Instr **instrs;
+    int *addrs;                 // address of each instruction
+    int *destIndex;             // where each branch/jump goes in this block (-1 if elsewhere)
+    int *loopIndex;             // which loop each instruction starts (-1 if not a loop start)
+    int *loopStart;             // instruction that starts each loop
+    int *loopBound;             // most times each loop jumps back (-1 if not known)
+    int *memo;                  // [instr * (loopCount+1) + loop]  cycles to reach the loop start again (or return)
+    bool *onPath;
+    bool *isLoopActive;
+    int instrCount;
+    int loopCount;
+    bool isActive;              // being worked out  (used to catch recursion)
+} TimingInfo;
+
+typedef struct {
+    char *funcName;
+    int budget;
+    int lineNum;
+} CycleBudget;
+
+static TimingInfo timingInfo[MAX_TIMING_BLOCKS];
+static int timingInfoCount;
+
+static CycleBudget cycleBudgets[MAX_CYCLE_BUDGETS];
+static int cycleBudgetCount;
+
+static char unboundedReason[80];    // first thing that made the timing unbounded
+
+//-----------------------------------------------------------------------
+//  Cycle math  (keeps track of unreachable/unbounded)
+
+static int addCycles(int cycles1, int cycles2) {
+    if ((cycles1 < 0) || (cycles2 < 0)) return UNREACHABLE;
+    if ((cycles1 == UNBOUNDED) || (cycles2 == UNBOUNDED) || (cycles1 > UNBOUNDED - cycles2)) return UNBOUNDED;
+    return cycles1 + cycles2;
+}
+
+static int mulCycles(int times, int cycles) {
+    if (cycles < 0) return UNREACHABLE;
+    if ((times == 0) || (cycles == 0)) return 0;
+    if ((cycles == UNBOUNDED) || (cycles > UNBOUNDED / times)) return UNBOUNDED;
+    return times * cycles;
+}
+
+static int maxCycles(int cycles1, int cycles2) {
+    return (cycles1 > cycles2) ? cycles1 : cycles2;
+}
+
+static int markUnbounded(const char *reason, int addr) {
+    if (unboundedReason[0] == '\0') {
+        snprintf(unboundedReason, sizeof(unboundedReason), "%s @%4X", reason, addr);
+    }
+    return UNBOUNDED;
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Find the code block (and the instruction in it) called by a JSR/JMP
+ * @return index into timingInfo, or -1 if not found
+ */
+static int findCalledCode(const char *name, int *entryIndex) {
+    *entryIndex = 0;
+    for_range(index, 0, timingInfoCount) {
+        if (strcmp(timingInfo[index].block->blockName, name) == 0) return index;
+    }
+
+    // could also be a label inside of a block  (ex: bank trampolines)
+    for_range(index, 0, timingInfoCount) {
+        int instrIndex = 0;
+        for (const Instr *curInstr = timingInfo[index].block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+            if ((curInstr->label != NULL) && (strcmp(curInstr->label->name, name) == 0)) {
+                *entryIndex = instrIndex;
+                return index;
+            }
+            instrIndex++;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Find the instruction in a block with the label
+ * @return index of the instruction, or -1 if not in the block
+ */
+static int findLabelIndex(const TimingInfo *info, const char *labelName) {
+    Label *label = findLabel(labelName);
+    while ((label != NULL) && (label->link != NULL)) label = label->link;
+
+    for_range(index, 0, info->instrCount) {
+        const Label *instrLabel = info->instrs[index]->label;
+        if ((instrLabel != NULL) && ((instrLabel == label) || (strcmp(instrLabel->name, labelName) == 0))) return index;
+    }
+    return -1;
+}
+
+/**
+ * Find the instruction in a block at an address
+ * @return index of the instruction, or -1 if not in the block
+ */
+static int findAddrIndex(const TimingInfo *info, int addr) {
+    for_range(index, 0, info->instrCount + 1) {
+        if (info->addrs[index] == addr) return index;       // (can also be the end of the code)
+    }
+    return -1;
+}
+
+static bool isIndexedRead(const Instr *instr) {
+    if ((instr->addrMode != ADDR_ABX) && (instr->addrMode != ADDR_ABY) && (instr->addrMode != ADDR_IY)) return false;
+    switch (instr->mne) {
+        case LDA: case LDX: case LDY: case LAX:
+        case ADC: case SBC: case AND: case ORA: case EOR: case CMP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Get the cycles an instruction takes  (not counting a taken branch or a call)
+ */
+static int getInstrCycles(const Instr *instr) {
+    if ((instr->mne == MNE_NONE) || (instr->mne == MNE_DATA) || (instr->mne == MNE_DATA_WORD)) return 0;
+
+    int cycles = getCycleCount(instr->mne, instr->addrMode);
+    if (isIndexedRead(instr)) cycles++;         // may cross a page
+    return cycles;
+}
+
+static bool changesIndexReg(const Instr *instr, bool isRegX) {
+    switch (instr->mne) {
+        case LDX: case TAX: case TSX: case INX: case DEX: case LAX: case SBX:
+            return isRegX;
+        case LDY: case TAY: case INY: case DEY:
+            return !isRegX;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Check for a loop counted down with X or Y:
+ *
+ *          LDX #n
+ *   start: ...         (nothing else changes X)
+ *          DEX
+ *          BNE start
+ *
+ * @return times the loop jumps back, or -1 if not a counted loop
+ */
+static int getCountedLoopBound(const TimingInfo *info, int startIndex, int branchIndex) {
+    if ((startIndex < 1) || (branchIndex < 1) || (info->instrs[branchIndex]->mne != BNE)) return -1;
+
+    const Instr *countInstr = info->instrs[branchIndex - 1];
+    const Instr *loadInstr = info->instrs[startIndex - 1];
+    bool isCountX = (countInstr->mne == DEX) && (loadInstr->mne == LDX);
+    bool isCountY = (countInstr->mne == DEY) && (loadInstr->mne == LDY);
+    if ((!isCountX && !isCountY) || (loadInstr->addrMode != ADDR_IMM) || (loadInstr->paramName != NULL)) return -1;
+
+    for_range(index, startIndex, branchIndex - 1) {
+        const Instr *instr = info->instrs[index];
+        if ((instr->mne == JSR) || (instr->label != NULL && index != startIndex)) return -1;
+        if (changesIndexReg(instr, isCountX)) return -1;
+    }
+
+    int count = loadInstr->offset & 0xff;
+    return ((count == 0) ? 256 : count) - 1;
+}
+
+static void prepTimingInfo(TimingInfo *info) {
+    int instrCount = 0;
+    for (Instr *curInstr = info->block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) instrCount++;
+    info->instrCount = instrCount;
+
+    info->instrs = calloc(instrCount + 1, sizeof(Instr *));
+    info->addrs = calloc(instrCount + 1, sizeof(int));
+    info->destIndex = calloc(instrCount + 1, sizeof(int));
+    info->loopIndex = calloc(instrCount + 1, sizeof(int));
+    info->loopStart = calloc(instrCount + 1, sizeof(int));
+    info->loopBound = calloc(instrCount + 1, sizeof(int));
+    info->onPath = calloc(instrCount + 1, sizeof(bool));
+    info->isLoopActive = calloc(instrCount + 1, sizeof(bool));
+
+    int index = 0;
+    int addr = info->block->blockAddr;
+    for (Instr *curInstr = info->block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        info->instrs[index] = curInstr;
+        info->addrs[index] = addr;
+        addr += getInstrSize(curInstr->mne, curInstr->addrMode);
+        index++;
+    }
+    info->addrs[instrCount] = addr;
+
+    for_range(instrIndex, 0, instrCount) {
+        const Instr *instr = info->instrs[instrIndex];
+        bool hasDest = (isBranch(instr->mne) || (instr->mne == JMP)) && (instr->addrMode != ADDR_IND);
+        if (hasDest && (instr->paramName != NULL)) {
+            info->destIndex[instrIndex] = findLabelIndex(info, instr->paramName);
+        } else if (hasDest && (instr->addrMode == ADDR_REL)) {
+            info->destIndex[instrIndex] = findAddrIndex(info, info->addrs[instrIndex] + instr->offset);   // (BCC *+4)
+        } else {
+            info->destIndex[instrIndex] = -1;
+        }
+    }
+
+    // find the loops  (from the code generator, or counted with X/Y)
+    int loopCount = 0;
+    for_range(instrIndex, 0, instrCount) {
+        const Label *label = info->instrs[instrIndex]->label;
+        int loopBound = ((label != NULL) && (label->type == LBL_LOOP_START)) ? label->loopBound : -1;
+        bool isLoopStart = (label != NULL) && (label->type == LBL_LOOP_START);
+
+        for_range(branchIndex, instrIndex, instrCount) {
+            if (info->destIndex[branchIndex] != instrIndex) continue;
+            int countedBound = getCountedLoopBound(info, instrIndex, branchIndex);
+            if (countedBound >= 0) {
+                isLoopStart = true;
+                if (loopBound < 0) loopBound = countedBound;
+            }
+        }
+
+        info->loopIndex[instrIndex] = isLoopStart ? loopCount : -1;
+        if (isLoopStart) {
+            info->loopStart[loopCount] = instrIndex;
+            info->loopBound[loopCount] = loopBound;
+            loopCount++;
+        }
+    }
+    info->loopCount = loopCount;
+
+    int memoSize = instrCount * (loopCount + 1);
+    info->memo = calloc(memoSize + 1, sizeof(int));
+    for_range(memoIndex, 0, memoSize) { info->memo[memoIndex] = NOT_DONE; }
+}
+
+static void freeTimingInfo(TimingInfo *info) {
+    if (info->instrs == NULL) return;
+    free(info->instrs);
+    free(info->addrs);
+    free(info->destIndex);
+    free(info->loopIndex);
+    free(info->loopStart);
+    free(info->loopBound);
+    free(info->memo);
+    free(info->onPath);
+    free(info->isLoopActive);
+    info->instrs = NULL;
+}
+
+//-----------------------------------------------------------------------
+
+static int calcCodeTiming(int infoIndex, int entryIndex);
+
+/**
+ * Get the worst case cycles of the code called by a JSR/JMP
+ */
+static int calcCalledTiming(const TimingInfo *info, int index) {
+    const Instr *instr = info->instrs[index];
+    if ((instr->addrMode != ADDR_ABS) || (instr->paramName == NULL)) {
+        return markUnbounded("Unknown call", info->addrs[index]);
+    }
+
+    int entryIndex;
+    int calledIndex = findCalledCode(instr->paramName, &entryIndex);
+    if (calledIndex < 0) return markUnbounded("Unknown call", info->addrs[index]);
+    if (timingInfo[calledIndex].isActive) return markUnbounded("Recursive call", info->addrs[index]);
+
+    return calcCodeTiming(calledIndex, entryIndex);
+}
+
+/**
+ * Get the worst case cycles of the functions a dispatch routine can go to
+ *   (0 if the block isn't a dispatch routine)
+ */
+static int calcDispatchTiming(const TimingInfo *info, int index) {
+    const List *funcList = ICG_GetDispatchTargets(info->block->blockName);
+    if (funcList == NULL) return 0;
+
+    int maxTiming = 0;
+    for_range(funcIndex, 1, funcList->count) {
+        int entryIndex;
+        int calledIndex = findCalledCode(funcList->nodes[funcIndex].value.str, &entryIndex);
+        if (calledIndex < 0) return markUnbounded("Unknown call", info->addrs[index]);
+        if (timingInfo[calledIndex].isActive) return markUnbounded("Recursive call", info->addrs[index]);
+
+        maxTiming = maxCycles(maxTiming, calcCodeTiming(calledIndex, entryIndex));
+    }
+    return maxTiming;
+}
+
+static int calcPathTiming(TimingInfo *info, int index, int targetLoop);
+
+/**
+ * Get the worst case cycles from an instruction to the target
+ *   (either back to the start of the target loop, or to the return)
+ */
+static int calcInstrTiming(TimingInfo *info, int index, int targetLoop) {
+    const Instr *instr = info->instrs[index];
+    int cycles = getInstrCycles(instr);
+    int destIndex = info->destIndex[index];
+
+    switch (instr->mne) {
+        case RTS:
+            if (targetLoop != TOP_LEVEL) return UNREACHABLE;
+            return addCycles(cycles, calcDispatchTiming(info, index));
+
+        case RTI: case BRK:
+            return (targetLoop == TOP_LEVEL) ? cycles : UNREACHABLE;
+
+        case JSR:
+            cycles = addCycles(cycles, calcCalledTiming(info, index));
+            return addCycles(cycles, calcPathTiming(info, index + 1, targetLoop));
+
+        case JMP:
+            if (destIndex >= 0) return addCycles(cycles, calcPathTiming(info, destIndex, targetLoop));
+
+            // jumping to other code  (it returns for us)
+            if (targetLoop != TOP_LEVEL) return UNREACHABLE;
+            return addCycles(cycles, calcCalledTiming(info, index));
+
+        default:
+            break;
+    }
+
+    int nextCycles = addCycles(cycles, calcPathTiming(info, index + 1, targetLoop));
+    if (!isBranch(instr->mne)) return nextCycles;
+
+    // branch taken:  +1 cycle, +1 more if the destination is on a different page
+    int branchCycles = cycles + 1;
+    int branchAddr = info->addrs[index] + 2;
+    if (destIndex >= 0) {
+        if ((branchAddr >> 8) != (info->addrs[destIndex] >> 8)) branchCycles++;
+        branchCycles = addCycles(branchCycles, calcPathTiming(info, destIndex, targetLoop));
+    } else {
+        branchCycles = (targetLoop == TOP_LEVEL) ? markUnbounded("Branch out of code", info->addrs[index]) : UNREACHABLE;
+    }
+    return maxCycles(nextCycles, branchCycles);
+}
+
+/**
+ * Get the worst case cycles from an instruction to the target (memoized)
+ *
+ *  When a loop start is reached, the loop is collapsed into:
+ *     loopBound * (trip around loop) + (way out of loop)
+ */
+static int calcPathTiming(TimingInfo *info, int index, int targetLoop) {
+    if (index >= info->instrCount) return (targetLoop == TOP_LEVEL) ? 0 : UNREACHABLE;
+
+    int loopIndex = info->loopIndex[index];
+    if ((loopIndex >= 0) && (loopIndex == targetLoop)) return 0;
+    if ((loopIndex >= 0) && info->isLoopActive[loopIndex]) return UNREACHABLE;     // (loop being left)
+
+    int *memo = &info->memo[index * (info->loopCount + 1) + (targetLoop + 1)];
+    if (*memo != NOT_DONE) return *memo;
+
+    // code that loops back without a loop start  (ex: asm code)
+    if (info->onPath[index]) return markUnbounded("Loop without a bound", info->addrs[index]);
+    info->onPath[index] = true;
+
+    int cycles;
+    if (loopIndex >= 0) {
+        info->isLoopActive[loopIndex] = true;
+        int tripCycles = calcInstrTiming(info, index, loopIndex);
+        info->isLoopActive[loopIndex] = false;
+
+        // the way out can't go back to the start of the loop either
+        info->isLoopActive[loopIndex] = true;
+        int exitCycles = calcInstrTiming(info, index, targetLoop);
+        info->isLoopActive[loopIndex] = false;
+
+        int loopBound = info->loopBound[loopIndex];
+        if (tripCycles == UNREACHABLE) {
+            cycles = exitCycles;
+        } else if (loopBound < 0) {
+            // (when looking for the way back to an outer loop, only matters if this loop leads there)
+            bool leadsToTarget = (exitCycles != UNREACHABLE) || (targetLoop == TOP_LEVEL);
+            cycles = leadsToTarget ? markUnbounded("Loop without a bound", info->addrs[index]) : UNREACHABLE;
+        } else {
+            cycles = addCycles(mulCycles(loopBound, tripCycles), exitCycles);
+            if (exitCycles == UNREACHABLE) cycles = UNREACHABLE;
+        }
+    } else {
+        cycles = calcInstrTiming(info, index, targetLoop);
+    }
+
+    info->onPath[index] = false;
+    *memo = cycles;
+    return cycles;
+}
+
+/**
+ * Get the worst case cycles of a block's code  (starting at the entry instruction)
+ */
+static int calcCodeTiming(int infoIndex, int entryIndex) {
+    TimingInfo *info = &timingInfo[infoIndex];
+    if (info->instrs == NULL) prepTimingInfo(info);
+
+    info->isActive = true;
+    int cycles = calcPathTiming(info, entryIndex, TOP_LEVEL);
+    info->isActive = false;
+
+    return (cycles == UNREACHABLE) ? 0 : cycles;
+}
+
+//-----------------------------------------------------------------------
+
+static void collectCodeBlocks() {
+    timingInfoCount = 0;
+
+    OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
+    for (; (block != NULL) && (timingInfoCount < MAX_TIMING_BLOCKS); block = block->nextBlock) {
+        if ((block->blockType != BT_CODE) || (block->codeBlock == NULL)) continue;
+
+        TimingInfo *info = &timingInfo[timingInfoCount++];
+        memset(info, 0, sizeof(TimingInfo));
+        info->block = block;
+    }
+}
+
+/**
+ * Get the most times an instruction can run in one call of its code
+ *   (each loop it's inside of multiplies it)
+ */
+static int calcTimesRun(const TimingInfo *info, int index) {
+    int timesRun = 1;
+    for_range(loopIndex, 0, info->loopCount) {
+        int tripCycles = info->memo[index * (info->loopCount + 1) + (loopIndex + 1)];
+        bool isInLoop = (tripCycles >= 0) || (info->loopStart[loopIndex] == index);
+        if (!isInLoop) continue;
+
+        int loopBound = info->loopBound[loopIndex];
+        if (loopBound < 0) return UNBOUNDED;
+        timesRun = mulCycles(loopBound + 1, timesRun);
+    }
+    return timesRun;
+}
+
+static void printCallSites(const TimingInfo *info) {
+    bool hasCalls = false;
+    for_range(index, 0, info->instrCount) {
+        const Instr *instr = info->instrs[index];
+        if ((instr->mne != JSR) || (instr->paramName == NULL)) continue;
+        if (!hasCalls) printf("      times   cycles   call\n");
+        hasCalls = true;
+
+        int entryIndex;
+        int calledIndex = findCalledCode(instr->paramName, &entryIndex);
+        int calledCycles = (calledIndex >= 0) ? calcCodeTiming(calledIndex, entryIndex) : UNBOUNDED;
+        int timesRun = calcTimesRun(info, index);
+
+        char timesStr[12], cyclesStr[12];
+        if (timesRun == UNBOUNDED) strcpy(timesStr, "?"); else sprintf(timesStr, "%d", timesRun);
+        if (calledCycles == UNBOUNDED) strcpy(cyclesStr, "?"); else sprintf(cyclesStr, "%d", calledCycles + 6);
+        printf("    %7s  %7s   JSR %-24s @%4X\n", timesStr, cyclesStr, instr->paramName, info->addrs[index]);
+    }
+}
+
+static void showFuncTiming(const char *funcName, int cycles, int budget, const TimingInfo *info) {
+    if (cycles == UNBOUNDED) {
+        printf("\nWorst case timing of %s: unbounded  (%s)\n", funcName, unboundedReason);
+    } else if (budget >= 0) {
+        printf("\nWorst case timing of %s: %d cycles  (budget: %d)\n", funcName, cycles, budget);
+    } else {
+        printf("\nWorst case timing of %s: %d cycles\n", funcName, cycles);
+    }
+    printCallSites(info);
+}
+
+static bool isTimingShown(const char *funcName) {
+    return (compilerOptions.timingFuncName != NULL) && (strcmp(compilerOptions.timingFuncName, funcName) == 0);
+}
+
+/**
+ * Work out the worst case cycles of a function
+ *   (shown when picked with '-vt', or when it runs over its budget)
+ *
+ * @param funcName - function to check
+ * @param budget - most cycles allowed  (-1 if no budget)
+ * @param lineNum - line of the '#cycle_budget' (for errors)
+ */
+static void checkFuncTiming(const char *funcName, int budget, int lineNum) {
+    int entryIndex;
+    int infoIndex = findCalledCode(funcName, &entryIndex);
+    if (infoIndex < 0) {
+        WarningMessage("Unable to work out timing of function (not in the output)", funcName, lineNum);
+        return;
+    }
+
+    unboundedReason[0] = '\0';
+    int cycles = calcCodeTiming(infoIndex, entryIndex);
+
+    bool isOverBudget = (budget >= 0) && ((cycles == UNBOUNDED) || (cycles > budget));
+    if (isOverBudget || isTimingShown(funcName)) {
+        showFuncTiming(funcName, cycles, budget, &timingInfo[infoIndex]);
+    }
+
+    if (budget < 0) return;
+
+    char errStr[120];
+    if (cycles == UNBOUNDED) {
+        snprintf(errStr, sizeof(errStr), "%s: %s  (use #max_loops)", funcName, unboundedReason);
+        ErrorMessage("Unable to work out worst case timing", errStr, lineNum);
+    } else if (cycles > budget) {
+        snprintf(errStr, sizeof(errStr), "%s: %d cycles, budget is %d", funcName, cycles, budget);
+        ErrorMessage("Function runs over its cycle budget", errStr, lineNum);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Set the most cycles a function is allowed to take  ('#cycle_budget n')
+ */
+void CT_SetCycleBudget(char *funcName, int budget, int lineNum) {
+    if (cycleBudgetCount >= MAX_CYCLE_BUDGETS) {
+        WarningMessage("Too many cycle budgets", funcName, lineNum);
+        return;
+    }
+    CycleBudget *cycleBudget = &cycleBudgets[cycleBudgetCount++];
+    cycleBudget->funcName = funcName;
+    cycleBudget->budget = budget;
+    cycleBudget->lineNum = lineNum;
+}
+
+/**
+ * Check the worst case timing of each function with a cycle budget
+ *   (and show the timing of the function picked with '-vt')
+ */
+void CT_CheckCycleBudgets() {
+    if ((cycleBudgetCount == 0) && (compilerOptions.timingFuncName == NULL)) return;
+
+    collectCodeBlocks();
+
+    bool hasShownTiming = false;
+    for_range(budgetIndex, 0, cycleBudgetCount) {
+        CycleBudget *cycleBudget = &cycleBudgets[budgetIndex];
+        checkFuncTiming(cycleBudget->funcName, cycleBudget->budget, cycleBudget->lineNum);
+        if (isTimingShown(cycleBudget->funcName)) hasShownTiming = true;
+    }
+    if ((compilerOptions.timingFuncName != NULL) && !hasShownTiming) {
+        checkFuncTiming(compilerOptions.timingFuncName, -1, 0);
+    }
+
+    for_range(index, 0, timingInfoCount) {
+        freeTimingInfo(&timingInfo[index]);
+    }
+}
@@ -0,0 +1,25 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef NEOLITHIC_CYCLE_TIMING_H
+#define NEOLITHIC_CYCLE_TIMING_H
+
+extern void CT_SetCycleBudget(char *funcName, int budget, int lineNum);
+extern void CT_CheckCycleBudgets();
+
+#endif //NEOLITHIC_CYCLE_TIMING_H
@@ -0,0 +1,290 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Data Merge - share ROM space between constant tables
+//
+//  Runs over the data blocks after code generation (before the final layout):
+//
+//   - tables that are byte-identical to (or contained within) another table
+//     are removed and their symbol points into the other table.
+//   - when the end of one table matches the start of another, the second
+//     table is appended to the first so the matching bytes are shared.
+//
+//  Merged blocks hang off of the block that holds their data (mergedBlocks),
+//  so their symbol follows the host block wherever it ends up.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data_merge.h"
+#include "output_block.h"
+#include "codegen/gen_common.h"
+#include "data/syntax_tree.h"
+#include "optimizer/optimizer.h"
+
+enum { MAX_MERGE_TABLES = 256 };
+
+typedef struct {
+    OutputBlock *block;
+    unsigned char *data;
+    int size;
+    int elementSize;
+    bool canMove;       // can be placed inside of another block
+    bool isMerged;
+} MergeTable;
+
+static MergeTable tables[MAX_MERGE_TABLES];
+static int tableCount;
+
+//-----------------------------------------------------------------------
+
+/**
+ * Get the bytes that will be output for a data block
+ *
+ * @return false if the data can't be determined (non-numeric values)
+ */
+bool loadTableData(MergeTable *table) {
+    const List *dataList = table->block->dataList;
+    int elementSize = table->elementSize;
+
+    table->size = (dataList->count - 1) * elementSize;
+    table->data = allocMem(table->size + 1);
+
+    int writeIndex = 0;
+    for_range(index, 1, dataList->count) {
+        if (dataList->nodes[index].type != N_INT) return false;
+
+        int value = dataList->nodes[index].value.num;
+        table->data[writeIndex++] = value & 0xff;
+        if (elementSize > 1) table->data[writeIndex++] = (value >> 8) & 0xff;
+    }
+    return true;
+}
+
+bool isMergeCandidate(const OutputBlock *block) {
+    return (block->blockType == BT_DATA) && (block->dataList != NULL) && (block->dataList->count > 1);
+}
+
+void collectTables() {
+    tableCount = 0;
+    OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
+    while ((block != NULL) && (tableCount < MAX_MERGE_TABLES)) {
+        if (isMergeCandidate(block)) {
+            MergeTable *table = &tables[tableCount];
+            table->block = block;
+            table->elementSize = (getBaseVarSize(block->symbol) > 1) ? 2 : 1;
+            table->canMove = (block->alignOffset < 0) && !block->hasFixedAddr;
+            table->isMerged = false;
+            if (loadTableData(table)) tableCount++;
+        }
+        block = block->nextBlock;
+    }
+}
+
+/**
+ * Can these two tables share space?  (they need to end up in the same bank)
+ */
+bool canShareSpace(const MergeTable *table, const MergeTable *hostTable) {
+    return (table != hostTable) && !table->isMerged && !hostTable->isMerged
+           && (table->block->bankNum == hostTable->block->bankNum)
+           && (table->block->isBankPinned == hostTable->block->isBankPinned);
+}
+
+//-----------------------------------------------------------------------
+//--- Duplicate and contained tables
+
+/**
+ * Find where the data for table is found inside hostTable
+ * @return offset into hostTable, or -1 if not found
+ */
+int findTableData(const MergeTable *table, const MergeTable *hostTable) {
+    int lastOfs = hostTable->size - table->size;
+    for (int ofs = 0; ofs <= lastOfs; ofs++) {
+        if (memcmp(&(hostTable->data[ofs]), table->data, table->size) == 0) return ofs;
+    }
+    return -1;
+}
+
+int compareTableSize(const void *a, const void *b) {
+    const MergeTable *tableA = &tables[*(const int *)a];
+    const MergeTable *tableB = &tables[*(const int *)b];
+    if (tableA->size != tableB->size) return tableB->size - tableA->size;
+    return *(const int *)a - *(const int *)b;      // keep original order for same size tables
+}
+
+/**
+ * Remove tables whose data is already found in another table
+ *
+ * @return number of bytes saved
+ */
+int mergeContainedTables() {
+    int bytesSaved = 0;
+
+    // check biggest tables first, so smaller ones end up in the biggest
+    int order[MAX_MERGE_TABLES];
+    for_range(index, 0, tableCount) { order[index] = index; }
+    qsort(order, tableCount, sizeof(int), compareTableSize);
+
+    for_range(orderIndex, 1, tableCount) {
+        MergeTable *table = &tables[order[orderIndex]];
+        if (!table->canMove) continue;
+
+        for_range(hostIndex, 0, orderIndex) {
+            MergeTable *hostTable = &tables[order[hostIndex]];
+            if (!canShareSpace(table, hostTable)) continue;
+
+            int ofs = findTableData(table, hostTable);
+            if (ofs >= 0) {
+                OB_MergeBlockInto(table->block, hostTable->block, ofs);
+                table->isMerged = true;
+                bytesSaved += table->size;
+                break;
+            }
+        }
+    }
+    return bytesSaved;
+}
+
+//-----------------------------------------------------------------------
+//--- Overlapping tables
+
+/**
+ * Find how many bytes at the end of table match the start of nextTable
+ *   (only whole elements are shared)
+ */
+int calcOverlap(const MergeTable *table, const MergeTable *nextTable) {
+    int maxOverlap = (table->size < nextTable->size) ? table->size : nextTable->size;
+    for (int overlap = maxOverlap - 1; overlap > 0; overlap--) {
+        if ((overlap % table->elementSize) != 0) continue;
+        if (memcmp(&(table->data[table->size - overlap]), nextTable->data, overlap) == 0) return overlap;
+    }
+    return 0;
+}
+
+/**
+ * Append the non-overlapping part of nextTable to the end of table,
+ *   and place nextTable inside of table.
+ */
+void appendTable(MergeTable *table, MergeTable *nextTable, int overlap) {
+    OutputBlock *block = table->block;
+    int skipElements = overlap / table->elementSize;
+    const List *nextList = nextTable->block->dataList;
+
+    // build a new list (the symbol keeps its original data)
+    List *combinedList = createList(block->dataList->count + nextList->count);
+    for_range(index, 0, block->dataList->count) {
+        addNode(combinedList, block->dataList->nodes[index]);
+    }
+    for_range(index, skipElements + 1, nextList->count) {
+        addNode(combinedList, nextList->nodes[index]);
+    }
+    combinedList->lineNum = block->dataList->lineNum;
+
+    int nextTableOfs = table->size - overlap;
+    block->dataList = combinedList;
+    block->blockSize += nextTable->size - overlap;
+
+    OB_MergeBlockInto(nextTable->block, block, nextTableOfs);
+    nextTable->isMerged = true;
+
+    // reload data, so the combined table can be checked against other tables
+    free(table->data);
+    loadTableData(table);
+}
+
+/**
+ * Chain together tables where the end of one matches the start of another
+ *
+ * @return number of bytes saved
+ */
+int mergeOverlappingTables() {
+    int bytesSaved = 0;
+    for (;;) {
+        int bestOverlap = 0;
+        MergeTable *bestTable = NULL;
+        MergeTable *bestNextTable = NULL;
+
+        for_range(tableIndex, 0, tableCount) {
+            MergeTable *table = &tables[tableIndex];
+            for_range(nextIndex, 0, tableCount) {
+                MergeTable *nextTable = &tables[nextIndex];
+                if (!nextTable->canMove || !canShareSpace(nextTable, table)) continue;
+                if (table->elementSize != nextTable->elementSize) continue;
+
+                int overlap = calcOverlap(table, nextTable);
+                if (overlap > bestOverlap) {
+                    bestOverlap = overlap;
+                    bestTable = table;
+                    bestNextTable = nextTable;
+                }
+            }
+        }
+        if (bestOverlap == 0) break;
+
+        appendTable(bestTable, bestNextTable, bestOverlap);
+        bytesSaved += bestOverlap;
+    }
+    return bytesSaved;
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Share ROM space between identical/overlapping constant tables
+ *
+ *  Blocks are then relocated (unless bank placement will be doing that)
+ */
+void DM_MergeData() {
+    collectTables();
+    if (tableCount < 2) return;
+
+    int tablesBefore = tableCount;
+    int bytesSaved = mergeContainedTables();
+    bytesSaved += mergeOverlappingTables();
+
+    int tablesMerged = 0;
+    for_range(index, 0, tableCount) {
+        if (tables[index].isMerged) tablesMerged++;
+        free(tables[index].data);
+    }
+    if (tablesMerged == 0) return;
+
+    if (!OB_UsesBankPlacement()) {
+        // remember where code was, so moved code can be rechecked for page crossings
+        int oldCodeAddr[MAX_MERGE_TABLES * 2];
+        int codeCount = 0;
+        const OutputBlock *block = OB_getFirstBlock();
+        for (; (block != NULL) && (codeCount < MAX_MERGE_TABLES * 2); block = block->nextBlock) {
+            if (block->blockType == BT_CODE) oldCodeAddr[codeCount++] = block->blockAddr;
+        }
+
+        OB_Relayout();
+
+        codeCount = 0;
+        OutputBlock *codeBlock = (OutputBlock *)OB_getFirstBlock();
+        for (; (codeBlock != NULL) && (codeCount < MAX_MERGE_TABLES * 2); codeBlock = codeBlock->nextBlock) {
+            if (codeBlock->blockType != BT_CODE) continue;
+            if (codeBlock->blockAddr != oldCodeAddr[codeCount++]) OPT_CheckBranchAlignment(codeBlock);
+        }
+    }
+
+    if (compilerOptions.showGeneralInfo) {
+        printf("Merged %d of %d data tables, saving %d bytes\n", tablesMerged, tablesBefore, bytesSaved);
+    }
+}
@@ -46,6 +46,12 @@ enum Machines curMachine;
 static int curAddr;
 static int curBank;
 static int blockCount;
+static int bankAddr[MAX_BANKS];     // next free address in each bank
+static int pendingAlignOffset;      // page alignment requested for next block
+static bool pendingFixedAddr;       // address of next block was set by the user
+static bool bankSetByUser;
+static bool useBankPlacement;       // banks are assigned after code generation
+static bool isLayoutFinal;          // blocks won't be shrinking anymore  (see OB_CheckBlocksFit)
 
 void DEBUG_printFirstBlockPtr(char *funcName) {
     OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
@@ -59,6 +65,12 @@ void OB_Init() {
     curAddr = 0;
     curBank = 0;
     blockCount = 0;
+    pendingAlignOffset = -1;
+    pendingFixedAddr = false;
+    bankSetByUser = false;
+    useBankPlacement = false;
+    isLayoutFinal = false;
+    for_range(bankNum, 0, MAX_BANKS) { bankAddr[bankNum] = 0; }
 }
 
 void OB_AddBlock(OutputBlock *newBlock) {
@@ -66,7 +78,13 @@ void OB_AddBlock(OutputBlock *newBlock) {
     // set location of block (NOTE: linear allocation)
     newBlock->blockAddr = curAddr;
     newBlock->bankNum = curBank;
+    newBlock->isBankPinned = bankSetByUser;
+    newBlock->alignOffset = pendingAlignOffset;
+    newBlock->hasFixedAddr = pendingFixedAddr;
+    newBlock->mergedBlocks = NULL;
     curAddr += newBlock->blockSize;
+    pendingAlignOffset = -1;
+    pendingFixedAddr = false;
 
     // add block to the linked list
     if (firstBlock == NULL) {
@@ -88,6 +106,7 @@ void OB_MoveToNextPage() {
     if ((curAddr & 0xFF) != 0) {
         curAddr = (curAddr & 0xff00) + 0x100;
     }
+    pendingAlignOffset = 0;
 }
 
 void OB_AlignToPageOffset(int ofs) {
@@ -99,6 +118,7 @@ void OB_AlignToPageOffset(int ofs) {
 
     if (newAddr > curAddr) {
         curAddr = newAddr;
+        pendingAlignOffset = ofs;
     } else {
         printf("WARNING:  Unable to do page_align offset from %4X to %4X.\n", curAddr, newAddr);
     }
@@ -107,16 +127,35 @@ void OB_AlignToPageOffset(int ofs) {
 
 void OB_SetAddress(int newAddr) {
     curAddr = newAddr;
+    pendingFixedAddr = true;
 }
 
 void OB_SetBank(int newBank) {
+    // each bank keeps track of its own free space
+    bankAddr[curBank] = curAddr;
+    curAddr = bankAddr[newBank];
     curBank = newBank;
+    bankSetByUser = true;
 }
 
 void OB_SetMachine(enum Machines machine) {
     curMachine = machine;
 }
 
+/**
+ * Enable automatic placement of blocks into banks
+ *
+ *  Blocks still get a temporary location during code generation,
+ *  but their final bank and address is decided by BP_PlaceBlocks().
+ */
+void OB_EnableBankPlacement() {
+    useBankPlacement = true;
+}
+
+bool OB_UsesBankPlacement() {
+    return useBankPlacement;
+}
+
 /**
  * Add a function / code block to the Output Block list
  * @return
@@ -169,9 +208,15 @@ OutputBlock *OB_FindByName(char *blockNameToFind) {
     return NULL;
 }
 
+void OB_PrintGap(int gapStart, int gapEnd, int bankNum) {
+    int gapSize = gapEnd - gapStart + 1;
+    printf("%-32s  %04X - %04X   %04X   %02X  %5d bytes   %s\n",
+           "  (gap)", gapStart, gapEnd, gapSize, bankNum, gapSize, "GAP" );
+}
+
 void OB_PrintBlockList() {
     int startAddr = 0;
-    int endAddr = 0;
+    int endAddr = -1;
     int lastBank = 0;
     int totalGapSize = 0;
 
@@ -183,13 +228,20 @@ void OB_PrintBlockList() {
         // get start address of this new block
         startAddr = block->blockAddr;
 
+        // moved to a new bank?  show remaining space in the last one
+        if (block->bankNum != lastBank) {
+            int bankEnd = BL_getUsableSize(lastBank) - 1;
+            if (bankEnd > endAddr) {
+                OB_PrintGap(endAddr + 1, bankEnd, lastBank);
+                totalGapSize += bankEnd - endAddr;
+            }
+            endAddr = -1;
+        }
+
         // check if there was a gap between blocks
         if (startAddr - 1 > endAddr) {
-            int gapSize = startAddr - endAddr - 1;
-            printf("%-32s  %04X - %04X   %04X   %02X  %5d bytes   %s\n",
-                   "  (gap)",
-                   (endAddr + 1), (startAddr - 1), gapSize, lastBank, gapSize, "GAP" );
-            totalGapSize += gapSize;
+            OB_PrintGap(endAddr + 1, startAddr - 1, block->bankNum);
+            totalGapSize += startAddr - endAddr - 1;
         }
 
         // calculate new end address
@@ -210,20 +262,33 @@ void OB_PrintBlockList() {
                 block->blockSize,
                (block->blockType == BT_CODE) ? "CODE" : "DATA" );
 
+        // show how much merging identical code saved
+        if ((block->blockType == BT_CODE) && (block->codeBlock != NULL) && (block->codeBlock->tailMergeSavings > 0)) {
+            printf("  %-30s  %5d bytes saved\n", "(tail merging)", block->codeBlock->tailMergeSavings);
+        }
+
+        // show any data that shares this block
+        OutputBlock *mergedBlock = block->mergedBlocks;
+        while (mergedBlock != NULL) {
+            printf("  %-30s  %04X - %04X   %04X   %02X  (in %s)\n",
+                   mergedBlock->blockName,
+                   startAddr + mergedBlock->blockAddr,
+                   startAddr + mergedBlock->blockAddr + mergedBlock->blockSize - 1,
+                   mergedBlock->blockSize,
+                   block->bankNum,
+                   block->blockName);
+            mergedBlock = mergedBlock->nextBlock;
+        }
+
         block = block->nextBlock;
     }
 
     // figure out how much space is remaining before bank end
-    int bankNum = lastBlock->bankNum;
-    int bankEnd = (bankNum * 4096) + 0xFF7;
-    int lastBlockEnd = lastBlock->blockAddr + lastBlock->blockSize - 1;
-
-    int lastGapSize = bankEnd - lastBlockEnd;
+    int bankEnd = BL_getUsableSize(lastBank) - 1;
+    int lastGapSize = bankEnd - endAddr;
     totalGapSize += lastGapSize;
 
-    printf("%-32s  %04X - %04X   %04X   %02X  %5d bytes   %s\n",
-           "  (gap)",
-           lastBlockEnd, bankEnd, lastGapSize, bankNum, lastGapSize, "GAP" );
+    OB_PrintGap(endAddr + 1, bankEnd, lastBank);
     printf("\n");
     printf("Total space available (sum of gaps):   %d bytes\n", totalGapSize);
 }
@@ -251,6 +316,124 @@ void OB_WalkCodeBlocks(ProcessBlockFunc codeBlockFunc) {
     }
 }
 
+/**
+ * Rebuild the output block list using the provided order
+ *
+ * (Used by bank placement after blocks have been rearranged)
+ *
+ * @param blocks - array of blocks in the new order
+ * @param count - number of blocks
+ */
+void OB_RebuildList(OutputBlock **blocks, int count) {
+    firstBlock = NULL;
+    curBlock = NULL;
+    for_range(index, 0, count) {
+        OutputBlock *block = blocks[index];
+        block->nextBlock = NULL;
+        if (firstBlock == NULL) {
+            firstBlock = block;
+        } else {
+            curBlock->nextBlock = block;
+        }
+        curBlock = block;
+    }
+    lastBlock = curBlock;
+    blockCount = count;
+}
+
+/**
+ * Move a block's contents inside of another block (the data is shared)
+ *
+ *  The block is removed from the output list and its symbol will be located
+ *  relative to the host block.  Any blocks already merged into the block
+ *  are moved over to the host block as well.
+ *
+ * @param block - block to remove from output list
+ * @param hostBlock - block that contains the same data
+ * @param offset - where in hostBlock the data starts
+ */
+void OB_MergeBlockInto(OutputBlock *block, OutputBlock *hostBlock, int offset) {
+
+    // remove from output list
+    OutputBlock *prevBlock = NULL;
+    OutputBlock *curListBlock = firstBlock;
+    while ((curListBlock != NULL) && (curListBlock != block)) {
+        prevBlock = curListBlock;
+        curListBlock = curListBlock->nextBlock;
+    }
+    if (curListBlock == NULL) return;
+
+    if (prevBlock == NULL) {
+        firstBlock = block->nextBlock;
+    } else {
+        prevBlock->nextBlock = block->nextBlock;
+    }
+    if (lastBlock == block) lastBlock = prevBlock;
+    if (curBlock == block) curBlock = lastBlock;
+    blockCount--;
+
+    // move blocks that were merged into this block over to the host
+    OutputBlock *mergedBlock = block->mergedBlocks;
+    while (mergedBlock != NULL) {
+        OutputBlock *nextMerged = mergedBlock->nextBlock;
+        mergedBlock->blockAddr += offset;
+        mergedBlock->bankNum = hostBlock->bankNum;
+        mergedBlock->nextBlock = hostBlock->mergedBlocks;
+        hostBlock->mergedBlocks = mergedBlock;
+        mergedBlock = nextMerged;
+    }
+    block->mergedBlocks = NULL;
+
+    block->blockAddr = offset;
+    block->bankNum = hostBlock->bankNum;
+    block->nextBlock = hostBlock->mergedBlocks;
+    hostBlock->mergedBlocks = block;
+}
+
+/**
+ * Set the symbol location for a block (and all the blocks merged into it)
+ */
+void OB_SetBlockLocation(const OutputBlock *block) {
+    int blockLoc = BL_getMachineAddr(block->bankNum) + block->blockAddr;
+
+    SymbolRecord *symbol = (block->blockType == BT_CODE) ? block->codeBlock->funcSym : block->symbol;
+    setSymbolLocation(symbol, blockLoc, SS_ROM);
+
+    OutputBlock *mergedBlock = block->mergedBlocks;
+    while (mergedBlock != NULL) {
+        setSymbolLocation(mergedBlock->symbol, blockLoc + mergedBlock->blockAddr, SS_ROM);
+        mergedBlock = mergedBlock->nextBlock;
+    }
+}
+
+/**
+ * Reassign block addresses after blocks have been removed/resized
+ *
+ *  Blocks stay in the same order and bank.  Page alignment
+ *  and addresses set by the user are kept.
+ */
+void OB_Relayout() {
+    for_range(bankNum, 0, MAX_BANKS) { bankAddr[bankNum] = 0; }
+
+    OutputBlock *block = firstBlock;
+    while (block != NULL) {
+        int addr = bankAddr[block->bankNum];
+        if (block->hasFixedAddr) {
+            addr = block->blockAddr;
+        } else if (block->alignOffset >= 0) {
+            int alignedAddr = (addr & 0xFF00) + block->alignOffset;
+            if (alignedAddr < addr) alignedAddr += 0x100;
+            addr = alignedAddr;
+        }
+        block->blockAddr = addr;
+        bankAddr[block->bankNum] = addr + block->blockSize;
+
+        OB_SetBlockLocation(block);
+        block = block->nextBlock;
+    }
+    curAddr = bankAddr[curBank];
+}
+
 //-------------------------------------------------------------------
 //--- Track code address
 //-
@@ -261,21 +444,38 @@ void OB_WalkCodeBlocks(ProcessBlockFunc codeBlockFunc) {
 bool checkIfBlockFits(const OutputBlock *outputBlock, const SymbolRecord *symRec) {
     // check if code doesn't fit in bank
 
+    // blocks are placed in banks later... (see BP_PlaceBlocks)
+    if (useBankPlacement) return true;
+
+    // when optimizing for size, code can still shrink after it's generated
+    if (compilerOptions.optimizeForSize && !isLayoutFinal) return true;
+
     // information about bank to check
     int bankNum = outputBlock->bankNum;
-    int bankEnd = (bankNum * 4096) + 0xFF7;
+    int bankEnd = BL_getUsableSize(bankNum) - 1;
 
     //---
     int blockEndAddr = (outputBlock->blockAddr + outputBlock->blockSize) - 1;
     if (blockEndAddr > bankEnd) {
         char errStr[128];
         sprintf(errStr, "Block %s ends at: %04X (bank %d)", symRec->name, blockEndAddr, outputBlock->bankNum);
-        ErrorMessage("Code block doesn't fit in bank\n\t", errStr, symRec->astList->lineNum);
+        ErrorMessage("Code block doesn't fit in bank\n\t", errStr, (symRec->astList != NULL) ? symRec->astList->lineNum : 0);
         return false;
     }
     return true;
 }
 
+/**
+ * Check that all blocks fit in their bank, now that their final size is known
+ */
+void OB_CheckBlocksFit() {
+    isLayoutFinal = true;
+    for (const OutputBlock *block = firstBlock; block != NULL; block = block->nextBlock) {
+        const SymbolRecord *symRec = (block->blockType == BT_CODE) ? block->codeBlock->funcSym : block->symbol;
+        if (!checkIfBlockFits(block, symRec)) break;
+    }
+}
+
 void checkAndSaveBlockAddr(const OutputBlock *outputBlock, SymbolRecord *symRec) {
 
     if (checkIfBlockFits(outputBlock, symRec)) {
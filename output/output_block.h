@@ -34,6 +34,9 @@ typedef struct SOutputBlock {
     int blockSize;
     char *blockName;
     int bankNum;            // which bank it's in
+    bool isBankPinned;      // bank was selected by the user (#set_bank)
+    int alignOffset;        // requested page offset (#page_align), or -1 if none
+    bool hasFixedAddr;      // address was set by the user (#set_address)
 
     SymbolRecord *symbol;   // symbol that this block represents... (need to rename)
     union {
@@ -41,6 +44,7 @@ typedef struct SOutputBlock {
         List *dataList;          // if data list
     };
 
+    struct SOutputBlock *mergedBlocks;  // blocks whose data is contained in this one (blockAddr is the offset)
     struct SOutputBlock *nextBlock;
 } OutputBlock;
 
@@ -53,12 +57,19 @@ extern void OB_AlignToPageOffset(int ofs);
 extern void OB_SetAddress(int newAddr);
 extern void OB_SetBank(int newBank);
 extern void OB_SetMachine(enum Machines machine);
+extern void OB_EnableBankPlacement();
+extern bool OB_UsesBankPlacement();
 
 extern OutputBlock *OB_FindByName(char *blockNameToFind);
 extern void OB_PrintBlockList();
 extern const OutputBlock *OB_getFirstBlock();
 
 extern void OB_WalkCodeBlocks(ProcessBlockFunc codeBlockFunc);
+extern void OB_RebuildList(OutputBlock **blocks, int count);
+extern void OB_MergeBlockInto(OutputBlock *block, OutputBlock *hostBlock, int offset);
+extern void OB_SetBlockLocation(const OutputBlock *block);
+extern void OB_Relayout();
+extern void OB_CheckBlocksFit();
 extern void OB_BuildInitialLayout();
 extern void OB_ArrangeBlocks();
 
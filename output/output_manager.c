@@ -25,6 +25,7 @@
 
 #include <data/bank_layout.h>
 #include <data/instr_list.h>
+#include "codegen/gen_common.h"
 #include "output_block.h"
 #include "write_output.h"
 
@@ -45,16 +46,44 @@ void initOutputGenerator(enum Machines targetMachine) {
     // TODO: this is initial code to start incorporating code/data banks... need to flesh out
     // Build a default bank that matches the binary memory space available in the machine
 
-    // Create main bank
+    // Create main bank (reserving space for the CPU vectors / cart header at the end)
+    int reserved = 0;
+    switch (targetMachine) {
+        case Atari2600: reserved = 4; break;
+        case Atari5200: reserved = 0x20; break;
+        case Atari7800: reserved = 8; break;
+        default: break;
+    }
     bankSize = (outputTargetMachine.endAddr - outputTargetMachine.startAddr + 1);
-    BL_addBank(bankSize, outputTargetMachine.startAddr, 0);
+    BL_addBank(bankSize, outputTargetMachine.startAddr, 0, reserved);
 }
 
-void addBankToOutputGenerator() {
-    if (outputTargetMachine.machine == Atari2600) {
-        // TEMP (2600-only .. F8 bank-switching
-        BL_addBank(bankSize, outputTargetMachine.startAddr + 0x2000, 0x1000);
+/**
+ * Switch the output over to a bank-switching scheme  (#set_banking F8)
+ *
+ *   Once banking is enabled, code and data blocks are placed into
+ *   banks automatically after code generation (see bank_placement.c)
+ *
+ * @param bankingSchemeName - name of scheme (F8, F6, F4, E0, 3F) ... defaults to F8
+ * @param lineNum - line number of directive (for error reporting)
+ */
+void addBankToOutputGenerator(const char *bankingSchemeName, int lineNum) {
+    if (outputTargetMachine.machine != Atari2600) {
+        WarningMessage("Bank-switching is only supported for the Atari2600", NULL, lineNum);
+        return;
     }
+
+    const BankingSchemeDef *bankingScheme = NULL;
+    if (bankingSchemeName != NULL) {
+        bankingScheme = BL_lookupBankingScheme(bankingSchemeName);
+        if (bankingScheme == NULL) {
+            WarningMessage("Unknown bank-switching scheme, using F8", bankingSchemeName, lineNum);
+        }
+    }
+    if (bankingScheme == NULL) bankingScheme = BL_lookupBankingScheme("F8");
+
+    BL_setBankingScheme(bankingScheme, outputTargetMachine.startAddr);
+    OB_EnableBankPlacement();
 }
 
 void generateOutput(char *projectName, SymbolTable *mainSymbolTable, OutputFlags outputFlags) {
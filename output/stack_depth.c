@@ -0,0 +1,361 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Stack Depth - work out the most the hardware stack will ever hold
+//
+//  Runs over the final code (after all code blocks are done being changed).
+//  Each code block is walked, keeping track of how deep the stack is:
+//
+//   - PHA/PHP push a byte, PLA/PLP pull one
+//   - TSX / INX... / TXS drops bytes  (LDX #$FF / TXS resets the stack)
+//   - JSR pushes the return address, plus whatever the called code uses
+//   - branches and jumps carry the depth over to where they go
+//
+//  A function table's dispatch routine goes on to one of the functions in
+//  its table (at the depth it was called at), so it uses as much as the
+//  deepest of them.
+//
+//  A call to a label inside of a block (a bank trampoline) starts walking
+//  at that label, and stops once the code can't go any further.
+//
+//  The call tree starts at main.  Interrupt handlers (irq/nmi) can happen at
+//  any point, so their stack use (plus the 3 bytes pushed to get there) is
+//  added on top of the deepest point in main.
+//
+//  The result is checked against the space the variable allocator left for
+//  the stack, and the build fails if they collide.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stack_depth.h"
+#include "output_block.h"
+#include "codegen/gen_alloc.h"
+#include "codegen/gen_common.h"
+#include "cpu_arch/instrs_dispatch.h"
+#include "machine/mem.h"
+
+enum {
+    MAX_STACK_BLOCKS = 512,
+    JSR_STACK_SIZE = 2,             // return address
+    INTERRUPT_STACK_SIZE = 3        // return address + flags
+};
+
+typedef struct {
+    OutputBlock *block;
+    int stackUse;               // most bytes pushed by the block (and the code it calls)
+    bool isActive;              // being worked out  (used to catch recursion)
+    bool isDone;
+} StackInfo;
+
+static StackInfo stackInfo[MAX_STACK_BLOCKS];
+static int stackInfoCount;
+static const char *recursiveFuncName;      // stack use can't be worked out when code calls itself
+
+//-----------------------------------------------------------------------
+
+static bool hasLabel(const Instr *instr, const Label *label, const char *labelName) {
+    if (instr->label == NULL) return false;
+    return (instr->label == label) || (strcmp(instr->label->name, labelName) == 0);
+}
+
+/**
+ * Find the instruction in a block with the label
+ * @return index of the instruction, or -1 if not in the block
+ */
+static int findLabelInBlock(Instr **instrs, int instrCount, const char *labelName) {
+    Label *label = findLabel(labelName);
+    while ((label != NULL) && (label->link != NULL)) label = label->link;
+
+    for_range(index, 0, instrCount) {
+        if (hasLabel(instrs[index], label, labelName)) return index;
+    }
+    return -1;
+}
+
+/**
+ * Find the code block called by a JSR/JMP
+ * @return index into stackInfo, or -1 if not found
+ */
+static int findCalledBlock(const char *name) {
+    for_range(index, 0, stackInfoCount) {
+        if (strcmp(stackInfo[index].block->blockName, name) == 0) return index;
+    }
+
+    // could also be a label inside of a block  (ex: bank trampolines)
+    for_range(index, 0, stackInfoCount) {
+        for (const Instr *curInstr = stackInfo[index].block->codeBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+            if ((curInstr->label != NULL) && (strcmp(curInstr->label->name, name) == 0)) return index;
+        }
+    }
+    return -1;
+}
+
+static int calcBlockStackUse(int infoIndex);
+static int calcLabelStackUse(int infoIndex, const char *labelName);
+
+static int calcCalledStackUse(const Instr *instr) {
+    if ((instr->addrMode != ADDR_ABS) || (instr->paramName == NULL)) return 0;
+
+    int calledIndex = findCalledBlock(instr->paramName);
+    if (calledIndex < 0) return 0;
+
+    // a label inside of a block is its own entry point  (only the code reached from it counts)
+    if (strcmp(stackInfo[calledIndex].block->blockName, instr->paramName) != 0) {
+        return calcLabelStackUse(calledIndex, instr->paramName);
+    }
+    return calcBlockStackUse(calledIndex);
+}
+
+/**
+ * Get the most stack used by the functions a dispatch routine can go to
+ */
+static int calcDispatchStackUse(const char *blockName) {
+    const List *funcList = ICG_GetDispatchTargets(blockName);
+    if (funcList == NULL) return 0;
+
+    int maxUse = 0;
+    for_range(index, 1, funcList->count) {
+        int calledIndex = findCalledBlock(funcList->nodes[index].value.str);
+        int funcUse = (calledIndex >= 0) ? calcBlockStackUse(calledIndex) : 0;
+        if (funcUse > maxUse) maxUse = funcUse;
+    }
+    return maxUse;
+}
+
+static void carryDepthTo(int *depthAt, int index, int depth) {
+    if ((index >= 0) && (depth > depthAt[index])) depthAt[index] = depth;
+}
+
+/**
+ * Walk thru the code of a block, tracking how deep the stack gets
+ *
+ *  Two passes are done, so the depth at the end of a loop makes it
+ *  back to the top of the loop.
+ *
+ * @param startIndex - entry point  (when not at the top, the walk ends at
+ *                     the first code that can't be reached from it)
+ */
+static int walkBlock(Instr **instrs, int instrCount, int startIndex) {
+    int *depthAt = calloc(instrCount + 1, sizeof(int));
+    for_range(index, 0, instrCount) { depthAt[index] = -1; }
+
+    int maxUse = 0;
+    for_range(pass, 0, 2) {
+        int depth = 0;
+        bool isReachable = true;
+        bool xHasStackPtr = false;      // X was loaded with TSX  (xValue is the change since)
+        bool xIsConst = false;
+        int xValue = 0;
+
+        for_range(index, startIndex, instrCount) {
+            const Instr *instr = instrs[index];
+            if ((startIndex > 0) && !isReachable && (depthAt[index] < 0)) break;
+
+            // code at a label can be reached from elsewhere
+            if (instr->label != NULL) {
+                if ((depthAt[index] >= 0) && (!isReachable || (depthAt[index] > depth))) depth = depthAt[index];
+                carryDepthTo(depthAt, index, depth);
+                xHasStackPtr = false;
+                xIsConst = false;
+            }
+            isReachable = true;
+
+            switch (instr->mne) {
+                case PHA: case PHP:
+                    depth++;
+                    break;
+                case PLA: case PLP:
+                    if (depth > 0) depth--;
+                    break;
+
+                case TSX:
+                    xHasStackPtr = true;
+                    xIsConst = false;
+                    xValue = 0;
+                    break;
+                case INX: xValue++; break;
+                case DEX: xValue--; break;
+                case LDX: case LAX:
+                    xHasStackPtr = false;
+                    xIsConst = (instr->addrMode == ADDR_IMM) && (instr->paramName == NULL);
+                    xValue = xIsConst ? instr->offset : 0;
+                    break;
+                case TAX: case SBX:
+                    xHasStackPtr = false;
+                    xIsConst = false;
+                    break;
+                case TXS:
+                    if (xHasStackPtr) depth -= xValue;
+                    if (xIsConst) depth = 0xFF - (xValue & 0xFF);
+                    if (depth < 0) depth = 0;
+                    break;
+
+                case JSR: {
+                    int callUse = depth + JSR_STACK_SIZE + calcCalledStackUse(instr);
+                    if (callUse > maxUse) maxUse = callUse;
+                    xHasStackPtr = false;
+                    xIsConst = false;
+                } break;
+
+                case JMP: {
+                    int destIndex = (instr->paramName != NULL) ? findLabelInBlock(instrs, instrCount, instr->paramName) : -1;
+                    if (destIndex >= 0) {
+                        carryDepthTo(depthAt, destIndex, depth);
+                    } else {
+                        // jumping to another function  (it returns for us)
+                        int callUse = depth + calcCalledStackUse(instr);
+                        if (callUse > maxUse) maxUse = callUse;
+                    }
+                    isReachable = false;
+                } break;
+
+                case RTS: case RTI:
+                    isReachable = false;
+                    break;
+                case BRK:
+                    if (depth + INTERRUPT_STACK_SIZE > maxUse) maxUse = depth + INTERRUPT_STACK_SIZE;
+                    isReachable = false;
+                    break;
+
+                default:
+                    if (isBranch(instr->mne) && (instr->paramName != NULL)) {
+                        carryDepthTo(depthAt, findLabelInBlock(instrs, instrCount, instr->paramName), depth);
+                    }
+                    break;
+            }
+            if (depth > maxUse) maxUse = depth;
+        }
+    }
+
+    free(depthAt);
+    return maxUse;
+}
+
+static Instr **collectInstrs(const OutputBlock *block, int *instrCount) {
+    InstrBlock *instrBlock = block->codeBlock;
+    *instrCount = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) (*instrCount)++;
+
+    Instr **instrs = calloc(*instrCount + 1, sizeof(Instr *));
+    int index = 0;
+    for (Instr *curInstr = instrBlock->firstInstr; curInstr != NULL; curInstr = curInstr->nextInstr) {
+        instrs[index++] = curInstr;
+    }
+    return instrs;
+}
+
+/**
+ * Work out the most stack a block (and everything it calls) will use
+ */
+static int calcBlockStackUse(int infoIndex) {
+    StackInfo *info = &stackInfo[infoIndex];
+    if (info->isDone) return info->stackUse;
+    if (info->isActive) {
+        if (recursiveFuncName == NULL) recursiveFuncName = info->block->blockName;
+        return 0;
+    }
+    info->isActive = true;
+
+    int instrCount;
+    Instr **instrs = collectInstrs(info->block, &instrCount);
+    info->stackUse = walkBlock(instrs, instrCount, 0);
+
+    int dispatchUse = calcDispatchStackUse(info->block->blockName);
+    if (dispatchUse > info->stackUse) info->stackUse = dispatchUse;
+    info->isActive = false;
+    info->isDone = true;
+
+    free(instrs);
+    return info->stackUse;
+}
+
+/**
+ * Work out the most stack used from a label inside of a block
+ *
+ *  Not kept with the block, since each label goes somewhere different
+ *  (ex: the boot code and each trampoline sharing one block)
+ */
+static int calcLabelStackUse(int infoIndex, const char *labelName) {
+    int instrCount;
+    Instr **instrs = collectInstrs(stackInfo[infoIndex].block, &instrCount);
+
+    int startIndex = findLabelInBlock(instrs, instrCount, labelName);
+    int stackUse = (startIndex >= 0) ? walkBlock(instrs, instrCount, startIndex) : 0;
+
+    free(instrs);
+    return stackUse;
+}
+
+static void collectCodeBlocks() {
+    stackInfoCount = 0;
+    recursiveFuncName = NULL;
+
+    OutputBlock *block = (OutputBlock *)OB_getFirstBlock();
+    for (; (block != NULL) && (stackInfoCount < MAX_STACK_BLOCKS); block = block->nextBlock) {
+        if ((block->blockType != BT_CODE) || (block->codeBlock == NULL)) continue;
+
+        StackInfo *info = &stackInfo[stackInfoCount++];
+        info->block = block;
+        info->stackUse = 0;
+        info->isActive = false;
+        info->isDone = false;
+    }
+}
+
+/**
+ * Get the stack use of an interrupt handler  (including what the CPU pushes)
+ */
+static int calcInterruptStackUse(const char *handlerName) {
+    int handlerIndex = findCalledBlock(handlerName);
+    return (handlerIndex >= 0) ? INTERRUPT_STACK_SIZE + calcBlockStackUse(handlerIndex) : 0;
+}
+
+//-----------------------------------------------------------------------
+
+/**
+ * Work out the worst case stack depth of the program, and make sure it
+ *   doesn't run into the variables
+ */
+void SD_CheckStackDepth() {
+    collectCodeBlocks();
+
+    int mainIndex = findCalledBlock(compilerOptions.entryPointFuncName);
+    if (mainIndex < 0) return;
+
+    int mainUse = calcBlockStackUse(mainIndex);
+    int irqUse = calcInterruptStackUse("irq");
+    int nmiUse = calcInterruptStackUse("nmi");       // can interrupt the irq handler too
+
+    if (recursiveFuncName != NULL) {
+        WarningMessage("Unable to work out stack depth of recursive function", recursiveFuncName, 0);
+        return;
+    }
+
+    int stackBytes = mainUse + irqUse + nmiUse;
+    if (compilerOptions.showVarAllocations) {
+        printf("\nWorst case stack depth: %d bytes  (main: %d, irq: %d, nmi: %d)\n", stackBytes, mainUse, irqUse, nmiUse);
+    }
+
+    if (!checkStackUsage(stackBytes)) {
+        char errStr[80];
+        sprintf(errStr, "needs %d bytes, only %d are free", stackBytes, SMA_getStackSpace());
+        ErrorMessage("Stack runs into variables\n\t", errStr, 0);
+    }
+}
@@ -0,0 +1,24 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef NEOLITHIC_STACK_DEPTH_H
+#define NEOLITHIC_STACK_DEPTH_H
+
+extern void SD_CheckStackDepth();
+
+#endif //NEOLITHIC_STACK_DEPTH_H
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include "write_output.h"
+#include "bank_placement.h"
 
 //#define DEBUG_WRITE_BIN
 //#define DEBUG_WRITE_BIN_OPCODE
@@ -102,10 +103,18 @@ void WriteBIN_EndOfBlock(const OutputBlock *block) {
 
     switch (BIN_target.machine) {
         case Atari2600: {
+            // with bank-switching, the reset vector goes to the boot code which selects main's bank
+            Label *bootLabel = findLabel(BANK_BOOT_LABEL);
+            const BankingSchemeDef *bankingScheme = BL_getBankingScheme();
+            int resetAddr = (bootLabel != NULL) ? bootLabel->location : mainLabel->location;
+
             for (int b=0; b<mainBankLayout->banksUsed; b++) {
-                int fileOfs = b * 4096;
-                WriteBIN_WriteVector(mainLabel->location, 0xFFC + fileOfs);
-                WriteBIN_WriteVector(mainLabel->location, 0xFFE + fileOfs);
+                const BankDef *bank = &(mainBankLayout->banks[b]);
+                if ((bankingScheme != NULL) && bankingScheme->hasFixedBank && !bank->isFixed) continue;
+
+                int fileOfs = bank->fileLoc + bank->size;
+                WriteBIN_WriteVector(resetAddr, fileOfs - 4);
+                WriteBIN_WriteVector(resetAddr, fileOfs - 2);
             }
         } break;
 
@@ -215,7 +224,7 @@ void WriteBIN_PreprocessLabels(const InstrBlock *instrBlock, int blockAddr) {
     while (curOutInstr != NULL) {
         // handle label, if this instruction has a label, keep track of where it is
         if (curOutInstr->label != NULL) {
-            curOutInstr->label->location = blockAddr + BIN_target.startAddr;
+            curOutInstr->label->location = blockAddr;
             curOutInstr->label->hasLocation = true;
         }
 
@@ -231,12 +240,8 @@ void WriteBIN_PreprocessLabels(const InstrBlock *instrBlock, int blockAddr) {
 
 //---- Figure out where this block will be written
 int calcBlockWriteAddr(const OutputBlock *block) {
-    int writeAddr = block->blockAddr;
     int writeBank = block->bankNum;
-
-    for (int b=0; b<writeBank; b++) {
-        writeAddr += mainBankLayout->banks[b].size;
-    }
+    int writeAddr = mainBankLayout->banks[writeBank].fileLoc + block->blockAddr;
 
 #ifdef DEBUG_WRITE_BIN
     printf("Writing %s to %4X (bank %d)\n", block->blockName, writeAddr, writeBank);
@@ -255,7 +260,7 @@ void WriteBIN_FunctionBlock(const OutputBlock *block) {
 
     funcSymbolTable = GET_LOCAL_SYMBOL_TABLE(instrBlock->funcSym);
 
-    WriteBIN_PreprocessLabels(instrBlock, writeAddr);
+    WriteBIN_PreprocessLabels(instrBlock, BL_getMachineAddr(block->bankNum) + block->blockAddr);
 
     Instr *curOutInstr = instrBlock->firstInstr;
     while (curOutInstr != NULL) {
@@ -303,7 +308,26 @@ void WriteBIN_FunctionBlock(const OutputBlock *block) {
 #endif
 }
 
+/**
+ * Write out a function table  (low bytes of each function's address-1, then the high bytes)
+ */
+void WriteBIN_FuncTableData(const OutputBlock *block) {
+    int writeAddr = calcBlockWriteAddr(block);
+    int funcCount = block->symbol->numElements;
+
+    for_range (vidx, 1, block->dataList->count) {
+        Label *funcLabel = findLabel(block->dataList->nodes[vidx].value.str);
+        int funcAddr = (funcLabel != NULL) ? (funcLabel->location - 1) : 0;
+        binData[writeAddr++] = ((vidx > funcCount) ? (funcAddr >> 8) : funcAddr) & 0xff;
+    }
+}
+
 void WriteBIN_StaticArrayData(const OutputBlock *block) {
+    if (IS_FUNC_TABLE(block->symbol)) {
+        WriteBIN_FuncTableData(block);
+        return;
+    }
+
     int writeAddr = calcBlockWriteAddr(block);
     bool isInt = getBaseVarSize(block->symbol) > 1;
 
@@ -321,9 +345,10 @@ void WriteBIN_StaticArrayData(const OutputBlock *block) {
  *
  * @param structSymTbl  - structure of the data
  * @param writeAddr     - where in the output stream to write the data
+ * @param byteStride    - distance between each byte of the record (more than 1 for split arrays)
  * @param dataList      -
  */
-void WriteBIN_WriteStructRecordData(SymbolTable *structSymTbl, int writeAddr, const List *dataList) {
+void WriteBIN_WriteStructRecordData(SymbolTable *structSymTbl, int writeAddr, int byteStride, const List *dataList) {
     int symIndex = 1;
     SymbolRecord *structVar = structSymTbl->firstSymbol;
     while (structVar != NULL) {
@@ -338,9 +363,11 @@ void WriteBIN_WriteStructRecordData(SymbolTable *structSymTbl, int writeAddr, co
                    lineNum, value, structVar->name, dataTypeStr);
         }
 
-        binData[writeAddr++] = value & 0xff;
+        binData[writeAddr] = value & 0xff;
+        writeAddr += byteStride;
         if (varSize == 2) {
-            binData[writeAddr++] = (value >> 8) & 0xff;
+            binData[writeAddr] = (value >> 8) & 0xff;
+            writeAddr += byteStride;
         }
         symIndex++;
 
@@ -356,12 +383,14 @@ void WriteBIN_StaticStructData(const OutputBlock *block) {
 
     List *dataList = block->dataList;
     if (isArray(block->symbol)) {
-        int structSize = calcVarSize(structSym);
+        // split arrays interleave the records, so each record starts one byte after the last
+        int recordStride = IS_SPLIT_ARRAY(block->symbol) ? 1 : calcVarSize(structSym);
+        int byteStride = getArrayByteStride(block->symbol);
         for_range(index, 1, block->dataList->count) {
-            WriteBIN_WriteStructRecordData(structSymTbl, writeAddr, dataList->nodes[index].value.list);
-            writeAddr += structSize;
+            WriteBIN_WriteStructRecordData(structSymTbl, writeAddr, byteStride, dataList->nodes[index].value.list);
+            writeAddr += recordStride;
         }
     } else {
-        WriteBIN_WriteStructRecordData(structSymTbl, writeAddr, dataList);
+        WriteBIN_WriteStructRecordData(structSymTbl, writeAddr, 1, dataList);
     }
 }
\ No newline at end of file
@@ -19,11 +19,13 @@
 #include <stdio.h>
 #include <string.h>
 #include "write_output.h"
+#include "bank_placement.h"
 
 static FILE *outputFile;
 static SymbolTable *mainSymbolTable;
 static struct BankLayout *mainBankLayout;
 static MachineInfo DASM_target;
+static int curBankNum;
 
 //---------------------------------------------------------
 // Output Adapter API
@@ -71,13 +73,32 @@ void WriteDASM_WriteBlockFooter(char *name) {
     fprintf(outputFile, "\techo \"%-30s \", (*-%s),(%s),\"-\",(*-1)\n\n", name, name, name);
 }
 
-void WriteDASM_StartOfBank() {
-    int bankStart = mainBankLayout->banks[0].memLoc;
-    fprintf(outputFile, "\n\n\tORG $0000");             // TODO: use file offset from bank in BankLayout
-    fprintf(outputFile,"\n\tRORG $%4X\n", bankStart);
+/**
+ * Output labels for data that shares space with this block (see data_merge.c)
+ */
+void WriteDASM_MergedBlockLabels(const OutputBlock *outputBlock) {
+    const OutputBlock *mergedBlock = outputBlock->mergedBlocks;
+    while (mergedBlock != NULL) {
+        fprintf(outputFile, "%-20s = %s+%d\t;-- shares data with %s\n",
+                mergedBlock->blockName, outputBlock->blockName, mergedBlock->blockAddr, outputBlock->blockName);
+        mergedBlock = mergedBlock->nextBlock;
+    }
 }
 
-void WriteDASM_EndOfBank() {
+void WriteDASM_StartOfBank(int bankNum) {
+    struct BankDef curBank = mainBankLayout->banks[bankNum];
+    if (mainBankLayout->banksUsed > 1) fprintf(outputFile, "\n\n;--- BANK %d\n", bankNum);
+    fprintf(outputFile, "\n\n\tORG $%04X", curBank.fileLoc);
+    fprintf(outputFile,"\n\tRORG $%4X\n", curBank.memLoc);
+    curBankNum = bankNum;
+}
+
+void WriteDASM_EndOfBank(int bankNum) {
+    const BankingSchemeDef *bankingScheme = BL_getBankingScheme();
+    struct BankDef curBank = mainBankLayout->banks[bankNum];
+
+    // with a fixed bank, only the fixed bank has the CPU vectors
+    if ((bankingScheme != NULL) && bankingScheme->hasFixedBank && !curBank.isFixed) return;
 
     // figure out how many bytes are needed to be reserved at the end of the bank
     //  FOR CPU jump vectors and other reserved bytes
@@ -89,22 +110,22 @@ void WriteDASM_EndOfBank() {
         default:break;
     }
 
-    struct BankDef curBank = mainBankLayout->banks[0];
     int bankStart = curBank.memLoc;
     int bankEnd = (bankStart + curBank.size);
 
     // print footer
     fprintf(outputFile, "\n;---------------------------------------------\n");
     fprintf(outputFile, ";-- $%04X .. $%04X\n", bankStart, (bankEnd-1));
-    fprintf(outputFile, "\n\tORG $%04X\n", (curBank.size - footerSize));
+    fprintf(outputFile, "\n\tORG $%04X\n", (curBank.fileLoc + curBank.size - footerSize));
     fprintf(outputFile, "\tRORG $%04X\n", (bankEnd - footerSize));
 
     // output machine specific data
     switch (DASM_target.machine) {
 
         case Atari2600: {
-            fprintf(outputFile, "\t.word  main\n");
-            fprintf(outputFile, "\t.word  main\n");
+            const char *resetLabel = (bankingScheme != NULL) ? BANK_BOOT_LABEL : "main";
+            fprintf(outputFile, "\t.word  %s\n", resetLabel);
+            fprintf(outputFile, "\t.word  %s\n", resetLabel);
         } break;
 
         case Atari5200: {
@@ -120,7 +141,16 @@ void WriteDASM_EndOfBank() {
 
         default:break;
     }
-    fprintf(outputFile, "\n\n;--- END OF PROGRAM\n\n");
+}
+
+/**
+ * Close out the current bank, and start the next one (including any empty banks in between)
+ */
+void WriteDASM_MoveToBank(int bankNum) {
+    while (curBankNum < bankNum) {
+        WriteDASM_EndOfBank(curBankNum);
+        WriteDASM_StartOfBank(curBankNum + 1);
+    }
 }
 
 //-------------------------------------------------------
@@ -374,6 +404,34 @@ void HandleSingleStructRecord(const List *dataList, SymbolTable *structSymTbl) {
     }
 }
 
+/**
+ * Write out an array of structs that is split into one array per struct byte
+ *   (one line for each byte of the struct, with the value from each record)
+ */
+void HandleSplitStructArray(const List *dataList, SymbolTable *structSymTbl, int numElements) {
+    SymbolRecord *structVar = structSymTbl->firstSymbol;
+    int symIndex = 1;
+    while (structVar != NULL) {
+        int varSize = getBaseVarSize(structVar);
+        for_range(byteIndex, 0, varSize) {
+            fprintf(outputFile, "\t.byte ");
+            for_range(index, 1, numElements + 1) {
+                // records without an initializer are filled with zeros
+                int value = (index < dataList->count) ? dataList->nodes[index].value.list->nodes[symIndex].value.num : 0;
+                if ((varSize == 1) && (value & 0xff00)) {
+                    printf("ERROR Line #%d: The value %d exceeds the size of %s (type: byte)\n",
+                           dataList->lineNum, value, structVar->name);
+                }
+                fprintf(outputFile, "$%02X%s", (value >> (byteIndex * 8)) & 0xff,
+                        (index < numElements) ? "," : "");
+            }
+            fprintf(outputFile, "\t\t;-- %s%s\n", structVar->name,
+                    (varSize == 1) ? "" : ((byteIndex == 0) ? " (lo)" : " (hi)"));
+        }
+        symIndex++;
+        structVar = structVar->next;
+    }
+}
 
 //---------------------------------------------------------
 
@@ -387,13 +445,14 @@ void WriteDASM_Init(FILE *outFile, MachineInfo targetMachine, SymbolTable *mainS
     if (outputFile != stdout) {
         fprintf(outputFile, "\t\tprocessor 6502\n\n");
         WO_PrintSymbolTable(mainSymbolTable, "Main");
-        WriteDASM_StartOfBank();
+        WriteDASM_StartOfBank(0);
     }
 }
 
 void WriteDASM_Done() {
-    WriteDASM_EndOfBank();
-    fclose(outputFile);
+    WriteDASM_MoveToBank(mainBankLayout->banksUsed - 1);
+    WriteDASM_EndOfBank(curBankNum);
+    fprintf(outputFile, "\n\n;--- END OF PROGRAM\n\n");
 }
 
 char* WriteDASM_getExt() { return ".asm"; }
@@ -411,6 +470,11 @@ void WriteDASM_FunctionBlock(const OutputBlock *block) {
 }
 
 void WriteDASM_StartOfBlock(const OutputBlock *block, const OutputBlock *lastBlock) {
+    if (block->bankNum != curBankNum) {
+        WriteDASM_MoveToBank(block->bankNum);
+        lastBlock = NULL;
+    }
+
     int endOfLastBlock = 0;
     if (lastBlock != NULL) {
         endOfLastBlock = lastBlock->blockAddr + lastBlock->blockSize;
@@ -437,7 +501,30 @@ void WriteDASM_EndOfBlock(const OutputBlock *block) {
 //
 //  Outputs list of values from valueNode (ListNode)
 
+/**
+ * Write out a function table  (low bytes of each function's address-1, then the high bytes)
+ */
+void WriteDASM_FuncTableData(const OutputBlock *block) {
+    WriteDASM_WriteBlockHeader(block, true);
+
+    int funcCount = block->symbol->numElements;
+    for_range (half, 0, 2) {
+        fprintf(outputFile, "\t.byte ");
+        for_range (index, 0, funcCount) {
+            const char *funcName = block->dataList->nodes[half * funcCount + index + 1].value.str;
+            fprintf(outputFile, "%c(%s-1)%s", (half == 0) ? '<' : '>', funcName, (index < funcCount - 1) ? "," : "\n");
+        }
+    }
+    WriteDASM_WriteBlockFooter(block->blockName);
+    fprintf(outputFile, "\n\n");
+}
+
 void WriteDASM_StaticArrayData(const OutputBlock *block) {
+    if (IS_FUNC_TABLE(block->symbol)) {
+        WriteDASM_FuncTableData(block);
+        return;
+    }
+
     WriteDASM_WriteBlockHeader(block, true);
 
     //-------------------------------------------------
@@ -465,6 +552,7 @@ void WriteDASM_StaticArrayData(const OutputBlock *block) {
         if (!isInt) outNum = outNum & 0xff;
         fprintf(outputFile, fmtStr, outNum, sepChar);
     }
+    WriteDASM_MergedBlockLabels(block);
     WriteDASM_WriteBlockFooter(block->blockName);
     fprintf(outputFile, "\n\n");
 }
@@ -478,7 +566,9 @@ void WriteDASM_StaticStructData(const OutputBlock *block) {
     // TODO: Are we assuming data is in an array?  Yes.
 
     List *dataList = block->dataList;
-    if (dataList->hasNestedList && isToken(dataList->nodes[0], PT_LIST)) {
+    if (IS_SPLIT_ARRAY(block->symbol) && dataList->hasNestedList) {
+        HandleSplitStructArray(dataList, structSymTbl, block->symbol->numElements);
+    } else if (dataList->hasNestedList && isToken(dataList->nodes[0], PT_LIST)) {
         int index = 1;
         while (index < dataList->count) {
             HandleSingleStructRecord(dataList->nodes[index].value.list, structSymTbl);
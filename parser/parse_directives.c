@@ -42,7 +42,14 @@ const char* CompilerDirectiveNames[NUM_COMPILER_DIRECTIVES] = {
         "set_bank",
         "set_banking",
         "set_address",
-        "always_include"
+        "always_include",
+
+        // Code generation hints
+        "unroll",
+        "likely",
+        "unlikely",
+        "max_loops",
+        "cycle_budget"
 };
 
 enum CompilerDirectiveTokens lookupDirectiveToken(char *tokenName) {
@@ -98,7 +105,7 @@ ListNode buildBankDirective(enum CompilerDirectiveTokens token) {
 
 ListNode buildBankingDirective(enum CompilerDirectiveTokens token) {
 
-    char *bankingFlag = getToken()->tokenStr;
+    char *bankingFlag = copyTokenStr(getToken());
     if (bankingFlag != NULL) {
         List *bankDirList = createList(3);
         addNode(bankDirList, createParseToken(PT_DIRECTIVE));
@@ -161,6 +168,9 @@ ListNode parse_compilerDirective(enum ParserScope parserScope) {
                 node = buildAddrDirective(directiveToken);
                 break;
             case PAGE_ALIGN:
+            case UNROLL:
+            case MAX_LOOPS:
+            case CYCLE_BUDGET:
                 node = buildDirectiveWithOptionalNumeric(directiveToken);
                 break;
 
@@ -45,6 +45,12 @@ enum CompilerDirectiveTokens {
     SET_ADDRESS,
     ALWAYS_INCLUDE,
 
+    UNROLL,
+    LIKELY,
+    UNLIKELY,
+    MAX_LOOPS,
+    CYCLE_BUDGET,
+
     //---- size of list
     NUM_COMPILER_DIRECTIVES
 };
@@ -858,6 +858,8 @@ List *parse_mod_list() {// Process all modifiers
             case TT_UNSIGNED: parseToken = PT_UNSIGNED; break;
             case TT_REGISTER: parseToken = PT_REGISTER; break;
             case TT_INLINE:   parseToken = PT_INLINE;   break;
+            case TT_SPLIT:    parseToken = PT_SPLIT;    break;
+            case TT_PACKED:   parseToken = PT_PACKED;   break;
             default:
                 printError("Unknown modifier: %s\n", modToken->tokenStr);
                 break;
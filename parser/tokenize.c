@@ -111,7 +111,7 @@ static const TokenObject TokenSymbols[] = {
         {"extern",  TT_EXTERN,      TF_MODIFIER},
         {"false",   TT_FALSE,       TF_OP},
         {"for",     TT_FOR,         TF_OP},
-        {"function",TT_FUNCTION,    TF_OP},
+        {"function",TT_FUNCTION,    TF_TYPE},
         {"if",      TT_IF,          TF_OP},
         {"import",  TT_IMPORT,      TF_OP},
         {"in",      TT_IN,          TF_OP},
@@ -120,10 +120,12 @@ static const TokenObject TokenSymbols[] = {
         {"loop",    TT_LOOP,        TF_OP},
         {"new",     TT_NEW,         TF_OP},
         {"null",    TT_NULL,        TF_OP},
+        {"packed",  TT_PACKED,      TF_MODIFIER},
         {"register",TT_REGISTER,    TF_MODIFIER},
         {"return",  TT_RETURN,      TF_OP},
         {"signed",  TT_SIGNED,      TF_MODIFIER},
         {"sizeof",  TT_SIZEOF,      TF_OP},
+        {"split",   TT_SPLIT,       TF_MODIFIER},
         {"static",  TT_STATIC,      TF_MODIFIER},
         {"strobe",  TT_STROBE,      TF_OP},
         {"struct",  TT_STRUCT,      TF_MODIFIER},
@@ -84,10 +84,12 @@ typedef enum TokenType {
     TT_LOOP,
     TT_NEW,
     TT_NULL,
+    TT_PACKED,
     TT_REGISTER,
     TT_RETURN,
     TT_SIGNED,
     TT_SIZEOF,
+    TT_SPLIT,
     TT_STATIC,
     TT_STROBE,
     TT_STRUCT,
@@ -101,6 +101,8 @@ const char* ParseTokenNames[NUM_PARSE_TOKENS] = {
         "const",
         "alias",
         "register",
+        "split",
+        "packed",
 
         "list",
 
@@ -87,6 +87,8 @@ enum ParseToken {
     PT_CONST,
     PT_ALIAS,
     PT_REGISTER,
+    PT_SPLIT,
+    PT_PACKED,
 
     // mark a list of data values
     PT_LIST,
@@ -0,0 +1,45 @@
+#--  Compiles each test program and runs it in the simulator, reporting
+#--  the cycles, instructions and memory writes of each.
+#--
+#--  Called from the sim_tests target with:
+#--    NEOLITHIC, NEOSIM - paths to the executables
+#--    TEST_DIR          - directory holding the test_*.c programs
+#--    WORK_DIR          - where the programs are compiled
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(GLOB testFiles ${TEST_DIR}/test_*.c)
+list(SORT testFiles)
+
+set(failedTests "")
+foreach(testFile ${testFiles})
+    get_filename_component(testName ${testFile} NAME_WE)
+    file(COPY ${testFile} DESTINATION ${WORK_DIR})
+
+    execute_process(COMMAND ${NEOLITHIC} ${testName}.c -o
+            WORKING_DIRECTORY ${WORK_DIR}
+            RESULT_VARIABLE compileResult
+            OUTPUT_QUIET ERROR_QUIET)
+    if(NOT compileResult EQUAL 0 OR NOT EXISTS ${WORK_DIR}/${testName}.bin)
+        message(STATUS "${testName}: compile failed (${compileResult})")
+        list(APPEND failedTests ${testName})
+        continue()
+    endif()
+
+    execute_process(COMMAND ${NEOSIM} ${testName}
+            WORKING_DIRECTORY ${WORK_DIR}
+            RESULT_VARIABLE simResult
+            OUTPUT_VARIABLE simOutput)
+    string(REGEX MATCH "Stopped: [^\n]*" stopLine "${simOutput}")
+    string(REGEX MATCH "Cycles: *[0-9]+" cycleLine "${simOutput}")
+    string(REGEX MATCH "Instructions: *[0-9]+" instrLine "${simOutput}")
+    string(REGEX MATCH "Memory writes: *[0-9]+" writeLine "${simOutput}")
+    message(STATUS "${testName}: ${stopLine}, ${cycleLine}, ${instrLine}, ${writeLine}")
+
+    if(NOT simResult EQUAL 0)
+        list(APPEND failedTests ${testName})
+    endif()
+endforeach()
+
+if(failedTests)
+    message(STATUS "Failed: ${failedTests}")
+endif()
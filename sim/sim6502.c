@@ -0,0 +1,466 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  Simple 6502 simulator - used to measure the code the compiler generates
+//
+//  Instructions are decoded using the same opcode table used by the compiler
+//  (cpu_arch/asm_code.c), so base cycle counts match what the compiler reports.
+//  On top of that, the simulator adds the extra cycles that depend on the
+//  data:  page crossings on indexed reads, and taken/page-crossing branches.
+//
+//  Memory is accessed thru the read/write functions provided to SIM_Init(),
+//  which handle the memory map of the machine being simulated.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+
+#include "sim6502.h"
+#include "common/common.h"
+#include "cpu_arch/asm_code.h"
+
+#define STACK_PAGE 0x100
+#define RETURN_SENTINEL 0xFFFF      // fake return address used by SIM_CallFunction
+
+static CpuState cpu;
+static SimReadFunc readMem;
+static SimWriteFunc writeMem;
+static OpcodeEntry decodeTable[256];
+static int callStackBase;           // stack pointer to return to (when calling a function)
+
+//-----------------------------------------------------------------------
+//--- Memory / stack helpers
+
+unsigned char readByte(int addr) {
+    return readMem(addr & 0xFFFF);
+}
+
+void writeByte(int addr, unsigned char value) {
+    writeMem(addr & 0xFFFF, value);
+    cpu.memWrites++;
+}
+
+int readWord(int addr) {
+    return readByte(addr) | (readByte(addr + 1) << 8);
+}
+
+/**
+ * Read word from the zeropage (the pointer wraps around within the zeropage)
+ */
+int readZpWord(int addr) {
+    return readByte(addr & 0xFF) | (readByte((addr + 1) & 0xFF) << 8);
+}
+
+void push(unsigned char value) {
+    writeByte(STACK_PAGE + cpu.sp, value);
+    cpu.sp--;
+}
+
+unsigned char pull() {
+    cpu.sp++;
+    return readByte(STACK_PAGE + cpu.sp);
+}
+
+void setFlag(enum CpuFlags flag, bool isSet) {
+    if (isSet) {
+        cpu.flags |= flag;
+    } else {
+        cpu.flags &= ~flag;
+    }
+}
+
+bool getFlag(enum CpuFlags flag) {
+    return (cpu.flags & flag) != 0;
+}
+
+unsigned char setNZ(unsigned char value) {
+    setFlag(FLAG_Z, value == 0);
+    setFlag(FLAG_N, (value & 0x80) != 0);
+    return value;
+}
+
+//-----------------------------------------------------------------------
+//--- Instruction decoding
+
+void SIM_Init(SimReadFunc readFunc, SimWriteFunc writeFunc) {
+    readMem = readFunc;
+    writeMem = writeFunc;
+
+    for_range(opcode, 0, 256) {
+        OpcodeEntry opcodeEntry = lookupOpcodeByValue(opcode);
+
+        decodeTable[opcode] = opcodeEntry;
+    }
+}
+
+/**
+ * Does this instruction take an extra cycle when indexing crosses a page?
+ *   (only instructions that read memory, stores/RMW instructions always take the extra cycle)
+ */
+bool hasPageCrossPenalty(enum MnemonicCode mne) {
+    switch (mne) {
+        case ADC: case AND: case CMP: case EOR: case LDA: case LDX: case LDY:
+        case ORA: case SBC: case LAX: case NOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isPageCrossed(int addr1, int addr2) {
+    return (addr1 & 0xFF00) != (addr2 & 0xFF00);
+}
+
+/**
+ * Figure out the effective address for the instruction's address mode
+ *   (PC points to the operand)
+ */
+int calcEffectiveAddr(enum AddrModes addrMode, bool *pageCrossed) {
+    int operandAddr = cpu.pc;
+    int baseAddr;
+    *pageCrossed = false;
+
+    switch (addrMode) {
+        case ADDR_IMM: return operandAddr;
+        case ADDR_ZP:  return readByte(operandAddr);
+        case ADDR_ZPX: return (readByte(operandAddr) + cpu.x) & 0xFF;
+        case ADDR_ZPY: return (readByte(operandAddr) + cpu.y) & 0xFF;
+        case ADDR_ABS: return readWord(operandAddr);
+        case ADDR_ABX:
+        case ADDR_ABY:
+            baseAddr = readWord(operandAddr);
+            int indexedAddr = (baseAddr + ((addrMode == ADDR_ABX) ? cpu.x : cpu.y)) & 0xFFFF;
+            *pageCrossed = isPageCrossed(baseAddr, indexedAddr);
+            return indexedAddr;
+        case ADDR_IX: return readZpWord(readByte(operandAddr) + cpu.x);
+        case ADDR_IY:
+            baseAddr = readZpWord(readByte(operandAddr));
+            *pageCrossed = isPageCrossed(baseAddr, baseAddr + cpu.y);
+            return (baseAddr + cpu.y) & 0xFFFF;
+        case ADDR_IND: {
+            // 6502 bug: indirect pointer doesn't cross pages
+            int ptrAddr = readWord(operandAddr);
+            return readByte(ptrAddr) | (readByte((ptrAddr & 0xFF00) | ((ptrAddr + 1) & 0xFF)) << 8);
+        }
+        case ADDR_REL: {
+            signed char ofs = (signed char)readByte(operandAddr);
+            return (cpu.pc + 1 + ofs) & 0xFFFF;
+        }
+        default:
+            return 0;
+    }
+}
+
+//-----------------------------------------------------------------------
+//--- Instruction execution
+
+void doADC(unsigned char value) {
+    int carry = getFlag(FLAG_C) ? 1 : 0;
+    int binResult = cpu.a + value + carry;
+
+    if (getFlag(FLAG_D)) {
+        int result = (cpu.a & 0x0F) + (value & 0x0F) + carry;
+        if (result > 9) result += 6;
+        result = (result & 0x0F) + (cpu.a & 0xF0) + (value & 0xF0) + ((result > 0x0F) ? 0x10 : 0);
+
+        setFlag(FLAG_Z, (binResult & 0xFF) == 0);
+        setFlag(FLAG_N, (result & 0x80) != 0);
+        setFlag(FLAG_V, (~(cpu.a ^ value) & (cpu.a ^ result) & 0x80) != 0);
+        if ((result & 0x1F0) > 0x90) result += 0x60;
+        setFlag(FLAG_C, (result & 0xFF0) > 0xF0);
+        cpu.a = result & 0xFF;
+    } else {
+        setFlag(FLAG_C, binResult > 0xFF);
+        setFlag(FLAG_V, (~(cpu.a ^ value) & (cpu.a ^ binResult) & 0x80) != 0);
+        cpu.a = setNZ(binResult & 0xFF);
+    }
+}
+
+void doSBC(unsigned char value) {
+    int borrow = getFlag(FLAG_C) ? 0 : 1;
+    int binResult = cpu.a - value - borrow;
+
+    // flags are always based on the binary result
+    setFlag(FLAG_C, binResult >= 0);
+    setFlag(FLAG_V, ((cpu.a ^ value) & (cpu.a ^ binResult) & 0x80) != 0);
+    setNZ(binResult & 0xFF);
+
+    if (getFlag(FLAG_D)) {
+        int lo = (cpu.a & 0x0F) - (value & 0x0F) - borrow;
+        int hi = (cpu.a >> 4) - (value >> 4);
+        if (lo & 0x10) {
+            lo -= 6;
+            hi--;
+        }
+        if (hi & 0x10) hi -= 6;
+        cpu.a = ((hi << 4) | (lo & 0x0F)) & 0xFF;
+    } else {
+        cpu.a = binResult & 0xFF;
+    }
+}
+
+void doCompare(unsigned char reg, unsigned char value) {
+    setFlag(FLAG_C, reg >= value);
+    setNZ((reg - value) & 0xFF);
+}
+
+/**
+ * Shift/rotate instructions (used for accumulator and memory versions)
+ */
+unsigned char doShift(enum MnemonicCode mne, unsigned char value) {
+    int carryIn = getFlag(FLAG_C) ? 1 : 0;
+    int result;
+    switch (mne) {
+        case ASL: setFlag(FLAG_C, value & 0x80); result = value << 1; break;
+        case LSR: setFlag(FLAG_C, value & 0x01); result = value >> 1; break;
+        case ROL: setFlag(FLAG_C, value & 0x80); result = (value << 1) | carryIn; break;
+        case ROR: setFlag(FLAG_C, value & 0x01); result = (value >> 1) | (carryIn << 7); break;
+        default:  result = value;
+    }
+    return setNZ(result & 0xFF);
+}
+
+bool isBranchTaken(enum MnemonicCode mne) {
+    switch (mne) {
+        case BCC: return !getFlag(FLAG_C);
+        case BCS: return getFlag(FLAG_C);
+        case BNE: return !getFlag(FLAG_Z);
+        case BEQ: return getFlag(FLAG_Z);
+        case BPL: return !getFlag(FLAG_N);
+        case BMI: return getFlag(FLAG_N);
+        case BVC: return !getFlag(FLAG_V);
+        case BVS: return getFlag(FLAG_V);
+        default:  return false;
+    }
+}
+
+void showTraceLine(int instrAddr, OpcodeEntry opcodeEntry) {
+    struct StAddressMode addrModeSt = getAddrModeSt(opcodeEntry.addrMode);
+    printf("%04X  %-3s ", instrAddr, getMnemonicStr(opcodeEntry.mneCode));
+    switch (addrModeSt.instrSize) {
+        case 2: printf("$%02X    ", readByte(instrAddr + 1)); break;
+        case 3: printf("$%04X  ", readWord(instrAddr + 1)); break;
+        default: printf("       ");
+    }
+    printf("%-4s A:%02X X:%02X Y:%02X SP:%02X P:%02X  cyc:%lu\n",
+           addrModeSt.name, cpu.a, cpu.x, cpu.y, cpu.sp, cpu.flags, cpu.cycles);
+}
+
+/**
+ * Execute a single instruction
+ */
+enum StopReason executeInstr(bool showTrace) {
+    int instrAddr = cpu.pc;
+    OpcodeEntry opcodeEntry = decodeTable[readByte(instrAddr)];
+    enum MnemonicCode mne = opcodeEntry.mneCode;
+    enum AddrModes addrMode = opcodeEntry.addrMode;
+
+    if (mne == MNE_NONE) return STOP_ILLEGAL_OPCODE;
+    if (showTrace) showTraceLine(instrAddr, opcodeEntry);
+
+    int instrSize = getAddrModeSt(addrMode).instrSize;
+    if ((addrMode == ADDR_NONE) || (addrMode == ADDR_ACC)) instrSize = 1;
+
+    cpu.pc = (cpu.pc + 1) & 0xFFFF;
+    bool pageCrossed;
+    int addr = calcEffectiveAddr(addrMode, &pageCrossed);
+    cpu.pc = (instrAddr + instrSize) & 0xFFFF;
+
+    int cycles = opcodeEntry.cycles;
+    if (pageCrossed && hasPageCrossPenalty(mne)) cycles++;
+
+    bool isAccMode = (addrMode == ADDR_NONE) || (addrMode == ADDR_ACC);
+    unsigned char value;
+
+    switch (mne) {
+        //--- loads/stores
+        case LDA: cpu.a = setNZ(readByte(addr)); break;
+        case LDX: cpu.x = setNZ(readByte(addr)); break;
+        case LDY: cpu.y = setNZ(readByte(addr)); break;
+        case LAX: cpu.a = cpu.x = setNZ(readByte(addr)); break;
+        case STA: writeByte(addr, cpu.a); break;
+        case STX: writeByte(addr, cpu.x); break;
+        case STY: writeByte(addr, cpu.y); break;
+        case SAX: writeByte(addr, cpu.a & cpu.x); break;
+
+        //--- register transfers
+        case TAX: cpu.x = setNZ(cpu.a); break;
+        case TAY: cpu.y = setNZ(cpu.a); break;
+        case TXA: cpu.a = setNZ(cpu.x); break;
+        case TYA: cpu.a = setNZ(cpu.y); break;
+        case TSX: cpu.x = setNZ(cpu.sp); break;
+        case TXS: cpu.sp = cpu.x; break;
+
+        //--- math/logic
+        case ADC: doADC(readByte(addr)); break;
+        case SBC: doSBC(readByte(addr)); break;
+        case AND: cpu.a = setNZ(cpu.a & readByte(addr)); break;
+        case ORA: cpu.a = setNZ(cpu.a | readByte(addr)); break;
+        case EOR: cpu.a = setNZ(cpu.a ^ readByte(addr)); break;
+        case CMP: doCompare(cpu.a, readByte(addr)); break;
+        case CPX: doCompare(cpu.x, readByte(addr)); break;
+        case CPY: doCompare(cpu.y, readByte(addr)); break;
+        case SBX: {
+            unsigned char andValue = cpu.a & cpu.x;
+            value = readByte(addr);
+            doCompare(andValue, value);
+            cpu.x = (andValue - value) & 0xFF;
+        } break;
+        case BIT:
+            value = readByte(addr);
+            setFlag(FLAG_Z, (cpu.a & value) == 0);
+            setFlag(FLAG_N, value & 0x80);
+            setFlag(FLAG_V, value & 0x40);
+            break;
+
+        //--- increment/decrement
+        case INC: writeByte(addr, setNZ(readByte(addr) + 1)); break;
+        case DEC: writeByte(addr, setNZ(readByte(addr) - 1)); break;
+        case DCP:
+            value = readByte(addr) - 1;
+            writeByte(addr, value);
+            doCompare(cpu.a, value);
+            break;
+        case ISB:
+            value = readByte(addr) + 1;
+            writeByte(addr, value);
+            doSBC(value);
+            break;
+        case INX: cpu.x = setNZ(cpu.x + 1); break;
+        case INY: cpu.y = setNZ(cpu.y + 1); break;
+        case DEX: cpu.x = setNZ(cpu.x - 1); break;
+        case DEY: cpu.y = setNZ(cpu.y - 1); break;
+
+        //--- shifts
+        case ASL: case LSR: case ROL: case ROR:
+            if (isAccMode) {
+                cpu.a = doShift(mne, cpu.a);
+            } else {
+                writeByte(addr, doShift(mne, readByte(addr)));
+            }
+            break;
+
+        //--- flags
+        case CLC: setFlag(FLAG_C, false); break;
+        case SEC: setFlag(FLAG_C, true); break;
+        case CLD: setFlag(FLAG_D, false); break;
+        case SED: setFlag(FLAG_D, true); break;
+        case CLI: setFlag(FLAG_I, false); break;
+        case SEI: setFlag(FLAG_I, true); break;
+        case CLV: setFlag(FLAG_V, false); break;
+
+        //--- stack
+        case PHA: push(cpu.a); break;
+        case PHP: push(cpu.flags | FLAG_B | FLAG_U); break;
+        case PLA: cpu.a = setNZ(pull()); break;
+        case PLP: cpu.flags = (pull() & ~FLAG_B) | FLAG_U; break;
+
+        //--- jumps/branches
+        case JMP: cpu.pc = addr; break;
+        case JSR:
+            push(((cpu.pc - 1) >> 8) & 0xFF);
+            push((cpu.pc - 1) & 0xFF);
+            cpu.pc = addr;
+            break;
+        case RTS:
+            cpu.pc = pull();
+            cpu.pc = ((pull() << 8) | cpu.pc) + 1;
+            cpu.cycles += cycles;
+            cpu.instrCount++;
+            if (cpu.sp == callStackBase) return STOP_RETURNED;
+            return STOP_NONE;
+        case RTI:
+            cpu.flags = (pull() & ~FLAG_B) | FLAG_U;
+            cpu.pc = pull();
+            cpu.pc |= pull() << 8;
+            break;
+        case BCC: case BCS: case BNE: case BEQ: case BPL: case BMI: case BVC: case BVS:
+            if (isBranchTaken(mne)) {
+                cycles += isPageCrossed(cpu.pc, addr) ? 2 : 1;
+                cpu.pc = addr;
+            }
+            break;
+
+        case NOP: break;
+        case BRK:
+            cpu.pc = instrAddr;
+            return STOP_BRK;
+
+        default:
+            cpu.pc = instrAddr;
+            return STOP_ILLEGAL_OPCODE;
+    }
+
+    cpu.cycles += cycles;
+    cpu.instrCount++;
+    return STOP_NONE;
+}
+
+//-----------------------------------------------------------------------
+
+void SIM_Reset(int startAddr) {
+    cpu.a = cpu.x = cpu.y = 0;
+    cpu.sp = 0xFF;
+    cpu.flags = FLAG_U | FLAG_I;
+    cpu.pc = startAddr & 0xFFFF;
+    cpu.cycles = 0;
+    cpu.instrCount = 0;
+    cpu.memWrites = 0;
+    callStackBase = -1;
+}
+
+/**
+ * Set up the CPU to run a single function.  When the function
+ *  returns, the simulator will stop.
+ */
+void SIM_CallFunction(int funcAddr) {
+    callStackBase = cpu.sp;
+    push(((RETURN_SENTINEL - 1) >> 8) & 0xFF);
+    push((RETURN_SENTINEL - 1) & 0xFF);
+    cpu.memWrites = 0;
+    cpu.pc = funcAddr & 0xFFFF;
+}
+
+/**
+ * Run until the marker address is reached, the cycle limit is hit,
+ *  or the function being called returns.
+ *
+ * @param markerAddr - address to stop at (-1 for none)
+ */
+enum StopReason SIM_Run(int markerAddr, unsigned long cycleLimit, bool showTrace) {
+    enum StopReason stopReason = STOP_NONE;
+    while (stopReason == STOP_NONE) {
+        if (cpu.pc == markerAddr) return STOP_MARKER;
+        if (cpu.cycles >= cycleLimit) return STOP_CYCLE_LIMIT;
+        stopReason = executeInstr(showTrace);
+    }
+    return stopReason;
+}
+
+const CpuState *SIM_GetState() {
+    return &cpu;
+}
+
+const char *SIM_GetStopReasonStr(enum StopReason stopReason) {
+    switch (stopReason) {
+        case STOP_RETURNED:       return "function returned";
+        case STOP_MARKER:         return "reached marker";
+        case STOP_CYCLE_LIMIT:    return "cycle limit reached";
+        case STOP_BRK:            return "BRK instruction";
+        case STOP_ILLEGAL_OPCODE: return "illegal opcode";
+        default:                  return "running";
+    }
+}
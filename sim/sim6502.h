@@ -0,0 +1,64 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+// Created by admin on 10/18/2026.
+//
+
+#ifndef NEOLITHIC_SIM6502_H
+#define NEOLITHIC_SIM6502_H
+
+#include <stdbool.h>
+
+enum CpuFlags {
+    FLAG_C = 0x01,
+    FLAG_Z = 0x02,
+    FLAG_I = 0x04,
+    FLAG_D = 0x08,
+    FLAG_B = 0x10,
+    FLAG_U = 0x20,      // unused (always set)
+    FLAG_V = 0x40,
+    FLAG_N = 0x80
+};
+
+enum StopReason {
+    STOP_NONE,
+    STOP_RETURNED,          // function returned to the simulator
+    STOP_MARKER,            // reached the marker address
+    STOP_CYCLE_LIMIT,
+    STOP_BRK,
+    STOP_ILLEGAL_OPCODE
+};
+
+typedef unsigned char (*SimReadFunc)(int addr);
+typedef void (*SimWriteFunc)(int addr, unsigned char value);
+
+typedef struct {
+    unsigned char a, x, y, sp, flags;
+    int pc;
+
+    unsigned long cycles;
+    unsigned long instrCount;
+    unsigned long memWrites;
+} CpuState;
+
+extern void SIM_Init(SimReadFunc readFunc, SimWriteFunc writeFunc);
+extern void SIM_Reset(int startAddr);
+extern void SIM_CallFunction(int funcAddr);
+extern enum StopReason SIM_Run(int markerAddr, unsigned long cycleLimit, bool showTrace);
+
+extern const CpuState *SIM_GetState();
+extern const char *SIM_GetStopReasonStr(enum StopReason stopReason);
+
+#endif //NEOLITHIC_SIM6502_H
@@ -0,0 +1,321 @@
+/***************************************************************************
+ * Neolithic Compiler - Simple C Cross-compiler for the 6502
+ *
+ * Copyright (c) 2020-2022 by Philip Blackman
+ * -------------------------------------------------------------------------
+ *
+ * Licensed under the GNU General Public License v2.0
+ *
+ * See the "LICENSE.TXT" file for more information regarding usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ * -------------------------------------------------------------------------
+ */
+
+//
+//  neosim - runs a program built by the compiler, to measure the generated code
+//
+//    Loads the .bin file (and the .sym file for looking up names), then runs
+//    either main (from the reset vector) or a single function, until it
+//    returns, reaches a marker address, or hits the cycle limit.
+//
+//  Hardware registers (TIA/RIOT, etc) are treated as plain memory, so
+//  programs that wait on hardware (WSYNC, timers) should be run with a
+//  marker or cycle limit.
+//
+// Created by admin on 10/18/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim6502.h"
+#include "common/common.h"
+
+#define DEFAULT_CYCLE_LIMIT 1000000
+#define MAX_ROM_SIZE 0x10000
+
+enum SimMachine { SIM_2600, SIM_5200, SIM_7800 };
+
+typedef struct {
+    char *name;
+    enum SimMachine machine;
+} SimMachineDef;
+
+static const SimMachineDef machineDefs[] = {
+    {"Atari2600", SIM_2600},
+    {"Atari5200", SIM_5200},
+    {"Atari7800", SIM_7800},
+};
+
+static enum SimMachine machine = SIM_2600;
+
+static unsigned char romData[MAX_ROM_SIZE];
+static int romSize;
+static int romStart;                // address where ROM starts (for non-banked machines)
+static unsigned char memory[0x10000];
+static bool ramWritten[0x10000];
+
+// 2600 bank-switching (selected by reading/writing hotspots at the top of the ROM)
+static int bankCount = 1;
+static int curBank = 0;
+static int firstHotspot;
+
+//-----------------------------------------------------------------------
+//--- Memory maps
+
+int getHotspotBank(int addr) {
+    if ((bankCount > 1) && (addr >= firstHotspot) && (addr < firstHotspot + bankCount)) {
+        return addr - firstHotspot;
+    }
+    return -1;
+}
+
+unsigned char read2600(int addr) {
+    addr &= 0x1FFF;
+    if (addr & 0x1000) {
+        int hotspotBank = getHotspotBank(addr);
+        unsigned char value = romData[(curBank * 0x1000) + (addr & 0xFFF)];
+        if (hotspotBank >= 0) curBank = hotspotBank;
+        return value;
+    }
+
+    // RAM is at $80-$FF (mirrored at $180-$1FF for the stack), everything else is TIA/RIOT
+    if (!(addr & 0x0200) && (addr & 0x0080)) return memory[0x80 | (addr & 0x7F)];
+    return memory[addr];
+}
+
+void write2600(int addr, unsigned char value) {
+    addr &= 0x1FFF;
+    if (addr & 0x1000) {
+        int hotspotBank = getHotspotBank(addr);
+        if (hotspotBank >= 0) curBank = hotspotBank;
+        return;
+    }
+    if (!(addr & 0x0200) && (addr & 0x0080)) addr = 0x80 | (addr & 0x7F);
+    memory[addr] = value;
+    ramWritten[addr] = true;
+}
+
+unsigned char readFlat(int addr) {
+    if ((addr >= romStart) && (addr < romStart + romSize)) return romData[addr - romStart];
+    return memory[addr];
+}
+
+void writeFlat(int addr, unsigned char value) {
+    if ((addr >= romStart) && (addr < romStart + romSize)) return;     // ROM is read-only
+    memory[addr] = value;
+    ramWritten[addr] = true;
+}
+
+/**
+ * Select the bank an address from the symbol file lives in  (for bank-switched programs)
+ *
+ *   The compiler places each 2600 bank at its own 8K mirror of the cart space,
+ *   so the bank can be found from the address.
+ */
+void selectBankForAddr(int symAddr) {
+    if (machine != SIM_2600) return;
+
+    int bank = symAddr >> 13;
+    if (bank < bankCount) curBank = bank;
+}
+
+//-----------------------------------------------------------------------
+//--- Loading files
+
+bool loadBinFile(const char *fileName) {
+    FILE *binFile = fopen(fileName, "rb");
+    if (!binFile) {
+        printf("Unable to open %s\n", fileName);
+        return false;
+    }
+    romSize = (int)fread(romData, 1, MAX_ROM_SIZE, binFile);
+    fclose(binFile);
+
+    switch (machine) {
+        case SIM_2600:
+            bankCount = (romSize > 0x1000) ? (romSize / 0x1000) : 1;
+            switch (bankCount) {
+                case 1: break;
+                case 2: firstHotspot = 0x1FF8; break;       // F8
+                case 4: firstHotspot = 0x1FF6; break;       // F6
+                case 8: firstHotspot = 0x1FF4; break;       // F4
+                default:
+                    printf("Unsupported bank-switching scheme (%d bytes)\n", romSize);
+                    return false;
+            }
+            SIM_Init(read2600, write2600);
+            break;
+        case SIM_5200:
+            romStart = 0x4000;
+            SIM_Init(readFlat, writeFlat);
+            break;
+        case SIM_7800:
+            romStart = 0x10000 - romSize;
+            SIM_Init(readFlat, writeFlat);
+            break;
+    }
+    return true;
+}
+
+/**
+ * Get the start address of the program  (the 5200 BIOS jumps thru the cart's vector)
+ */
+int getResetAddr() {
+    switch (machine) {
+        case SIM_2600: return read2600(0x1FFC) | (read2600(0x1FFD) << 8);
+        case SIM_5200: return readFlat(0xBFFE) | (readFlat(0xBFFF) << 8);
+        default:       return readFlat(0xFFFC) | (readFlat(0xFFFD) << 8);
+    }
+}
+
+bool isHexStr(const char *str) {
+    return (str[0] != '\0') && (strspn(str, "0123456789abcdefABCDEF") == strlen(str));
+}
+
+/**
+ * Look up the location of a symbol in the .sym file written by the compiler
+ *
+ * @return location, or -1 if not found
+ */
+int lookupSymbol(const char *symFileName, const char *symName) {
+    FILE *symFile = fopen(symFileName, "r");
+    if (!symFile) {
+        printf("Unable to open %s\n", symFileName);
+        return -1;
+    }
+
+    char line[256];
+    int location = -1;
+    while ((location < 0) && fgets(line, sizeof(line), symFile)) {
+        char name[64], locStr[16], kind[16];
+        if (sscanf(line, " %63s %15s %15s", name, locStr, kind) != 3) continue;
+
+        // constants without a location only have a kind
+        if ((strcmp(name, symName) == 0) && isHexStr(locStr)) {
+            location = (int)strtol(locStr, NULL, 16);
+        }
+    }
+    fclose(symFile);
+    return location;
+}
+
+/**
+ * Get an address from the command line  ($hex or a symbol name)
+ */
+int getAddrParam(const char *param, const char *symFileName) {
+    if (param[0] == '$') return (int)strtol(param + 1, NULL, 16);
+
+    int location = lookupSymbol(symFileName, param);
+    if (location < 0) printf("Symbol not found: %s\n", param);
+    return location;
+}
+
+//-----------------------------------------------------------------------
+
+void showWrittenRAM() {
+    printf("\nRAM written:\n");
+    int count = 0;
+    for_range(addr, 0, 0x10000) {
+        if (!ramWritten[addr]) continue;
+        printf("  %04X: %02X", addr, memory[addr]);
+        if ((++count % 6) == 0) printf("\n");
+    }
+    if ((count % 6) != 0) printf("\n");
+}
+
+void showResults(enum StopReason stopReason) {
+    const CpuState *state = SIM_GetState();
+    printf("Stopped: %s at $%04X\n", SIM_GetStopReasonStr(stopReason), state->pc);
+    printf("  Cycles:        %lu\n", state->cycles);
+    printf("  Instructions:  %lu\n", state->instrCount);
+    printf("  Memory writes: %lu\n", state->memWrites);
+    printf("  Registers:     A:%02X X:%02X Y:%02X SP:%02X P:%02X\n",
+           state->a, state->x, state->y, state->sp, state->flags);
+}
+
+void showUsage() {
+    printf("Usage:\tneosim (program) (options)\n"
+           "  (program) - name of the compiled program (without extension)\n\n"
+           "  -m<machine>    Atari2600 (default), Atari5200, Atari7800\n"
+           "  -f<func>       run a single function (name or $addr), instead of main\n"
+           "  -u<marker>     stop when the marker (name or $addr) is reached\n"
+           "  -c<cycles>     cycle limit (default %d)\n"
+           "  -t             show trace of each instruction executed\n"
+           "  -v             show the RAM written\n\n", DEFAULT_CYCLE_LIMIT);
+}
+
+int main(int argc, char *argv[]) {
+    printf("\nNeolithic 6502 Simulator\n\n");
+    if (argc < 2) {
+        showUsage();
+        return -1;
+    }
+
+    const char *progName = argv[1];
+    const char *funcName = NULL;
+    const char *markerName = NULL;
+    unsigned long cycleLimit = DEFAULT_CYCLE_LIMIT;
+    bool showTrace = false;
+    bool showRAM = false;
+
+    for (int c=2; c<argc; c++) {
+        char *cmdParam = argv[c];
+        if (cmdParam[0] != '-') continue;
+        switch (cmdParam[1]) {
+            case 'm': {
+                bool found = false;
+                for_range(index, 0, (int)(sizeof(machineDefs) / sizeof(SimMachineDef))) {
+                    if (strcmp(machineDefs[index].name, cmdParam + 2) == 0) {
+                        machine = machineDefs[index].machine;
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    printf("Unknown machine: %s\n", cmdParam + 2);
+                    return -1;
+                }
+            } break;
+            case 'f': funcName = cmdParam + 2; break;
+            case 'u': markerName = cmdParam + 2; break;
+            case 'c': cycleLimit = strtoul(cmdParam + 2, NULL, 10); break;
+            case 't': showTrace = true; break;
+            case 'v': showRAM = true; break;
+            default:
+                printf("Unknown option: %s\n", cmdParam);
+                showUsage();
+                return -1;
+        }
+    }
+
+    char *binFileName = catStrs(progName, ".bin");
+    char *symFileName = catStrs(progName, ".sym");
+    if (!loadBinFile(binFileName)) return -1;
+
+    int markerAddr = -1;
+    if (markerName != NULL) {
+        markerAddr = getAddrParam(markerName, symFileName);
+        if (markerAddr < 0) return -1;
+    }
+
+    // start up from the reset vector, like the real machine
+    SIM_Reset(getResetAddr());
+
+    if (funcName != NULL) {
+        int funcAddr = getAddrParam(funcName, symFileName);
+        if (funcAddr < 0) return -1;
+        printf("Running function %s at $%04X\n", funcName, funcAddr);
+        selectBankForAddr(funcAddr);
+        SIM_CallFunction(funcAddr);
+    } else {
+        printf("Running %s from reset\n", progName);
+    }
+
+    enum StopReason stopReason = SIM_Run(markerAddr, cycleLimit, showTrace);
+    showResults(stopReason);
+    if (showRAM) showWrittenRAM();
+
+    return (stopReason == STOP_ILLEGAL_OPCODE) ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+//--- Test bank placement of functions with parameters  (check results with and without the optimizer)
+#set_banking F8
+
+byte r1, r2, r3
+
+//-- left unpinned, so they end up in their caller's bank when their params are on the stack
+byte addTen(byte v) { return v + 10 }
+byte addBoth(byte a, byte b) { return a + b }
+
+#set_bank 1
+byte getBase() { return 40 }
+byte getStep() { return 2 }
+
+#set_bank 0
+void main() {
+    r1 = addTen(200) + addBoth(3, 4)        // (r1 = $D9)
+    r2 = getBase() + getStep()              //-- cross-bank calls thru trampolines  (r2 = $2A)
+    r3 = addBoth(r2, getStep())             // (r3 = $2C)
+    r1 = r1
+}
@@ -0,0 +1,35 @@
+//--- Test short-circuit boolean expressions, both in conditions and as values
+//      (bump() should never get called)
+char a;
+char b;
+char c;
+char d;
+char r1;
+char r2;
+char r3;
+char r4;
+char r5;
+char calls;
+
+char bump() {
+    calls++;
+    return 1;
+}
+
+void main() {
+    a = 5;
+    b = 3;
+    c = 0;
+    d = 7;
+    r1 = a > b && c;
+    r2 = a > b || bump();
+    r3 = (a < b || d == 7) && !(c != 0);
+    if ((a == 5 || b == 9) && (c == 0 || bump())) {
+        r4 = 1;
+    }
+    r5 = !c && (a <= 0 || b >= 3);
+    while (c < 3 && (a != 0 || d != 0)) {
+        c++;
+    }
+    d = c;      // (d = 3)
+}
@@ -0,0 +1,13 @@
+//--- Test carry tracking (the CLC/SEC after the compares and the LSR aren't needed)
+byte x, y, z, q
+word w
+
+void main() {
+    x = 5
+    q = 7
+    if (x < 10) { y = x + 3 }
+    if (x >= 3) { z = x - 2 }
+    z = ((x & 14) >> 1) + q
+    w = w + 1
+    w = w + 1
+}
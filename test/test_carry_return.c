@@ -0,0 +1,43 @@
+//--- Test bool results returned in carry  (leaf bool functions return with SEC/CLC, callers branch with BCC/BCS)
+byte px, py, hits, misses, total
+packed bool isAlive = true
+bool b1, b2
+byte r1, r2
+
+bool isInBox(byte x, byte y) {
+    return (x >= 10) && (x < 20) && (y >= 30) && (y < 40)
+}
+
+bool isAliveCheck() {
+    return isAlive
+}
+
+bool isNonZero(byte v) {
+    return v
+}
+
+bool alwaysTrue() {
+    return true
+}
+
+bool outer(byte x) {
+    if (x == 0) return false
+    return isInBox(x, 35)
+}
+
+void main() {
+    px = 0
+    do {
+        if (isInBox(px, 35)) hits++
+        if (!isInBox(px, 35)) misses++
+        px = px + 5
+    } while (px < 40)
+    b1 = isInBox(12, 31)
+    b2 = isNonZero(0)
+    if (isAliveCheck() && alwaysTrue()) total = total + 10
+    r1 = isNonZero(7) + alwaysTrue()
+    isAlive = isInBox(50, 50)
+    if (outer(15)) total = total + 1
+    r2 = outer(0) + 5
+    total++
+}
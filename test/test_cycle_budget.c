@@ -0,0 +1,45 @@
+//--- Test worst case timing  (compile with -vtupdateFrame to see the timing)
+byte enemyX[8], enemyY[8]
+byte playerX, playerY, count, frame
+
+void moveEnemy(byte n) {
+    if (enemyX[n] < playerX) {
+        enemyX[n]++
+    } else {
+        enemyX[n]--
+    }
+}
+
+void clearRow() {
+    count = 8
+    #max_loops 8
+    while (count > 0) {
+        count--
+        enemyY[count] = 0
+    }
+    #max_loops 8
+    #unroll 0
+    for (count = 0; count < playerY; count++) {
+        enemyX[count] = 0
+    }
+}
+
+#cycle_budget 2700
+void updateFrame() {
+    byte i
+    loop (i, 0, 8) {
+        moveEnemy(i)
+    }
+    if (frame == 0) {
+        clearRow()
+    }
+    frame++
+}
+
+void main() {
+    playerX = 80
+    playerY = 2
+    enemyX[3] = 90
+    frame = 0
+    updateFrame()
+}
@@ -0,0 +1,22 @@
+//--- Test sharing of constant tables (run with optimizer: -o)
+
+// identical tables
+const char colorsA[] = { 10, 20, 30, 40, 50 };
+const char colorsB[] = { 10, 20, 30, 40, 50 };
+
+// table found inside another table
+const char colorsTail[] = { 40, 50 };
+
+// end of spriteA matches the start of spriteB
+const char spriteA[] = { 1, 2, 3, 4, 0, 0 };
+const char spriteB[] = { 0, 0, 7, 8, 9 };
+
+char x;
+
+void main() {
+    x = colorsA[1];
+    x = colorsB[2];
+    x = colorsTail[0];
+    x = spriteA[3];
+    x = spriteB[2];
+}
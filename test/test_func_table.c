@@ -0,0 +1,46 @@
+//--- Test function tables  (split lo/hi address tables, called thru an RTS dispatch stub)
+byte state, score, lives, frames, result
+
+void stateTitle() {
+    score = 0
+    state = 1
+}
+
+void stateGame() {
+    byte speed
+    speed = frames + 2
+    score = score + speed
+    if (score > 20) state = 2
+}
+
+void loseLife() {
+    lives--
+}
+
+void stateOver() {
+    loseLife()
+    state = 0
+}
+
+byte getOne() { return 1 }
+byte getTwo() { return 2 }
+
+const function stateHandlers[] = { stateTitle, stateGame, stateOver }
+const function getters[] = { getOne, getTwo }
+
+void runState() {
+    stateHandlers[state]()
+}
+
+void main() {
+    lives = 3
+    state = 0
+    frames = 0
+    do {
+        stateHandlers[state]()
+        frames++
+    } while (frames < 8)
+    runState()
+    result = getters[1]() + getters[lives - 1]()
+    frames++
+}
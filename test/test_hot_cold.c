@@ -0,0 +1,43 @@
+//--- Test moving rarely used code out of the way
+byte data[8]
+byte errors, total, lastValue, mode
+
+byte checkValue(byte v) {
+    if (v >= 200) {
+        errors++
+        return 0
+    }
+    return v + 1
+}
+
+void addValue(byte v) {
+    #unlikely
+    if (v == 0) {
+        errors++
+        lastValue = 0
+    }
+    total = total + v
+}
+
+void setMode(byte m) {
+    #likely
+    if (m < 4) {
+        mode = m
+    } else {
+        mode = 0
+        errors++
+    }
+    lastValue = mode
+}
+
+void main() {
+    byte i
+    for (i = 0; i < 8; i++) {
+        data[i] = checkValue(i * 40)
+    }
+    addValue(data[1])
+    addValue(0)
+    setMode(2)
+    setMode(7)
+    total = total + mode
+}
@@ -0,0 +1,36 @@
+//--- Test loop counter kept in the Y register  (run with optimizer: -o, c[j*3] is only supported there)
+struct Enemy {
+    byte x
+    byte y
+    byte hp
+}
+
+Enemy enemies[6]
+byte a[8]
+byte b[8]
+byte c[24]
+byte i, j, total, sum
+
+void main() {
+    total = 5
+    #unroll 0
+    for (i = 0; i < 8; i++) {
+        a[i] = i
+    }
+    #unroll 0
+    for (j = 7; j >= 1; j--) {
+        c[j*3] = total
+    }
+    #unroll 0
+    loop (j, 0, 6) {
+        enemies[j].x = 10
+        enemies[j].hp = enemies[j].x + 5
+    }
+    sum = 0
+    #unroll 0
+    for (i = 0; i < 8; i++) {
+        sum = sum + a[i]            //-- array op uses Y directly  (sum = $1C)
+        if (sum > 200) sum = 0
+    }
+    total = total + i + j
+}
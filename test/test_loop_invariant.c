@@ -0,0 +1,51 @@
+//--- Test hoisting of loop invariant expressions
+struct Enemy {
+    byte x
+    byte y
+}
+
+Enemy enemies[4]
+Enemy *ep
+const byte tbl[] = { 1, 2, 3, 4, 5, 6, 7, 8 }
+byte dst[8]
+byte k, n, x, total, sum
+
+void show(byte v) {
+    total = total + v
+}
+
+void main() {
+    byte m, cnt
+    k = 3
+    n = 2
+    m = 4
+    enemies[2].x = 9
+    x = 0
+    while (x < 8) {
+        dst[x] = tbl[n] + k*3
+        x++
+    }
+    cnt = 0
+    do {
+        total = total + enemies[n].x + (k << 2)
+        cnt++
+    } while (cnt < m + 1)
+    x = 0
+    while (x < 3) {
+        show(m * 4)
+        x++
+    }
+
+    //-- storing thru a pointer can change any struct  (sum = $D2)
+    enemies[0].x = 10
+    ep = &enemies[0]
+    n = 0
+    sum = 0
+    x = 0
+    while (x < 3) {
+        sum = sum + enemies[n].x
+        ep.x = 100
+        x++
+    }
+    k = total
+}
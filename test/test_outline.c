@@ -0,0 +1,43 @@
+//--- Test moving repeated code into subroutines  (compile with -os)
+byte enemyX[4], enemyY[4]
+byte posX, posY, score, lives, timer
+
+void moveEnemy(byte n) {
+    posX = enemyX[2]
+    posY = enemyY[2]
+    score = score + 5
+    timer = 20
+    enemyX[0] = n
+}
+
+void hitEnemy(byte n) {
+    posX = enemyX[2]
+    posY = enemyY[2]
+    score = score + 5
+    timer = 20
+    lives = n
+}
+
+void resetEnemy() {
+    byte count = 3
+    posX = enemyX[2]
+    posY = enemyY[2]
+    score = score + 5
+    timer = 20
+    enemyY[1] = count
+}
+
+void main() {
+    enemyX[2] = 40
+    enemyY[2] = 30
+    moveEnemy(7)
+    hitEnemy(2)
+    resetEnemy()
+
+    #show_cycles
+    posX = enemyX[2]
+    posY = enemyY[2]
+    score = score + 5
+    timer = 20
+    #hide_cycles
+}
@@ -0,0 +1,32 @@
+//--- Test packed bools  (bools share a byte, the busiest ones get bits 7/6 to be tested with BIT)
+packed bool isRunning = true
+packed bool hasKey
+packed bool isDead
+packed bool gotBonus = true
+bool plain
+byte count, total, result
+
+void check(byte n) {
+    if (isDead) {
+        total = total + n
+    }
+}
+
+void main() {
+    count = 0
+    while (isRunning) {
+        count++
+        if (count == 3) hasKey = true
+        if (count == 5) isRunning = false
+        if (hasKey && !isDead) total++
+    }
+    isDead = !isDead
+    check(10)
+    plain = hasKey
+    isDead = count > 4
+    result = gotBonus + hasKey
+    if (hasKey == gotBonus) result = result + 10
+    gotBonus = plain
+    if (!gotBonus) result = result + 100
+    count = 0
+}
@@ -0,0 +1,32 @@
+//--- Test the calling convention for function params
+//      (frame params, a param passed in a register, and stack params for recursion)
+char table[8];
+char total;
+char count;
+
+// 'idx' is used as an array index, so it gets passed in Y
+void setEntry(char value, char idx) {
+    table[idx] = value;
+}
+
+char addThree(char a, char b, char c) {
+    return a + b + c;
+}
+
+// recursive, so its param stays on the stack
+void countDown(char n) {
+    count++;
+    if (n > 0) countDown(n - 1);
+}
+
+void main() {
+    total = 3;
+    setEntry(10, 1);
+    setEntry(total + 1, total);
+    total = addThree(1, 2, total);
+
+    // call in the args, so the params can't be set up in the frame
+    total = addThree(addThree(1, 1, 1), 2, 3);
+
+    countDown(3);
+}
@@ -0,0 +1,18 @@
+//--- Test startup RAM init  (RAM is cleared, then initial values are copied from one table)
+byte lives = 3
+byte level = 1
+byte score
+word hiscore = 1000
+word timer = 0
+bool isRunning = true
+byte playerX = 80, playerY = 20
+
+byte total
+
+void main() {
+    total = lives + level + playerX + playerY
+    if (isRunning) {
+        hiscore = hiscore + score
+    }
+    level = level + 1       // (level = 2)
+}
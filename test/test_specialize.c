@@ -0,0 +1,51 @@
+//--- Test specializing functions for constant arguments
+//      (calls with the same constant args share a clone of the function)
+char table[8];
+char total;
+char out;
+
+void setEntry(char value, char idx) {
+    table[idx] = value;
+}
+
+// only called once, so the clone replaces it
+char addTwice(char v, char amount) {
+    return v + amount + amount;
+}
+
+// too big to copy  (the statements are counted once, not per param)
+void big(char c, int w) {
+    out = c;
+    out = out + 1;
+    out = out + 2;
+    out = out + 3;
+    out = out + 4;
+    out = out + 5;
+    out = out + 6;
+    out = out + 7;
+    out = out + 8;
+    out = out + 9;
+    out = out + 10;
+    out = out + 11;
+    out = out + 12;
+    out = out + 13;
+    out = out + 14;
+    out = out + 15;
+    out = out + 16;
+    out = out + 17;
+    out = out + 18;
+    out = out + 19;
+}
+
+void main() {
+    total = 3;
+    setEntry(10, 1);
+    setEntry(20, 2);
+    setEntry(total, 5);
+    setEntry(total, 5);
+    big(1, 300);
+    big(1, 300);
+    big(2, 300);
+    big(2, 300);
+    out = addTwice(total, 2);
+}
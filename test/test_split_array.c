@@ -0,0 +1,36 @@
+//--- Test split arrays of structs (one array per struct field)
+struct Enemy {
+    char x;
+    char y;
+    int speed;
+};
+
+split Enemy enemies[4];
+split const Enemy starts[2] = { {1, 2, 300}, {4, 5, 600} };
+
+char i;
+char total;
+char r1, r2;
+
+void main() {
+    i = 2;
+    enemies[i].x = 5;
+    enemies[1].y = enemies[i].x;
+    enemies[i].speed = 1000;
+    total = enemies[i].x + enemies[i].y;
+    if (enemies[i].y == 3) total = 1;
+    total = starts[i].x;
+
+    // a var index has to make Y forget the constant index loaded before it
+    enemies[2].y = 4;
+    enemies[3].y = 6;
+    i = 2;
+    r1 = enemies[i].x;
+    r2 = enemies[3].y;      // (r2 = 6)
+
+    alias Enemy e = enemies[i];
+    e = { 7, 8, 1234 };
+    e.x++;
+
+    total = sizeof(enemies);
+}
@@ -0,0 +1,31 @@
+//--- Test working out the worst case stack depth  (compile with -va to see it)
+byte total, count
+
+void addOne() {
+    asm {
+        pha
+        pha
+        pla
+        pla
+    }
+    total = total + 1
+}
+
+void addTwo() {
+    addOne()
+    addOne()
+}
+
+void addMany(byte n) {
+    count = n
+    do {
+        addTwo()
+        count--
+    } while (count > 0)
+}
+
+void main() {
+    total = 0
+    addMany(3)
+    addOne()
+}
@@ -0,0 +1,53 @@
+//--- Test merging identical code at the end of if/else and switch cases
+byte posX, posY, moves, hits
+
+void move(byte d) {
+    switch (d) {
+        case 0: {
+            posY--
+            moves++
+            hits = hits + 2
+        }
+        case 1: {
+            posY++
+            moves++
+            hits = hits + 2
+        }
+        case 2: {
+            posX--
+            moves++
+            hits = hits + 2
+        }
+        default: {
+            posX++
+            moves++
+            hits = hits + 2
+        }
+    }
+}
+
+void bump(byte v) {
+    if (v < 10) {
+        posX = v
+        moves++
+        hits = hits + 1
+    } else {
+        posY = v
+        moves++
+        hits = hits + 1
+    }
+    posX++
+}
+
+void main() {
+    posX = 5
+    posY = 5
+    move(0)
+    move(2)
+    move(3)
+    move(1)
+    move(1)
+    bump(3)
+    bump(20)
+    hits++
+}
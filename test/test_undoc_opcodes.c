@@ -0,0 +1,36 @@
+//--- Test undocumented opcodes  (compile with -ou:  LAX, SAX, DCP, SBX and ISB replace common sequences)
+byte xs[8]
+byte n, t, a, b, count, lives, result
+word mask
+
+byte getOne() { return 1 }
+byte getTwo() { return 2 }
+
+const function getters[] = { getOne, getTwo }
+
+void copyIndex() {
+    t = n               //-- LDA n / STA t / LDX n  ->  LAX n / STA t
+    xs[n]++
+}
+
+void main() {
+    n = 3
+    lives = 2
+    copyIndex()
+
+    mask = 0x0F0F
+    a = n & 15          //-- X still holds $0F from the word:  AND #$F / STA a  ->  SAX a
+
+    b = 20 - t
+    t++
+    b = b - t           //-- INC t / SEC / SBC t  ->  SEC / ISB t
+
+    count = 10
+    do {
+        a = a + 2
+        count--
+    } while (count != 4)    //-- DEC count / LDA count / CMP #4  ->  LDA #4 / DCP count
+
+    result = getters[lives - 1]()       //-- LDA lives / SEC / SBC #1 / TAX  ->  LAX lives / SBX #1
+    xs[0] = result
+}
@@ -0,0 +1,51 @@
+//--- Test loop unrolling
+char a,b,i,total;
+char array[8];
+char buffer[16];
+
+const char SIZE = 6;
+
+void clear_array() {
+    loop (i, 0, 8) {
+        array[i] = 0;
+    }
+}
+
+void copy_with_for() {
+    for (i=0; i<SIZE; i++) {
+        array[i+1] = buffer[i*2];
+    }
+}
+
+void force_unroll() {
+    #unroll
+    for (i=9; i>=2; i--) {
+        if (a == i) { b = i; }
+    }
+}
+
+void keep_rolled() {
+    #unroll 0
+    loop (i, 0, 4) {
+        array[i] = 0;
+    }
+}
+
+// the inner loop changes the counter, so this can't be unrolled  (total = 5)
+void nested_counter() {
+    #unroll
+    for (i=0; i<4; i++) {
+        loop (i, 0, 5) {
+            total++;
+        }
+    }
+}
+
+void main() {
+    clear_array();
+    copy_with_for();
+    force_unroll();
+    keep_rolled();
+    nested_counter();
+    a = total;
+}
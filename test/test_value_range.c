@@ -0,0 +1,22 @@
+//--- Test value ranges (masks and compares that can't change anything are dropped)
+enum Dir { UP, DOWN, LEFT, RIGHT }
+
+Dir dir
+byte x, y, r1, r2, r3, r4, r5
+word w
+
+void main() {
+    dir = Dir.LEFT
+    x = 7
+    y = dir & 0x0F
+    w = (x & 15) + (dir & 3)
+    if (dir < 8) { r1 = 1 }
+    if (x < 10) {
+        if (x < 20) { r2 = 1 }
+    }
+    if (x >= 5) {
+        if (x != 3) { r3 = 1 }
+    }
+    if (x > 255) { r5 = 1 }
+    r4 = ((x & 7) | 8) & 15
+}
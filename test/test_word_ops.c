@@ -0,0 +1,32 @@
+//--- Test 16-bit arithmetic, shifts and compares
+//      (r1, r3, r5 and r8 should end up set, the rest left alone)
+word a, b, c
+signed int s, t
+byte x, y
+byte r1, r2, r3, r4, r5, r6, r7, r8
+word w1, w2, w3, w4
+
+void main() {
+    a = 1000
+    b = 300
+    x = 200
+    y = 100
+    c = a + b
+    w1 = a - b
+    w2 = (a + b) - (x + y)
+    a = a + x
+    b = b - y
+    w3 = c << 2
+    w4 = c >> 3
+    s = 0 - 5
+    t = 3
+    if (a > 1100) { r1 = 1 }
+    if (b <= 199) { r2 = 1 }
+    if (c == 1300) { r3 = 1 }
+    if (c != 1300) { r4 = 1 }
+    if (s < t) { r5 = 1 }
+    if (a < b) { r6 = 1 }
+    if (c >= a + x) { r7 = 1 }
+    if (w1) { r8 = 1 }
+    s = s >> 1
+}